@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace amethyst
+{
+    /**
+     * The CRC-32 used by zlib, PNG and gzip (polynomial 0xEDB88320).  Data
+     * can be added in pieces; value() is the checksum of everything so far.
+     */
+    class crc32
+    {
+    public:
+        crc32() = default;
+
+        void update(const void* data, size_t length)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            const auto& t = table();
+            for (size_t i = 0; i < length; ++i)
+            {
+                m_crc = t[(m_crc ^ bytes[i]) & 0xff] ^ (m_crc >> 8);
+            }
+        }
+
+        uint32_t value() const { return ~m_crc; }
+
+        static uint32_t of(const void* data, size_t length)
+        {
+            crc32 c;
+            c.update(data, length);
+            return c.value();
+        }
+
+    private:
+        static const std::array<uint32_t, 256>& table()
+        {
+            static const std::array<uint32_t, 256> t = []()
+            {
+                std::array<uint32_t, 256> result;
+                for (uint32_t n = 0; n < 256; ++n)
+                {
+                    uint32_t c = n;
+                    for (int k = 0; k < 8; ++k)
+                    {
+                        c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+                    }
+                    result[n] = c;
+                }
+                return result;
+            }();
+            return t;
+        }
+
+        uint32_t m_crc = 0xffffffffu;
+    };
+
+    /**
+     * The Adler-32 checksum that ends a zlib stream.
+     */
+    class adler32
+    {
+    public:
+        adler32() = default;
+
+        void update(const void* data, size_t length)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            while (length > 0)
+            {
+                // 5552 bytes is the most that can be summed before b could
+                // overflow 32 bits.
+                size_t block = (length < 5552) ? length : 5552;
+                length -= block;
+                for (size_t i = 0; i < block; ++i)
+                {
+                    m_a += bytes[i];
+                    m_b += m_a;
+                }
+                bytes += block;
+                m_a %= modulus;
+                m_b %= modulus;
+            }
+        }
+
+        uint32_t value() const { return (m_b << 16) | m_a; }
+
+        static uint32_t of(const void* data, size_t length)
+        {
+            adler32 a;
+            a.update(data, length);
+            return a.value();
+        }
+
+    private:
+        static constexpr uint32_t modulus = 65521;
+
+        uint32_t m_a = 1;
+        uint32_t m_b = 0;
+    };
+}
@@ -0,0 +1,254 @@
+#include "deflate_stream.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace amethyst
+{
+    namespace
+    {
+        // RFC 1951 section 3.2.5.
+        const uint16_t length_base[29] = {
+            3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+        };
+        const uint8_t length_extra[29] = {
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+        };
+        const uint16_t distance_base[30] = {
+            1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+        };
+        const uint8_t distance_extra[30] = {
+            0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+        };
+
+        // The index of the last entry of a sorted table that is <= value.
+        template <size_t N>
+        size_t code_for(const uint16_t (&bases)[N], size_t value)
+        {
+            return size_t(std::upper_bound(bases, bases + N, value) - bases) - 1;
+        }
+    }
+
+    deflate_stream::deflate_stream(output_function output)
+        : m_output(std::move(output))
+        , m_head(hash_size, 0)
+        , m_previous(window_size, 0)
+    {
+        m_buffer.reserve(2 * window_size);
+
+        // zlib header: deflate with a 32K window, no dictionary.
+        m_pending.push_back(0x78);
+        m_pending.push_back(0x01);
+    }
+
+    void deflate_stream::write(const void* data, size_t length)
+    {
+        if (m_finished)
+        {
+            throw std::logic_error("deflate_stream::write: the stream is finished");
+        }
+        m_adler.update(data, length);
+
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        while (length > 0)
+        {
+            size_t count = std::min(length, 2 * window_size - m_buffer.size());
+            m_buffer.insert(m_buffer.end(), bytes, bytes + count);
+            bytes += count;
+            length -= count;
+            if (m_buffer.size() == 2 * window_size)
+            {
+                compress(false);
+            }
+        }
+    }
+
+    void deflate_stream::finish()
+    {
+        if (m_finished)
+        {
+            return;
+        }
+        compress(true);
+        m_finished = true;
+
+        // Pad to a byte, then the checksum of the uncompressed data.
+        put_bits(0, (8 - m_bit_count % 8) % 8);
+        uint32_t check = m_adler.value();
+        for (int shift = 24; shift >= 0; shift -= 8)
+        {
+            put_bits((check >> shift) & 0xff, 8);
+        }
+        flush_output();
+        m_buffer.clear();
+    }
+
+    size_t deflate_stream::hash_at(uint64_t position) const
+    {
+        const uint8_t* p = m_buffer.data() + (position - m_base);
+        return ((size_t(p[0]) << 10) ^ (size_t(p[1]) << 5) ^ p[2]) & (hash_size - 1);
+    }
+
+    void deflate_stream::insert_hash(uint64_t position)
+    {
+        size_t h = hash_at(position);
+        m_previous[position & (window_size - 1)] = m_head[h];
+        m_head[h] = position + 1;
+    }
+
+    size_t deflate_stream::longest_match(uint64_t position, uint64_t end, size_t& distance) const
+    {
+        const size_t limit = size_t(std::min<uint64_t>(max_match, end - position));
+        if (limit < min_match)
+        {
+            return 0;
+        }
+        const uint64_t oldest = std::max<uint64_t>(m_base, (position > window_size) ? position - window_size : 0);
+        const uint8_t* here = m_buffer.data() + (position - m_base);
+
+        size_t best = 0;
+        uint64_t candidate = m_head[hash_at(position)];
+        for (size_t chain = 0; (chain < max_chain) && (candidate > oldest); ++chain)
+        {
+            uint64_t start = candidate - 1;
+            const uint8_t* there = m_buffer.data() + (start - m_base);
+            if (there[best] == here[best])
+            {
+                size_t length = 0;
+                while ((length < limit) && (there[length] == here[length]))
+                {
+                    ++length;
+                }
+                if (length > best)
+                {
+                    best = length;
+                    distance = size_t(position - start);
+                    if (best == limit)
+                    {
+                        break;
+                    }
+                }
+            }
+            uint64_t next = m_previous[start & (window_size - 1)];
+            // Entries in the ring that have been overwritten by newer
+            // positions would point forwards.
+            if (next >= candidate)
+            {
+                break;
+            }
+            candidate = next;
+        }
+        return (best >= min_match) ? best : 0;
+    }
+
+    void deflate_stream::compress(bool final)
+    {
+        const uint64_t end = m_base + m_buffer.size();
+        // Until the end of the stream, stop where a match could still be
+        // extended by input that has not arrived yet.
+        const uint64_t stop = final ? end : end - max_match;
+
+        // A block with the fixed Huffman codes.
+        put_bits(final ? 1 : 0, 1);
+        put_bits(1, 2);
+
+        while (m_position < stop)
+        {
+            size_t distance = 0;
+            size_t length = longest_match(m_position, end, distance);
+            if (length > 0)
+            {
+                put_match(length, distance);
+            }
+            else
+            {
+                put_literal_length(m_buffer[m_position - m_base]);
+                length = 1;
+            }
+            for (uint64_t p = m_position; p < m_position + length; ++p)
+            {
+                if (p + min_match <= end)
+                {
+                    insert_hash(p);
+                }
+            }
+            m_position += length;
+        }
+        put_literal_length(256);
+
+        if (!final && (m_position - m_base > window_size))
+        {
+            // Keep one window of history.
+            size_t discard = size_t(m_position - m_base - window_size);
+            m_buffer.erase(m_buffer.begin(), m_buffer.begin() + discard);
+            m_base += discard;
+        }
+        flush_output();
+    }
+
+    void deflate_stream::put_bits(uint32_t bits, unsigned count)
+    {
+        m_bits |= uint64_t(bits) << m_bit_count;
+        m_bit_count += count;
+        while (m_bit_count >= 8)
+        {
+            m_pending.push_back(uint8_t(m_bits & 0xff));
+            m_bits >>= 8;
+            m_bit_count -= 8;
+        }
+    }
+
+    // Huffman codes are stored starting from their most significant bit.
+    void deflate_stream::put_huffman(uint32_t code, unsigned length)
+    {
+        uint32_t reversed = 0;
+        for (unsigned i = 0; i < length; ++i)
+        {
+            reversed = (reversed << 1) | ((code >> i) & 1);
+        }
+        put_bits(reversed, length);
+    }
+
+    void deflate_stream::put_literal_length(unsigned symbol)
+    {
+        if (symbol < 144)
+        {
+            put_huffman(0x30 + symbol, 8);
+        }
+        else if (symbol < 256)
+        {
+            put_huffman(0x190 + (symbol - 144), 9);
+        }
+        else if (symbol < 280)
+        {
+            put_huffman(symbol - 256, 7);
+        }
+        else
+        {
+            put_huffman(0xc0 + (symbol - 280), 8);
+        }
+    }
+
+    void deflate_stream::put_match(size_t length, size_t distance)
+    {
+        size_t lcode = code_for(length_base, length);
+        put_literal_length(unsigned(257 + lcode));
+        put_bits(uint32_t(length - length_base[lcode]), length_extra[lcode]);
+
+        size_t dcode = code_for(distance_base, distance);
+        put_huffman(uint32_t(dcode), 5);
+        put_bits(uint32_t(distance - distance_base[dcode]), distance_extra[dcode]);
+    }
+
+    void deflate_stream::flush_output()
+    {
+        if (!m_pending.empty())
+        {
+            m_output(m_pending.data(), m_pending.size());
+            m_pending.clear();
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "general/checksum.hpp"
+
+namespace amethyst
+{
+    /**
+     * Compresses data into a zlib stream (RFC 1950/1951) as it is written,
+     * holding no more than two 32K windows of it at a time.  This is the
+     * compression PNG needs for its image data, for writers that get their
+     * rows one at a time.
+     *
+     * Matches are found with hash chains and coded with the fixed Huffman
+     * codes, which is about what stb_image_write does with a whole image.
+     * Compressed data is passed to the output function as it is produced.
+     */
+    class deflate_stream
+    {
+    public:
+        using output_function = std::function<void(const uint8_t* data, size_t length)>;
+
+        explicit deflate_stream(output_function output);
+
+        deflate_stream(const deflate_stream&) = delete;
+        deflate_stream& operator=(const deflate_stream&) = delete;
+
+        void write(const void* data, size_t length);
+
+        // End the stream.  Nothing can be written after this.
+        void finish();
+
+    private:
+        static constexpr size_t window_size = 32768;
+        static constexpr size_t hash_size = 1 << 15;
+        static constexpr size_t min_match = 3;
+        static constexpr size_t max_match = 258;
+        static constexpr size_t max_chain = 64;
+
+        void compress(bool final);
+        void insert_hash(uint64_t position);
+        size_t hash_at(uint64_t position) const;
+        size_t longest_match(uint64_t position, uint64_t end, size_t& distance) const;
+
+        void put_bits(uint32_t bits, unsigned count);
+        void put_huffman(uint32_t code, unsigned length);
+        void put_literal_length(unsigned symbol);
+        void put_match(size_t length, size_t distance);
+        void flush_output();
+
+        output_function m_output;
+        adler32 m_adler;
+        bool m_finished = false;
+
+        // The input, from absolute stream position m_base.  Everything before
+        // m_position has been compressed, and is kept as history for matches.
+        std::vector<uint8_t> m_buffer;
+        uint64_t m_base = 0;
+        uint64_t m_position = 0;
+
+        // Hash chains of absolute positions plus one (0 ends a chain).
+        std::vector<uint64_t> m_head;
+        std::vector<uint64_t> m_previous;
+
+        uint64_t m_bits = 0;
+        unsigned m_bit_count = 0;
+        std::vector<uint8_t> m_pending;
+    };
+}
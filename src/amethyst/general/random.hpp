@@ -132,7 +132,14 @@ namespace amethyst
         virtual ~standard_random() = default;
 
         using random<T>::next_int;
-        uint32_t next_int() override { return m_rand(); }
+        // The conversions in random<T> expect 31 bit values.
+        uint32_t next_int() override
+        {
+            if constexpr (StdRand::max() > 0x7fffffffu)
+                return uint32_t(m_rand() >> 1);
+            else
+                return uint32_t(m_rand());
+        }
         void set_seed(uint32_t seed) override { m_rand.seed(seed); }
         std::unique_ptr<random<T>> clone_new() const
         {
@@ -0,0 +1,31 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "general/checksum.hpp"
+#include <string>
+
+using namespace amethyst;
+
+AUTO_UNIT_TEST(known_checksums)
+{
+    const std::string digits = "123456789";
+    TEST_COMPARE_EQUAL(crc32::of(digits.data(), digits.size()), 0xCBF43926u);
+    TEST_COMPARE_EQUAL(adler32::of("Wikipedia", 9), 0x11E60398u);
+    TEST_COMPARE_EQUAL(crc32::of(nullptr, 0), 0u);
+    TEST_COMPARE_EQUAL(adler32::of(nullptr, 0), 1u);
+
+    // In pieces, and long enough for the adler32 sums to be reduced.
+    std::string data;
+    for (size_t i = 0; i < 100000; ++i)
+    {
+        data.push_back(char(255 - i % 7));
+    }
+    crc32 crc;
+    adler32 adler;
+    for (size_t i = 0; i < data.size(); i += 1000)
+    {
+        crc.update(data.data() + i, 1000);
+        adler.update(data.data() + i, 1000);
+    }
+    TEST_COMPARE_EQUAL(crc.value(), crc32::of(data.data(), data.size()));
+    TEST_COMPARE_EQUAL(adler.value(), adler32::of(data.data(), data.size()));
+}
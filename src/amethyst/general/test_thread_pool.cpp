@@ -0,0 +1,63 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "general/thread_pool.hpp"
+#include <atomic>
+#include <stdexcept>
+
+using namespace amethyst;
+
+AUTO_UNIT_TEST(thread_pool_runs_everything)
+{
+    thread_pool pool(4);
+    TEST_COMPARE_EQUAL(pool.size(), size_t(4));
+
+    std::atomic<int> count(0);
+    for (int i = 0; i < 1000; ++i)
+    {
+        pool.submit([&]() { ++count; });
+    }
+    pool.wait();
+    TEST_COMPARE_EQUAL(count.load(), 1000);
+
+    // The pool is reusable once it has drained.
+    for (int i = 0; i < 10; ++i)
+    {
+        pool.submit([&]() { ++count; });
+    }
+    pool.wait();
+    TEST_COMPARE_EQUAL(count.load(), 1010);
+}
+
+AUTO_UNIT_TEST(thread_pool_nested_submit)
+{
+    thread_pool pool(3);
+    std::atomic<int> count(0);
+    for (int i = 0; i < 10; ++i)
+    {
+        pool.submit([&]()
+        {
+            for (int j = 0; j < 10; ++j)
+            {
+                pool.submit([&]() { ++count; });
+            }
+        });
+    }
+    pool.wait();
+    TEST_COMPARE_EQUAL(count.load(), 100);
+}
+
+AUTO_UNIT_TEST(thread_pool_rethrows)
+{
+    thread_pool pool(2);
+    std::atomic<int> count(0);
+    pool.submit([]() { throw std::runtime_error("task failure"); });
+    for (int i = 0; i < 10; ++i)
+    {
+        pool.submit([&]() { ++count; });
+    }
+    TEST_EXCEPTION_THROW_SPECIFIC(pool.wait(), std::runtime_error);
+    TEST_COMPARE_EQUAL(count.load(), 10);
+
+    // The failure is only reported once.
+    pool.wait();
+}
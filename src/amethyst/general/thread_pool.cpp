@@ -0,0 +1,188 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+
+namespace amethyst
+{
+    namespace
+    {
+        // Identifies the pool (and queue) owned by the current thread, if any.
+        thread_local const thread_pool* g_current_pool = nullptr;
+        thread_local size_t g_current_queue = 0;
+    }
+
+    thread_pool::thread_pool(size_t thread_count)
+    {
+        if (thread_count == 0)
+        {
+            thread_count = default_thread_count();
+        }
+
+        m_queues.reserve(thread_count);
+        for (size_t i = 0; i < thread_count; ++i)
+        {
+            m_queues.push_back(std::make_unique<task_queue>());
+        }
+
+        m_threads.reserve(thread_count);
+        for (size_t i = 0; i < thread_count; ++i)
+        {
+            m_threads.emplace_back([this, i]() { worker_loop(i); });
+        }
+    }
+
+    thread_pool::~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(m_state_lock);
+            m_stopping = true;
+        }
+        m_work_available.notify_all();
+
+        for (auto& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    size_t thread_pool::default_thread_count()
+    {
+        return std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    void thread_pool::submit(task_type task)
+    {
+        size_t index;
+        if (g_current_pool == this)
+        {
+            index = g_current_queue;
+        }
+        else
+        {
+            std::lock_guard<std::mutex> guard(m_state_lock);
+            index = m_next_queue;
+            m_next_queue = (m_next_queue + 1) % m_queues.size();
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(m_queues[index]->lock);
+            m_queues[index]->tasks.push_back(std::move(task));
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(m_state_lock);
+            ++m_unclaimed;
+            ++m_outstanding;
+        }
+        m_work_available.notify_one();
+    }
+
+    void thread_pool::wait()
+    {
+        {
+            std::unique_lock<std::mutex> guard(m_state_lock);
+            m_work_finished.wait(guard, [this]() { return m_outstanding == 0; });
+        }
+        rethrow_failure();
+    }
+
+    bool thread_pool::wait_for(std::chrono::milliseconds timeout)
+    {
+        {
+            std::unique_lock<std::mutex> guard(m_state_lock);
+            if (!m_work_finished.wait_for(guard, timeout, [this]() { return m_outstanding == 0; }))
+            {
+                return false;
+            }
+        }
+        rethrow_failure();
+        return true;
+    }
+
+    void thread_pool::rethrow_failure()
+    {
+        std::exception_ptr failure;
+        {
+            std::lock_guard<std::mutex> guard(m_state_lock);
+            std::swap(failure, m_failure);
+        }
+        if (failure)
+        {
+            std::rethrow_exception(failure);
+        }
+    }
+
+    thread_pool::task_type thread_pool::take_task(size_t index)
+    {
+        // The caller has already claimed a task, so one is guaranteed to be
+        // sitting in some queue.  Look in our own queue first (newest task),
+        // then steal the oldest task from the others.
+        while (true)
+        {
+            for (size_t offset = 0; offset < m_queues.size(); ++offset)
+            {
+                task_queue& queue = *m_queues[(index + offset) % m_queues.size()];
+                std::lock_guard<std::mutex> guard(queue.lock);
+                if (!queue.tasks.empty())
+                {
+                    task_type task;
+                    if (offset == 0)
+                    {
+                        task = std::move(queue.tasks.back());
+                        queue.tasks.pop_back();
+                    }
+                    else
+                    {
+                        task = std::move(queue.tasks.front());
+                        queue.tasks.pop_front();
+                    }
+                    return task;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    void thread_pool::worker_loop(size_t index)
+    {
+        g_current_pool = this;
+        g_current_queue = index;
+
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> guard(m_state_lock);
+                m_work_available.wait(guard, [this]() { return m_stopping || m_unclaimed > 0; });
+                if (m_unclaimed == 0)
+                {
+                    // Stopping, and nothing left to do.
+                    return;
+                }
+                --m_unclaimed;
+            }
+
+            task_type task = take_task(index);
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> guard(m_state_lock);
+                if (!m_failure)
+                {
+                    m_failure = std::current_exception();
+                }
+            }
+
+            bool finished;
+            {
+                std::lock_guard<std::mutex> guard(m_state_lock);
+                finished = (--m_outstanding == 0);
+            }
+            if (finished)
+            {
+                m_work_finished.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace amethyst
+{
+    /**
+     * A fixed-size pool of worker threads with per-thread task queues.
+     *
+     * Each worker pulls the most recently queued task from its own queue and,
+     * when that runs dry, steals the oldest task from one of the other
+     * workers.  Tasks submitted from outside the pool are dealt round-robin
+     * into the queues; tasks submitted from a worker go to that worker's own
+     * queue.
+     *
+     * The first exception thrown by a task is captured and rethrown by the
+     * next call to wait().
+     */
+    class thread_pool
+    {
+    public:
+        using task_type = std::function<void()>;
+
+        // A thread_count of 0 uses default_thread_count().
+        explicit thread_pool(size_t thread_count = 0);
+        ~thread_pool();
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        // The number of threads the hardware can run concurrently (at least 1).
+        static size_t default_thread_count();
+
+        size_t size() const { return m_threads.size(); }
+
+        void submit(task_type task);
+
+        // Block until every submitted task has completed.
+        void wait();
+
+        // Block until every submitted task has completed or the timeout has
+        // elapsed.  Returns true if everything completed.
+        bool wait_for(std::chrono::milliseconds timeout);
+
+    private:
+        struct task_queue
+        {
+            std::mutex lock;
+            std::deque<task_type> tasks;
+        };
+
+        void worker_loop(size_t index);
+        task_type take_task(size_t index);
+        void rethrow_failure();
+
+        std::vector<std::unique_ptr<task_queue>> m_queues;
+        std::vector<std::thread> m_threads;
+
+        std::mutex m_state_lock;
+        std::condition_variable m_work_available;
+        std::condition_variable m_work_finished;
+        // Tasks sitting in a queue that no worker has claimed yet.
+        size_t m_unclaimed = 0;
+        // Tasks that have been submitted but not yet completed.
+        size_t m_outstanding = 0;
+        size_t m_next_queue = 0;
+        bool m_stopping = false;
+        std::exception_ptr m_failure;
+    };
+}
@@ -6,13 +6,26 @@
 #include "amethyst/general/string_format.hpp"
 #include "amethyst/general/random.hpp"
 #include "amethyst/graphics/alpha_triangle_2d.hpp"
+#include "amethyst/graphics/image_metrics.hpp"
+#include "amethyst/graphics/image_scale.hpp"
+#include "amethyst/general/thread_pool.hpp"
+#include "amethyst/general/checksum.hpp"
+#include "amethyst/graphics/mapped_raster.hpp"
 
 #include <string>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <future>
 #include <limits>
 #include <map>
+#include <sstream>
 
 using namespace amethyst;
 
@@ -21,6 +34,13 @@ using number_type = double;
 using color = rgbcolor<number_type>;
 using alpha_triangle = alpha_triangle_2d<number_type>;
 
+// Evaluate at 1/divisor of the reference size until the given generation.
+struct pyramid_step
+{
+    size_t divisor;
+    size_t until_generation;
+};
+
 struct globals
 {
     number_type birth_rate = 0.1;
@@ -37,21 +57,19 @@ struct globals
     size_t max_population_size = 300;
     size_t width = 0;
     size_t height = 0;
+    // The threads used to evaluate the population (0 for one per core).
+    size_t threads = 0;
+    // Redraw only the parts of children that differ from their parents.
+    bool incremental = true;
+    // The reduced resolutions to evaluate at in early generations, in order
+    // of generation (empty to always use the full size).
+    std::vector<pyramid_step> pyramid;
+    // Write the population file as text instead of binary.
+    bool text_population = false;
     std::shared_ptr<image_io<number_type>> io;
 } GLOBALS;
 
-// Add the term to the current sum, add the dropped bits to the correction
-// term, and return the new sum
-template <typename T>
-inline T corrected_sum(T current_sum, T term, T& correction)
-{
-    volatile T sum1 = current_sum + term;
-    // In an ideal world, this would be zero: (x - (x + t) + t)
-    correction += (current_sum - sum1) + term;
-    return sum1;
-}
-
-void rasterize_triangles(std::vector<alpha_triangle> triangles, image<number_type>& img)
+void rasterize_triangles(const std::vector<alpha_triangle>& triangles, image<number_type>& img)
 {
     // Blank the image...
     size_t num_pixels = img.get_width() * img.get_height();
@@ -91,40 +109,25 @@ void generate_random_triangles(std::vector<alpha_triangle>& triangles,
     }
 }
 
-inline color squared_difference(const color& c1, const color& c2)
-{
-    /*
-       return color(
-        ((c1.r() - c2.r()) * (c1.r() - c2.r())),
-        ((c1.g() - c2.g()) * (c1.g() - c2.g())),
-        ((c1.b() - c2.b()) * (c1.b() - c2.b())));
-     */
-    return color(
-        fabs(c1.r() - c2.r()),
-        fabs(c1.g() - c2.g()),
-        fabs(c1.b() - c2.b()));
-}
-
+// The error of an image is the sum of the absolute channel differences,
+// scaled to a byte range.
 number_type calculate_error(const image<number_type>& ref, const image<number_type>& img)
 {
-    number_type error(0);
-    number_type addition_error(0);
-
-    size_t width = ref.get_width();
-    size_t height = ref.get_height();
+    return number_type(256 * image_difference(ref, img, image_metric::l1));
+}
 
-    const color* ref_pixels = ref.raw_data();
-    const color* img_pixels = img.raw_data();
+struct pleb_rendering;
 
-    size_t max_pixel = width * height;
-    for (size_t i = 0; i < max_pixel; ++i)
+// The error of part of an image.
+number_type calculate_error(const image<number_type>& ref, const image<number_type>& img, const pixel_region& region)
+{
+    if (region.empty())
     {
-        color difference = 256 * squared_difference(ref_pixels[i], img_pixels[i]);
-        error = corrected_sum(error,
-                              difference.r() + difference.g() + difference.b(),
-                              addition_error);
+        return 0;
     }
-    return error + addition_error;
+    return number_type(256 * image_difference(ref.view(region.x_begin, region.y_begin, region.x_end - 1, region.y_end - 1),
+                                              img.view(region.x_begin, region.y_begin, region.x_end - 1, region.y_end - 1),
+                                              image_metric::l1));
 }
 
 struct pleb
@@ -173,6 +176,10 @@ struct pleb
 
     std::vector<pleb_data_entry> pleb_data;
 
+    // How the pleb looked when it was last evaluated (if it was), shared
+    // with the children copied from it.
+    std::shared_ptr<pleb_rendering> rendering;
+
     pleb()
         : error(std::numeric_limits<number_type>::max())
         , pleb_data()
@@ -186,6 +193,18 @@ struct pleb
     }
 };
 
+struct pleb_rendering
+{
+    std::vector<pleb::pleb_data_entry> pleb_data;
+    amethyst::image<number_type> image;
+    number_type error;
+};
+
+bool same_entry(const pleb::pleb_data_entry& e1, const pleb::pleb_data_entry& e2)
+{
+    return std::equal(e1.raw_data, e1.raw_data + 18, e2.raw_data);
+}
+
 typedef std::vector<pleb> population;
 
 
@@ -220,23 +239,30 @@ std::istream& operator>>(std::istream& input, pleb& p)
 }
 
 
-void convert_to_triangles(pleb& p, std::vector<alpha_triangle>& output, size_t image_width, size_t image_height)
+alpha_triangle convert_to_triangle(const pleb::pleb_data_entry& e, size_t image_width, size_t image_height)
+{
+    alpha_triangle t;
+    t.v1.rgb.set( e.pleb_verts[0].r, e.pleb_verts[0].g, e.pleb_verts[0].b);
+    t.v1.xy.set( e.pleb_verts[0].x / 100.0 * image_width, e.pleb_verts[0].y / 100.0 * image_height);
+    t.v1.a = e.pleb_verts[0].a;
+
+    t.v2.rgb.set( e.pleb_verts[1].r, e.pleb_verts[1].g, e.pleb_verts[1].b);
+    t.v2.xy.set( e.pleb_verts[1].x / 100.0 * image_width, e.pleb_verts[1].y / 100.0 * image_height);
+    t.v2.a = e.pleb_verts[1].a;
+
+    t.v3.rgb.set( e.pleb_verts[2].r, e.pleb_verts[2].g, e.pleb_verts[2].b);
+    t.v3.xy.set(e.pleb_verts[2].x / 100.0 * image_width, e.pleb_verts[2].y / 100.0 * image_height);
+    t.v3.a = e.pleb_verts[2].a;
+    return t;
+}
+
+void convert_to_triangles(const pleb& p, std::vector<alpha_triangle>& output, size_t image_width, size_t image_height)
 {
     size_t triangles = p.pleb_data.size();
     output.resize(triangles);
     for (size_t i = 0; i < triangles; ++i)
     {
-        output[i].v1.rgb.set( p.pleb_data[i].pleb_verts[0].r, p.pleb_data[i].pleb_verts[0].g, p.pleb_data[i].pleb_verts[0].b);
-        output[i].v1.xy.set( p.pleb_data[i].pleb_verts[0].x / 100.0 * image_width, p.pleb_data[i].pleb_verts[0].y / 100.0 * image_height);
-        output[i].v1.a = p.pleb_data[i].pleb_verts[0].a;
-
-        output[i].v2.rgb.set( p.pleb_data[i].pleb_verts[1].r, p.pleb_data[i].pleb_verts[1].g, p.pleb_data[i].pleb_verts[1].b);
-        output[i].v2.xy.set( p.pleb_data[i].pleb_verts[1].x / 100.0 * image_width, p.pleb_data[i].pleb_verts[1].y / 100.0 * image_height);
-        output[i].v2.a = p.pleb_data[i].pleb_verts[1].a;
-
-        output[i].v3.rgb.set( p.pleb_data[i].pleb_verts[2].r, p.pleb_data[i].pleb_verts[2].g, p.pleb_data[i].pleb_verts[2].b);
-        output[i].v3.xy.set(p.pleb_data[i].pleb_verts[2].x / 100.0 * image_width, p.pleb_data[i].pleb_verts[2].y / 100.0 * image_height);
-        output[i].v3.a = p.pleb_data[i].pleb_verts[2].a;
+        output[i] = convert_to_triangle(p.pleb_data[i], image_width, image_height);
     }
 }
 
@@ -292,7 +318,8 @@ void random_cross(const pleb& p1, const pleb& p2, size_t points, size_t count, s
     // Generate some random crossover points, all unique.
     std::vector<size_t> point_locations;
     point_locations.reserve(points);
-    const size_t num_data_points = p1.pleb_data.size() * 18;
+    // Only the genes both parents have can be swapped between the children.
+    const size_t num_data_points = std::min(p1.pleb_data.size(), p2.pleb_data.size()) * 18;
     //	std::cout << "Generating " << points << " points between 1 and " << num_data_points << std::endl;
 
     unique_random_list(point_locations, 1, num_data_points, points, rnd);
@@ -358,89 +385,298 @@ struct pleb_data
 {
     size_t pleb_index = 0;
     number_type error = 0;
-    amethyst::image<number_type> image;
 };
 
+// Sorts by error, and then by index, so the order does not depend on which
+// thread evaluated which pleb.
 bool pleb_is_better(const pleb_data& p1, const pleb_data& p2)
 {
-    return p1.error < p2.error;
+    return (p1.error < p2.error) || ((p1.error == p2.error) && (p1.pleb_index < p2.pleb_index));
 }
 
 bool pleb_is_worse(const pleb_data& p1, const pleb_data& p2)
 {
-    return p1.error > p2.error;
+    return (p1.error > p2.error) || ((p1.error == p2.error) && (p1.pleb_index < p2.pleb_index));
 }
 
-void add_to_statistics(
-    const pleb_data& data,
-    size_t count_of_each,
-    std::vector<pleb_data>& best,
-    std::vector<pleb_data>& worst)
+// Rasterizes plebs and measures their error against a reference.  Each
+// worker thread has its own image and triangle list, which are reused from
+// one generation to the next.
+//
+// When incremental, each pleb keeps its image and error.  A pleb that was
+// evaluated before (or copied from one that was) only has the area covered
+// by its changed triangles redrawn, and its error adjusted by the difference
+// in that area, so a small mutation costs about as much as the triangles it
+// moved rather than the whole image.
+//
+// The errors are multiplied by error_scale, so that errors measured on a
+// reduced reference estimate those of the full size one.
+class pleb_evaluator
 {
-    if (best.empty())
+public:
+    struct statistics
+    {
+        size_t unchanged = 0;
+        size_t partial = 0;
+        size_t full = 0;
+        // The pixels redrawn by the partial evaluations.
+        size_t partial_pixels = 0;
+    };
+
+    pleb_evaluator(size_t width, size_t height, size_t threads, bool incremental, number_type error_scale = 1)
+        : width(width)
+        , height(height)
+        , incremental(incremental)
+        , error_scale(error_scale)
     {
-        best.push_back(data);
+        if (threads == 0)
+        {
+            threads = thread_pool::default_thread_count();
+        }
+        if (threads > 1)
+        {
+            pool = std::make_unique<thread_pool>(threads);
+        }
+        for (size_t i = 0; i < threads; ++i)
+        {
+            scratch.emplace_back(width, height);
+        }
     }
-    else
+
+    size_t threads() const { return scratch.size(); }
+
+    // Set the error of every pleb in the population.
+    void evaluate(population& populous, const image<number_type>& reference)
     {
-        best.push_back(data);
-        std::sort(best.begin(), best.end(), &pleb_is_better);
-        if (best.size() > count_of_each)
+        unchanged = 0;
+        partial = 0;
+        full = 0;
+        partial_pixels = 0;
+
+        // Which renderings are shared is decided here, before any worker
+        // starts, as the use counts change while the workers replace them.
+        // No worker writes to a shared rendering; each pleb using one makes
+        // its own copy when it has to change it.
+        shared_rendering.assign(populous.size(), 0);
+        for (size_t i = 0; i < populous.size(); ++i)
         {
-            best.erase(best.begin() + count_of_each, best.end());
+            shared_rendering[i] = populous[i].rendering && (populous[i].rendering.use_count() > 1);
         }
+
+        if (!pool)
+        {
+            evaluate_range(populous, reference, scratch[0], 0, populous.size());
+            return;
+        }
+
+        // Plebs differ in size, so the workers take them one at a time
+        // rather than as fixed ranges.
+        std::atomic<size_t> next(0);
+        for (worker_scratch& s : scratch)
+        {
+            pool->submit([&, this]()
+                {
+                    for (size_t i = next++; i < populous.size(); i = next++)
+                    {
+                        evaluate_range(populous, reference, s, i, i + 1);
+                    }
+                });
+        }
+        pool->wait();
     }
-    if (worst.empty())
+
+    // What the last evaluate() did.
+    statistics last_statistics() const
     {
-        worst.push_back(data);
+        statistics result;
+        result.unchanged = unchanged;
+        result.partial = partial;
+        result.full = full;
+        result.partial_pixels = partial_pixels;
+        return result;
     }
-    else
+
+    // The image of a pleb.
+    image<number_type> render(const pleb& p)
+    {
+        worker_scratch& s = scratch[0];
+        convert_to_triangles(p, s.triangles, width, height);
+        rasterize_triangles(s.triangles, s.image);
+        return s.image;
+    }
+
+private:
+    struct worker_scratch
+    {
+        worker_scratch(size_t width, size_t height) : image(width, height) { }
+
+        amethyst::image<number_type> image;
+        std::vector<alpha_triangle> triangles;
+    };
+
+    void evaluate_range(population& populous, const image<number_type>& reference, worker_scratch& s, size_t first, size_t last)
     {
-        worst.push_back(data);
-        std::sort(worst.begin(), worst.end(), &pleb_is_worse);
-        if (worst.size() > count_of_each)
+        for (size_t i = first; i < last; ++i)
         {
-            worst.erase(worst.begin() + count_of_each, worst.end());
+            pleb& p = populous[i];
+            convert_to_triangles(p, s.triangles, width, height);
+            // Renderings from an evaluator of another size are of no use.
+            if (p.rendering && ((p.rendering->image.get_width() != width) || (p.rendering->image.get_height() != height)))
+            {
+                p.rendering.reset();
+            }
+            if (!incremental)
+            {
+                rasterize_triangles(s.triangles, s.image);
+                p.error = error_scale * calculate_error(reference, s.image);
+                ++full;
+            }
+            else if (!p.rendering || !redraw_changes(p, shared_rendering[i], reference, s.triangles))
+            {
+                // A rendering shared with other plebs is left for them.
+                if (!p.rendering || shared_rendering[i])
+                {
+                    p.rendering = std::make_shared<pleb_rendering>();
+                    p.rendering->image = image<number_type>(width, height);
+                }
+                rasterize_triangles(s.triangles, p.rendering->image);
+                p.rendering->pleb_data = p.pleb_data;
+                p.rendering->error = calculate_error(reference, p.rendering->image);
+                p.error = error_scale * p.rendering->error;
+                ++full;
+            }
         }
     }
 
-}
+    // Update the pleb's rendering by redrawing the area its changed
+    // triangles cover, unless that is most of the image (or it is not
+    // worth it), returning false if it was not updated.
+    bool redraw_changes(pleb& p, bool shared, const image<number_type>& reference, const std::vector<alpha_triangle>& triangles)
+    {
+        const pleb_rendering& previous = *p.rendering;
+        pixel_region dirty;
+        const size_t count = std::max(previous.pleb_data.size(), p.pleb_data.size());
+        for (size_t i = 0; i < count; ++i)
+        {
+            const bool in_previous = i < previous.pleb_data.size();
+            const bool in_current = i < p.pleb_data.size();
+            if (in_previous && in_current && same_entry(previous.pleb_data[i], p.pleb_data[i]))
+            {
+                continue;
+            }
+            if (in_previous)
+            {
+                dirty = merge_regions(dirty, triangle_region(convert_to_triangle(previous.pleb_data[i], width, height), width, height));
+            }
+            if (in_current)
+            {
+                dirty = merge_regions(dirty, triangle_region(triangles[i], width, height));
+            }
+        }
+
+        if (dirty.empty())
+        {
+            p.error = error_scale * previous.error;
+            ++unchanged;
+            return true;
+        }
+        if (dirty.pixels() > width * height / 2)
+        {
+            return false;
+        }
+
+        // Copy the rendering, unless this pleb is the only one using it.
+        if (shared)
+        {
+            p.rendering = std::make_shared<pleb_rendering>(previous);
+        }
+        pleb_rendering& current = *p.rendering;
+
+        // Take the error of the old pixels out, redraw them, and add the
+        // error of the new ones.
+        number_type error = current.error - calculate_error(reference, current.image, dirty);
+        for (size_t y = dirty.y_begin; y < dirty.y_end; ++y)
+        {
+            for (size_t x = dirty.x_begin; x < dirty.x_end; ++x)
+            {
+                current.image(x, y).set(0, 0, 0);
+            }
+        }
+        for (const alpha_triangle& t : triangles)
+        {
+            const pixel_region clip = intersect_regions(dirty, triangle_region(t, width, height));
+            if (!clip.empty())
+            {
+                dda_rasterize_triangle(current.image, t, clip);
+            }
+        }
+        error += calculate_error(reference, current.image, dirty);
+
+        current.pleb_data = p.pleb_data;
+        current.error = error;
+        p.error = error_scale * error;
+        ++partial;
+        partial_pixels += dirty.pixels();
+        return true;
+    }
+
+    size_t width;
+    size_t height;
+    bool incremental;
+    number_type error_scale;
+    std::unique_ptr<thread_pool> pool;
+    std::vector<worker_scratch> scratch;
+    // For each pleb, whether its rendering was shared when evaluate began.
+    std::vector<char> shared_rendering;
+    std::atomic<size_t> unchanged{ 0 };
+    std::atomic<size_t> partial{ 0 };
+    std::atomic<size_t> full{ 0 };
+    std::atomic<size_t> partial_pixels{ 0 };
+};
 
 void calculate_population_error(population& populous, const image<number_type>& reference,
                                 size_t count_of_each,
                                 std::vector<pleb_data>& best,
-                                std::vector<pleb_data>& worst)
+                                std::vector<pleb_data>& worst,
+                                pleb_evaluator& evaluator)
 {
-    size_t width = reference.get_width();
-    size_t height = reference.get_height();
-
-    best.clear();
-    worst.clear();
+    std::cout << "Converting and rasterizing " << populous.size() << " plebs..." << std::flush;
+    auto start = std::chrono::steady_clock::now();
+    evaluator.evaluate(populous, reference);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << string_format(" %1s (%2ms per pleb, %3 threads)",
+                               elapsed.count(), 1000 * elapsed.count() / std::max<size_t>(populous.size(), 1), evaluator.threads())
+              << std::endl;
+    const pleb_evaluator::statistics stats = evaluator.last_statistics();
+    if ((stats.unchanged > 0) || (stats.partial > 0))
+    {
+        const size_t image_pixels = reference.get_width() * reference.get_height();
+        std::cout << string_format("%1 unchanged, %2 redrawn in part (%3%% of their pixels), %4 redrawn in full",
+                                   stats.unchanged, stats.partial,
+                                   100.0 * stats.partial_pixels / std::max<size_t>(stats.partial * image_pixels, 1), stats.full)
+                  << std::endl;
+    }
 
-    std::cout << "Converting and rasterizing...";
+    std::vector<pleb_data> all(populous.size());
     for (size_t i = 0; i < populous.size(); ++i)
     {
-        pleb_data data;
-        data.pleb_index = i;
-        data.image = image<number_type>(width, height);
-
-        std::vector<alpha_triangle> triangles;
-        std::cout << "...#" << i << " (" << populous[i].pleb_data.size() << ")" << std::flush;
-        convert_to_triangles(populous[i], triangles, width, height);
-        rasterize_triangles(triangles, data.image);
-        data.error = calculate_error(reference, data.image);
-        populous[i].error = data.error;
-        add_to_statistics(data, count_of_each, best, worst);
+        all[i].pleb_index = i;
+        all[i].error = populous[i].error;
     }
-    std::cout << std::endl;
+    const size_t count = std::min(count_of_each, all.size());
+
+    best = all;
+    std::partial_sort(best.begin(), best.begin() + count, best.end(), &pleb_is_better);
+    best.resize(count);
+
+    worst = all;
+    std::partial_sort(worst.begin(), worst.begin() + count, worst.end(), &pleb_is_worse);
+    worst.resize(count);
 }
 
 image<number_type> get_error_image(const image<number_type>& img1, const image<number_type>& img2)
 {
-    image<number_type> retval(img1.get_width(), img1.get_height());
-
-    const color* in_colors1 = img1.raw_data();
-    const color* in_colors2 = img2.raw_data();
+    image<number_type> retval = difference_image(img1, img2);
     color* out_pixels = retval.reinterpret<color*>();
 
     color max_color = color(-100, -100, -100);
@@ -450,15 +686,13 @@ image<number_type> get_error_image(const image<number_type>& img1, const image<n
 
     for (size_t i = 0; i < num_pixels; ++i)
     {
-        color difference = squared_difference(in_colors1[i], in_colors2[i]);
+        const color& difference = out_pixels[i];
 
         max_color.set_r(std::max(max_color.r(), difference.r()));
         max_color.set_g(std::max(max_color.g(), difference.g()));
         max_color.set_b(std::max(max_color.b(), difference.b()));
 
         error_sum += difference;
-
-        out_pixels[i] = difference;
     }
 
     const color average = error_sum * (1 / number_type(num_pixels));
@@ -488,10 +722,11 @@ void run_generation(population& populous, const image<number_type>& reference,
                     size_t images_to_dump,
                     size_t generation_number,
                     number_type gamma,
-                    image_io<number_type>& io)
+                    image_io<number_type>& io,
+                    pleb_evaluator& evaluator)
 {
     std::cout << "Running generation #" << generation_number << std::endl;
-    calculate_population_error(populous, reference, count_of_each, best, worst);
+    calculate_population_error(populous, reference, count_of_each, best, worst, evaluator);
 
     for (size_t i = 0; i < images_to_dump; ++i)
     {
@@ -500,14 +735,15 @@ void run_generation(population& populous, const image<number_type>& reference,
 
         // Dump the best image...
         std::cout << "Generation " << buffer << ": Best error #" << i << " = " << std::setprecision(3) << std::fixed << best[i].error << " (" << best[i].pleb_index << ")" << std::endl;
-        io.output(string_format("genetic_triangles_best-%1-%2.%3", buffer, i, io.default_extension()), best[i].image, gamma);
+        image<number_type> best_image = evaluator.render(populous[best[i].pleb_index]);
+        io.output(string_format("genetic_triangles_best-%1-%2.%3", buffer, i, io.default_extension()), best_image, gamma);
 
         // Dump the worst image...
         std::cout << "Generation " << buffer << ": Worst error #" << i << " = " << std::setprecision(3) << std::fixed << worst[i].error << " (" << worst[i].pleb_index << ")" << std::endl;
-        io.output(string_format("genetic_triangles_worst-%1-%2.%3", buffer, i, io.default_extension()), worst[i].image, gamma);
+        io.output(string_format("genetic_triangles_worst-%1-%2.%3", buffer, i, io.default_extension()), evaluator.render(populous[worst[i].pleb_index]), gamma);
 
         // Dump the error image...
-        image<number_type> error = get_error_image(reference, best[i].image);
+        image<number_type> error = get_error_image(reference, best_image);
         io.output(string_format("genetic_triangles_error-%1-%2.%3", buffer, i, io.default_extension()), error, gamma);
     }
 
@@ -527,10 +763,234 @@ void write_population(const std::string& filename, const population& populous, s
     output.flush();
 }
 
+// The start of a binary population file.  A population_file_pleb for each
+// pleb follows, and then the triangles of every pleb in order, each as the
+// raw_data of a pleb_data_entry.  Everything is in the byte order of the
+// machine and aligned to its size, so the plebs can be read where the file
+// is mapped.
+struct population_file_header
+{
+    static constexpr char signature[8] = { 'A', 'M', 'G', 'E', 'N', 'P', 'O', 'P' };
+    static constexpr uint32_t current_version = 1;
+
+    char magic[8];
+    uint32_t version;
+    // sizeof(number_type), so that files of float and double builds are
+    // not mixed up.
+    uint32_t value_size;
+    uint64_t generation;
+    uint64_t pleb_count;
+    uint64_t triangle_count;
+    // The crc32 of everything after the header.
+    uint32_t checksum;
+    uint32_t reserved;
+};
+
+struct population_file_pleb
+{
+    double error;
+    uint64_t triangles;
+};
+
+// The bytes of a binary population file, except for the checksum (which is
+// left for the writer, as it takes longer than the copy).
+std::vector<char> serialize_population(const population& populous, size_t generation)
+{
+    size_t triangles = 0;
+    for (const pleb& p : populous)
+    {
+        triangles += p.pleb_data.size();
+    }
+    const size_t entry_size = sizeof(pleb::pleb_data_entry::raw_data);
+    const size_t triangle_offset = sizeof(population_file_header) + populous.size() * sizeof(population_file_pleb);
+    std::vector<char> bytes(triangle_offset + triangles * entry_size);
+
+    population_file_header header = {};
+    std::memcpy(header.magic, population_file_header::signature, sizeof(header.magic));
+    header.version = population_file_header::current_version;
+    header.value_size = sizeof(number_type);
+    header.generation = generation;
+    header.pleb_count = populous.size();
+    header.triangle_count = triangles;
+    std::memcpy(bytes.data(), &header, sizeof(header));
+
+    char* pleb_out = bytes.data() + sizeof(population_file_header);
+    char* triangle_out = bytes.data() + triangle_offset;
+    for (const pleb& p : populous)
+    {
+        population_file_pleb record = { double(p.error), p.pleb_data.size() };
+        std::memcpy(pleb_out, &record, sizeof(record));
+        pleb_out += sizeof(record);
+        for (const pleb::pleb_data_entry& e : p.pleb_data)
+        {
+            std::memcpy(triangle_out, e.raw_data, entry_size);
+            triangle_out += entry_size;
+        }
+    }
+    return bytes;
+}
+
+// Fill in the checksum of serialized population, and write it beside the
+// file before renaming it over, so that an interrupted write leaves the last
+// complete population.
+void write_population_file(const std::string& filename, std::vector<char>& bytes)
+{
+    const size_t header_size = sizeof(population_file_header);
+    const uint32_t checksum = crc32::of(bytes.data() + header_size, bytes.size() - header_size);
+    std::memcpy(bytes.data() + offsetof(population_file_header, checksum), &checksum, sizeof(checksum));
+
+    const std::string temporary = filename + ".tmp";
+    {
+        std::ofstream output(temporary.c_str(), std::ios::binary | std::ios::trunc);
+        output.write(bytes.data(), std::streamsize(bytes.size()));
+        output.flush();
+        if (!output)
+        {
+            throw std::runtime_error("Unable to write population to " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), filename.c_str()) != 0)
+    {
+        throw std::runtime_error("Unable to rename " + temporary + " to " + filename);
+    }
+}
+
+// Writes binary population files on a background thread, one at a time, so
+// that a generation only waits for its population to be copied.  A failed
+// write is reported, and the run continues (as it does for text files), as
+// the next generation writes the whole population again; the last complete
+// file is kept meanwhile.
+class population_writer
+{
+public:
+    explicit population_writer(const std::string& filename)
+        : filename(filename)
+    {
+    }
+
+    ~population_writer()
+    {
+        finish();
+    }
+
+    void write(const population& populous, size_t generation)
+    {
+        std::vector<char> bytes = serialize_population(populous, generation);
+        finish();
+        pending = std::async(std::launch::async, [this, bytes = std::move(bytes)]() mutable
+            {
+                write_population_file(filename, bytes);
+            });
+    }
+
+    // Wait for the last write to complete, returning false (after reporting
+    // why) if it failed.
+    bool finish()
+    {
+        if (!pending.valid())
+        {
+            return true;
+        }
+        try
+        {
+            pending.get();
+            return true;
+        }
+        catch (const std::runtime_error& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return false;
+        }
+    }
+
+private:
+    std::string filename;
+    std::future<void> pending;
+};
+
+// Read a file written by population_writer.
+// @throws std::runtime_error if the file is damaged or from a different
+// version or build.
+void read_binary_population(const std::string& filename, population& populous, size_t& generation)
+{
+    mapped_file file(filename, map_mode::read_only);
+    const char* data = file.data();
+
+    population_file_header header;
+    if (file.size() < sizeof(header))
+    {
+        throw std::runtime_error("Truncated population file: " + filename);
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.version != population_file_header::current_version)
+    {
+        throw std::runtime_error(string_format("Population file %1 is version %2, not %3",
+                                               filename, header.version, population_file_header::current_version));
+    }
+    if (header.value_size != sizeof(number_type))
+    {
+        throw std::runtime_error(string_format("Population file %1 has %2 byte values, not %3",
+                                               filename, header.value_size, sizeof(number_type)));
+    }
+    // The counts are checked against the size before being multiplied, so
+    // that huge counts cannot overflow into a size that matches.
+    const size_t entry_size = sizeof(pleb::pleb_data_entry::raw_data);
+    const size_t data_size = file.size() - sizeof(header);
+    if ((header.pleb_count > data_size / sizeof(population_file_pleb)) ||
+        (header.triangle_count > (data_size - header.pleb_count * sizeof(population_file_pleb)) / entry_size))
+    {
+        throw std::runtime_error("Truncated or invalid population file: " + filename);
+    }
+    const size_t triangle_offset = sizeof(header) + header.pleb_count * sizeof(population_file_pleb);
+    if (file.size() != triangle_offset + header.triangle_count * entry_size)
+    {
+        throw std::runtime_error("Truncated or invalid population file: " + filename);
+    }
+    if (crc32::of(data + sizeof(header), file.size() - sizeof(header)) != header.checksum)
+    {
+        throw std::runtime_error("Bad checksum in population file: " + filename);
+    }
+
+    generation = header.generation;
+    populous.assign(header.pleb_count, pleb());
+    const char* pleb_in = data + sizeof(header);
+    const char* triangle_in = data + triangle_offset;
+    size_t triangles_left = header.triangle_count;
+    for (pleb& p : populous)
+    {
+        population_file_pleb record;
+        std::memcpy(&record, pleb_in, sizeof(record));
+        pleb_in += sizeof(record);
+        if (record.triangles > triangles_left)
+        {
+            throw std::runtime_error("Invalid population file: " + filename);
+        }
+        triangles_left -= record.triangles;
+        p.error = number_type(record.error);
+        p.pleb_data.resize(record.triangles);
+        for (pleb::pleb_data_entry& e : p.pleb_data)
+        {
+            std::memcpy(e.raw_data, triangle_in, entry_size);
+            triangle_in += entry_size;
+        }
+    }
+}
+
+// Read a population written as text or in binary.
 bool read_population(const std::string& filename, population& populous, size_t& generation)
 {
     std::ifstream input(filename.c_str());
 
+    char magic[sizeof(population_file_header::signature)] = {};
+    input.read(magic, sizeof(magic));
+    if (input && (std::memcmp(magic, population_file_header::signature, sizeof(magic)) == 0))
+    {
+        read_binary_population(filename, populous, generation);
+        return true;
+    }
+    input.clear();
+    input.seekg(0);
+
     input >> generation;
 
     size_t size;
@@ -579,6 +1039,20 @@ void mutate_plebs(population& populous, number_type mutation_rate, amethyst::ran
     std::cout << std::endl;
 }
 
+// The divisor of the reference size to evaluate the given generation at,
+// reduced if needed to leave at least one pixel each way.
+size_t divisor_at_generation(size_t generation, size_t width, size_t height)
+{
+    for (const pyramid_step& step : GLOBALS.pyramid)
+    {
+        if (generation < step.until_generation)
+        {
+            return std::max<size_t>(1, std::min(step.divisor, std::min(width, height)));
+        }
+    }
+    return 1;
+}
+
 typedef void (*generation_tweaker)(population& populous, size_t generation, size_t width, size_t height, amethyst::random<number_type>& rnd);
 typedef void (*generation_crosser)(population& populous, size_t generation, const std::vector<pleb_data>& best, const std::vector<pleb_data>& worst, size_t width, size_t height, amethyst::random<number_type>& rnd);
 
@@ -593,15 +1067,34 @@ void run_for_generations(population& populous, const image<number_type>& referen
 {
     const size_t width = reference.get_width();
     const size_t height = reference.get_height();
+    population_writer writer(GLOBALS.population_filename);
+
+    // The reference and evaluator for the current step of the pyramid.
+    size_t divisor = 0;
+    image<number_type> level_reference;
+    std::unique_ptr<pleb_evaluator> evaluator;
 
     for (size_t generation = starting_generation; generation < generations; ++generation)
     {
+        auto start = std::chrono::steady_clock::now();
         std::vector<pleb_data> best;
         std::vector<pleb_data> worst;
 
+        const size_t wanted_divisor = divisor_at_generation(generation, width, height);
+        if (wanted_divisor != divisor)
+        {
+            divisor = wanted_divisor;
+            level_reference = (divisor == 1) ? reference : scale_image(reference, width / divisor, height / divisor, divisor);
+            const size_t level_width = level_reference.get_width();
+            const size_t level_height = level_reference.get_height();
+            evaluator = std::make_unique<pleb_evaluator>(level_width, level_height, GLOBALS.threads, GLOBALS.incremental,
+                                                         number_type(width * height) / number_type(level_width * level_height));
+            std::cout << string_format("Evaluating at 1/%1 size (%2x%3) from generation %4", divisor, level_width, level_height, generation) << std::endl;
+        }
+
         size_t amount_to_cross = size_t(1) << GLOBALS.crossover_points;
 
-        run_generation(populous, reference, best, worst, amount_to_cross, GLOBALS.images_per_generation, generation, gamma, io);
+        run_generation(populous, level_reference, best, worst, amount_to_cross, GLOBALS.images_per_generation, generation, gamma, io, *evaluator);
 
         if ((generation + 1) < generations)
         {
@@ -623,8 +1116,19 @@ void run_for_generations(population& populous, const image<number_type>& referen
             // Do any non-crossing modifications (such as adding new genes).
             modify_generation(populous, generation, width, height, rnd);
         }
-        write_population(GLOBALS.population_filename, populous, generation);
+        if (GLOBALS.text_population)
+        {
+            write_population(GLOBALS.population_filename, populous, generation);
+        }
+        else
+        {
+            writer.write(populous, generation);
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << string_format("Generation %1 took %2s", generation, elapsed.count()) << std::endl;
     }
+    writer.finish();
 }
 
 void cross_best_replace_worst(population& populous, size_t generation, const std::vector<pleb_data>& best, const std::vector<pleb_data>& worst, size_t crossover_points, number_type mutation_rate, size_t width, size_t height, amethyst::random<number_type>& rnd)
@@ -1122,41 +1626,29 @@ double string_to_double(const std::string& s)
     return retval;
 }
 
-image<number_type> scale_image(const image<number_type>& img, size_t width, size_t height, size_t spp = 1)
+// Parse a comma separated list of divisor:generation pairs, in order of
+// generation.
+std::vector<pyramid_step> parse_pyramid_schedule(const std::string& s)
 {
-    image<number_type> dest(width, height);
-
-    size_t source_width = img.get_width();
-    size_t source_height = img.get_height();
-
-    number_type y_factor = source_height / number_type(height);
-    number_type x_factor = source_width / number_type(width);
-    number_type half_spp = number_type(spp) / 2;
-
-    for (unsigned y = 0; y < height; ++y)
+    std::vector<pyramid_step> result;
+    std::istringstream input(s);
+    std::string step;
+    while (std::getline(input, step, ','))
     {
-        for (unsigned x = 0; x < width; ++x)
+        const size_t colon = step.find(':');
+        if (colon == std::string::npos)
         {
-            color target(0, 0, 0);
-            for (unsigned yspp = 0; yspp < spp; ++yspp)
-            {
-                number_type yshift = yspp - half_spp;
-                size_t source_ypos = std::min<size_t>(source_height - 1, std::max<int>(0, int(y_factor * (y + yshift) + 0.5)));
-
-                for (unsigned xspp = 0; xspp < spp; ++xspp)
-                {
-                    number_type xshift = xspp - half_spp;
-                    size_t source_xpos = std::min<size_t>(source_width - 1, std::max<int>(0, int(x_factor * (x + xshift) + 0.5)));
-
-                    target += img(source_xpos, source_ypos);
-                }
-            }
-            target /= number_type(spp * spp);
-            dest(x, y) = target;
+            throw std::runtime_error("invalid pyramid step \"" + step + "\" (expected divisor:generation)");
         }
+        const int divisor = string_to_int(step.substr(0, colon));
+        const int generation = string_to_int(step.substr(colon + 1));
+        if ((divisor < 1) || (generation < 0) || (!result.empty() && (size_t(generation) <= result.back().until_generation)))
+        {
+            throw std::runtime_error("invalid pyramid step \"" + step + "\"");
+        }
+        result.push_back({ size_t(divisor), size_t(generation) });
     }
-
-    return dest;
+    return result;
 }
 
 bool parse_command_line(int argc, const char** argv,
@@ -1181,6 +1673,10 @@ bool parse_command_line(int argc, const char** argv,
     parser.add_optional_arg("children", '\0', "3", "Set the number of children per crossing to [children].  Must be 2 or larger.", "children");
     parser.add_optional_arg("width", '\0', "0", "Set the output image width", "width");
     parser.add_optional_arg("height", '\0', "0", "Set the output image height", "height");
+    parser.add_argless("full-evaluation", '\0', "Redraw every pleb in full each generation, instead of keeping the images (which uses more memory) and redrawing only what changed");
+    parser.add_optional_arg("threads", 'j', "0", "Evaluate the population on [count] threads (at least 1).  The default is one per core", "count");
+    parser.add_argless("text-population", '\0', "Write the population file as text (larger and slower, but readable) instead of binary.  Either can be read by --continue");
+    parser.add_optional_arg("pyramid", '\0', "", "Evaluate early generations on a reduced reference, by a [schedule] of divisor:generation pairs.  For example, 4:500,2:2000 uses a quarter of the size until generation 500, then half until generation 2000, then the full size", "schedule");
 
     bool retval = true;
 
@@ -1208,7 +1704,7 @@ bool parse_command_line(int argc, const char** argv,
         std::cerr << "No input image filename was supplied." << std::endl;
         retval = false;
     }
-    num_generations = string_to_int(parser.get_option_value("max-generations", "1000000"));
+    num_generations = string_to_int(parser.get_option_value("max-generation", "1000000"));
     resume = parser.opt_was_supplied("continue");
     GLOBALS.io = getImageLoader<number_type>(input_file);
     GLOBALS.min_population_size = string_to_int(parser.get_option_value("min-population-size", "300"));
@@ -1224,6 +1720,19 @@ bool parse_command_line(int argc, const char** argv,
     GLOBALS.num_offspring = string_to_int(parser.get_option_value("children", "3"));
     GLOBALS.width = string_to_int(parser.get_option_value("width", "0"));
     GLOBALS.height = string_to_int(parser.get_option_value("height", "0"));
+    if (parser.opt_was_supplied("threads"))
+    {
+        const int threads = string_to_int(parser.get_option_value("threads", "0"));
+        if (threads < 1)
+        {
+            std::cerr << "The thread count must be at least 1." << std::endl;
+            retval = false;
+        }
+        GLOBALS.threads = size_t(std::max(threads, 1));
+    }
+    GLOBALS.incremental = !parser.opt_was_supplied("full-evaluation");
+    GLOBALS.text_population = parser.opt_was_supplied("text-population");
+    GLOBALS.pyramid = parse_pyramid_schedule(parser.get_option_value("pyramid", ""));
 
     if (parser.opt_was_supplied("crossover-points"))
     {
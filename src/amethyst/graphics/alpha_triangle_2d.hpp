@@ -1,4 +1,6 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
 #include "amethyst/math/coord2.hpp"
 #include "amethyst/graphics/rgbcolor.hpp"
 #include "amethyst/graphics/image.hpp"
@@ -21,6 +23,62 @@ namespace amethyst
         alpha_vertex_2d<T> v3;
     };
 
+    /**
+     * A rectangle of pixels, from (x_begin, y_begin) up to, but not including,
+     * (x_end, y_end).
+     */
+    struct pixel_region
+    {
+        size_t x_begin = 0;
+        size_t y_begin = 0;
+        size_t x_end = 0;
+        size_t y_end = 0;
+
+        bool empty() const { return (x_begin >= x_end) || (y_begin >= y_end); }
+        size_t pixels() const { return empty() ? 0 : (x_end - x_begin) * (y_end - y_begin); }
+    };
+
+    // The smallest region holding both.
+    inline pixel_region merge_regions(const pixel_region& r1, const pixel_region& r2)
+    {
+        if (r1.empty())
+        {
+            return r2;
+        }
+        if (r2.empty())
+        {
+            return r1;
+        }
+        return { std::min(r1.x_begin, r2.x_begin), std::min(r1.y_begin, r2.y_begin),
+                 std::max(r1.x_end, r2.x_end), std::max(r1.y_end, r2.y_end) };
+    }
+
+    // The pixels in both (which may be none).
+    inline pixel_region intersect_regions(const pixel_region& r1, const pixel_region& r2)
+    {
+        return { std::max(r1.x_begin, r2.x_begin), std::max(r1.y_begin, r2.y_begin),
+                 std::min(r1.x_end, r2.x_end), std::min(r1.y_end, r2.y_end) };
+    }
+
+    /**
+     * The pixels of a width x height image that dda_rasterize_triangle may
+     * change when drawing the triangle (with a pixel to spare on each side).
+     */
+    template <class T>
+    pixel_region triangle_region(const alpha_triangle_2d<T>& triangle, size_t width, size_t height)
+    {
+        auto clamped = [](T v, size_t limit)
+        {
+            return size_t(std::min(std::max(v, T(0)), T(limit)));
+        };
+        const T x_min = std::min({ triangle.v1.xy.x(), triangle.v2.xy.x(), triangle.v3.xy.x() });
+        const T x_max = std::max({ triangle.v1.xy.x(), triangle.v2.xy.x(), triangle.v3.xy.x() });
+        const T y_min = std::min({ triangle.v1.xy.y(), triangle.v2.xy.y(), triangle.v3.xy.y() });
+        const T y_max = std::max({ triangle.v1.xy.y(), triangle.v2.xy.y(), triangle.v3.xy.y() });
+        return { clamped(std::floor(x_min) - 1, width), clamped(std::floor(y_min) - 1, height),
+                 clamped(std::floor(x_max) + 2, width), clamped(std::floor(y_max) + 2, height) };
+    }
+
     enum class alpha_index_2d
     {
         X, Y,
@@ -96,6 +154,8 @@ namespace amethyst
      * @param a2 The alpha value at x2.
      * @param swap_x_and_y A flag to allow vertical lines to be drawn by
      *   swapping x and y.
+     * @param clip The only pixels that will be changed.  Pixels are given the
+     *   same color as when drawing without a clip region.
      */
     template <class T>
     void draw_horizontal_line(
@@ -104,21 +164,17 @@ namespace amethyst
         T x1, T x2, T y,
         rgbcolor<T> c1, rgbcolor<T> c2,
         T a1, T a2,
-        bool swap_x_and_y = false)
+        bool swap_x_and_y,
+        const pixel_region& clip)
     {
-        if (!swap_x_and_y)
+        // When x and y are swapped, x runs down the image instead of across it.
+        const size_t y_begin = swap_x_and_y ? clip.x_begin : clip.y_begin;
+        const size_t y_end = swap_x_and_y ? clip.x_end : clip.y_end;
+        const size_t x_begin = swap_x_and_y ? clip.y_begin : clip.x_begin;
+        const size_t x_end = swap_x_and_y ? clip.y_end : clip.x_end;
+        if ((y < 0) || (size_t(y) < y_begin) || (size_t(y) >= y_end) || (x_begin >= x_end))
         {
-            if ((y < 0) || (size_t(y) >= height))
-            {
-                return;
-            }
-        }
-        else
-        {
-            if ((y < 0) || (size_t(y) >= width))
-            {
-                return;
-            }
+            return;
         }
 
         // Go between x1 and x2, a1 and a2, c1 and c2
@@ -139,19 +195,33 @@ namespace amethyst
         rgbcolor<T> c = c1;
 
         // Do the bounds checking here so it doesn't need to be done for each pixel.
+        // (This is written to also skip lines with an end that is not a number.)
+        if (!((x2 + 0.5) >= 0))
+        {
+            return;
+        }
         if (x1 < 0)
         {
             a = a1 - x1 * a_dx;
             c = c1 - x1 * cdx;
             x1 = 0;
         }
-        if ((x2 + 0.5) >= width)
+        if ((x2 + 0.5) >= x_end)
         {
-            x2 = T(width - 1);
+            x2 = T(x_end - 1);
         }
 
         size_t endx = size_t(x2 + 0.5);
-        for (size_t x = size_t(x1 + 0.5); x <= endx; x += 1)
+        size_t x = size_t(x1 + 0.5);
+
+        // Step (rather than jump) to the clip region, so the colors match
+        // those drawn without one.
+        for (; (x < x_begin) && (x <= endx); x += 1)
+        {
+            a += a_dx;
+            c += cdx;
+        }
+        for (; x <= endx; x += 1)
         {
             if (swap_x_and_y)
             {
@@ -166,6 +236,18 @@ namespace amethyst
         }
     }
 
+    template <class T>
+    void draw_horizontal_line(
+        rgbcolor<T>* pixels,
+        size_t width, size_t height,
+        T x1, T x2, T y,
+        rgbcolor<T> c1, rgbcolor<T> c2,
+        T a1, T a2,
+        bool swap_x_and_y = false)
+    {
+        draw_horizontal_line(pixels, width, height, x1, x2, y, c1, c2, a1, a2, swap_x_and_y, pixel_region{ 0, 0, width, height });
+    }
+
     /**
      *
      * An algorithm similar to Bresenems's line drawing, but for rasterizing an
@@ -174,12 +256,16 @@ namespace amethyst
      * At some point, this could be modified to draw the body of the triangle
      * with 1 sample per pixel (no need for more) and draw smooth edges using
      * more samples.
+     *
+     * Only the pixels in the clip region are changed, which lets part of an
+     * image be redrawn.
      */
     template <class T>
     void dda_rasterize_triangle(
         rgbcolor<T>* pixels,
         size_t width, size_t height,
-        alpha_vertex_2d<T> p1, alpha_vertex_2d<T> p2, alpha_vertex_2d<T> p3)
+        alpha_vertex_2d<T> p1, alpha_vertex_2d<T> p2, alpha_vertex_2d<T> p3,
+        const pixel_region& clip)
     {
 
         // Do a sort of the 3 points by y coord.  This is done with 3 compare/swap operations.
@@ -242,7 +328,7 @@ namespace amethyst
         {
             for (; y <= p2.xy.y(); y += 1)
             {
-                draw_horizontal_line(pixels, width, height, x1, x2, y, c1, c2, a1, a2, swap_x_and_y);
+                draw_horizontal_line(pixels, width, height, x1, x2, y, c1, c2, a1, a2, swap_x_and_y, clip);
 
                 x1 += dp1_dy.x();
                 x2 += dp2_dy.x();
@@ -268,7 +354,7 @@ namespace amethyst
 
             for (; y <= p3.xy.y(); y += 1)
             {
-                draw_horizontal_line(pixels, width, height, x1, x2, y, c1, c2, a1, a2, swap_x_and_y);
+                draw_horizontal_line(pixels, width, height, x1, x2, y, c1, c2, a1, a2, swap_x_and_y, clip);
 
                 x1 += dp3_dy.x();
                 x2 += dp2_dy.x();
@@ -280,6 +366,15 @@ namespace amethyst
         }
     }
 
+    template <class T>
+    void dda_rasterize_triangle(
+        rgbcolor<T>* pixels,
+        size_t width, size_t height,
+        alpha_vertex_2d<T> p1, alpha_vertex_2d<T> p2, alpha_vertex_2d<T> p3)
+    {
+        dda_rasterize_triangle(pixels, width, height, p1, p2, p3, pixel_region{ 0, 0, width, height });
+    }
+
     template <class T>
     void dda_rasterize_triangle(
         rgbcolor<T>* pixels,
@@ -300,4 +395,18 @@ namespace amethyst
             img.get_width(), img.get_height(),
             triangle.v1, triangle.v2, triangle.v3);
     }
-}
\ No newline at end of file
+
+    template <class T>
+    void dda_rasterize_triangle(
+        image<T>& img,
+        const alpha_triangle_2d<T>& triangle,
+        const pixel_region& clip)
+    {
+        rgbcolor<T>* pixels = img.template reinterpret<rgbcolor<T>*>();
+        dda_rasterize_triangle(
+            pixels,
+            img.get_width(), img.get_height(),
+            triangle.v1, triangle.v2, triangle.v3,
+            clip);
+    }
+}
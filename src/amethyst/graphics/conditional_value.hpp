@@ -35,7 +35,9 @@ namespace amethyst
             , test_value(test_val)
         {
         }
-        virtual ~conditional_value() = default;
+        // Not virtual (and not meant to be derived from), so a conditional
+        // value of a simple type stays trivially copyable.
+        ~conditional_value() = default;
         conditional_value(const conditional_value& old) = default;
         conditional_value& operator=(const conditional_value& old) = default;
 
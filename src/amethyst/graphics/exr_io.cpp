@@ -0,0 +1,387 @@
+#include "exr_io.hpp"
+#include "half.hpp"
+#include "general/string_format.hpp"
+#include <cstring>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+namespace amethyst
+{
+    namespace impl
+    {
+        namespace
+        {
+            // The OpenEXR pixel types.
+            const int32_t exr_uint = 0;
+            const int32_t exr_half = 1;
+            const int32_t exr_float = 2;
+
+            // Everything in an OpenEXR file is little endian.
+            class exr_bytes
+            {
+            public:
+                void add(const void* data, size_t length)
+                {
+                    const uint8_t* p = static_cast<const uint8_t*>(data);
+                    bytes.insert(bytes.end(), p, p + length);
+                }
+                void add_string(const std::string& s)
+                {
+                    add(s.c_str(), s.size() + 1);
+                }
+                void add_int(uint64_t value, size_t size)
+                {
+                    for (size_t i = 0; i < size; ++i)
+                    {
+                        bytes.push_back(uint8_t(value >> (8 * i)));
+                    }
+                }
+                void add_float(float value)
+                {
+                    uint32_t bits;
+                    std::memcpy(&bits, &value, sizeof(bits));
+                    add_int(bits, 4);
+                }
+                void add_attribute(const std::string& name, const std::string& type, const exr_bytes& value)
+                {
+                    add_string(name);
+                    add_string(type);
+                    add_int(value.bytes.size(), 4);
+                    add(value.bytes.data(), value.bytes.size());
+                }
+
+                std::vector<uint8_t> bytes;
+            };
+
+            uint64_t read_int(std::istream& input, size_t size)
+            {
+                uint8_t bytes[8];
+                if (!input.read(reinterpret_cast<char*>(bytes), std::streamsize(size)))
+                {
+                    throw std::runtime_error("truncated OpenEXR file");
+                }
+                uint64_t value = 0;
+                for (size_t i = 0; i < size; ++i)
+                {
+                    value |= uint64_t(bytes[i]) << (8 * i);
+                }
+                return value;
+            }
+
+            std::string read_string(std::istream& input)
+            {
+                std::string s;
+                char c;
+                while (input.get(c) && (c != 0))
+                {
+                    s += c;
+                }
+                if (!input)
+                {
+                    throw std::runtime_error("truncated OpenEXR file");
+                }
+                return s;
+            }
+
+            // The bytes left in the input, or the most there could be if it
+            // cannot seek.  Sizes read from the file are checked against this
+            // before anything is allocated for them.
+            uint64_t remaining_bytes(std::istream& input)
+            {
+                const std::streampos position = input.tellg();
+                if (position == std::streampos(-1))
+                {
+                    return std::numeric_limits<uint64_t>::max();
+                }
+                input.seekg(0, std::ios::end);
+                const std::streampos end = input.tellg();
+                input.seekg(position);
+                if (!input || (end < position))
+                {
+                    throw std::runtime_error("unreadable OpenEXR file");
+                }
+                return uint64_t(end - position);
+            }
+
+            int32_t get_int32(const std::vector<uint8_t>& bytes, size_t offset)
+            {
+                if (offset + 4 > bytes.size())
+                {
+                    throw std::runtime_error("invalid OpenEXR attribute");
+                }
+                return int32_t(uint32_t(bytes[offset]) | (uint32_t(bytes[offset + 1]) << 8) |
+                               (uint32_t(bytes[offset + 2]) << 16) | (uint32_t(bytes[offset + 3]) << 24));
+            }
+
+            struct exr_channel
+            {
+                std::string name;
+                int32_t type;
+                size_t size() const { return (type == exr_half) ? 2 : 4; }
+            };
+        }
+
+        bool write_exr(std::streambuf& output, size_t width, size_t height,
+                       const std::function<void(size_t y, rgbcolor<float>* pixels)>& row)
+        {
+            if ((width == 0) || (height == 0) || (width > 0x7fffffff) || (height > 0x7fffffff))
+            {
+                return false;
+            }
+
+            exr_bytes header;
+            header.add_int(20000630, 4);
+            header.add_int(2, 4);
+
+            // Channels must be in alphabetical order.
+            exr_bytes channels;
+            for (const char* name : { "B", "G", "R" })
+            {
+                channels.add_string(name);
+                channels.add_int(exr_half, 4);
+                channels.add_int(0, 4); // pLinear and reserved
+                channels.add_int(1, 4); // x sampling
+                channels.add_int(1, 4); // y sampling
+            }
+            channels.add_int(0, 1);
+            header.add_attribute("channels", "chlist", channels);
+
+            exr_bytes compression;
+            compression.add_int(0, 1);
+            header.add_attribute("compression", "compression", compression);
+
+            exr_bytes window;
+            window.add_int(0, 4);
+            window.add_int(0, 4);
+            window.add_int(width - 1, 4);
+            window.add_int(height - 1, 4);
+            header.add_attribute("dataWindow", "box2i", window);
+            header.add_attribute("displayWindow", "box2i", window);
+
+            exr_bytes line_order;
+            line_order.add_int(0, 1);
+            header.add_attribute("lineOrder", "lineOrder", line_order);
+
+            exr_bytes one;
+            one.add_float(1);
+            header.add_attribute("pixelAspectRatio", "float", one);
+            exr_bytes center;
+            center.add_float(0);
+            center.add_float(0);
+            header.add_attribute("screenWindowCenter", "v2f", center);
+            header.add_attribute("screenWindowWidth", "float", one);
+            header.add_int(0, 1);
+
+            // One scanline per chunk, each at a known offset.
+            const size_t data_size = width * 3 * sizeof(uint16_t);
+            const uint64_t first_chunk = header.bytes.size() + height * sizeof(uint64_t);
+            for (size_t y = 0; y < height; ++y)
+            {
+                header.add_int(first_chunk + y * (8 + data_size), 8);
+            }
+
+            bool good = output.sputn(reinterpret_cast<const char*>(header.bytes.data()), std::streamsize(header.bytes.size())) ==
+                std::streamsize(header.bytes.size());
+
+            std::vector<rgbcolor<float>> pixels(width);
+            std::vector<float> channel(width);
+            exr_bytes chunk;
+            chunk.bytes.reserve(8 + data_size);
+            std::vector<uint16_t> halves(width);
+            for (size_t y = 0; good && (y < height); ++y)
+            {
+                row(y, pixels.data());
+
+                chunk.bytes.clear();
+                chunk.add_int(y, 4);
+                chunk.add_int(data_size, 4);
+                for (unsigned c : { 2u, 1u, 0u })
+                {
+                    for (size_t x = 0; x < width; ++x)
+                    {
+                        channel[x] = pixels[x][c];
+                    }
+                    float_to_half(channel.data(), halves.data(), width);
+                    for (uint16_t h : halves)
+                    {
+                        chunk.add_int(h, 2);
+                    }
+                }
+                good = output.sputn(reinterpret_cast<const char*>(chunk.bytes.data()), std::streamsize(chunk.bytes.size())) ==
+                    std::streamsize(chunk.bytes.size());
+            }
+            return good && (output.pubsync() == 0);
+        }
+
+        raster<rgbcolor<float>> read_exr(std::istream& input)
+        {
+            if (read_int(input, 4) != 20000630)
+            {
+                throw std::runtime_error("not an OpenEXR file");
+            }
+            const uint64_t version = read_int(input, 4);
+            // Tiled, deep and multi-part files are not supported.
+            if (((version & 0xff) != 2) || (version & 0x1a00))
+            {
+                throw std::runtime_error("unsupported OpenEXR file (only single part scanline images can be read)");
+            }
+
+            std::vector<exr_channel> channels;
+            int32_t compression = -1;
+            int32_t x_min = 0, y_min = 0, x_max = -1, y_max = -1;
+            for (;;)
+            {
+                std::string name = read_string(input);
+                if (name.empty())
+                {
+                    break;
+                }
+                std::string type = read_string(input);
+                const uint64_t value_size = read_int(input, 4);
+                if (value_size > remaining_bytes(input))
+                {
+                    throw std::runtime_error("truncated OpenEXR file");
+                }
+                std::vector<uint8_t> value(value_size);
+                if (!input.read(reinterpret_cast<char*>(value.data()), std::streamsize(value.size())))
+                {
+                    throw std::runtime_error("truncated OpenEXR file");
+                }
+
+                if ((name == "channels") && (type == "chlist"))
+                {
+                    size_t offset = 0;
+                    while ((offset < value.size()) && (value[offset] != 0))
+                    {
+                        exr_channel channel;
+                        while ((offset < value.size()) && (value[offset] != 0))
+                        {
+                            channel.name += char(value[offset++]);
+                        }
+                        channel.type = get_int32(value, offset + 1);
+                        if ((channel.type != exr_uint) && (channel.type != exr_half) && (channel.type != exr_float))
+                        {
+                            throw std::runtime_error("invalid OpenEXR channel type");
+                        }
+                        if ((get_int32(value, offset + 9) != 1) || (get_int32(value, offset + 13) != 1))
+                        {
+                            throw std::runtime_error("unsupported OpenEXR file (subsampled channels)");
+                        }
+                        channels.push_back(channel);
+                        offset += 17;
+                    }
+                }
+                else if ((name == "compression") && (value.size() == 1))
+                {
+                    compression = value[0];
+                }
+                else if ((name == "dataWindow") && (type == "box2i"))
+                {
+                    x_min = get_int32(value, 0);
+                    y_min = get_int32(value, 4);
+                    x_max = get_int32(value, 8);
+                    y_max = get_int32(value, 12);
+                }
+            }
+
+            if (compression != 0)
+            {
+                throw std::runtime_error("unsupported OpenEXR file (only uncompressed images can be read)");
+            }
+            if ((x_max < x_min) || (y_max < y_min))
+            {
+                throw std::runtime_error("invalid OpenEXR data window");
+            }
+
+            // Where each channel goes (r, g, b), or -1 to skip it.
+            std::vector<int> destination;
+            size_t pixel_size = 0;
+            int found = 0;
+            for (const exr_channel& channel : channels)
+            {
+                int d = (channel.name == "R") ? 0 : (channel.name == "G") ? 1 : (channel.name == "B") ? 2 : -1;
+                if ((d >= 0) && (channel.type != exr_uint))
+                {
+                    found |= 1 << d;
+                }
+                else
+                {
+                    d = -1;
+                }
+                destination.push_back(d);
+                pixel_size += channel.size();
+            }
+            if (found != 7)
+            {
+                throw std::runtime_error("unsupported OpenEXR file (needs half or float R, G and B channels)");
+            }
+
+            // Every line needs an offset, a chunk header and its pixels.
+            const uint64_t width = uint64_t(int64_t(x_max) - x_min + 1);
+            const uint64_t height = uint64_t(int64_t(y_max) - y_min + 1);
+            const uint64_t available = remaining_bytes(input);
+            if ((width > available / pixel_size) || (height > available / (16 + width * pixel_size)))
+            {
+                throw std::runtime_error(string_format("truncated OpenEXR file (for a %1x%2 data window)", width, height));
+            }
+            raster<rgbcolor<float>> result(width, height);
+
+            // The offset table is not needed, as every chunk says which line
+            // it holds.
+            input.ignore(std::streamsize(height * sizeof(uint64_t)));
+
+            std::vector<uint8_t> data;
+            std::vector<uint16_t> halves(width);
+            std::vector<float> values(width);
+            for (size_t line = 0; line < height; ++line)
+            {
+                int64_t y = int32_t(read_int(input, 4)) - int64_t(y_min);
+                size_t size = size_t(read_int(input, 4));
+                if ((y < 0) || (size_t(y) >= height) || (size != width * pixel_size))
+                {
+                    throw std::runtime_error(string_format("invalid OpenEXR scanline %1", line));
+                }
+                data.resize(size);
+                if (!input.read(reinterpret_cast<char*>(data.data()), std::streamsize(size)))
+                {
+                    throw std::runtime_error("truncated OpenEXR file");
+                }
+
+                const uint8_t* p = data.data();
+                rgbcolor<float>* out = &result(0, size_t(y));
+                for (size_t c = 0; c < channels.size(); ++c)
+                {
+                    const size_t bytes = width * channels[c].size();
+                    if (destination[c] >= 0)
+                    {
+                        if (channels[c].type == exr_half)
+                        {
+                            for (size_t x = 0; x < width; ++x)
+                            {
+                                halves[x] = uint16_t(p[2 * x] | (p[2 * x + 1] << 8));
+                            }
+                            half_to_float(halves.data(), values.data(), width);
+                        }
+                        else
+                        {
+                            for (size_t x = 0; x < width; ++x)
+                            {
+                                uint32_t bits = uint32_t(p[4 * x]) | (uint32_t(p[4 * x + 1]) << 8) |
+                                    (uint32_t(p[4 * x + 2]) << 16) | (uint32_t(p[4 * x + 3]) << 24);
+                                std::memcpy(&values[x], &bits, sizeof(float));
+                            }
+                        }
+                        for (size_t x = 0; x < width; ++x)
+                        {
+                            out[x][destination[c]] = values[x];
+                        }
+                    }
+                    p += bytes;
+                }
+            }
+            return result;
+        }
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+/*
+   exr_io.hpp -- OpenEXR input and output of linear (high dynamic range)
+   images, as half floats.
+ */
+
+#include "graphics/image_io.hpp"
+#include <functional>
+#include <type_traits>
+#include <iostream>
+
+namespace amethyst
+{
+    namespace impl
+    {
+        // Write an uncompressed scanline OpenEXR file with half float R, G
+        // and B channels.  row(y, pixels) fills in the width pixels of row y.
+        bool write_exr(std::streambuf& output, size_t width, size_t height,
+                       const std::function<void(size_t y, rgbcolor<float>* pixels)>& row);
+
+        // Read an uncompressed scanline OpenEXR file with R, G and B channels
+        // (half or float; any other channels are ignored).
+        // @throws std::runtime_error if the file is not one of those.
+        raster<rgbcolor<float>> read_exr(std::istream& input);
+
+        // Integer colors are scaled to and from 0..1 (as convert_color does),
+        // floating point ones are stored as they are.
+        template <typename ColorType>
+        rgbcolor<float> to_linear_float(const ColorType& c)
+        {
+            if constexpr (std::is_floating_point<typename ColorType::number_type>::value)
+            {
+                return rgbcolor<float>(float(c.r()), float(c.g()), float(c.b()));
+            }
+            else
+            {
+                rgbcolor<double> d = convert_color<double>(c);
+                return rgbcolor<float>(float(d.r()), float(d.g()), float(d.b()));
+            }
+        }
+
+        template <typename ColorType>
+        ColorType from_linear_float(const rgbcolor<float>& c)
+        {
+            using number_type = typename ColorType::number_type;
+            if constexpr (std::is_floating_point<number_type>::value)
+            {
+                return ColorType(number_type(c.r()), number_type(c.g()), number_type(c.b()));
+            }
+            else
+            {
+                return convert_color<number_type>(rgbcolor<double>(c.r(), c.g(), c.b()));
+            }
+        }
+    }
+
+    /**
+     *
+     * Reads and writes OpenEXR files.  Unlike the other formats, the values
+     * are not clamped or converted to 8 bits: they are stored as half floats
+     * (with about 3 significant digits, and a range of up to 65504), so a
+     * linear rendering can be saved and have its exposure changed later.
+     *
+     * Only uncompressed scanline images are read, which is what this writes.
+     *
+     * @author Kevin Harris <kpharris@users.sourceforge.net>
+     * @version $Revision: 1.0 $
+     *
+     */
+    template <typename T, typename ColorType = rgbcolor<T>>
+    class exr_io : public image_io<T, ColorType>
+    {
+    public:
+        using parent = image_io<T, ColorType>;
+
+        exr_io() = default;
+        ~exr_io() = default;
+
+        using parent::output;
+        using parent::input;
+
+        std::string default_extension() const override
+        {
+            return "exr";
+        }
+
+        bool output(std::ostream& o, const raster<ColorType>& source) const override
+        {
+            return output(*o.rdbuf(), source);
+        }
+
+        bool output(std::streambuf& stream, const raster<ColorType>& source) const override
+        {
+            return impl::write_exr(stream, source.get_width(), source.get_height(),
+                [&source](size_t y, rgbcolor<float>* pixels)
+                {
+                    for (size_t x = 0; x < source.get_width(); ++x)
+                    {
+                        pixels[x] = impl::to_linear_float(source(x, y));
+                    }
+                });
+        }
+
+        raster<ColorType> input(std::istream& i) const override
+        {
+            raster<rgbcolor<float>> pixels = impl::read_exr(i);
+            raster<ColorType> result(pixels.get_width(), pixels.get_height());
+            for (size_t y = 0; y < pixels.get_height(); ++y)
+            {
+                for (size_t x = 0; x < pixels.get_width(); ++x)
+                {
+                    result(x, y) = impl::from_linear_float<ColorType>(pixels(x, y));
+                }
+            }
+            return result;
+        }
+    };
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+/*
+   half.hpp -- Conversion between float and IEEE 754 half precision (16 bit)
+   floating point, as stored by OpenEXR.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace amethyst
+{
+    namespace impl
+    {
+        inline uint32_t float_bits(float f)
+        {
+            uint32_t u;
+            std::memcpy(&u, &f, sizeof(u));
+            return u;
+        }
+
+        inline float bits_float(uint32_t u)
+        {
+            float f;
+            std::memcpy(&f, &u, sizeof(f));
+            return f;
+        }
+    }
+
+    /**
+     * Round a float to the nearest half (ties to even).  Values too large for
+     * a half become infinity, and NaNs stay NaNs.
+     */
+    inline uint16_t float_to_half(float value)
+    {
+        uint32_t f = impl::float_bits(value);
+        const uint32_t sign = f & 0x80000000u;
+        f ^= sign;
+
+        uint32_t result;
+        if (f >= 0x47800000u)
+        {
+            // Too large (65520 and up round to infinity), infinity or NaN.
+            result = (f > 0x7f800000u) ? 0x7e00u : 0x7c00u;
+        }
+        else if (f < 0x38800000u)
+        {
+            // Smaller than the smallest normal half: adding 0.5 puts the
+            // denormal bits at the bottom of the mantissa, rounded by the
+            // floating point add itself.
+            const float denormal_magic = impl::bits_float(126u << 23);
+            result = impl::float_bits(impl::bits_float(f) + denormal_magic) - (126u << 23);
+        }
+        else
+        {
+            // Rebias the exponent and round the 13 mantissa bits dropped.
+            const uint32_t odd = (f >> 13) & 1;
+            f += (uint32_t(15 - 127) << 23) + 0xfff + odd;
+            result = f >> 13;
+        }
+        return uint16_t(result | (sign >> 16));
+    }
+
+    /** The exact float value of a half. */
+    inline float half_to_float(uint16_t half)
+    {
+        const uint32_t shifted_exponent = 0x7c00u << 13;
+        uint32_t f = (uint32_t(half) & 0x7fffu) << 13;
+        const uint32_t exponent = f & shifted_exponent;
+        f += uint32_t(127 - 15) << 23;
+
+        if (exponent == shifted_exponent)
+        {
+            // Infinity or NaN.
+            f += uint32_t(128 - 16) << 23;
+        }
+        else if (exponent == 0)
+        {
+            // Zero or denormal: renormalized by the float subtract.
+            f += 1u << 23;
+            f = impl::float_bits(impl::bits_float(f) - impl::bits_float(113u << 23));
+        }
+        return impl::bits_float(f | ((uint32_t(half) & 0x8000u) << 16));
+    }
+
+    // Convert many values at once, with the F16C instructions where the
+    // compiler targets them.
+    inline void float_to_half(const float* source, uint16_t* dest, size_t count)
+    {
+        size_t i = 0;
+#if defined(__F16C__)
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(source + i), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), halves);
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            dest[i] = float_to_half(source[i]);
+        }
+    }
+
+    inline void half_to_float(const uint16_t* source, float* dest, size_t count)
+    {
+        size_t i = 0;
+#if defined(__F16C__)
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+            _mm256_storeu_ps(dest + i, _mm256_cvtph_ps(halves));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            dest[i] = half_to_float(source[i]);
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+/*
+   hit_record.hpp -- The closest hit along a line: just the shape and distance.
+ */
+
+#include "amethyst/graphics/shapes/shape_fwd.hpp"
+#include <limits>
+
+namespace amethyst
+{
+    //
+    // hit_record struct:
+    // The closest shape found (so far) along a line, and the distance to it.
+    // This is all that is needed while searching for the closest hit; the
+    // full intersection_info (point, normal, uv, ...) is then only computed
+    // for the shape that was hit.
+    //
+    template <typename T, typename color_type>
+    struct hit_record
+    {
+        const shape<T, color_type>* obj = nullptr;
+        T distance = std::numeric_limits<T>::max();
+
+        bool hit() const { return obj != nullptr; }
+
+        // Record a hit if it is closer than the current one.
+        bool record(T dist, const shape<T, color_type>* s)
+        {
+            if (dist < distance)
+            {
+                distance = dist;
+                obj = s;
+                return true;
+            }
+            return false;
+        }
+    };
+}
@@ -3,6 +3,33 @@
 
 namespace amethyst
 {
+    double gamma_curve::encode(double linear) const
+    {
+        if (srgb)
+        {
+            if (linear <= 0.0031308)
+            {
+                return 12.92 * linear;
+            }
+            // (The same as 1.055 * p - 0.055, but exactly 1 at 1.)
+            return 1 + 1.055 * (std::pow(linear, 1 / gamma) - 1);
+        }
+        return std::pow(linear, 1 / gamma);
+    }
+
+    double gamma_curve::decode(double encoded) const
+    {
+        if (srgb)
+        {
+            if (encoded <= 0.04045)
+            {
+                return encoded / 12.92;
+            }
+            return std::pow((encoded + 0.055) / 1.055, gamma);
+        }
+        return std::pow(encoded, gamma);
+    }
+
     // ---------------------------------------------------------------------------
     // doubles
 
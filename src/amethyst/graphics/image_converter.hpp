@@ -1,5 +1,14 @@
 #pragma once
 #include "amethyst/graphics/image.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
 
 namespace amethyst
 {
@@ -51,24 +60,394 @@ namespace amethyst
     }
 
     /**
-     * Generic conversion from one type of image to another, using a gamma
-     * conversion.
+     * The curve used to encode linear values for display: either a plain
+     * power (1/gamma), or the sRGB curve (a linear segment near black, then a
+     * power of 1/2.4).
+     */
+    struct gamma_curve
+    {
+        double gamma = 2.2;
+        bool srgb = false;
+
+        static gamma_curve power(double gamma) { return { gamma, false }; }
+        static gamma_curve srgb_curve() { return { 2.4, true }; }
+
+        // The exact (slow) curve, which the fast versions below are tested
+        // against.  For a power curve, this is what gamma_convert_color does.
+        double encode(double linear) const;
+        double decode(double encoded) const;
+    };
+
+    /**
+     * Fast gamma encoding to 8 or 16 bit values.  The result is identical to
+     * convert_color<U>(rgbcolor<double>(curve.encode(x))) (which is what
+     * gamma_convert_color<U> gives) for every input that is not negative.
+     * Negative and NaN values give 0.
+     *
+     * It holds the smallest input giving every output value, and a coarse
+     * table (indexed by the square root of the input, where the curve is
+     * nearly straight) of the output at the start of each step.  Where a step
+     * holds at most one threshold (nearly all of them), a comparison in each
+     * direction gives the exact output; the few steep steps near black fall
+     * back to a search.
+     */
+    template <class U>
+    class gamma_lut
+    {
+    public:
+        static_assert(std::is_integral<U>::value, "gamma_lut is for integer output");
+
+        explicit gamma_lut(const gamma_curve& curve);
+
+        // The table for a curve, built on first use and kept, as building a
+        // 16 bit table takes longer than converting a small image.
+        static std::shared_ptr<const gamma_lut> shared(const gamma_curve& curve);
+
+        U operator()(double linear) const
+        {
+            if (!(linear > 0))
+            {
+                return 0;
+            }
+            if (linear >= 1)
+            {
+                return max_value;
+            }
+            const size_t step = size_t(std::sqrt(linear) * step_count);
+            size_t code = start[step];
+            if (size_t(start[step + 1]) - code > 1)
+            {
+                // Widened by one on each side, for rounding in the step.
+                const double* first = &thresholds[code > 0 ? code - 1 : 0];
+                const double* last = &thresholds[std::min(size_t(start[step + 1]) + 2, max_value + 1)];
+                return U(std::upper_bound(first, last, linear) - &thresholds[1]);
+            }
+            code -= size_t(linear < thresholds[code]);
+            code += size_t(linear >= thresholds[code + 1]);
+            return U(code);
+        }
+
+        // Integer colors are scaled to [0,1] (as by convert_color) first.
+        template <class T>
+        rgbcolor<U> operator()(const rgbcolor<T>& color) const
+        {
+            if constexpr (std::is_integral<T>::value)
+            {
+                const rgbcolor<double> linear = convert_color<double>(color);
+                return { (*this)(linear.r()), (*this)(linear.g()), (*this)(linear.b()) };
+            }
+            else
+            {
+                return { (*this)(double(color.r())), (*this)(double(color.g())), (*this)(double(color.b())) };
+            }
+        }
+
+    private:
+        static constexpr size_t max_value = std::numeric_limits<U>::max();
+        static constexpr size_t step_count = 4 * (max_value + 1);
+
+        // thresholds[k] is the smallest input that gives k (or more).  The
+        // last one (past the maximum) is never reached.
+        std::vector<double> thresholds;
+        // start[i] is the output for (i / step_count)^2.
+        std::vector<U> start;
+    };
+
+    template <class U>
+    gamma_lut<U>::gamma_lut(const gamma_curve& curve)
+        : thresholds(max_value + 2)
+        , start(step_count + 2)
+    {
+        auto reference = [&](double linear)
+        {
+            return size_t(std::min(curve.encode(linear), 1.0) * max_value);
+        };
+
+        // Bisect (on the bits of the doubles, which order the same way as
+        // positive values) for the first input giving each code, starting
+        // from a bracket of a few units in the last place around the inverse
+        // of the curve, when that holds.
+        auto bits_of = [](double x)
+        {
+            uint64_t bits;
+            std::memcpy(&bits, &x, sizeof(bits));
+            return bits;
+        };
+        auto value_of = [](uint64_t bits)
+        {
+            double x;
+            std::memcpy(&x, &bits, sizeof(x));
+            return x;
+        };
+        thresholds[0] = 0;
+        for (size_t code = 1; code <= max_value; ++code)
+        {
+            uint64_t low = bits_of(thresholds[code - 1]);
+            uint64_t high = bits_of(1.0);
+            const double guess = curve.decode(double(code) / max_value);
+            if ((guess > thresholds[code - 1]) && (guess < 1))
+            {
+                const uint64_t below = bits_of(guess) - 4;
+                const uint64_t above = bits_of(guess) + 4;
+                if ((below > low) && (reference(value_of(below)) < code))
+                {
+                    low = below;
+                }
+                if ((above < high) && (reference(value_of(above)) >= code))
+                {
+                    high = above;
+                }
+            }
+            while (high - low > 1)
+            {
+                const uint64_t middle = low + (high - low) / 2;
+                (reference(value_of(middle)) >= code ? high : low) = middle;
+            }
+            thresholds[code] = value_of(high);
+        }
+        thresholds[max_value + 1] = std::numeric_limits<double>::infinity();
+
+        size_t code = 0;
+        for (size_t i = 0; i <= step_count; ++i)
+        {
+            const double s = double(i) / step_count;
+            while ((code < max_value) && (s * s >= thresholds[code + 1]))
+            {
+                ++code;
+            }
+            start[i] = U(code);
+        }
+        start[step_count + 1] = U(max_value);
+    }
+
+    template <class U>
+    std::shared_ptr<const gamma_lut<U>> gamma_lut<U>::shared(const gamma_curve& curve)
+    {
+        static std::mutex cache_mutex;
+        static std::vector<std::pair<gamma_curve, std::shared_ptr<const gamma_lut>>> cache;
+
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        for (const auto& entry : cache)
+        {
+            if ((entry.first.gamma == curve.gamma) && (entry.first.srgb == curve.srgb))
+            {
+                return entry.second;
+            }
+        }
+        cache.emplace_back(curve, std::make_shared<const gamma_lut>(curve));
+        return cache.back().second;
+    }
+
+    namespace impl
+    {
+        // log2 and exp2 for the fast gamma curve.  These use only arithmetic
+        // and bit operations (no calls, branches, or conversions between
+        // integers and floating point), so loops over them can be vectorized:
+        // floats with SSE2, and doubles with SSE4.2 (which adds the 64 bit
+        // comparisons).  Both are accurate to a few units in the last place
+        // of a float.
+        template <class T, class I>
+        inline T fast_log2(T x)
+        {
+            constexpr int mantissa_bits = std::numeric_limits<T>::digits - 1;
+            constexpr I exponent_bias = std::numeric_limits<T>::max_exponent - 1;
+            constexpr I mantissa_mask = (I(1) << mantissa_bits) - 1;
+            // The bits of sqrt(1/2), and of 1.5 * 2^mantissa_bits (adding a
+            // small integer to which gives its value, without a conversion).
+            constexpr I sqrt_half_bits = (I(exponent_bias - 1) << mantissa_bits) | I(0x6a09e667f3bcc908ull >> (64 - mantissa_bits));
+            constexpr T round_base = T(3 * (I(1) << (mantissa_bits - 1)));
+            constexpr I round_base_bits = (I(exponent_bias + mantissa_bits) << mantissa_bits) | (I(1) << (mantissa_bits - 1));
+
+            // Split x into 2^exponent * m, with m in [sqrt(1/2), sqrt(2)) so
+            // the series below converges quickly.  The offset is kept
+            // positive, as there is no arithmetic shift of 64 bit values.
+            I bits;
+            std::memcpy(&bits, &x, sizeof(bits));
+            const I offset = bits - sqrt_half_bits + (exponent_bias << mantissa_bits);
+            I exponent_bits = round_base_bits + I(typename std::make_unsigned<I>::type(offset) >> mantissa_bits);
+            bits = (offset & mantissa_mask) + sqrt_half_bits;
+            T exponent;
+            std::memcpy(&exponent, &exponent_bits, sizeof(exponent));
+            exponent -= round_base + T(exponent_bias);
+            T m;
+            std::memcpy(&m, &bits, sizeof(m));
+
+            // log2(m) = 2/ln(2) * atanh(t), where t = (m-1)/(m+1).
+            const T t = (m - 1) / (m + 1);
+            const T t2 = t * t;
+            const T series = T(1) + t2 * (T(1) / 3 + t2 * (T(1) / 5 + t2 * (T(1) / 7 + t2 * (T(1) / 9))));
+            return exponent + t * series * T(2.8853900817779268);
+        }
+
+        template <class T, class I>
+        inline T fast_exp2(T y)
+        {
+            constexpr int mantissa_bits = std::numeric_limits<T>::digits - 1;
+            constexpr I exponent_bias = std::numeric_limits<T>::max_exponent - 1;
+            // Adding 1.5 * 2^mantissa_bits rounds to an integer, which ends up
+            // in the low bits.
+            constexpr T round_base = T(3 * (I(1) << (mantissa_bits - 1)));
+            constexpr I round_base_bits = (I(exponent_bias + mantissa_bits) << mantissa_bits) | (I(1) << (mantissa_bits - 1));
+
+            const T rounded = y + round_base;
+            const T n = rounded - round_base;
+            const T f = (y - n) * T(0.69314718055994531);
+            // e^f for f in [-ln(2)/2, ln(2)/2].
+            const T p = T(1) + f * (T(1) + f * (T(1) / 2 + f * (T(1) / 6 + f * (T(1) / 24 + f * (T(1) / 120 + f * (T(1) / 720 + f * (T(1) / 5040)))))));
+
+            // The integer is in the low bits of the rounded value.  Results
+            // below the normal range go to 0, by masking with the sign of the
+            // exponent (a comparison here would become a branch).
+            I bits;
+            std::memcpy(&bits, &rounded, sizeof(bits));
+            I exponent = bits - round_base_bits + exponent_bias;
+            exponent &= I(typename std::make_unsigned<I>::type(exponent) >> (sizeof(I) * 8 - 1)) - 1;
+            bits = exponent << mantissa_bits;
+            T scale;
+            std::memcpy(&scale, &bits, sizeof(scale));
+            return p * scale;
+        }
+
+        template <class T>
+        using fast_math_int = typename std::conditional<sizeof(T) == 8, int64_t, int32_t>::type;
+
+        // The comparisons of 64 bit integers needed for doubles are missing
+        // from SSE2, and without vectorizing, the fast curve is no faster
+        // than std::pow for doubles.
+#if defined(__SSE4_2__) || defined(__aarch64__)
+        constexpr bool vectorized_double_gamma = true;
+#else
+        constexpr bool vectorized_double_gamma = false;
+#endif
+
+        template <class T, bool srgb>
+        inline T fast_gamma_encode(T linear, T inverse_gamma)
+        {
+            using I = fast_math_int<T>;
+            constexpr int mantissa_bits = std::numeric_limits<T>::digits - 1;
+            constexpr I exponent_bias = std::numeric_limits<T>::max_exponent - 1;
+            constexpr I smallest_bits = I(1) << mantissa_bits;
+            constexpr I infinity_bits = (2 * exponent_bias + 1) << mantissa_bits;
+
+            // The input is clipped to the normal numbers as an integer, which
+            // orders the same way for positive numbers.  The same done on the
+            // floating point values is a branch (for NaN), which the compiler
+            // specializes on the clipped constant instead of vectorizing.
+            I bits;
+            std::memcpy(&bits, &linear, sizeof(bits));
+            const I clipped_bits = std::min(std::max(bits, smallest_bits), infinity_bits - 1);
+            T x;
+            std::memcpy(&x, &clipped_bits, sizeof(x));
+
+            T encoded = fast_exp2<T, I>(fast_log2<T, I>(x) * inverse_gamma);
+            I result_bits;
+            if (srgb)
+            {
+                encoded = T(1) + T(1.055) * (encoded - T(1));
+                const T segment = x * T(12.92);
+                const I use_segment = -I(x <= T(0.0031308));
+                I encoded_bits;
+                I segment_bits;
+                std::memcpy(&encoded_bits, &encoded, sizeof(encoded_bits));
+                std::memcpy(&segment_bits, &segment, sizeof(segment_bits));
+                result_bits = (segment_bits & use_segment) | (encoded_bits & ~use_segment);
+            }
+            else
+            {
+                std::memcpy(&result_bits, &encoded, sizeof(result_bits));
+            }
+
+            // Negative, NaN and tiny inputs give 0.
+            result_bits &= -I((bits >= smallest_bits) & (bits <= infinity_bits));
+            T result;
+            std::memcpy(&result, &result_bits, sizeof(result));
+            return result;
+        }
+    }
+
+    /**
+     * Fast gamma encoding of floating point values, in place.  Like
+     * gamma_convert_color, values above 1 are not clipped.  For a gamma of 1
+     * or more, the results are within 2e-8 (float: 5e-6) relative error of
+     * the exact curve, for all values large enough to be normal numbers.
+     * Smaller values, negative values and NaN give 0.
+     */
+    template <class T>
+    void gamma_encode(T* values, size_t count, const gamma_curve& curve)
+    {
+        static_assert(std::is_floating_point<T>::value, "gamma_encode is for floating point values");
+        const T inverse_gamma = T(1 / curve.gamma);
+        if (curve.srgb)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                values[i] = impl::fast_gamma_encode<T, true>(values[i], inverse_gamma);
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                values[i] = impl::fast_gamma_encode<T, false>(values[i], inverse_gamma);
+            }
+        }
+    }
+
+    /**
+     * Generic conversion from one type of image to another, gamma encoding
+     * the values with the given curve.  Integer output uses a gamma_lut (with
+     * the same results as gamma_convert_color), and floating point output
+     * uses gamma_encode (except for doubles where that cannot be vectorized).
      */
     template <class U, class T>
-    image<U> convert_image(const image<T>& img, double gamma)
+    image<U> convert_image(const image<T>& img, const gamma_curve& curve)
     {
         image<U> result(img.get_width(), img.get_height());
+        const size_t pixels = img.get_width() * img.get_height();
 
-        for (unsigned y = 0; y < result.get_height(); ++y)
+        if constexpr (std::is_integral<U>::value)
         {
-            for (unsigned x = 0; x < result.get_width(); ++x)
+            const auto lut = gamma_lut<U>::shared(curve);
+            const rgbcolor<T>* source = img.raw_data();
+            rgbcolor<U>* dest = result.template reinterpret<rgbcolor<U>*>();
+            for (size_t i = 0; i < pixels; ++i)
+            {
+                dest[i] = (*lut)(source[i]);
+            }
+        }
+        else if constexpr ((sizeof(U) == 8) && !impl::vectorized_double_gamma)
+        {
+            const rgbcolor<T>* source = img.raw_data();
+            rgbcolor<U>* dest = result.template reinterpret<rgbcolor<U>*>();
+            for (size_t i = 0; i < pixels; ++i)
             {
-                result(x, y) = gamma_convert_color<U>(img(x, y), gamma);
+                const rgbcolor<U> color = convert_color<U>(source[i]);
+                dest[i].set(curve.encode(color.r()), curve.encode(color.g()), curve.encode(color.b()));
             }
         }
+        else
+        {
+            const rgbcolor<T>* source = img.raw_data();
+            rgbcolor<U>* dest = result.template reinterpret<rgbcolor<U>*>();
+            for (size_t i = 0; i < pixels; ++i)
+            {
+                dest[i] = convert_color<U>(source[i]);
+            }
+            gamma_encode(result.template reinterpret<U*>(), 3 * pixels, curve);
+        }
         return result;
     }
 
+    /**
+     * Generic conversion from one type of image to another, using a gamma
+     * conversion.
+     */
+    template <class U, class T>
+    image<U> convert_image(const image<T>& img, double gamma)
+    {
+        return convert_image<U>(img, gamma_curve::power(gamma));
+    }
+
 
     // byte [0,255] --> double [0,1.0)
     template <>
@@ -14,7 +14,10 @@
 
 #include "graphics/image.hpp"
 #include "graphics/image_converter.hpp"
+#include <array>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace amethyst
 {
@@ -87,10 +90,34 @@ namespace amethyst
             char low, high;
             i.get(high).get(low);
             c = (int16_t(high) << 8) + (int16_t(low) & 0xff);
-            std::cout << "low=" << (int(low) & 0xff) << " high=" << (int(high) & 0xff) << " c=" << c << std::endl;
             return bool(i);
         }
 
+        // Read count bytes into buffer (resizing it to fit).
+        bool input_bytes(std::istream& i, std::vector<uint8_t>& buffer, size_t count) const
+        {
+            buffer.resize(count);
+            i.read(reinterpret_cast<char*>(buffer.data()), std::streamsize(count));
+            return size_t(i.gcount()) == count;
+        }
+
+        // Every 8 bit channel value, converted to the number type of the
+        // colors.  Converting a whole image through this is much faster than
+        // a convert_color call for each pixel.
+        static const std::array<typename ColorType::number_type, 256>& byte_values()
+        {
+            static const std::array<typename ColorType::number_type, 256> values = []()
+            {
+                std::array<typename ColorType::number_type, 256> result;
+                for (size_t v = 0; v < 256; ++v)
+                {
+                    result[v] = convert_color<typename ColorType::number_type>(rgbcolor<uint8_t>(uint8_t(v))).r();
+                }
+                return result;
+            }();
+            return values;
+        }
+
         virtual raster<ColorType> input(const std::string& filename) const
         {
             std::ifstream i(filename.c_str(), std::ios::binary);
@@ -2,6 +2,7 @@
 #include "ppm_io.hpp"
 #include "tga_io.hpp"
 #include "png_io.hpp"
+#include "exr_io.hpp"
 
 namespace amethyst
 {
@@ -25,6 +26,10 @@ namespace amethyst
         {
             return std::make_unique<png_io<T, ColorType>>();
         }
+        if (impl::endsWith(filename, ".exr") || impl::endsWith(filename, ".EXR"))
+        {
+            return std::make_unique<exr_io<T, ColorType>>();
+        }
 
         throw std::runtime_error("Unknown image format for file: " + filename);
     }
@@ -0,0 +1,262 @@
+#pragma once
+
+/*
+   image_metrics.hpp -- Differences between two images, for fitness functions
+   and for checking renderings against a reference.
+ */
+
+#include "amethyst/general/extra_exceptions.hpp"
+#include "amethyst/general/string_format.hpp"
+#include "amethyst/graphics/image.hpp"
+#include "amethyst/graphics/raster_view.hpp"
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+namespace amethyst
+{
+    enum class image_metric
+    {
+        // The sum of the absolute differences of every channel.
+        l1,
+        // The sum of the squared differences of every channel.
+        l2,
+        // The sum of the squared differences in luma and (half weighted)
+        // chroma, taken after a gamma of 2, which is closer to how the
+        // difference looks than the linear values are.
+        perceptual
+    };
+
+    namespace impl
+    {
+        // Channels are added in blocks, each with several independent sums
+        // (which the compiler keeps in vector registers), and the blocks are
+        // added pairwise.  The rounding error grows with the log of the
+        // number of pixels rather than the number, without the compensation
+        // terms of a Kahan sum (which have to be kept from being optimized
+        // away, and cannot be vectorized).
+        constexpr size_t metric_lanes = 8;
+        constexpr size_t metric_block_pixels = 256;
+
+        // Floats are summed as floats within a block; everything else as
+        // doubles.
+        template <class T>
+        using metric_sum_type = typename std::conditional<std::is_same<T, float>::value, float, double>::type;
+
+        // Adds values in a balanced binary tree, with one partial sum kept
+        // for each level.
+        class pairwise_sum
+        {
+        public:
+            void add(double value)
+            {
+                size_t level = 0;
+                for (uint64_t n = m_count; n & 1; n >>= 1)
+                {
+                    value += m_levels[level++];
+                }
+                m_levels[level] = value;
+                ++m_count;
+            }
+
+            double total() const
+            {
+                double result = 0;
+                size_t level = 0;
+                for (uint64_t n = m_count; n != 0; n >>= 1)
+                {
+                    if (n & 1)
+                    {
+                        result += m_levels[level];
+                    }
+                    ++level;
+                }
+                return result;
+            }
+
+        private:
+            double m_levels[64];
+            uint64_t m_count = 0;
+        };
+
+        template <class S, class T>
+        S absolute_difference(T a, T b)
+        {
+            return std::abs(S(a) - S(b));
+        }
+
+        template <class S, class T>
+        S squared_difference(T a, T b)
+        {
+            const S d = S(a) - S(b);
+            return d * d;
+        }
+
+        // The perceptual difference of one pixel.
+        template <class S, class T>
+        S perceptual_difference(const T* a, const T* b)
+        {
+            S d[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                d[c] = std::sqrt(std::max(S(a[c]), S(0))) - std::sqrt(std::max(S(b[c]), S(0)));
+            }
+            const S luma = S(0.2126) * d[0] + S(0.7152) * d[1] + S(0.0722) * d[2];
+            const S blue = d[2] - luma;
+            const S red = d[0] - luma;
+            return luma * luma + S(0.25) * (blue * blue + red * red);
+        }
+
+        // The sum of the metric over count pixels.
+        template <class T>
+        double metric_block_sum(const T* a, const T* b, size_t count, image_metric metric)
+        {
+            using S = metric_sum_type<T>;
+            S sums[metric_lanes] = {};
+            if (metric == image_metric::perceptual)
+            {
+                size_t i = 0;
+                for (; i + metric_lanes <= count; i += metric_lanes)
+                {
+                    for (size_t k = 0; k < metric_lanes; ++k)
+                    {
+                        sums[k] += perceptual_difference<S>(a + 3 * (i + k), b + 3 * (i + k));
+                    }
+                }
+                for (; i < count; ++i)
+                {
+                    sums[0] += perceptual_difference<S>(a + 3 * i, b + 3 * i);
+                }
+            }
+            else
+            {
+                const size_t channels = 3 * count;
+                const bool squared = metric == image_metric::l2;
+                size_t i = 0;
+                for (; i + metric_lanes <= channels; i += metric_lanes)
+                {
+                    if (squared)
+                    {
+                        for (size_t k = 0; k < metric_lanes; ++k)
+                        {
+                            sums[k] += squared_difference<S>(a[i + k], b[i + k]);
+                        }
+                    }
+                    else
+                    {
+                        for (size_t k = 0; k < metric_lanes; ++k)
+                        {
+                            sums[k] += absolute_difference<S>(a[i + k], b[i + k]);
+                        }
+                    }
+                }
+                for (; i < channels; ++i)
+                {
+                    sums[0] += squared ? squared_difference<S>(a[i], b[i]) : absolute_difference<S>(a[i], b[i]);
+                }
+            }
+
+            double total = 0;
+            for (size_t k = 0; k < metric_lanes; ++k)
+            {
+                total += double(sums[k]);
+            }
+            return total;
+        }
+    }
+
+    /**
+     * The difference between two images (or parts of them) of the same size,
+     * in the units of the channels (so 0..255 for bytes).
+     *
+     * @throws size_mismatch if the images are not the same size.
+     */
+    template <class T>
+    double image_difference(raster_view<const rgbcolor<T>> a, raster_view<const rgbcolor<T>> b, image_metric metric)
+    {
+        if ((a.get_width() != b.get_width()) || (a.get_height() != b.get_height()))
+        {
+            throw size_mismatch(string_format("image_difference: %1x%2 and %3x%4 images",
+                                              a.get_width(), a.get_height(), b.get_width(), b.get_height()));
+        }
+
+        impl::pairwise_sum sum;
+        const size_t width = a.get_width();
+        for (size_t y = 0; y < a.get_height(); ++y)
+        {
+            const T* row_a = reinterpret_cast<const T*>(a.row(y));
+            const T* row_b = reinterpret_cast<const T*>(b.row(y));
+            for (size_t x = 0; x < width; x += impl::metric_block_pixels)
+            {
+                const size_t count = std::min(impl::metric_block_pixels, width - x);
+                sum.add(impl::metric_block_sum(row_a + 3 * x, row_b + 3 * x, count, metric));
+            }
+        }
+        return sum.total();
+    }
+
+    template <class T>
+    double image_difference(raster_view<rgbcolor<T>> a, raster_view<rgbcolor<T>> b, image_metric metric)
+    {
+        return image_difference(raster_view<const rgbcolor<T>>(a), raster_view<const rgbcolor<T>>(b), metric);
+    }
+
+    template <class T>
+    double image_difference(const raster<rgbcolor<T>>& a, const raster<rgbcolor<T>>& b, image_metric metric)
+    {
+        return image_difference(a.view(), b.view(), metric);
+    }
+
+    /**
+     * The root mean square of the per channel (or for perceptual, per pixel)
+     * differences, or for l1, the mean absolute difference.
+     */
+    template <class T>
+    double mean_image_difference(raster_view<const rgbcolor<T>> a, raster_view<const rgbcolor<T>> b, image_metric metric)
+    {
+        const double count = double(a.get_width()) * double(a.get_height()) * ((metric == image_metric::perceptual) ? 1 : 3);
+        const double total = image_difference(a, b, metric);
+        if (count == 0)
+        {
+            return 0;
+        }
+        return (metric == image_metric::l1) ? total / count : std::sqrt(total / count);
+    }
+
+    template <class T>
+    double mean_image_difference(raster_view<rgbcolor<T>> a, raster_view<rgbcolor<T>> b, image_metric metric)
+    {
+        return mean_image_difference(raster_view<const rgbcolor<T>>(a), raster_view<const rgbcolor<T>>(b), metric);
+    }
+
+    template <class T>
+    double mean_image_difference(const raster<rgbcolor<T>>& a, const raster<rgbcolor<T>>& b, image_metric metric)
+    {
+        return mean_image_difference(a.view(), b.view(), metric);
+    }
+
+    /**
+     * The absolute difference of each channel of each pixel.
+     *
+     * @throws size_mismatch if the images are not the same size.
+     */
+    template <class T>
+    image<T> difference_image(const image<T>& a, const image<T>& b)
+    {
+        if ((a.get_width() != b.get_width()) || (a.get_height() != b.get_height()))
+        {
+            throw size_mismatch(string_format("difference_image: %1x%2 and %3x%4 images",
+                                              a.get_width(), a.get_height(), b.get_width(), b.get_height()));
+        }
+        image<T> result(a.get_width(), a.get_height());
+        const size_t channels = 3 * a.get_width() * a.get_height();
+        const T* pa = a.template reinterpret<const T*>();
+        const T* pb = b.template reinterpret<const T*>();
+        T* out = result.template reinterpret<T*>();
+        for (size_t i = 0; i < channels; ++i)
+        {
+            out[i] = (pa[i] > pb[i]) ? T(pa[i] - pb[i]) : T(pb[i] - pa[i]);
+        }
+        return result;
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+/*
+   image_scale.hpp -- Resizing images by point sampling.
+ */
+
+#include "amethyst/graphics/image.hpp"
+#include <algorithm>
+#include <cstddef>
+
+namespace amethyst
+{
+    /**
+     * A copy of the image at another size.  Each pixel is the average of an
+     * spp x spp grid of samples spread evenly over the area of the source it
+     * covers (the centers of the grid cells), so with spp equal to the factor
+     * of a reduction it is the average of the whole block of source pixels.
+     * With one sample, the pixel nearest the center is used.
+     */
+    template <typename T>
+    image<T> scale_image(const image<T>& img, size_t width, size_t height, size_t spp = 1)
+    {
+        image<T> dest(width, height);
+
+        const size_t source_width = img.get_width();
+        const size_t source_height = img.get_height();
+        const double x_factor = source_width / double(width);
+        const double y_factor = source_height / double(height);
+
+        // The source rows and columns of the samples for one pixel.
+        auto source_position = [spp](size_t pixel, size_t sample, double factor, size_t size)
+        {
+            return std::min(size - 1, size_t(factor * (pixel + (sample + 0.5) / spp)));
+        };
+
+        for (size_t y = 0; y < height; ++y)
+        {
+            for (size_t x = 0; x < width; ++x)
+            {
+                rgbcolor<T> target(0, 0, 0);
+                for (size_t yspp = 0; yspp < spp; ++yspp)
+                {
+                    const size_t source_y = source_position(y, yspp, y_factor, source_height);
+                    for (size_t xspp = 0; xspp < spp; ++xspp)
+                    {
+                        target += img(source_position(x, xspp, x_factor, source_width), source_y);
+                    }
+                }
+                target /= T(spp * spp);
+                dest(x, y) = target;
+            }
+        }
+
+        return dest;
+    }
+}
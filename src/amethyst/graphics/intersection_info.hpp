@@ -3,6 +3,7 @@
 #include "amethyst/graphics/conditional_value.hpp"
 #include "amethyst/general/defaulted_value.hpp"
 #include "amethyst/graphics/shapes/shape_fwd.hpp"
+#include <memory>
 #include <vector>
 #include "amethyst/math/vector3.hpp"
 #include "amethyst/math/coord2.hpp"
@@ -34,6 +35,15 @@ namespace amethyst
         typedef conditional_value<unit_line3<T>, ibool> conditional_line;
         typedef conditional_value<std::vector<intersection_info<T,color_type>>, ibool> conditional_intersection_list;
 
+        // The lists, which are only wanted when the requirements ask for them
+        // (all hits, containers).  These are kept out of line so that an
+        // intersection without them is cheap to create and copy.
+        struct extra_info
+        {
+            conditional_shape_vector all_containers;
+            conditional_intersection_list all_intersections;
+        };
+
         conditional_shape shape_hit;
         conditional_scalar first_hit_distance;
         conditional_point point_of_hit;
@@ -41,10 +51,42 @@ namespace amethyst
         conditional_coord2 uv_of_hit;
         conditional_onb onb_of_hit;
         conditional_vector3 normal;
-        conditional_shape_vector all_containers;
-        conditional_intersection_list all_intersections;
+        std::unique_ptr<extra_info> extras;
+
+        extra_info& get_extras()
+        {
+            if (!extras)
+            {
+                extras = std::make_unique<extra_info>();
+            }
+            return *extras;
+        }
 
     public:
+        intersection_info() = default;
+        intersection_info(const intersection_info& old)
+            : shape_hit(old.shape_hit)
+            , first_hit_distance(old.first_hit_distance)
+            , point_of_hit(old.point_of_hit)
+            , ray(old.ray)
+            , uv_of_hit(old.uv_of_hit)
+            , onb_of_hit(old.onb_of_hit)
+            , normal(old.normal)
+            , extras(old.extras ? std::make_unique<extra_info>(*old.extras) : nullptr)
+        {
+        }
+        intersection_info(intersection_info&& old) = default;
+        intersection_info& operator=(const intersection_info& old)
+        {
+            if (this != &old)
+            {
+                intersection_info temp(old);
+                *this = std::move(temp);
+            }
+            return *this;
+        }
+        intersection_info& operator=(intersection_info&& old) = default;
+
         const shape<T,color_type>* get_shape() const { return *shape_hit; }
         T get_first_distance() const { return *first_hit_distance; }
         point3<T> get_first_point() const { return *point_of_hit; }
@@ -52,8 +94,16 @@ namespace amethyst
         coord2<T> get_uv() const { return *uv_of_hit; }
         onb<T> get_onb() const { return *onb_of_hit; }
         vector3<T> get_normal() const { return *normal; }
-        const std::vector<const shape<T,color_type>*>& get_containers() const { return *all_containers; }
-        std::vector<intersection_info<T,color_type>> get_all_intersections() const { return *all_intersections; }
+        // Both lists are empty when they were never set.
+        const std::vector<const shape<T,color_type>*>& get_containers() const
+        {
+            static const std::vector<const shape<T,color_type>*> none;
+            return extras ? *extras->all_containers : none;
+        }
+        std::vector<intersection_info<T,color_type>> get_all_intersections() const
+        {
+            return extras ? *extras->all_intersections : std::vector<intersection_info<T,color_type>>();
+        }
 
         void set_shape(const shape<T,color_type>* s) { shape_hit = conditional_shape(s, true); }
         void set_first_distance(T dist) { first_hit_distance = conditional_scalar(dist, true); }
@@ -62,24 +112,26 @@ namespace amethyst
         void set_uv(const coord2<T>& c) { uv_of_hit = conditional_coord2(c, true); }
         void set_onb(const onb<T>& o) { onb_of_hit = conditional_onb(o, true); }
         void set_normal(const vector3<T>& n) { normal = conditional_vector3(n, true); }
-        void set_containers(const std::vector<const shape<T,color_type>*>& cv) { all_containers = conditional_shape_vector(cv, true); }
-        void set_all_intersections(const std::vector<intersection_info<T,color_type>>& intersections) { all_intersections = conditional_intersection_list(intersections, true); }
+        void set_containers(const std::vector<const shape<T,color_type>*>& cv) { get_extras().all_containers = conditional_shape_vector(cv, true); }
+        void set_all_intersections(const std::vector<intersection_info<T,color_type>>& intersections) { get_extras().all_intersections = conditional_intersection_list(intersections, true); }
 
         void append_container(const shape<T,color_type>* s)
         {
-            if (!all_containers.do_test())
+            extra_info& e = get_extras();
+            if (!e.all_containers.do_test())
             {
-                all_containers = conditional_shape_vector(std::vector<const shape<T,color_type>*>(), true);
+                e.all_containers = conditional_shape_vector(std::vector<const shape<T,color_type>*>(), true);
             }
-            all_containers->push_back(s);
+            e.all_containers->push_back(s);
         }
         void append_intersection(const intersection_info<T,color_type>& info)
         {
-            if (!all_intersections.do_test())
+            extra_info& e = get_extras();
+            if (!e.all_intersections.do_test())
             {
-                all_intersections = conditional_intersection_list(std::vector<intersection_info<T,color_type>>(), true);
+                e.all_intersections = conditional_intersection_list(std::vector<intersection_info<T,color_type>>(), true);
             }
-            all_intersections->push_back(info);
+            e.all_intersections->push_back(info);
         }
 
         bool have_shape() const { return shape_hit.do_test(); }
@@ -89,8 +141,8 @@ namespace amethyst
         bool have_uv() const { return uv_of_hit.do_test(); }
         bool have_onb() const { return onb_of_hit.do_test(); }
         bool have_normal() const { return normal.do_test(); }
-        bool have_containers() const { return all_containers.do_test(); }
-        bool have_multiple_intersections() const { return all_intersections.do_test(); }
+        bool have_containers() const { return extras && extras->all_containers.do_test(); }
+        bool have_multiple_intersections() const { return extras && extras->all_intersections.do_test(); }
 
         // Calculate any important values that are missing, based on other values contained herein.
         void calculate_missing();
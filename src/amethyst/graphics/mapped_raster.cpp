@@ -0,0 +1,118 @@
+#include "mapped_raster.hpp"
+#include "general/auto_descriptor.hpp"
+#include <cerrno>
+
+#if defined(POSIX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace amethyst
+{
+    namespace
+    {
+        std::runtime_error mapping_error(const std::string& action, const std::string& filename)
+        {
+            return std::runtime_error(string_format("Unable to %1 %2: %3", action, filename, std::strerror(errno)));
+        }
+    }
+
+#if defined(POSIX)
+    mapped_file::mapped_file(const std::string& filename, map_mode mode)
+        : file_mode(mode)
+    {
+        auto_descriptor fd(::open(filename.c_str(), (mode == map_mode::read_write) ? O_RDWR : O_RDONLY));
+        if (!fd)
+        {
+            throw mapping_error("open", filename);
+        }
+        struct stat info;
+        if (::fstat(fd.get(), &info) != 0)
+        {
+            throw mapping_error("stat", filename);
+        }
+        file_size = size_t(info.st_size);
+        map(fd.get(), filename);
+    }
+
+    mapped_file::mapped_file(const std::string& filename, size_t size)
+        : file_size(size)
+        , file_mode(map_mode::read_write)
+    {
+        auto_descriptor fd(::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644));
+        if (!fd)
+        {
+            throw mapping_error("create", filename);
+        }
+        if (::ftruncate(fd.get(), off_t(size)) != 0)
+        {
+            throw mapping_error("resize", filename);
+        }
+        map(fd.get(), filename);
+    }
+
+    void mapped_file::map(int fd, const std::string& filename)
+    {
+        if (file_size == 0)
+        {
+            return;
+        }
+
+        // A read-only raster is mapped privately, so writing to its pixels
+        // (which a raster allows) copies the page instead of faulting.
+        int flags = (file_mode == map_mode::read_write) ? MAP_SHARED : MAP_PRIVATE;
+#if defined(MAP_NORESERVE)
+        if (file_mode == map_mode::read_only)
+        {
+            flags |= MAP_NORESERVE;
+        }
+#endif
+        void* address = ::mmap(nullptr, file_size, PROT_READ | PROT_WRITE, flags, fd, 0);
+        if (address == MAP_FAILED)
+        {
+            throw mapping_error("map", filename);
+        }
+        file_data = static_cast<char*>(address);
+    }
+
+    mapped_file::~mapped_file()
+    {
+        if (file_data)
+        {
+            ::munmap(file_data, file_size);
+        }
+    }
+
+    bool mapped_file::sync()
+    {
+        if (!file_data || (file_mode != map_mode::read_write))
+        {
+            return true;
+        }
+        return ::msync(file_data, file_size, MS_SYNC) == 0;
+    }
+#else
+    mapped_file::mapped_file(const std::string& filename, map_mode mode)
+    {
+        throw std::runtime_error("Memory mapped files are not supported on this platform: " + filename);
+    }
+
+    mapped_file::mapped_file(const std::string& filename, size_t size)
+    {
+        throw std::runtime_error("Memory mapped files are not supported on this platform: " + filename);
+    }
+
+    void mapped_file::map(int fd, const std::string& filename)
+    {
+    }
+
+    mapped_file::~mapped_file() = default;
+
+    bool mapped_file::sync()
+    {
+        return false;
+    }
+#endif
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+/*
+   mapped_raster.hpp -- Rasters whose pixels are in a memory mapped file, so
+   images larger than memory can be read and written without loading or
+   copying them.
+ */
+
+#include "graphics/raster.hpp"
+#include "general/string_format.hpp"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace amethyst
+{
+    enum class map_mode
+    {
+        // Changes to the pixels are private to this process, and never
+        // written to the file.
+        read_only,
+        // Changes to the pixels are written to the file.
+        read_write
+    };
+
+    /**
+     *
+     * A file mapped into memory, which is unmapped when this is destroyed.
+     * Rasters from create_mapped_raster and open_mapped_raster hold one of
+     * these as their storage.
+     *
+     * @author Kevin Harris <kpharris@users.sourceforge.net>
+     * @version $Revision: 1.0 $
+     *
+     */
+    class mapped_file
+    {
+    public:
+        // Map all of an existing file.
+        // @throws std::runtime_error if the file cannot be opened or mapped.
+        mapped_file(const std::string& filename, map_mode mode);
+        // Create (or truncate) a file of the given size, and map it for
+        // writing.
+        // @throws std::runtime_error if the file cannot be created or mapped.
+        mapped_file(const std::string& filename, size_t size);
+        ~mapped_file();
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        char* data() const { return file_data; }
+        size_t size() const { return file_size; }
+        map_mode mode() const { return file_mode; }
+
+        // Write any changes to the file now, instead of when it is unmapped.
+        bool sync();
+
+    private:
+        void map(int fd, const std::string& filename);
+
+        char* file_data = nullptr;
+        size_t file_size = 0;
+        map_mode file_mode = map_mode::read_only;
+    };
+
+    /**
+     * The start of a mapped raster file.  The pixels follow at data_offset,
+     * as raw values of the raster's type (in the byte order of the machine).
+     */
+    struct mapped_raster_header
+    {
+        static constexpr char signature[8] = { 'A', 'M', 'R', 'A', 'S', 'T', 'E', 'R' };
+        static constexpr uint64_t default_data_offset = 64;
+
+        char magic[8];
+        uint64_t width;
+        uint64_t height;
+        uint64_t element_size;
+        uint64_t data_offset;
+    };
+
+    // Create a width by height raster, backed by a new file (or an existing
+    // one, which is replaced).  The pixels are not initialized (the file
+    // reads as zeros).
+    // @throws std::runtime_error if the file cannot be created or mapped.
+    template <class T>
+    raster<T> create_mapped_raster(const std::string& filename, size_t width, size_t height)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "mapped rasters need trivially copyable pixels");
+
+        const uint64_t offset = mapped_raster_header::default_data_offset;
+        auto file = std::make_shared<mapped_file>(filename, size_t(offset + width * height * sizeof(T)));
+
+        mapped_raster_header header;
+        std::memcpy(header.magic, mapped_raster_header::signature, sizeof(header.magic));
+        header.width = width;
+        header.height = height;
+        header.element_size = sizeof(T);
+        header.data_offset = offset;
+        std::memcpy(file->data(), &header, sizeof(header));
+
+        T* pixels = reinterpret_cast<T*>(file->data() + offset);
+        return raster<T>(width, height, pixels, std::move(file));
+    }
+
+    // Map a raster file written by create_mapped_raster.
+    // @throws std::runtime_error if the file cannot be mapped, is not a
+    // raster file, or is for a different pixel type.
+    template <class T>
+    raster<T> open_mapped_raster(const std::string& filename, map_mode mode = map_mode::read_only)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "mapped rasters need trivially copyable pixels");
+
+        auto file = std::make_shared<mapped_file>(filename, mode);
+
+        mapped_raster_header header;
+        if (file->size() < sizeof(header))
+        {
+            throw std::runtime_error("Not a raster file: " + filename);
+        }
+        std::memcpy(&header, file->data(), sizeof(header));
+        if (std::memcmp(header.magic, mapped_raster_header::signature, sizeof(header.magic)) != 0)
+        {
+            throw std::runtime_error("Not a raster file: " + filename);
+        }
+        if (header.element_size != sizeof(T))
+        {
+            throw std::runtime_error(string_format("Raster file %1 has %2 byte pixels, not %3",
+                    filename, header.element_size, sizeof(T)));
+        }
+        // The size is bounded by division, so huge dimensions cannot overflow
+        // into a size that fits the file.
+        if ((header.data_offset % alignof(T) != 0) || (header.data_offset > file->size()) ||
+            ((header.width != 0) && (header.height > (file->size() - header.data_offset) / sizeof(T) / header.width)))
+        {
+            throw std::runtime_error("Truncated or invalid raster file: " + filename);
+        }
+
+        T* pixels = reinterpret_cast<T*>(file->data() + header.data_offset);
+        return raster<T>(header.width, header.height, pixels, std::move(file));
+    }
+}
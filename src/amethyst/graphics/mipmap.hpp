@@ -0,0 +1,342 @@
+#pragma once
+
+/*
+   mipmap.hpp -- Prefiltered image pyramids, for texture lookups that average
+   over a pixel's footprint instead of aliasing.
+ */
+
+#include "graphics/raster.hpp"
+#include "graphics/rgbcolor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace amethyst
+{
+    // The filter used to make each level from the one above it.
+    enum class mipmap_filter
+    {
+        // The average of each 2x2 block.  Fast, but slightly blurry, and lets
+        // some aliasing through.
+        box,
+        // A Kaiser windowed sinc, 8 texels wide: sharper, with less aliasing.
+        kaiser
+    };
+
+    // How texels outside the image are found.
+    enum class mipmap_wrap
+    {
+        clamp,
+        repeat
+    };
+
+    namespace impl
+    {
+        // Filtering is done in doubles, whatever the color type.
+        template <typename ColorType>
+        rgbcolor<double> to_filter_color(const ColorType& c)
+        {
+            return { double(c.r()), double(c.g()), double(c.b()) };
+        }
+
+        template <typename ColorType>
+        ColorType from_filter_color(const rgbcolor<double>& c)
+        {
+            using number_type = typename ColorType::number_type;
+            if constexpr (std::is_integral<number_type>::value)
+            {
+                auto channel = [](double v)
+                {
+                    return number_type(std::min(std::max(std::round(v), 0.0), double(std::numeric_limits<number_type>::max())));
+                };
+                return ColorType(channel(c.r()), channel(c.g()), channel(c.b()));
+            }
+            else
+            {
+                return ColorType(number_type(c.r()), number_type(c.g()), number_type(c.b()));
+            }
+        }
+
+        // The modified Bessel function of the first kind, order zero.
+        inline double bessel_i0(double x)
+        {
+            double sum = 1;
+            double term = 1;
+            const double quarter_x2 = x * x / 4;
+            for (int k = 1; k < 50; ++k)
+            {
+                term *= quarter_x2 / (k * k);
+                sum += term;
+                if (term < sum * 1e-16)
+                {
+                    break;
+                }
+            }
+            return sum;
+        }
+
+        // The weights for halving an image with the filter.  Output texel i
+        // is made from input texels 2i + first, 2i + first + 1, ...
+        inline std::vector<double> halving_weights(mipmap_filter filter, int& first)
+        {
+            if (filter == mipmap_filter::box)
+            {
+                first = 0;
+                return { 0.5, 0.5 };
+            }
+
+            // A sinc (for a cutoff at the new Nyquist frequency) windowed to
+            // two output texels either side, with alpha = 4.
+            const int radius = 4;
+            const double alpha = 4;
+            first = 1 - radius;
+            std::vector<double> weights;
+            double total = 0;
+            for (int j = first; j < first + 2 * radius; ++j)
+            {
+                // The distance from the output texel center, in output texels.
+                const double d = (j + 0.5 - 1) / 2;
+                const double sinc = (d == 0) ? 1 : std::sin(M_PI * d) / (M_PI * d);
+                const double r = d / (radius / 2.0);
+                const double window = bessel_i0(alpha * std::sqrt(std::max(0.0, 1 - r * r))) / bessel_i0(alpha);
+                weights.push_back(sinc * window);
+                total += weights.back();
+            }
+            for (double& w : weights)
+            {
+                w /= total;
+            }
+            return weights;
+        }
+
+        inline size_t wrap_index(long i, size_t size, mipmap_wrap wrap)
+        {
+            if (wrap == mipmap_wrap::repeat)
+            {
+                if ((size & (size - 1)) == 0)
+                {
+                    return size_t(i) & (size - 1);
+                }
+                long m = i % long(size);
+                return size_t((m < 0) ? m + long(size) : m);
+            }
+            return size_t(std::min(std::max(i, 0L), long(size) - 1));
+        }
+    }
+
+    /**
+     *
+     * An image and successively halved copies of it (down to 1x1), each
+     * filtered from the one above.  Lookups pick the levels whose texels are
+     * about the size of the area being sampled, so distant textures are
+     * averaged rather than aliased, and touch the same few (small) texels.
+     *
+     * Each level is stored in 4x4 texel tiles, so that the texels around a
+     * lookup share cache lines in both directions.
+     *
+     * Texture coordinates are as for a raster: u goes across and v goes down,
+     * with the image covering [0,1] in each.
+     *
+     * @author Kevin Harris <kpharris@users.sourceforge.net>
+     * @version $Revision: 1.0 $
+     *
+     */
+    template <typename ColorType>
+    class mipmap
+    {
+    public:
+        static constexpr size_t tile_bits = 2;
+        static constexpr size_t tile_size = size_t(1) << tile_bits;
+
+        mipmap(const raster<ColorType>& source, mipmap_wrap wrap = mipmap_wrap::clamp, mipmap_filter filter = mipmap_filter::box)
+            : m_wrap(wrap)
+        {
+            add_level(source.get_width(), source.get_height());
+            for (size_t y = 0; y < source.get_height(); ++y)
+            {
+                for (size_t x = 0; x < source.get_width(); ++x)
+                {
+                    m_levels[0].texels[index(m_levels[0], x, y)] = source(x, y);
+                }
+            }
+
+            int first;
+            const std::vector<double> weights = impl::halving_weights(filter, first);
+            while ((m_levels.back().width > 1) || (m_levels.back().height > 1))
+            {
+                halve(weights, first);
+            }
+        }
+
+        size_t levels() const { return m_levels.size(); }
+        size_t get_width(size_t level = 0) const { return m_levels[level].width; }
+        size_t get_height(size_t level = 0) const { return m_levels[level].height; }
+        mipmap_wrap get_wrap() const { return m_wrap; }
+
+        // The bytes used by the texels of every level.
+        size_t memory_used() const
+        {
+            size_t bytes = 0;
+            for (const level& l : m_levels)
+            {
+                bytes += l.texels.size() * sizeof(ColorType);
+            }
+            return bytes;
+        }
+
+        const ColorType& texel(size_t level, size_t x, size_t y) const
+        {
+            return m_levels[level].texels[index(m_levels[level], x, y)];
+        }
+
+        // A texel, with x and y wrapped or clamped to the level.
+        const ColorType& texel_wrapped(size_t level, long x, long y) const
+        {
+            const struct level& l = m_levels[level];
+            return l.texels[index(l, impl::wrap_index(x, l.width, m_wrap), impl::wrap_index(y, l.height, m_wrap))];
+        }
+
+        template <typename T>
+        ColorType nearest(T u, T v) const
+        {
+            const level& l = m_levels[0];
+            return texel_wrapped(0, long(std::floor(u * l.width)), long(std::floor(v * l.height)));
+        }
+
+        template <typename T>
+        ColorType bilinear(size_t level, T u, T v) const
+        {
+            return impl::from_filter_color<ColorType>(bilinear_filter(level, u, v));
+        }
+
+        // The average color over an area about width (in texture coordinates)
+        // across, interpolated between the two nearest levels.
+        template <typename T>
+        ColorType trilinear(T u, T v, T width) const
+        {
+            const level& base = m_levels[0];
+            const double texels = double(width) * double(std::max(base.width, base.height));
+            const double lod = (texels > 1) ? std::min(std::log2(texels), double(m_levels.size() - 1)) : 0.0;
+            const size_t lower = size_t(lod);
+            const double fraction = lod - double(lower);
+            if ((fraction == 0) || (lower + 1 >= m_levels.size()))
+            {
+                return bilinear(lower, u, v);
+            }
+            return impl::from_filter_color<ColorType>(bilinear_filter(lower, u, v) * (1 - fraction) +
+                                                      bilinear_filter(lower + 1, u, v) * fraction);
+        }
+
+    private:
+        struct level
+        {
+            size_t width;
+            size_t height;
+            size_t tiles_across;
+            std::vector<ColorType> texels;
+        };
+
+        static size_t index(const level& l, size_t x, size_t y)
+        {
+            const size_t tile = (y >> tile_bits) * l.tiles_across + (x >> tile_bits);
+            return (tile << (2 * tile_bits)) | ((y & (tile_size - 1)) << tile_bits) | (x & (tile_size - 1));
+        }
+
+        void add_level(size_t width, size_t height)
+        {
+            level l;
+            l.width = width;
+            l.height = height;
+            l.tiles_across = (width + tile_size - 1) >> tile_bits;
+            const size_t tiles_down = (height + tile_size - 1) >> tile_bits;
+            l.texels.resize((l.tiles_across * tiles_down) << (2 * tile_bits));
+            m_levels.push_back(std::move(l));
+        }
+
+        // Filter the last level across, then down, into a new one half its
+        // size (rounded up).
+        void halve(const std::vector<double>& weights, int first)
+        {
+            const size_t source_level = m_levels.size() - 1;
+            const size_t width = m_levels[source_level].width;
+            const size_t height = m_levels[source_level].height;
+            const size_t new_width = (width + 1) / 2;
+            const size_t new_height = (height + 1) / 2;
+
+            // A dimension already at 1 is left as it is.
+            const bool across = width > 1;
+            const bool down = height > 1;
+
+            std::vector<rgbcolor<double>> columns(new_width * height);
+            for (size_t y = 0; y < height; ++y)
+            {
+                for (size_t x = 0; x < new_width; ++x)
+                {
+                    rgbcolor<double> sum(0, 0, 0);
+                    if (across)
+                    {
+                        for (size_t k = 0; k < weights.size(); ++k)
+                        {
+                            sum += impl::to_filter_color(texel_wrapped(source_level, long(2 * x) + first + long(k), long(y))) * weights[k];
+                        }
+                    }
+                    else
+                    {
+                        sum = impl::to_filter_color(texel(source_level, x, y));
+                    }
+                    columns[y * new_width + x] = sum;
+                }
+            }
+
+            add_level(new_width, new_height);
+            level& result = m_levels.back();
+            for (size_t y = 0; y < new_height; ++y)
+            {
+                for (size_t x = 0; x < new_width; ++x)
+                {
+                    rgbcolor<double> sum(0, 0, 0);
+                    if (down)
+                    {
+                        for (size_t k = 0; k < weights.size(); ++k)
+                        {
+                            const size_t row = impl::wrap_index(long(2 * y) + first + long(k), height, m_wrap);
+                            sum += columns[row * new_width + x] * weights[k];
+                        }
+                    }
+                    else
+                    {
+                        sum = columns[y * new_width + x];
+                    }
+                    result.texels[index(result, x, y)] = impl::from_filter_color<ColorType>(sum);
+                }
+            }
+        }
+
+        template <typename T>
+        rgbcolor<double> bilinear_filter(size_t level, T u, T v) const
+        {
+            const struct level& l = m_levels[level];
+            const double s = double(u) * l.width - 0.5;
+            const double t = double(v) * l.height - 0.5;
+            const double s0 = std::floor(s);
+            const double t0 = std::floor(t);
+            const double fs = s - s0;
+            const double ft = t - t0;
+            const size_t x0 = impl::wrap_index(long(s0), l.width, m_wrap);
+            const size_t x1 = impl::wrap_index(long(s0) + 1, l.width, m_wrap);
+            const size_t y0 = impl::wrap_index(long(t0), l.height, m_wrap);
+            const size_t y1 = impl::wrap_index(long(t0) + 1, l.height, m_wrap);
+
+            return impl::to_filter_color(l.texels[index(l, x0, y0)]) * ((1 - fs) * (1 - ft)) +
+                impl::to_filter_color(l.texels[index(l, x1, y0)]) * (fs * (1 - ft)) +
+                impl::to_filter_color(l.texels[index(l, x0, y1)]) * ((1 - fs) * ft) +
+                impl::to_filter_color(l.texels[index(l, x1, y1)]) * (fs * ft);
+        }
+
+        mipmap_wrap m_wrap;
+        std::vector<level> m_levels;
+    };
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "amethyst/general/random.hpp"
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include "amethyst/math/template_math.hpp"
@@ -12,6 +14,14 @@ namespace amethyst
      *
      * A class for Perlin-style noise.
      *
+     * When the table size is a power of two (as the default is), the
+     * permutation is masked rather than reduced with a modulo, and the
+     * gradients are stored as separate x, y and z arrays of T.  The batch
+     * functions (values and turbulences) evaluate blocks of points, looking
+     * up every corner first and then blending them all in one loop without
+     * branches, which the compiler vectorizes.  Both give the same results
+     * as the corner by corner definition (omega_knot), to rounding.
+     *
      * @author Kevin Harris <kpharris@users.sourceforge.net>
      * @version $Revision: 1.1 $
      *
@@ -35,6 +45,10 @@ namespace amethyst
         T value(const coord3<T>& point) const;
         T turbulence(const coord3<T>& point, int levels = 8, T d = 2) const;
 
+        // The noise or turbulence at each of count points.
+        void values(const coord3<T>* points, T* results, size_t count) const;
+        void turbulences(const coord3<T>* points, T* results, size_t count, int levels = 8, T d = 2) const;
+
         coord3<T> vector_noise(const coord3<T>& point) const;
         coord3<T> vector_turbulence(const coord3<T>& point, int levels = 8, T d = 2) const;
 
@@ -50,40 +64,173 @@ namespace amethyst
         std::shared_ptr<random<T>> rnd_gen;
 
     private:
+        // The number of points evaluated together by the batch functions.
+        static constexpr size_t block_size = 16;
+
+        // The fractional position of each point in a block within its cell,
+        // and the gradients at the cell's corners.  Corner c is offset by
+        // (c >> 2, (c >> 1) & 1, c & 1) from the cell's lowest corner.
+        struct lattice_block
+        {
+            T fx[block_size], fy[block_size], fz[block_size];
+            T gx[8][block_size], gy[8][block_size], gz[8][block_size];
+        };
+
         void create_arrays();
+        size_t gradient_index(int i, int j, int k) const;
+        void gather(const coord3<T>* points, size_t count, lattice_block& block) const;
+        static void blend(const lattice_block& block, size_t count, T* results);
+        static T smooth(T u) { return u * u * (3 - 2 * u); }
 
         size_t size_of_arrays;
-        std::vector<size_t> P_array;
-        std::vector<coord3<T>> G_array;
+        // size_of_arrays - 1 when that is a power of two, and 0 otherwise.
+        size_t mask;
+        std::vector<uint32_t> P_array;
+        std::vector<T> G_x;
+        std::vector<T> G_y;
+        std::vector<T> G_z;
     };
 
+    template <class T>
+    size_t noise<T>::gradient_index(int i, int j, int k) const
+    {
+        if (mask != 0)
+        {
+            // The same as phi_hash, as size_t arithmetic wraps at a power of two.
+            const uint32_t* P = P_array.data();
+            return P[(size_t(i) + P[(size_t(j) + P[size_t(k) & mask]) & mask]) & mask];
+        }
+        return phi_hash(i + phi_hash(j + phi_hash(k)));
+    }
+
     template <class T>
     coord3<T> noise<T>::gradient(int i, int j, int k) const
     {
-        size_t index = phi_hash(i + phi_hash(j + phi_hash(k)));
-        return G_array[index];
+        size_t index = gradient_index(i, j, k);
+        return coord3<T>(G_x[index], G_y[index], G_z[index]);
+    }
+
+    template <class T>
+    void noise<T>::gather(const coord3<T>* points, size_t count, lattice_block& block) const
+    {
+        for (size_t p = 0; p < count; ++p)
+        {
+            const T x = points[p].x();
+            const T y = points[p].y();
+            const T z = points[p].z();
+            const int floor_x = int(floor(x));
+            const int floor_y = int(floor(y));
+            const int floor_z = int(floor(z));
+            block.fx[p] = x - floor_x;
+            block.fy[p] = y - floor_y;
+            block.fz[p] = z - floor_z;
+            size_t index[8];
+            if (mask != 0)
+            {
+                // The corners share the inner two hashes.
+                const uint32_t* P = P_array.data();
+                const size_t i = size_t(floor_x);
+                const size_t j = size_t(floor_y);
+                const size_t k = size_t(floor_z);
+                const size_t hk[2] = { P[k & mask], P[(k + 1) & mask] };
+                for (int c = 0; c < 4; ++c)
+                {
+                    const size_t hjk = P[(j + (c >> 1) + hk[c & 1]) & mask];
+                    index[c] = P[(i + hjk) & mask];
+                    index[c + 4] = P[(i + 1 + hjk) & mask];
+                }
+            }
+            else
+            {
+                for (int c = 0; c < 8; ++c)
+                {
+                    index[c] = gradient_index(floor_x + (c >> 2), floor_y + ((c >> 1) & 1), floor_z + (c & 1));
+                }
+            }
+            for (int c = 0; c < 8; ++c)
+            {
+                block.gx[c][p] = G_x[index[c]];
+                block.gy[c][p] = G_y[index[c]];
+                block.gz[c][p] = G_z[index[c]];
+            }
+        }
     }
 
+    // The weights of omega_knot are weighting(u) = 1 - smooth(u) for the
+    // near corner and weighting(u - 1) = smooth(u) for the far one, so the
+    // sum over the corners is a trilinear interpolation with smoothed
+    // fractions.
+    template <class T>
+    void noise<T>::blend(const lattice_block& block, size_t count, T* results)
+    {
+        for (size_t p = 0; p < count; ++p)
+        {
+            const T u = block.fx[p];
+            const T v = block.fy[p];
+            const T w = block.fz[p];
+            T d[8];
+            for (int c = 0; c < 8; ++c)
+            {
+                d[c] = block.gx[c][p] * (u - (c >> 2)) + block.gy[c][p] * (v - ((c >> 1) & 1)) + block.gz[c][p] * (w - (c & 1));
+            }
+            const T su = smooth(u);
+            const T sv = smooth(v);
+            const T sw = smooth(w);
+            const T d00 = d[0] + su * (d[4] - d[0]);
+            const T d01 = d[1] + su * (d[5] - d[1]);
+            const T d10 = d[2] + su * (d[6] - d[2]);
+            const T d11 = d[3] + su * (d[7] - d[3]);
+            const T d0 = d00 + sv * (d10 - d00);
+            const T d1 = d01 + sv * (d11 - d01);
+            results[p] = d0 + sw * (d1 - d0);
+        }
+    }
 
     template <class T>
     T noise<T>::value(const coord3<T>& point) const
     {
-        int floor_x = int(floor(point.x()));
-        int floor_y = int(floor(point.y()));
-        int floor_z = int(floor(point.z()));
+        lattice_block block;
+        gather(&point, 1, block);
+        T result;
+        blend(block, 1, &result);
+        return result;
+    }
 
-        T val = 0;
-        for (int i = floor_x; i <= (floor_x + 1); ++i)
+    template <class T>
+    void noise<T>::values(const coord3<T>* points, T* results, size_t count) const
+    {
+        lattice_block block;
+        for (size_t first = 0; first < count; first += block_size)
         {
-            for (int j = floor_y; j <= (floor_y + 1); ++j)
+            const size_t n = std::min(block_size, count - first);
+            gather(points + first, n, block);
+            blend(block, n, results + first);
+        }
+    }
+
+    template <class T>
+    void noise<T>::turbulences(const coord3<T>* points, T* results, size_t count, int levels, T d) const
+    {
+        coord3<T> scaled[block_size];
+        T octave[block_size];
+        for (size_t first = 0; first < count; first += block_size)
+        {
+            const size_t n = std::min(block_size, count - first);
+            std::copy(points + first, points + first + n, scaled);
+            T* sum = results + first;
+            std::fill(sum, sum + n, T(0));
+            T scalar = 1;
+            for (int i = 0; i <= levels; ++i)
             {
-                for (int k = floor_z; k <= (floor_z + 1); ++k)
+                values(scaled, octave, n);
+                for (size_t p = 0; p < n; ++p)
                 {
-                    val += omega_knot(i, j, k, point.x() - i, point.y() - j, point.z() - k);
+                    sum[p] += scalar * tfabs(octave[p]);
+                    scaled[p] *= d;
                 }
+                scalar *= 1 / d;
             }
         }
-        return val;
     }
 
     template <class T>
@@ -189,13 +336,19 @@ namespace amethyst
     template <class T>
     void noise<T>::create_arrays()
     {
+        mask = ((size_of_arrays & (size_of_arrays - 1)) == 0) ? size_of_arrays - 1 : 0;
         P_array.resize(size_of_arrays);
-        G_array.resize(size_of_arrays);
+        G_x.resize(size_of_arrays);
+        G_y.resize(size_of_arrays);
+        G_z.resize(size_of_arrays);
 
         for (size_t i = 0; i < size_of_arrays; ++i)
         {
-            P_array[i] = i;
-            G_array[i] = rand_vec();
+            P_array[i] = uint32_t(i);
+            const coord3<T> g = rand_vec();
+            G_x[i] = g.x();
+            G_y[i] = g.y();
+            G_z[i] = g.z();
         }
 
         if (size_of_arrays > 0)
@@ -49,6 +49,10 @@ namespace amethyst
         }
 
     private:
+        // A ray through view_point, with differentials for view points
+        // moving by screen_dx and screen_dy (in the viewing frame) per pixel.
+        ray_parameters<T,color_type> make_ray(const point3<T>& view_point, const vector3<T>& screen_dx, const vector3<T>& screen_dy, T time) const;
+
         frame<T> viewing_frame;
         coord2<T> ll_corner;
         coord2<T> ur_corner;
@@ -96,6 +100,37 @@ namespace amethyst
     {
     } // pinhole_camera()
 
+    template <typename T, typename color_type>
+    ray_parameters<T,color_type> pinhole_camera<T,color_type>::make_ray(const point3<T>& view_point, const vector3<T>& screen_dx, const vector3<T>& screen_dy, T time) const
+    {
+        const vector3<T> direction = viewing_frame.inverse_transform(view_point) - viewing_frame.origin();
+        unit_line3<T> line(viewing_frame.origin(), direction);
+
+        if (!shutter.empty())
+        {
+            time = shutter.begin() + time * (shutter.end() - shutter.begin());
+        }
+        ray_parameters<T,color_type> ray(line, time);
+
+        // The rays all start at the eye, and the derivative of the unit
+        // direction d/|d| is (d' - u (u . d')) / |d|.
+        const vector3<T> unit_direction = line.direction();
+        const T inverse_length = 1 / length(direction);
+        auto direction_derivative = [&](const vector3<T>& screen_step)
+        {
+            const vector3<T> d = viewing_frame.inverse_transform(screen_step);
+            return (d - unit_direction * dotprod(unit_direction, d)) * inverse_length;
+        };
+
+        ray_differentials<T> differentials;
+        differentials.origin_dx = vector3<T>(0, 0, 0);
+        differentials.origin_dy = vector3<T>(0, 0, 0);
+        differentials.direction_dx = direction_derivative(screen_dx);
+        differentials.direction_dy = direction_derivative(screen_dy);
+        ray.set_differentials(differentials);
+        return ray;
+    }
+
     template <typename T, typename color_type>
     ray_parameters<T,color_type> pinhole_camera<T,color_type>::get_ray(const coord2<T>& sample_point, T time) const
     {
@@ -105,23 +140,10 @@ namespace amethyst
         point3<T> view_point((ll_corner.x() + (T(1) - sample_point.x()) * vscreen_size.x()),
                              (ll_corner.y() + (T(1) - sample_point.y()) * vscreen_size.y()),
                              viewing_distance );
-        unit_line3<T> line( viewing_frame.origin(),
-                            (viewing_frame.inverse_transform(view_point) -
-                             viewing_frame.origin()));
-
-
-        if (!shutter.empty())
-        {
-            T adjusted_time = shutter.begin() + time * (shutter.end() - shutter.begin());
-            //      std::cout << "Adjusted_time(" << time << ")=" << adjusted_time << std::endl;
 
-            return ray_parameters<T,color_type>( line, adjusted_time );
-        }
-        else
-        {
-            //      std::cout << "time=" << time << std::endl;
-            return ray_parameters<T,color_type>( line, time );
-        }
+        const vector3<T> screen_dx(-vscreen_size.x() / T(base_camera<T,color_type>::width()), 0, 0);
+        const vector3<T> screen_dy(0, -vscreen_size.y() / T(base_camera<T,color_type>::height()), 0);
+        return make_ray(view_point, screen_dx, screen_dy, time);
     }
 
     template <typename T, typename color_type>
@@ -136,21 +158,9 @@ namespace amethyst
                              (ll_corner.y() + vscreen_size.y() * sy),
                              viewing_distance);
 
-        unit_line3<T> line( viewing_frame.origin(),
-                            (viewing_frame.inverse_transform(view_point) -
-                             viewing_frame.origin()));
-
-
-        if (!shutter.empty())
-        {
-            T adjusted_time = shutter.begin() + time * (shutter.end() - shutter.begin());
-
-            return ray_parameters<T,color_type>( line, adjusted_time );
-        }
-        else
-        {
-            return ray_parameters<T,color_type>( line, time );
-        }
+        const vector3<T> screen_dx(-vscreen_size.x() / T(base_camera<T,color_type>::width() - 1), 0, 0);
+        const vector3<T> screen_dy(0, -vscreen_size.y() / T(base_camera<T,color_type>::height() - 1), 0);
+        return make_ray(view_point, screen_dx, screen_dy, time);
     }
 
     template <typename T, typename color_type>
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "amethyst/general/extra_exceptions.hpp"
+#include "amethyst/general/textized.hpp"
+#include "amethyst/general/string_format.hpp"
+#include "amethyst/graphics/raster.hpp"
+#include "amethyst/graphics/raster_view.hpp"
+#include "amethyst/graphics/rgbcolor.hpp"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace amethyst
+{
+    /**
+     *
+     * A raster with each channel stored in its own plane (structure of
+     * arrays), instead of interleaved like raster<rgbcolor<T>>.
+     *
+     * Every row starts on a cache line (alignment bytes), and is padded to a
+     * whole number of cache lines, so a kernel working on one channel can use
+     * full width aligned loads for the whole row.  The padding is zero when
+     * the raster is created, and is never read or changed by this class, so
+     * kernels may run over the whole stride as long as they leave it zero
+     * (or ignore what is there).
+     *
+     * @author Kevin Harris <kpharris@users.sourceforge.net>
+     * @version $Revision: 1.0 $
+     *
+     */
+    template <class T, size_t Channels = 3>
+    class planar_raster
+    {
+    public:
+        static_assert(std::is_arithmetic<T>::value, "planar_raster channels must be arithmetic");
+
+        static constexpr size_t channels = Channels;
+        static constexpr size_t alignment = 64;
+
+        planar_raster() = default;
+        /** Creates a width by height raster, with every element zero. */
+        planar_raster(size_t width, size_t height);
+        planar_raster(const planar_raster& old);
+        planar_raster(planar_raster&& old) noexcept = default;
+        planar_raster& operator=(const planar_raster& old);
+        planar_raster& operator=(planar_raster&& old) noexcept = default;
+
+        /**
+         * Get the element of the channel at the given (x,y)
+         * @throws out_of_range if any of channel, x, or y is out of range.
+         */
+        T& operator()(size_t channel, size_t x, size_t y)
+        {
+            check_index(channel, x, y);
+            return row(channel, y)[x];
+        }
+        const T& operator()(size_t channel, size_t x, size_t y) const
+        {
+            check_index(channel, x, y);
+            return row(channel, y)[x];
+        }
+
+        /** The first element of row y of a channel (unchecked, and aligned). */
+        T* row(size_t channel, size_t y)
+        {
+            return planes.get() + (channel * height + y) * stride;
+        }
+        const T* row(size_t channel, size_t y) const
+        {
+            return planes.get() + (channel * height + y) * stride;
+        }
+
+        /**
+         * A view of one channel.
+         * @throws out_of_range if channel is out of range.
+         */
+        raster_view<T> channel(size_t c)
+        {
+            check_index(c, 0, 0);
+            return raster_view<T>(row(c, 0), width, height, stride);
+        }
+        raster_view<const T> channel(size_t c) const
+        {
+            check_index(c, 0, 0);
+            return raster_view<const T>(row(c, 0), width, height, stride);
+        }
+
+        size_t get_width() const { return width; }
+        size_t get_height() const { return height; }
+        /** The number of elements from the start of one row to the next. */
+        size_t get_stride() const { return stride; }
+        size_t get_numpixels() const { return width * height; }
+        bool empty() const { return !planes; }
+
+    private:
+        struct aligned_deleter
+        {
+            void operator()(T* p) const
+            {
+                ::operator delete[](p, std::align_val_t(alignment));
+            }
+        };
+
+        static size_t padded_width(size_t width)
+        {
+            const size_t per_line = alignment / sizeof(T);
+            return (width + per_line - 1) / per_line * per_line;
+        }
+
+        size_t total_elements() const
+        {
+            return channels * height * stride;
+        }
+
+        void allocate()
+        {
+            const size_t count = total_elements();
+            planes.reset(static_cast<T*>(::operator new[](count * sizeof(T), std::align_val_t(alignment))));
+            std::fill_n(planes.get(), count, T(0));
+        }
+
+        void check_index(size_t c, size_t x, size_t y) const
+        {
+            if ((c >= channels) || (x >= width) || (y >= height))
+            {
+                throw out_of_range(string_format("planar_raster<T>::op()(%1,%2,%3): %4", c, x, y, intl("index is out of range")));
+            }
+        }
+
+        size_t width = 0;
+        size_t height = 0;
+        size_t stride = 0;
+        std::unique_ptr<T[], aligned_deleter> planes;
+    };
+
+    template <class T, size_t Channels>
+    planar_raster<T, Channels>::planar_raster(size_t w, size_t h)
+        : width(w), height(h), stride(padded_width(w))
+    {
+        if ((width > 0) && (height > 0))
+        {
+            allocate();
+        }
+    }
+
+    template <class T, size_t Channels>
+    planar_raster<T, Channels>::planar_raster(const planar_raster& old)
+        : width(old.width), height(old.height), stride(old.stride)
+    {
+        if (old.planes)
+        {
+            allocate();
+            std::memcpy(planes.get(), old.planes.get(), total_elements() * sizeof(T));
+        }
+    }
+
+    template <class T, size_t Channels>
+    planar_raster<T, Channels>& planar_raster<T, Channels>::operator=(const planar_raster& old)
+    {
+        if (&old != this)
+        {
+            planar_raster copy(old);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    template <class T>
+    using planar_image = planar_raster<T, 3>;
+
+    /** Split the channels of interleaved colors into planes. */
+    template <class T>
+    planar_image<T> to_planar(const raster_view<const rgbcolor<T>>& source)
+    {
+        planar_image<T> result(source.get_width(), source.get_height());
+        for (size_t y = 0; y < source.get_height(); ++y)
+        {
+            const rgbcolor<T>* in = source.row(y);
+            T* r = result.row(0, y);
+            T* g = result.row(1, y);
+            T* b = result.row(2, y);
+            for (size_t x = 0; x < source.get_width(); ++x)
+            {
+                r[x] = in[x].r();
+                g[x] = in[x].g();
+                b[x] = in[x].b();
+            }
+        }
+        return result;
+    }
+
+    template <class T>
+    planar_image<T> to_planar(const raster_view<rgbcolor<T>>& source)
+    {
+        return to_planar(raster_view<const rgbcolor<T>>(source));
+    }
+
+    template <class T>
+    planar_image<T> to_planar(const raster<rgbcolor<T>>& source)
+    {
+        return to_planar(source.view());
+    }
+
+    /** Interleave planes back into a raster of colors. */
+    template <class T>
+    raster<rgbcolor<T>> to_interleaved(const planar_image<T>& source)
+    {
+        raster<rgbcolor<T>> result(source.get_width(), source.get_height());
+        for (size_t y = 0; y < source.get_height(); ++y)
+        {
+            const T* r = source.row(0, y);
+            const T* g = source.row(1, y);
+            const T* b = source.row(2, y);
+            rgbcolor<T>* out = &result(0, y);
+            for (size_t x = 0; x < source.get_width(); ++x)
+            {
+                out[x].set(r[x], g[x], b[x]);
+            }
+        }
+        return result;
+    }
+}
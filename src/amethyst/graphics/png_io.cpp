@@ -1,13 +1,23 @@
 #include "png_io.hpp"
 #include "image_converter.hpp"
+#include "png_stream.hpp"
 #include "stb_image.h"
 #include "stb_image_write.h"
+#include <fstream>
+#include <type_traits>
+#include <vector>
 
 namespace amethyst
 {
     bool write_png(const std::string& filename, const raster<rgbcolor<uint8_t>>& data)
     {
-        return stbi_write_png(filename.c_str(), int(data.get_width()), int(data.get_height()), 3, data.reinterpret<const unsigned char*>(), 0);
+        return write_png(filename, data.view());
+    }
+
+    bool write_png(const std::string& filename, const raster_view<const rgbcolor<uint8_t>>& data)
+    {
+        return stbi_write_png(filename.c_str(), int(data.get_width()), int(data.get_height()), 3,
+            reinterpret_cast<const unsigned char*>(data.data()), int(data.get_stride() * sizeof(rgbcolor<uint8_t>)));
     }
 
     bool write_png(const std::string& filename, const raster<rgbcolor<double>>& data)
@@ -31,7 +41,12 @@ namespace amethyst
 
     bool write_png(std::streambuf& output, const raster<rgbcolor<uint8_t>>& data)
     {
-        return stbi_write_png_to_func(write_to_streambuf, &output, int(data.get_width()), int(data.get_height()), 3, data.reinterpret<unsigned char*>(), 0);
+        return write_png(output, data.view());
+    }
+    bool write_png(std::streambuf& output, const raster_view<const rgbcolor<uint8_t>>& data)
+    {
+        return stbi_write_png_to_func(write_to_streambuf, &output, int(data.get_width()), int(data.get_height()), 3,
+            reinterpret_cast<const unsigned char*>(data.data()), int(data.get_stride() * sizeof(rgbcolor<uint8_t>)));
     }
     bool write_png(std::streambuf& output, const raster<rgbcolor<double>>& data)
     {
@@ -41,4 +56,98 @@ namespace amethyst
     {
         return write_png(output, convert_image<uint8_t>(data));
     }
-}
\ No newline at end of file
+
+    namespace
+    {
+        uint16_t to_16_bit(double value)
+        {
+            return convert_color<uint16_t>(rgbcolor<double>(value)).r();
+        }
+
+        template <typename ColorType>
+        bool write_png16_rows(std::streambuf& output, const raster<ColorType>& data)
+        {
+            png_stream png(output, 16);
+            bool good = png.begin(data.get_width(), data.get_height());
+            std::vector<uint8_t> row(data.get_width() * 6);
+            for (size_t y = 0; good && (y < data.get_height()); ++y)
+            {
+                for (size_t x = 0; x < data.get_width(); ++x)
+                {
+                    const ColorType& c = data(x, y);
+                    uint16_t values[3];
+                    if constexpr (std::is_same<typename ColorType::number_type, uint16_t>::value)
+                    {
+                        values[0] = c.r();
+                        values[1] = c.g();
+                        values[2] = c.b();
+                    }
+                    else if constexpr (std::is_same<typename ColorType::number_type, uint8_t>::value)
+                    {
+                        rgbcolor<uint16_t> wide = convert_color<uint16_t>(c);
+                        values[0] = wide.r();
+                        values[1] = wide.g();
+                        values[2] = wide.b();
+                    }
+                    else
+                    {
+                        values[0] = to_16_bit(c.r());
+                        values[1] = to_16_bit(c.g());
+                        values[2] = to_16_bit(c.b());
+                    }
+                    for (size_t i = 0; i < 3; ++i)
+                    {
+                        row[6 * x + 2 * i] = uint8_t(values[i] >> 8);
+                        row[6 * x + 2 * i + 1] = uint8_t(values[i]);
+                    }
+                }
+                good = png.write_row(row.data());
+            }
+            return png.end() && good;
+        }
+
+        template <typename ColorType>
+        bool write_png16_file(const std::string& filename, const raster<ColorType>& data)
+        {
+            std::filebuf f;
+            if (!f.open(filename.c_str(), std::ios_base::out | std::ios_base::binary))
+            {
+                return false;
+            }
+            return write_png16_rows(f, data);
+        }
+    }
+
+    bool write_png16(const std::string& filename, const raster<rgbcolor<uint8_t>>& data)
+    {
+        return write_png16_file(filename, data);
+    }
+    bool write_png16(const std::string& filename, const raster<rgbcolor<uint16_t>>& data)
+    {
+        return write_png16_file(filename, data);
+    }
+    bool write_png16(const std::string& filename, const raster<rgbcolor<double>>& data)
+    {
+        return write_png16_file(filename, data);
+    }
+    bool write_png16(const std::string& filename, const raster<rgbcolor<float>>& data)
+    {
+        return write_png16_file(filename, data);
+    }
+    bool write_png16(std::streambuf& output, const raster<rgbcolor<uint8_t>>& data)
+    {
+        return write_png16_rows(output, data);
+    }
+    bool write_png16(std::streambuf& output, const raster<rgbcolor<uint16_t>>& data)
+    {
+        return write_png16_rows(output, data);
+    }
+    bool write_png16(std::streambuf& output, const raster<rgbcolor<double>>& data)
+    {
+        return write_png16_rows(output, data);
+    }
+    bool write_png16(std::streambuf& output, const raster<rgbcolor<float>>& data)
+    {
+        return write_png16_rows(output, data);
+    }
+}
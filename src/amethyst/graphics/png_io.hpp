@@ -13,17 +13,35 @@ namespace amethyst
     bool write_png(const std::string& filename, const raster<rgbcolor<double>>& data);
     bool write_png(const std::string& filename, const raster<rgbcolor<float>>& data);
 
+    // Views are written directly from the viewed pixels (a crop of a raster
+    // or a mapped file needs no copy).
+    bool write_png(const std::string& filename, const raster_view<const rgbcolor<uint8_t>>& data);
+    bool write_png(std::streambuf& output, const raster_view<const rgbcolor<uint8_t>>& data);
+
     bool write_png(std::streambuf& output, const raster<rgbcolor<uint8_t>>& data);
     bool write_png(std::streambuf& output, const raster<rgbcolor<double>>& data);
     bool write_png(std::streambuf& output, const raster<rgbcolor<float>>& data);
 
+    // 16 bits per channel (without gamma), for more precision than 8 bit
+    // output.  Rows are converted and compressed one at a time (see
+    // png_stream), so no 16 bit copy of the image is made.
+    bool write_png16(const std::string& filename, const raster<rgbcolor<uint8_t>>& data);
+    bool write_png16(const std::string& filename, const raster<rgbcolor<uint16_t>>& data);
+    bool write_png16(const std::string& filename, const raster<rgbcolor<double>>& data);
+    bool write_png16(const std::string& filename, const raster<rgbcolor<float>>& data);
+    bool write_png16(std::streambuf& output, const raster<rgbcolor<uint8_t>>& data);
+    bool write_png16(std::streambuf& output, const raster<rgbcolor<uint16_t>>& data);
+    bool write_png16(std::streambuf& output, const raster<rgbcolor<double>>& data);
+    bool write_png16(std::streambuf& output, const raster<rgbcolor<float>>& data);
+
     template <typename T, typename ColorType = rgbcolor<T>>
     class png_io : public image_io<T, ColorType>
     {
     public:
         using Parent = image_io<T, ColorType>;
 
-        png_io() = default;
+        // A bit_depth of 16 writes 16 bits per channel.
+        explicit png_io(unsigned bit_depth = 8) : bit_depth(bit_depth) { }
         ~png_io() = default;
 
         using Parent::output;
@@ -33,11 +51,11 @@ namespace amethyst
 
         bool output(std::ostream& o, const raster<ColorType>& source) const override
         {
-            return write_png(*o.rdbuf(), source);
+            return output(*o.rdbuf(), source);
         }
         bool output(std::streambuf& stream, const raster<ColorType>& source) const override
         {
-            return write_png(stream, source);
+            return (bit_depth == 16) ? write_png16(stream, source) : write_png(stream, source);
         }
 
         raster<ColorType> input(std::istream& i) const override
@@ -50,5 +68,8 @@ namespace amethyst
         {
             return convert_image<typename ColorType::number_type>(load_image_with_stb(filename));
         }
+
+    private:
+        unsigned bit_depth;
     };
 }
@@ -0,0 +1,166 @@
+#include "png_stream.hpp"
+#include "general/checksum.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace amethyst
+{
+    namespace
+    {
+        const size_t chunk_size = 1 << 16;
+
+        bool put(std::streambuf& output, const void* data, size_t length)
+        {
+            return output.sputn(static_cast<const char*>(data), std::streamsize(length)) == std::streamsize(length);
+        }
+
+        void store_be(uint8_t* dest, uint32_t value)
+        {
+            dest[0] = uint8_t(value >> 24);
+            dest[1] = uint8_t(value >> 16);
+            dest[2] = uint8_t(value >> 8);
+            dest[3] = uint8_t(value);
+        }
+
+        uint8_t paeth(int a, int b, int c)
+        {
+            int p = a + b - c;
+            int pa = std::abs(p - a);
+            int pb = std::abs(p - b);
+            int pc = std::abs(p - c);
+            if ((pa <= pb) && (pa <= pc))
+            {
+                return uint8_t(a);
+            }
+            return uint8_t((pb <= pc) ? b : c);
+        }
+    }
+
+    png_stream::png_stream(std::streambuf& output, unsigned bit_depth)
+        : m_output(output)
+        , m_bit_depth(bit_depth)
+        , m_bytes_per_pixel(3 * bit_depth / 8)
+        , m_deflate([this](const uint8_t* data, size_t length) { add_image_data(data, length); })
+    {
+    }
+
+    bool png_stream::begin(size_t width, size_t height)
+    {
+        if ((width == 0) || (height == 0) || (width > 0x7fffffff) || (height > 0x7fffffff) ||
+            ((m_bit_depth != 8) && (m_bit_depth != 16)))
+        {
+            return false;
+        }
+        static const uint8_t signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+        m_good = put(m_output, signature, sizeof(signature));
+
+        // RGB, not interlaced.
+        uint8_t header[13] = { 0, 0, 0, 0, 0, 0, 0, 0, uint8_t(m_bit_depth), 2, 0, 0, 0 };
+        store_be(header, uint32_t(width));
+        store_be(header + 4, uint32_t(height));
+        write_chunk("IHDR", header, sizeof(header));
+
+        const size_t row_bytes = width * m_bytes_per_pixel;
+        m_previous.assign(row_bytes, 0);
+        m_current.resize(row_bytes);
+        m_filtered.resize(row_bytes + 1);
+        m_best.resize(row_bytes + 1);
+        return m_good;
+    }
+
+    bool png_stream::write_row(const uint8_t* bytes)
+    {
+        std::copy_n(bytes, m_current.size(), m_current.begin());
+
+        // Pick the filter that makes the row's bytes (as signed values)
+        // smallest, which is what stb_image_write does too.
+        size_t best_score = size_t(-1);
+        for (uint8_t filter = 0; filter < 5; ++filter)
+        {
+            size_t score = apply_filter(filter);
+            if (score < best_score)
+            {
+                best_score = score;
+                m_best.swap(m_filtered);
+            }
+        }
+        m_deflate.write(m_best.data(), m_best.size());
+        m_previous.swap(m_current);
+        return m_good;
+    }
+
+    bool png_stream::end()
+    {
+        m_deflate.finish();
+        flush_image_data();
+        write_chunk("IEND", nullptr, 0);
+        return m_good && (m_output.pubsync() == 0);
+    }
+
+    // Filter the current row into m_filtered (with the filter type first),
+    // returning the sum of its magnitudes.
+    size_t png_stream::apply_filter(uint8_t filter)
+    {
+        const size_t n = m_current.size();
+        const size_t bpp = m_bytes_per_pixel;
+        const uint8_t* row = m_current.data();
+        const uint8_t* up = m_previous.data();
+        uint8_t* out = m_filtered.data() + 1;
+        m_filtered[0] = filter;
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            int left = (i >= bpp) ? row[i - bpp] : 0;
+            int up_left = (i >= bpp) ? up[i - bpp] : 0;
+            int predicted = 0;
+            switch (filter)
+            {
+            case 1: predicted = left; break;
+            case 2: predicted = up[i]; break;
+            case 3: predicted = (left + up[i]) / 2; break;
+            case 4: predicted = paeth(left, up[i], up_left); break;
+            }
+            out[i] = uint8_t(row[i] - predicted);
+        }
+
+        size_t score = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            score += std::abs(int(int8_t(out[i])));
+        }
+        return score;
+    }
+
+    void png_stream::add_image_data(const uint8_t* data, size_t length)
+    {
+        m_image_data.insert(m_image_data.end(), data, data + length);
+        if (m_image_data.size() >= chunk_size)
+        {
+            flush_image_data();
+        }
+    }
+
+    void png_stream::flush_image_data()
+    {
+        if (!m_image_data.empty())
+        {
+            write_chunk("IDAT", m_image_data.data(), m_image_data.size());
+            m_image_data.clear();
+        }
+    }
+
+    void png_stream::write_chunk(const char* type, const uint8_t* data, size_t length)
+    {
+        uint8_t length_bytes[4];
+        store_be(length_bytes, uint32_t(length));
+
+        crc32 crc;
+        crc.update(type, 4);
+        crc.update(data, length);
+        uint8_t crc_bytes[4];
+        store_be(crc_bytes, crc.value());
+
+        m_good = put(m_output, length_bytes, 4) && put(m_output, type, 4) &&
+            put(m_output, data, length) && put(m_output, crc_bytes, 4) && m_good;
+    }
+}
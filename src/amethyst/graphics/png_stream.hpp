@@ -0,0 +1,47 @@
+#pragma once
+
+#include "general/deflate_stream.hpp"
+#include <cstdint>
+#include <streambuf>
+#include <vector>
+
+namespace amethyst
+{
+    /**
+     * Writes an RGB PNG one row at a time, compressing the image data as it
+     * goes (see deflate_stream), so the whole image is never held.
+     *
+     * Rows are given as raw bytes: 3 per pixel for 8 bit images, or 6 (each
+     * channel big endian, as PNG stores them) for 16 bit images.
+     */
+    class png_stream
+    {
+    public:
+        png_stream(std::streambuf& output, unsigned bit_depth = 8);
+
+        png_stream(const png_stream&) = delete;
+        png_stream& operator=(const png_stream&) = delete;
+
+        bool begin(size_t width, size_t height);
+        bool write_row(const uint8_t* bytes);
+        bool end();
+
+    private:
+        size_t apply_filter(uint8_t filter);
+        void add_image_data(const uint8_t* data, size_t length);
+        void flush_image_data();
+        void write_chunk(const char* type, const uint8_t* data, size_t length);
+
+        std::streambuf& m_output;
+        unsigned m_bit_depth;
+        size_t m_bytes_per_pixel;
+        deflate_stream m_deflate;
+        bool m_good = true;
+
+        std::vector<uint8_t> m_previous;
+        std::vector<uint8_t> m_current;
+        std::vector<uint8_t> m_filtered;
+        std::vector<uint8_t> m_best;
+        std::vector<uint8_t> m_image_data;
+    };
+}
@@ -21,10 +21,16 @@ namespace amethyst
             return "ppm";
         }
 
+        using parent::output;
         bool output(std::ostream& o, const raster<ColorType>& source) const override;
         bool output(std::streambuf& stream, const raster<ColorType>& source) const override;
 
-        template <class S> bool basic_output(S& o, const raster<ColorType>& source) const;
+        // Write the pixels of a view (such as a crop of a raster, or a mapped
+        // file) without copying them into a raster first.
+        bool output(const std::string& filename, const raster_view<const ColorType>& source) const;
+        bool output(std::streambuf& stream, const raster_view<const ColorType>& source) const;
+
+        template <class S, class source_type> bool basic_output(S& o, const source_type& source) const;
 
         void eat_whitespace_and_comments(std::istream& input) const;
         raster<ColorType> input(std::istream& i) const override;
@@ -39,8 +45,8 @@ namespace amethyst
 #if defined(USE_PPM_P6)
 #if !defined(USE_PPM_16BIT)
     template <typename T, typename ColorType>
-    template <typename S>
-    bool ppm_io<T, ColorType>::basic_output(S& o, const raster<ColorType>& source) const
+    template <typename S, typename source_type>
+    bool ppm_io<T, ColorType>::basic_output(S& o, const source_type& source) const
     {
         std::string header = string_format("P6 %1 %2 255\n", int(source.get_width()), int(source.get_height()));
 
@@ -60,8 +66,8 @@ namespace amethyst
     }
 #else // #if defined(USE_PPM_16BIT)
     template <typename T, typename ColorType>
-    template <typename S>
-    bool ppm_io<T, ColorType>::basic_output(S& o, const raster<ColorType>& source) const
+    template <typename S, typename source_type>
+    bool ppm_io<T, ColorType>::basic_output(S& o, const source_type& source) const
     {
         std::string header = string_format(
             "P6\n"    // binary format
@@ -88,8 +94,8 @@ namespace amethyst
 #endif // #if !defined(USE_PPM_16BIT)
 #else // !defined(USE_PPM_P6)
     template <typename T, typename ColorType>
-    template <typename S>
-    bool ppm_io<T, ColorType>::basic_output(S& o, const raster<ColorType>& source) const
+    template <typename S, typename source_type>
+    bool ppm_io<T, ColorType>::basic_output(S& o, const source_type& source) const
     {
         std::string header = string_format(
             "P3\n"    // binary format
@@ -133,6 +139,23 @@ namespace amethyst
         return basic_output(stream, source);
     }
 
+    template <typename T, typename ColorType>
+    bool ppm_io<T, ColorType>::output(const std::string& filename, const raster_view<const ColorType>& source) const
+    {
+        std::filebuf f;
+        if (!f.open(filename.c_str(), std::ios_base::out | std::ios_base::binary))
+        {
+            return false;
+        }
+        return output(f, source);
+    }
+
+    template <typename T, typename ColorType>
+    bool ppm_io<T, ColorType>::output(std::streambuf& stream, const raster_view<const ColorType>& source) const
+    {
+        return basic_output(stream, source);
+    }
+
 
     template <typename T, typename ColorType>
     void ppm_io<T, ColorType>::eat_whitespace_and_comments(std::istream& input) const
@@ -170,10 +193,12 @@ namespace amethyst
     template <typename T, typename ColorType>
     raster<ColorType> ppm_io<T, ColorType>::input(std::istream& input) const
     {
+        using number_type = typename ColorType::number_type;
+
         std::string format;
-        size_t width;
-        size_t height;
-        size_t max_pixel_value;
+        size_t width = 0;
+        size_t height = 0;
+        size_t max_pixel_value = 0;
 
         eat_whitespace_and_comments(input);
         input >> format;
@@ -183,86 +208,73 @@ namespace amethyst
         input >> height;
         eat_whitespace_and_comments(input);
         input >> max_pixel_value;
-        eat_whitespace_and_comments(input);
 
-        std::cout << "Format is " << format << "  Width=" << width << " Height=" << height << " max pixel value=" << max_pixel_value << std::endl;
+        if (!input || ((format != "P3") && (format != "P6")) || (max_pixel_value == 0) || (max_pixel_value > 65535))
+        {
+            throw std::runtime_error("unsupported or invalid PPM header");
+        }
 
         raster<ColorType> result{ width, height };
+        ColorType* data = result.template reinterpret<ColorType*>();
+        const auto& byte_values = parent::byte_values();
 
-        std::function<bool(int& r, int& g, int& b)> read_rgb;
-
-        auto rgb_p3 = [&input](int& r, int& g, int& b)
-        {
-            input >> r >> g >> b;
-            if (!input) {
-                std::cerr << "Failed reading p3" << std::endl;
-            }
-            return bool(input);
-        };
-        auto rgb_p6_byte = [&input, this](int& r, int& g, int& b) -> bool
-        {
-            char rv, gv, bv;
-            if (parent::input_byte(input, rv) && parent::input_byte(input, gv) && parent::input_byte(input, bv))
-            {
-                r = int(rv) & 0xff;
-                g = int(gv) & 0xff;
-                b = int(bv) & 0xff;
-                return true;
-            }
-            return false;
-        };
-        auto rgb_p6_word = [&input, this](int& r, int& g, int& b) -> bool
+        if (format == "P3")
         {
-            int16_t rv, gv, bv;
-            if (parent::input_word_be(input, rv) && parent::input_word_be(input, gv) && parent::input_word_be(input, bv))
+            eat_whitespace_and_comments(input);
+            for (size_t y = 0; y < height; ++y)
             {
-                r = rv;
-                g = gv;
-                b = bv;
-                return true;
+                ColorType* line = data + y * width;
+                for (size_t x = 0; x < width; ++x)
+                {
+                    int r, g, b;
+                    if (!(input >> r >> g >> b))
+                    {
+                        throw std::runtime_error(string_format("failed reading pixel value for [%1,%2]", x, y));
+                    }
+                    if (max_pixel_value > 255)
+                    {
+                        line[x] = convert_color<number_type>(rgbcolor<uint16_t>(r, g, b));
+                    }
+                    else
+                    {
+                        line[x] = ColorType(byte_values[r & 0xff], byte_values[g & 0xff], byte_values[b & 0xff]);
+                    }
+                }
             }
-            return false;
-        };
-
-        if (format == "P3")
-        {
-            read_rgb = rgb_p3;
-        }
-        else if (format == "P6" && (max_pixel_value > 255))
-        {
-            read_rgb = rgb_p6_word;
-        }
-        else if (format == "P6")
-        {
-            read_rgb = rgb_p6_byte;
+            return result;
         }
 
-        ColorType* data = result.template reinterpret<ColorType*>();
+        // Exactly one whitespace character separates the header from the
+        // pixels (which may themselves look like whitespace).
+        input.get();
 
+        // Whole rows are read at once, then decoded.
+        const size_t bytes_per_value = (max_pixel_value > 255) ? 2 : 1;
+        std::vector<uint8_t> row;
         for (size_t y = 0; y < height; ++y)
         {
+            if (!parent::input_bytes(input, row, width * 3 * bytes_per_value))
+            {
+                throw std::runtime_error(string_format("failed reading pixel values for row %1", y));
+            }
             ColorType* line = data + y * width;
-
-            for (size_t x = 0; x < width; ++x)
+            const uint8_t* bytes = row.data();
+            if (bytes_per_value == 1)
             {
-                int r, g, b;
-                if (!read_rgb(r, g, b))
+                for (size_t x = 0; x < width; ++x, bytes += 3)
                 {
-                    throw std::runtime_error(string_format("failed reading pixel value for [%1,%2]", x, y));
-                }
-                if (max_pixel_value > 255) {
-                    rgbcolor<uint16_t> source(r, g, b);
-                    line[x] = convert_color<typename ColorType::number_type>(source);
-                    //std::cout << string_format("pixel(%1,%2)=%3  (from word source %4)", x, y, inspect(line[x]), inspect(source)) << std::endl;
+                    line[x] = ColorType(byte_values[bytes[0]], byte_values[bytes[1]], byte_values[bytes[2]]);
                 }
-                else
+            }
+            else
+            {
+                for (size_t x = 0; x < width; ++x, bytes += 6)
                 {
-                    rgbcolor<uint8_t> source(r, g, b);
-                    line[x] = convert_color<typename ColorType::number_type>(source);
-                    //std::cout << string_format("pixel(%1,%2)=%3  (from byte source %4)", x, y, inspect(line[x]), inspect(source)) << std::endl;
+                    rgbcolor<uint16_t> source((bytes[0] << 8) | bytes[1], (bytes[2] << 8) | bytes[3], (bytes[4] << 8) | bytes[5]);
+                    line[x] = convert_color<number_type>(source);
                 }
             }
         }
         return result;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,279 @@
+#pragma once
+
+/*
+   progressive_renderer.hpp -- Rendering in passes, which are averaged into an
+   accumulation buffer that can be saved to disk and resumed later.
+ */
+
+#include "renderer.hpp"
+#include "general/string_format.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace amethyst
+{
+    template <typename color_type>
+    using frame_function = std::function<void(const raster<color_type>& frame, size_t passes)>;
+
+    /**
+     *
+     * The weighted sum of the completed passes of a progressive render, and
+     * what is needed to continue it.  Pass n is rendered with the seed plus n,
+     * and the samplers are reseeded from that for every pixel, so the number
+     * of passes and the first seed are the whole state of the sampling.  A
+     * render resumed from a saved buffer gives the same image as one that was
+     * never interrupted.
+     *
+     * The saved form is binary (in the byte order of the machine): a header
+     * of the magic string, size, passes, samples and seed, followed by the
+     * sums as three doubles per pixel.
+     *
+     * @author Kevin Harris <kpharris@users.sourceforge.net>
+     * @version $Revision: 1.0 $
+     *
+     */
+    template <typename color_type>
+    class accumulation_buffer
+    {
+    public:
+        accumulation_buffer() = default;
+        accumulation_buffer(size_t width, size_t height, uint32_t seed = 0);
+
+        size_t get_width() const { return sum.get_width(); }
+        size_t get_height() const { return sum.get_height(); }
+        size_t passes() const { return pass_count; }
+        uint64_t samples() const { return sample_count; }
+        uint32_t get_seed() const { return first_seed; }
+
+        // The seed to render the next pass with.
+        uint32_t next_seed() const { return first_seed + uint32_t(pass_count); }
+
+        // Add a pass rendered with samples_per_pixel samples per pixel.
+        void add_pass(const raster<color_type>& pass, size_t samples_per_pixel);
+
+        // The average of all passes so far (weighted by their samples).
+        raster<color_type> average() const;
+
+        // Write the buffer to a temporary file, then rename it over filename,
+        // so an interrupted save never leaves a broken file behind.
+        bool save(const std::string& filename) const;
+
+        // Returns false if the file cannot be opened.
+        // @throws std::runtime_error if the file is not a valid buffer.
+        bool load(const std::string& filename);
+
+    private:
+        static constexpr char magic[8] = { 'A', 'M', 'A', 'C', 'C', 'U', 'M', '1' };
+
+        raster<color_type> sum;
+        size_t pass_count = 0;
+        uint64_t sample_count = 0;
+        uint32_t first_seed = 0;
+    };
+
+    template <typename color_type>
+    accumulation_buffer<color_type>::accumulation_buffer(size_t width, size_t height, uint32_t seed)
+        : sum(width, height)
+        , first_seed(seed)
+    {
+        for (size_t y = 0; y < height; ++y)
+        {
+            for (size_t x = 0; x < width; ++x)
+            {
+                sum(x, y) = colors<color_type>::black;
+            }
+        }
+    }
+
+    template <typename color_type>
+    void accumulation_buffer<color_type>::add_pass(const raster<color_type>& pass, size_t samples_per_pixel)
+    {
+        for (size_t y = 0; y < get_height(); ++y)
+        {
+            for (size_t x = 0; x < get_width(); ++x)
+            {
+                sum(x, y) += pass(x, y) * samples_per_pixel;
+            }
+        }
+        ++pass_count;
+        sample_count += samples_per_pixel;
+    }
+
+    template <typename color_type>
+    raster<color_type> accumulation_buffer<color_type>::average() const
+    {
+        raster<color_type> result(get_width(), get_height());
+        const double scale = sample_count ? 1.0 / double(sample_count) : 0.0;
+        for (size_t y = 0; y < get_height(); ++y)
+        {
+            for (size_t x = 0; x < get_width(); ++x)
+            {
+                result(x, y) = sum(x, y) * scale;
+            }
+        }
+        return result;
+    }
+
+    template <typename color_type>
+    bool accumulation_buffer<color_type>::save(const std::string& filename) const
+    {
+        const std::string temp_filename = filename + ".tmp";
+        {
+            std::ofstream file(temp_filename, std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                return false;
+            }
+
+            const uint64_t header[] = { get_width(), get_height(), pass_count, sample_count, first_seed };
+            file.write(magic, sizeof(magic));
+            file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+            std::vector<double> row(3 * get_width());
+            for (size_t y = 0; y < get_height(); ++y)
+            {
+                for (size_t x = 0; x < get_width(); ++x)
+                {
+                    row[3 * x + 0] = sum(x, y).r();
+                    row[3 * x + 1] = sum(x, y).g();
+                    row[3 * x + 2] = sum(x, y).b();
+                }
+                file.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(double));
+            }
+
+            file.flush();
+            if (!file)
+            {
+                std::remove(temp_filename.c_str());
+                return false;
+            }
+        }
+        return std::rename(temp_filename.c_str(), filename.c_str()) == 0;
+    }
+
+    template <typename color_type>
+    bool accumulation_buffer<color_type>::load(const std::string& filename)
+    {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+
+        char file_magic[sizeof(magic)];
+        uint64_t header[5];
+        file.read(file_magic, sizeof(file_magic));
+        file.read(reinterpret_cast<char*>(header), sizeof(header));
+        if (!file || std::memcmp(file_magic, magic, sizeof(magic)) != 0)
+        {
+            throw std::runtime_error("Not an accumulation buffer: " + filename);
+        }
+
+        // The size has to match the pixels in the file, which is checked
+        // before anything is allocated (and without overflowing).
+        const std::streamoff pixel_start = file.tellg();
+        file.seekg(0, std::ios::end);
+        const uint64_t pixel_bytes = uint64_t(file.tellg() - pixel_start);
+        file.seekg(pixel_start);
+        const uint64_t bytes_per_pixel = 3 * sizeof(double);
+        const uint64_t width = header[0];
+        const uint64_t height = header[1];
+        const bool size_fits = (width == 0 || height == 0)
+            ? (pixel_bytes == 0)
+            : ((width <= pixel_bytes / bytes_per_pixel) && (height <= pixel_bytes / bytes_per_pixel / width) &&
+               (width * height * bytes_per_pixel == pixel_bytes));
+        if (!file || !size_fits)
+        {
+            throw std::runtime_error(string_format("Accumulation buffer %1 (%2x%3) does not match its size", filename, width, height));
+        }
+
+        accumulation_buffer<color_type> loaded(header[0], header[1], uint32_t(header[4]));
+        loaded.pass_count = header[2];
+        loaded.sample_count = header[3];
+
+        std::vector<double> row(3 * loaded.get_width());
+        for (size_t y = 0; y < loaded.get_height(); ++y)
+        {
+            file.read(reinterpret_cast<char*>(row.data()), row.size() * sizeof(double));
+            if (!file)
+            {
+                throw std::runtime_error(string_format("Truncated accumulation buffer (at row %1): %2", y, filename));
+            }
+            for (size_t x = 0; x < loaded.get_width(); ++x)
+            {
+                loaded.sum(x, y) = color_type(row[3 * x + 0], row[3 * x + 1], row[3 * x + 2]);
+            }
+        }
+
+        *this = std::move(loaded);
+        return true;
+    }
+
+    // Render the image in passes of samples_per_pass samples per pixel, until
+    // the given number of passes is done.  The average so far is given to
+    // frame after every pass.
+    //
+    // If a checkpoint file is given, the accumulation buffer is saved there
+    // after every pass.  If the file already exists (from a render that was
+    // interrupted), the render continues from it instead of starting over.
+    //
+    // @throws std::runtime_error if the checkpoint is invalid or is for an
+    // image of a different size.
+    template <typename T, typename color_type = rgbcolor<T>>
+    raster<color_type> render_progressive(
+        camera_ptr<T, color_type> camera,
+        shape_ptr<T, color_type> scene,
+        texture_ptr<T, color_type> scene_texture,
+        size_t width,
+        size_t height,
+        intersection_requirements requirements,
+        lighting_function<T, color_type> brightness,
+        background_function<T, color_type> background,
+        size_t samples_per_pass,
+        size_t passes,
+        sample_generator_2d_ptr<T> sampler,
+        frame_function<color_type> frame = nullptr,
+        const std::string& checkpoint_file = std::string(),
+        const render_options& options = render_options()
+    )
+    {
+        accumulation_buffer<color_type> accumulator(width, height, options.seed);
+        if (!checkpoint_file.empty() && accumulator.load(checkpoint_file))
+        {
+            if ((accumulator.get_width() != width) || (accumulator.get_height() != height))
+            {
+                throw std::runtime_error(string_format("Checkpoint %1 is for a %2x%3 image, not %4x%5",
+                        checkpoint_file, accumulator.get_width(), accumulator.get_height(), width, height));
+            }
+        }
+
+        render_options pass_options = options;
+        pass_options.variance_output = nullptr;
+        pass_options.samples_output = nullptr;
+        pass_options.tile_finished = nullptr;
+        pass_options.keep_image = true;
+
+        while (accumulator.passes() < passes)
+        {
+            pass_options.seed = accumulator.next_seed();
+            raster<color_type> pass = render<T, color_type>(
+                camera, scene, scene_texture, width, height, requirements,
+                brightness, background, samples_per_pass, sampler, nullptr, pass_options);
+            accumulator.add_pass(pass, samples_per_pass);
+
+            if (!checkpoint_file.empty() && !accumulator.save(checkpoint_file))
+            {
+                throw std::runtime_error("Unable to save checkpoint: " + checkpoint_file);
+            }
+            if (frame)
+            {
+                frame(accumulator.average(), accumulator.passes());
+            }
+        }
+
+        return accumulator.average();
+    }
+}
@@ -4,6 +4,8 @@
 #include "amethyst/general/extra_exceptions.hpp"
 #include "amethyst/general/template_functions.hpp"
 #include "amethyst/general/string_format.hpp"
+#include "amethyst/graphics/raster_view.hpp"
+#include <memory>
 #include <string>
 
 namespace amethyst
@@ -16,6 +18,12 @@ namespace amethyst
      * raster graphics and possibly lots of other fun stuff.  Note:  It does NOT
      * have iterators (at this time).
      *
+     * The pixels are normally allocated by the raster, but can instead belong
+     * to some other storage (such as a memory mapped file, see
+     * mapped_raster.hpp), which the raster keeps alive.  Copies always have
+     * their own pixels; use view() to work on part of a raster without
+     * copying it.
+     *
      * @author Kevin Harris <kpharris@users.sourceforge.net>
      * @version $Revision: 1.9 $
      *
@@ -27,6 +35,12 @@ namespace amethyst
         raster() = default;
         /** Size-specified constructor.  Creates a width by height sized raster */
         raster(size_t width, size_t height);
+        /**
+         * Use the width by height pixels at data, which belong to storage,
+         * instead of allocating them.  The storage is released when the
+         * raster is destroyed or resized.
+         */
+        raster(size_t width, size_t height, T* data, std::shared_ptr<void> storage);
         virtual ~raster();
         raster(const raster& old);
         raster(raster&& old) noexcept;
@@ -73,6 +87,30 @@ namespace amethyst
         raster<T> sub_raster(size_t x1, size_t y1,
                              size_t x2, size_t y2) const;
 
+        /** A view of the whole raster. */
+        raster_view<T> view()
+        {
+            return raster_view<T>(raster_data, width, height);
+        }
+        raster_view<const T> view() const
+        {
+            return raster_view<const T>(raster_data, width, height);
+        }
+
+        /**
+         * A view of the elements in the range (x1,y1) to (x2,y2) inclusive,
+         * which (unlike sub_raster) shares this raster's data.
+         * @throws out_of_range if any of x1, y1, x2, or y2 are out of range.
+         */
+        raster_view<T> view(size_t x1, size_t y1, size_t x2, size_t y2)
+        {
+            return view().sub_view(x1, y1, x2, y2);
+        }
+        raster_view<const T> view(size_t x1, size_t y1, size_t x2, size_t y2) const
+        {
+            return view().sub_view(x1, y1, x2, y2);
+        }
+
         /**
          * Resize the current raster to the given width and height.  If preserve is
          * given, the current data (if any), is copied across. If either width or
@@ -164,11 +202,16 @@ namespace amethyst
             }
         }
     private:
+        /** Free the data (or let go of the storage that holds it). */
+        void release_data();
+
         /** The width and height of the raster */
         size_t width = 0;
         size_t height = 0;
         /** The actual raster data. */
         T* raster_data = nullptr;
+        /** What holds the data, if it was not allocated by the raster. */
+        std::shared_ptr<void> storage;
     };
 
 
@@ -271,15 +314,34 @@ namespace amethyst
         }
     }
 
+    template <class T>
+    raster<T>::raster(size_t w, size_t h, T* data, std::shared_ptr<void> storage)
+        : width(w), height(h), raster_data(data), storage(std::move(storage))
+    {
+    }
+
     template <class T>
     raster<T>::~raster()
     {
-        delete[] raster_data;
-        raster_data = nullptr;
+        release_data();
         width = 0;
         height = 0;
     }
 
+    template <class T>
+    void raster<T>::release_data()
+    {
+        if (storage)
+        {
+            storage.reset();
+        }
+        else
+        {
+            delete[] raster_data;
+        }
+        raster_data = nullptr;
+    }
+
     template <class T>
     raster<T>::raster(const raster<T>& old)
         : width(old.width)
@@ -310,7 +372,7 @@ namespace amethyst
 
     template <class T>
     raster<T>::raster(raster<T>&& old) noexcept
-        : width(old.width), height(old.height), raster_data(old.raster_data)
+        : width(old.width), height(old.height), raster_data(old.raster_data), storage(std::move(old.storage))
     {
         old.width = 0;
         old.height = 0;
@@ -325,8 +387,7 @@ namespace amethyst
             return *this;
         }
 
-        delete[] raster_data;
-        raster_data = nullptr;
+        release_data();
         width = old.width;
         height = old.height;
 
@@ -352,6 +413,7 @@ namespace amethyst
         width = old.width;
         height = old.height;
         std::swap(raster_data, old.raster_data);
+        std::swap(storage, old.storage);
         return *this;
     }
 
@@ -442,6 +504,7 @@ namespace amethyst
         {
             return;
         }
+        std::shared_ptr<void> old_storage = std::move(storage);
 
         if ((width > 0) && (height > 0))
         {
@@ -472,7 +535,10 @@ namespace amethyst
         }
 
         // Delete the old data (if any).
-        delete[] old_data;
+        if (!old_storage)
+        {
+            delete[] old_data;
+        }
     }
 
     template <class T>
@@ -490,6 +556,7 @@ namespace amethyst
         {
             return;
         }
+        std::shared_ptr<void> old_storage = std::move(storage);
 
         if ((width > 0) && (height > 0))
         {
@@ -588,7 +655,10 @@ namespace amethyst
         }
 
         // Delete the old data (if any). Deleting NULL should be safe.
-        delete[] old_data;
+        if (!old_storage)
+        {
+            delete[] old_data;
+        }
     }
 
     // **********************************************************************
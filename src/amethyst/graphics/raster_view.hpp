@@ -0,0 +1,143 @@
+#pragma once
+
+#include "amethyst/general/extra_exceptions.hpp"
+#include "amethyst/general/textized.hpp"
+#include "amethyst/general/string_format.hpp"
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+namespace amethyst
+{
+    template <class T> class raster;
+
+    /**
+     *
+     * A view of a rectangle of pixels that are owned by something else (a
+     * raster, a mapped file, or a buffer from another library).  Rows are
+     * stride elements apart, so a view of part of a raster needs no copy.
+     *
+     * A view does not keep its pixels alive: it must not outlive the raster
+     * (or other storage) it was made from, or be used after that is resized.
+     * Use raster_view<const T> for read-only access.
+     *
+     * @author Kevin Harris <kpharris@users.sourceforge.net>
+     * @version $Revision: 1.0 $
+     *
+     */
+    template <class T>
+    class raster_view
+    {
+    public:
+        using value_type = typename std::remove_const<T>::type;
+
+        raster_view() = default;
+        raster_view(T* data, size_t width, size_t height, size_t stride)
+            : view_data(data), width(width), height(height), stride(stride)
+        {
+        }
+        raster_view(T* data, size_t width, size_t height)
+            : raster_view(data, width, height, width)
+        {
+        }
+
+        // A non-const view can be used as a const one.
+        template <class U, typename = typename std::enable_if<std::is_same<const U, T>::value && !std::is_same<U, T>::value>::type>
+        raster_view(const raster_view<U>& other)
+            : raster_view(other.data(), other.get_width(), other.get_height(), other.get_stride())
+        {
+        }
+
+        /**
+         * Get the element at the given (x,y)
+         * @throws out_of_range if either x or y is out of range.
+         */
+        T& operator()(size_t x, size_t y) const
+        {
+            if ((x < width) && (y < height))
+            {
+                return view_data[x + y * stride];
+            }
+            throw out_of_range(string_format("raster_view<T>::op()(%1,%2): %3", x, y, intl("index is out of range")));
+        }
+
+        /** The first element of row y (unchecked). */
+        T* row(size_t y) const
+        {
+            return view_data + y * stride;
+        }
+
+        /**
+         * Return a view of the elements in the range (x1,y1) to (x2,y2)
+         * inclusive, which shares this view's data.
+         * @throws out_of_range if any of x1, y1, x2, or y2 are out of range.
+         */
+        raster_view sub_view(size_t x1, size_t y1, size_t x2, size_t y2) const;
+
+        /** Copy the viewed pixels into a new raster. */
+        raster<value_type> copy() const;
+
+        void fill(const value_type& t) const
+        {
+            for (size_t y = 0; y < height; ++y)
+            {
+                std::fill(row(y), row(y) + width, t);
+            }
+        }
+
+        void fill(std::function<value_type(size_t x, size_t y)> generator) const
+        {
+            for (size_t y = 0; y < height; ++y)
+            {
+                T* line = row(y);
+                for (size_t x = 0; x < width; ++x)
+                {
+                    line[x] = generator(x, y);
+                }
+            }
+        }
+
+        T* data() const { return view_data; }
+        size_t get_width() const { return width; }
+        size_t get_height() const { return height; }
+        /** The number of elements from the start of one row to the next. */
+        size_t get_stride() const { return stride; }
+        size_t get_numpixels() const { return width * height; }
+        bool empty() const { return view_data == nullptr; }
+        /** If the rows follow each other with no gaps. */
+        bool contiguous() const { return (stride == width) || (height <= 1); }
+
+    private:
+        T* view_data = nullptr;
+        size_t width = 0;
+        size_t height = 0;
+        size_t stride = 0;
+    };
+
+    template <class T>
+    raster_view<T> raster_view<T>::sub_view(size_t x1, size_t y1, size_t x2, size_t y2) const
+    {
+        if ((x2 < width) && (y2 < height))
+        {
+            if ((x1 <= x2) && (y1 <= y2))
+            {
+                return raster_view(view_data + x1 + y1 * stride, x2 - x1 + 1, y2 - y1 + 1, stride);
+            }
+            throw out_of_range(std::string("raster_view<T>::sub_view(...): ") +
+                               intl("dimensions are incorrectly ordered"));
+        }
+        throw out_of_range(std::string("raster_view<T>::sub_view(...): ") +
+                           intl("index is out of range"));
+    }
+
+    template <class T>
+    raster<typename raster_view<T>::value_type> raster_view<T>::copy() const
+    {
+        raster<value_type> result(width, height);
+        for (size_t y = 0; y < height; ++y)
+        {
+            std::copy_n(row(y), width, &result(0, y));
+        }
+        return result;
+    }
+}
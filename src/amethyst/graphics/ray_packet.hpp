@@ -0,0 +1,185 @@
+#pragma once
+
+/*
+   ray_packet.hpp -- A bundle of lines traced together, stored one array per
+   component so that the per-lane loops of the intersection kernels can be
+   turned into SIMD instructions by the compiler.
+ */
+
+#include "amethyst/graphics/shapes/shape_fwd.hpp"
+#include "amethyst/math/unit_line3.hpp"
+#include "amethyst/math/bounding_box.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+namespace amethyst
+{
+    /**
+     *
+     * A packet of (usually coherent) lines, such as neighbouring camera rays.
+     *
+     * The packet is filled with add(), then passed to
+     * shape::intersect_packet(), which records the closest shape hit by each
+     * lane.  Shapes with a packet kernel (spheres, triangles, containers)
+     * test every lane at once; all others fall back to one quick_intersection
+     * per lane.
+     *
+     * Unused lanes have an empty range, so kernels can run over the full
+     * width without checking the count.
+     *
+     * @author Kevin Harris <kpharris@users.sourceforge.net>
+     * @version $Revision: 1.0 $
+     *
+     */
+    template <typename T, typename color_type>
+    class ray_packet
+    {
+    public:
+        // Eight lanes fill two AVX (or four SSE) registers of doubles.
+        static constexpr size_t width = 8;
+
+        ray_packet() { clear(); }
+
+        size_t size() const { return count; }
+        bool full() const { return count == width; }
+        bool empty() const { return count == 0; }
+
+        void clear();
+
+        // Add a line to the next lane, returning the lane used.  The line is
+        // referenced (not copied) for the scalar fallback, so it must outlive
+        // the packet.
+        size_t add(const unit_line3<T>& line, T time = 0);
+
+        const unit_line3<T>& get_line(size_t lane) const { return *lines[lane]; }
+
+        // Record a hit for the lane if it is closer than any found so far.
+        void record_hit(size_t lane, T distance, const shape<T, color_type>* obj)
+        {
+            if ((begin[lane] < distance) && (distance < limit[lane]))
+            {
+                limit[lane] = distance;
+                hit[lane] = obj;
+            }
+        }
+
+        // Test the packet against a box, setting enters[lane] for the lanes
+        // whose current range passes through it.  Returns true if any do.
+        bool intersects(const bounding_box<T>& box, bool* enters) const;
+        // Returns true if any lane's current range passes through the box.
+        bool intersects(const bounding_box<T>& box) const;
+
+        // Line data (direction is unit length).
+        T origin_x[width];
+        T origin_y[width];
+        T origin_z[width];
+        T direction_x[width];
+        T direction_y[width];
+        T direction_z[width];
+        T inverse_x[width];
+        T inverse_y[width];
+        T inverse_z[width];
+        T time[width];
+        // The range of each lane.  'limit' starts at the end of the line, and
+        // is reduced to the closest hit as hits are recorded.
+        T begin[width];
+        T limit[width];
+
+        // The closest shape hit by each lane (nullptr for a miss).
+        const shape<T, color_type>* hit[width];
+
+    private:
+        // The slab test of box_line_tester for one lane.
+        bool lane_intersects(size_t lane, const bounding_box<T>& box) const;
+
+        const unit_line3<T>* lines[width];
+        size_t count;
+    };
+
+    template <typename T, typename color_type>
+    void ray_packet<T, color_type>::clear()
+    {
+        count = 0;
+        for (size_t lane = 0; lane < width; ++lane)
+        {
+            origin_x[lane] = origin_y[lane] = origin_z[lane] = 0;
+            direction_x[lane] = direction_y[lane] = 0;
+            direction_z[lane] = 1;
+            inverse_x[lane] = inverse_y[lane] = std::numeric_limits<T>::max();
+            inverse_z[lane] = 1;
+            time[lane] = 0;
+            begin[lane] = 0;
+            limit[lane] = std::numeric_limits<T>::lowest();
+            hit[lane] = nullptr;
+            lines[lane] = nullptr;
+        }
+    }
+
+    template <typename T, typename color_type>
+    size_t ray_packet<T, color_type>::add(const unit_line3<T>& line, T line_time)
+    {
+        size_t lane = count++;
+        origin_x[lane] = line.origin().x();
+        origin_y[lane] = line.origin().y();
+        origin_z[lane] = line.origin().z();
+        direction_x[lane] = line.direction().x();
+        direction_y[lane] = line.direction().y();
+        direction_z[lane] = line.direction().z();
+        inverse_x[lane] = T(1) / direction_x[lane];
+        inverse_y[lane] = T(1) / direction_y[lane];
+        inverse_z[lane] = T(1) / direction_z[lane];
+        time[lane] = line_time;
+        begin[lane] = line.limits().begin();
+        limit[lane] = line.limits().end();
+        hit[lane] = nullptr;
+        lines[lane] = &line;
+        return lane;
+    }
+
+    template <typename T, typename color_type>
+    bool ray_packet<T, color_type>::lane_intersects(size_t lane, const bounding_box<T>& box) const
+    {
+        const T origin[3] = { origin_x[lane], origin_y[lane], origin_z[lane] };
+        const T inverse[3] = { inverse_x[lane], inverse_y[lane], inverse_z[lane] };
+        T t_near = begin[lane];
+        T t_far = limit[lane];
+        for (unsigned axis = 0; axis < 3; ++axis)
+        {
+            // The same ordering as box_line_tester, so that a NaN (0 *
+            // infinity, for an origin on a slab edge with a zero direction)
+            // leaves the range unchanged, and a lane gets the same answer
+            // as its line does on its own.
+            const unsigned sign = unsigned(inverse[axis] < 0);
+            T t0 = (box.corner(sign)[axis] - origin[axis]) * inverse[axis];
+            T t1 = (box.corner(1 - sign)[axis] - origin[axis]) * inverse[axis];
+            t1 *= box_line_tester<T>::far_scale;
+            t_near = (t0 > t_near) ? t0 : t_near;
+            t_far = (t1 < t_far) ? t1 : t_far;
+        }
+        return t_near <= t_far;
+    }
+
+    template <typename T, typename color_type>
+    bool ray_packet<T, color_type>::intersects(const bounding_box<T>& box, bool* enters) const
+    {
+        bool any = false;
+        for (size_t lane = 0; lane < width; ++lane)
+        {
+            enters[lane] = lane_intersects(lane, box);
+            any |= enters[lane];
+        }
+        return any;
+    }
+
+    template <typename T, typename color_type>
+    bool ray_packet<T, color_type>::intersects(const bounding_box<T>& box) const
+    {
+        bool any = false;
+        for (size_t lane = 0; lane < width; ++lane)
+        {
+            any |= lane_intersects(lane, box);
+        }
+        return any;
+    }
+}
@@ -3,9 +3,12 @@
 #include "amethyst/general/string_format.hpp"
 #include "amethyst/general/defines.hpp"
 #include "amethyst/general/reversable.hpp"
+#include "amethyst/general/random.hpp"
 #include "amethyst/math/point3.hpp"
 #include "amethyst/math/unit_line3.hpp"
 #include "amethyst/graphics/intersection_info.hpp"
+#include <algorithm>
+#include <cmath>
 #include <limits>
 
 namespace amethyst
@@ -85,6 +88,84 @@ namespace amethyst
         return true;
     }
 
+    /**
+     * How a ray's origin and (unit) direction change from one pixel to the
+     * next: one pixel across (dx) and one down (dy).  Carried along with the
+     * ray, these give the area of a surface that a pixel covers where the ray
+     * lands, so textures can be filtered over it (see Igehy, "Tracing Ray
+     * Differentials").
+     */
+    template <typename T>
+    struct ray_differentials
+    {
+        vector3<T> origin_dx;
+        vector3<T> origin_dy;
+        vector3<T> direction_dx;
+        vector3<T> direction_dy;
+
+        // For a pixel that is divided between several samples.
+        void scale(T factor)
+        {
+            origin_dx *= factor;
+            origin_dy *= factor;
+            direction_dx *= factor;
+            direction_dy *= factor;
+        }
+    };
+
+    // The differentials of a ray after it has travelled distance along
+    // direction to a surface with the given normal: the origin differentials
+    // become those of the point hit (on the surface's tangent plane).
+    template <typename T>
+    ray_differentials<T> transfer_differentials(const ray_differentials<T>& d, const vector3<T>& direction, T distance, const vector3<T>& normal)
+    {
+        ray_differentials<T> result = d;
+        result.origin_dx = d.origin_dx + distance * d.direction_dx;
+        result.origin_dy = d.origin_dy + distance * d.direction_dy;
+
+        const T cos = dotprod(direction, normal);
+        if (std::abs(cos) > AMETHYST_EPSILON)
+        {
+            result.origin_dx -= (dotprod(result.origin_dx, normal) / cos) * direction;
+            result.origin_dy -= (dotprod(result.origin_dy, normal) / cos) * direction;
+        }
+        return result;
+    }
+
+    // The direction differentials of a reflection (as done by reflect()).
+    // The surface is treated as flat where it was hit, so curved mirrors
+    // spread the rays more than this gives.
+    template <typename T>
+    void reflect_differentials(ray_differentials<T>& d, const vector3<T>& normal)
+    {
+        d.direction_dx -= (2 * dotprod(d.direction_dx, normal)) * normal;
+        d.direction_dy -= (2 * dotprod(d.direction_dy, normal)) * normal;
+    }
+
+    // The direction differentials of a refraction (as done by refract()),
+    // again treating the surface as flat.
+    template <typename T>
+    void refract_differentials(ray_differentials<T>& d, const vector3<T>& line, vector3<T> normal, T current_ior, T ior)
+    {
+        T cos = dotprod(line, normal);
+        T ni_over_nt = current_ior / ior;
+        if (cos > 0)
+        {
+            ni_over_nt = 1 / ni_over_nt;
+            normal = -normal;
+            cos = -cos;
+        }
+
+        const T radical = 1 - (ni_over_nt * ni_over_nt) * (1 - cos * cos);
+        if (radical <= 0)
+        {
+            return;
+        }
+        const T dmu_dcos = ni_over_nt + (ni_over_nt * ni_over_nt) * cos / sqrt(radical);
+        d.direction_dx = ni_over_nt * d.direction_dx - (dmu_dcos * dotprod(d.direction_dx, normal)) * normal;
+        d.direction_dy = ni_over_nt * d.direction_dy - (dmu_dcos * dotprod(d.direction_dy, normal)) * normal;
+    }
+
     /**
      *
      * A full set of parameters required for a ray.  This is used for
@@ -136,6 +217,25 @@ namespace amethyst
         long get_current_depth() const { return depth; }
         void set_current_depth(long val) { depth = val; }
 
+        // The random number source for materials that scatter randomly.  This
+        // is not owned by the ray, and is passed on to any rays spawned from
+        // this one.  When null, materials use their own generators.
+        random<T>* get_random() const { return random_source; }
+        void set_random(random<T>* r) { random_source = r; }
+
+        // The ray differentials, if whatever made the ray (such as a camera)
+        // gave it some.  Rays scattered in random directions have none.
+        bool have_differentials() const { return has_differentials; }
+        const ray_differentials<T>& get_differentials() const { return differentials; }
+        void set_differentials(const ray_differentials<T>& d) { differentials = d; has_differentials = true; }
+        void clear_differentials() { has_differentials = false; }
+
+        // How wide (in u-v coordinates) the area is that a pixel covers where
+        // this ray hit, for filtering textures.  Needs the ray's
+        // differentials, the intersection's distance, point and normal, and a
+        // shape that knows its u-v derivatives.
+        bool get_uv_footprint(const intersection_info<T,color_type>& info, T& width) const;
+
         // Perform a perfect reflection.
         bool perfect_reflection(const intersection_info<T,color_type>& info, ray_parameters<T,color_type>& results) const;
         // Perform a perfect refraction
@@ -184,6 +284,11 @@ namespace amethyst
         long depth_max = AMETHYST_DEPTH_MAX;
         // The current depth of the ray
         long depth = 0;
+        // Where scattering materials should get their random numbers (not owned).
+        random<T>* random_source = nullptr;
+        // The change of the ray between pixels.
+        ray_differentials<T> differentials;
+        bool has_differentials = false;
 
         bool entered(const shape<T, color_type>* s) const
         {
@@ -301,6 +406,13 @@ namespace amethyst
         limits.set(std::max(AMETHYST_EPSILON, limits.begin()), limits.end());
         results.set_line(unit_line3<T>(point, new_direction, limits));
         results.reflected = true;
+
+        if (has_differentials)
+        {
+            ray_differentials<T> d = transfer_differentials(differentials, line.direction(), distance, normal);
+            reflect_differentials(d, normal);
+            results.set_differentials(d);
+        }
         return true;
     }
 
@@ -340,6 +452,52 @@ namespace amethyst
         }
 
         results.refracted = true;
+
+        if (has_differentials)
+        {
+            ray_differentials<T> d = transfer_differentials(differentials, line.direction(), distance, normal);
+            refract_differentials(d, line.direction(), normal, get_ior(), ior);
+            results.set_differentials(d);
+        }
+        return true;
+    }
+
+    template <typename T, typename color_type>
+    bool ray_parameters<T,color_type>::get_uv_footprint(const intersection_info<T,color_type>& info, T& width) const
+    {
+        if (!has_differentials || !info.have_distance() || !info.have_point() || !info.have_normal() || !info.have_shape())
+        {
+            return false;
+        }
+
+        vector3<T> dp_du;
+        vector3<T> dp_dv;
+        if (!info.get_shape()->get_uv_derivatives(info.get_first_point(), dp_du, dp_dv))
+        {
+            return false;
+        }
+
+        const ray_differentials<T> at_hit = transfer_differentials(differentials, line.direction(), info.get_first_distance(), info.get_normal());
+
+        // The change in (u, v) that moves the point closest to each pixel
+        // step (least squares, as the step is not always in the surface).
+        const T uu = dotprod(dp_du, dp_du);
+        const T uv = dotprod(dp_du, dp_dv);
+        const T vv = dotprod(dp_dv, dp_dv);
+        const T determinant = uu * vv - uv * uv;
+        if (!(determinant > AMETHYST_EPSILON * uu * vv))
+        {
+            return false;
+        }
+        auto uv_length = [&](const vector3<T>& dp)
+        {
+            const T a = dotprod(dp_du, dp);
+            const T b = dotprod(dp_dv, dp);
+            const T du = (vv * a - uv * b) / determinant;
+            const T dv = (uu * b - uv * a) / determinant;
+            return sqrt(du * du + dv * dv);
+        };
+        width = std::max(uv_length(at_hit.origin_dx), uv_length(at_hit.origin_dy));
         return true;
     }
 
@@ -3,6 +3,8 @@
 #include "base_camera.hpp"
 #include "colors.hpp"
 #include "raster.hpp"
+#include "raster_view.hpp"
+#include "rgbcolor.hpp"
 #include "texture/texture.hpp"
 #include "samplegen2d.hpp"
 #include "graphics/shapes/shape.hpp"
@@ -10,8 +12,15 @@
 #include "requirements.hpp"
 #include "samplegen2d.hpp"
 #include "ray_parameters.hpp"
+#include "ray_packet.hpp"
 #include "general/template_functions.hpp"
+#include "general/thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <functional>
+#include <limits>
+#include <type_traits>
 
 namespace amethyst
 {
@@ -27,6 +36,71 @@ namespace amethyst
     template <typename T>
     using progress_function = std::function<void(T percentage)>;
 
+    // How the path of a camera ray is followed after it hits the scene.
+    enum class integrator_type
+    {
+        // sample_scene(): recurse on every scattered ray until its
+        // contribution is negligible.
+        recursive,
+        // trace_path(): follow the path in a loop, with a maximum depth and
+        // russian roulette.
+        iterative
+    };
+
+    // Options for the camera version of render().
+    struct render_options
+    {
+        // The number of threads to render with.  1 renders on the calling
+        // thread, 0 uses every thread the hardware supports.
+        size_t threads = 1;
+        // The image is split into square tiles of this size, which are the
+        // units of work handed out to the threads.
+        size_t tile_size = 16;
+        // Every pixel derives its own random numbers from this seed, so the
+        // output depends only on the seed and not on the number of threads.
+        uint32_t seed = 0;
+        // Trace the camera rays of neighbouring pixels together as packets
+        // (see ray_packet).  Only the first hit of each camera ray is found
+        // this way; everything after it is traced one ray at a time.  The
+        // image is the same either way.
+        bool ray_packets = true;
+
+        integrator_type integrator = integrator_type::recursive;
+        // For the iterative integrator: the most surfaces a path can hit, and
+        // the number hit before paths start being randomly ended (with a
+        // probability based on how little they still contribute).
+        size_t max_depth = 50;
+        size_t roulette_depth = 3;
+
+        // Adaptive sampling, used when adaptive_threshold is above zero.
+        // Every pixel starts with adaptive_min_samples samples.  Then, in each
+        // tile, the pixels whose relative error is still above the threshold
+        // get more samples (adaptive_min_samples at a time, the noisiest
+        // first), until every pixel has converged or the tile has used its
+        // budget of samples_per_pixel samples per pixel.  The relative error
+        // is the standard error of the mean brightness over the brightness.
+        // No pixel gets more than adaptive_max_samples (0 for 8 times
+        // samples_per_pixel).
+        double adaptive_threshold = 0;
+        size_t adaptive_min_samples = 8;
+        size_t adaptive_max_samples = 0;
+
+        // If set, these are resized to the image, and get the variance of the
+        // mean brightness and the number of samples taken for every pixel.
+        raster<double>* variance_output = nullptr;
+        raster<size_t>* samples_output = nullptr;
+
+        // If set, this is called with each tile as soon as it is finished
+        // (with the position of its top left corner), on the thread that
+        // rendered it, so it must be thread safe when there is more than one
+        // thread.  Tiles can be handed to a scanline_writer, so the image is
+        // written while the rest is still being rendered.
+        std::function<void(size_t x, size_t y, const raster_view<const rgbcolor<double>>& pixels)> tile_finished;
+        // If false, render() returns an empty raster, and each tile is only
+        // given to tile_finished, so the whole image is never held at once.
+        bool keep_image = true;
+    };
+
     template <typename T, typename color_type = rgbcolor<T>>
     raster<color_type> render(
         size_t width,
@@ -43,6 +117,7 @@ namespace amethyst
 
         uint64_t last_percentage_x10 = -1;
         uint64_t total_pixels = width * height;
+        std::vector<coord2<T>> samples;
 
         for (size_t y = 0; y < height; ++y)
         {
@@ -56,7 +131,7 @@ namespace amethyst
                 last_percentage_x10 = current_percentage_x10;
 
                 color_type current_color = black;
-                std::vector<coord2<T>> samples = sampler->get_samples(samples_per_pixel);
+                sampler->get_samples(samples_per_pixel, samples);
 
                 for (const auto& sample : samples)
                 {
@@ -74,8 +149,10 @@ namespace amethyst
 
     namespace impl
     {
+        // The texture's color where the ray hit, filtered over the pixel's
+        // footprint when the ray has differentials.
         template <typename T, typename color_type>
-        bool get_local_color(const intersection_info<T, color_type>& intersection, const texture_ptr<T,color_type>& tex, color_type& color)
+        bool get_local_color(const ray_parameters<T, color_type>& ray, const intersection_info<T, color_type>& intersection, const texture_ptr<T,color_type>& tex, color_type& color)
         {
             coord2<T> uv{};
             if (intersection.have_uv())
@@ -89,7 +166,11 @@ namespace amethyst
                 normal = intersection.get_normal();
             }
 
-            if (!tex->get_color(intersection.get_first_point(), uv, normal, color))
+            T width;
+            const bool found = (intersection.have_uv() && ray.get_uv_footprint(intersection, width)) ?
+                tex->get_filtered_color(intersection.get_first_point(), uv, normal, width, color) :
+                tex->get_color(intersection.get_first_point(), uv, normal, color);
+            if (!found)
             {
                 color = colors<color_type>::black;
                 return false;
@@ -106,55 +187,318 @@ namespace amethyst
         const texture_ptr<T, color_type> scene_texture,
         const intersection_requirements& requirements,
         const lighting_function<T, color_type>& brightness,
+        const background_function<T, color_type>& background);
+
+    // The color for a ray that hit the scene (described by intersection).
+    template <typename T, typename color_type = rgbcolor<T>>
+    color_type shade_intersection(
+        T x, T y,
+        const ray_parameters<T,color_type>& ray,
+        const intersection_info<T,color_type>& intersection,
+        const shape_ptr<T, color_type>& scene,
+        const texture_ptr<T, color_type> scene_texture,
+        const intersection_requirements& requirements,
+        const lighting_function<T, color_type>& brightness,
         const background_function<T, color_type>& background)
     {
-        intersection_info<T,color_type> intersection;
-        if (scene->intersects_ray(ray, intersection, requirements))
+        color_type light = brightness(intersection.get_first_point(), intersection.get_normal());
+
+        auto tex = intersection.get_shape()->texture();
+        if (!tex)
         {
-            color_type light = brightness(intersection.get_first_point(), intersection.get_normal());
+            tex = scene_texture;
+        }
+
+        bool scattered = false;
+
+        color_type local_color;
+        bool local = impl::get_local_color(ray, intersection, tex, local_color);
 
-            auto tex = intersection.get_shape()->texture();
-            if (!tex)
+        color_type scattered_color = colors<color_type>::black;
+        ray_parameters<T,color_type> scattered_ray;
+        color_type attenuation;
+        if (tex->scatter_ray(ray, intersection, scattered_ray, attenuation))
+        {
+            scattered_ray.set_contribution(attenuation * scattered_ray.get_contribution());
+            // Only send another ray if the contribution large enough to do something.
+            if (scattered_ray.get_scalar_contribution() > AMETHYST_EPSILON)
             {
-                tex = scene_texture;
+                scattered_color = attenuation * sample_scene(x, y, scattered_ray, scene, scene_texture, requirements, brightness, background);
+                scattered = true;
             }
+        }
+
+        if (!scattered && !local)
+        {
+            // A potential point to hit a debugger.  Could mean total internal reflection, border case, etc. that will be fixed by supersampling.
+
+            // std::cout << "scattered nothing, refracted nothing, local texture has no value." << std::endl;
+        }
 
-            bool scattered = false;
+        return clamp_visible(light * local_color + scattered_color);
+    }
 
-            color_type local_color;
-            bool local = impl::get_local_color(intersection, tex, local_color);
+    template <typename T, typename color_type>
+    color_type sample_scene(
+        T x, T y,
+        const ray_parameters<T,color_type>& ray,
+        const shape_ptr<T, color_type>& scene,
+        const texture_ptr<T, color_type> scene_texture,
+        const intersection_requirements& requirements,
+        const lighting_function<T, color_type>& brightness,
+        const background_function<T, color_type>& background)
+    {
+        intersection_info<T,color_type> intersection;
+        if (scene->intersects_ray(ray, intersection, requirements))
+        {
+            return shade_intersection(x, y, ray, intersection, scene, scene_texture, requirements, brightness, background);
+        }
+        else
+        {
+            return background(x, y, ray.get_line());
+        }
+    }
+
+    namespace impl
+    {
+        // Follow a path from a ray that has already hit the scene.
+        template <typename T, typename color_type>
+        color_type follow_path(
+            T x, T y,
+            ray_parameters<T,color_type> ray,
+            intersection_info<T,color_type> intersection,
+            const shape_ptr<T, color_type>& scene,
+            const texture_ptr<T, color_type>& scene_texture,
+            const intersection_requirements& requirements,
+            const lighting_function<T, color_type>& brightness,
+            const background_function<T, color_type>& background,
+            const render_options& options)
+        {
+            color_type result = colors<color_type>::black;
+            color_type throughput = colors<color_type>::white;
+            color_type attenuated = colors<color_type>::white;
 
-            color_type scattered_color = colors<color_type>::black;
-            ray_parameters<T,color_type> scattered_ray;
-            color_type attenuation;
-            if (tex->scatter_ray(ray, intersection, scattered_ray, attenuation))
+            for (size_t depth = 1; ; ++depth)
             {
-                scattered_ray.set_contribution(attenuation * scattered_ray.get_contribution());
-                // Only send another ray if the contribution large enough to do something.
-                if (scattered_ray.get_scalar_contribution() > AMETHYST_EPSILON)
+                color_type light = brightness(intersection.get_first_point(), intersection.get_normal());
+
+                auto tex = intersection.get_shape()->texture();
+                if (!tex)
                 {
-                    scattered_color = attenuation * sample_scene(x, y, scattered_ray, scene, scene_texture, requirements, brightness, background);
-                    scattered = true;
+                    tex = scene_texture;
+                }
+
+                color_type local_color;
+                get_local_color(ray, intersection, tex, local_color);
+                result += throughput * light * local_color;
+
+                ray_parameters<T,color_type> scattered_ray;
+                color_type attenuation;
+                if (depth >= options.max_depth || !tex->scatter_ray(ray, intersection, scattered_ray, attenuation))
+                {
+                    break;
+                }
+
+                throughput = throughput * attenuation;
+                attenuated = attenuated * attenuation;
+                T strength = std::max(std::max(attenuated[0], attenuated[1]), attenuated[2]);
+                if (strength <= AMETHYST_EPSILON)
+                {
+                    break;
+                }
+
+                // Russian roulette: end weak paths early, and boost the
+                // survivors so the expected result is unchanged.  The chance of
+                // surviving is based on the attenuation alone (without the
+                // boosts), so that long paths keep getting ended.
+                if (depth >= options.roulette_depth && ray.get_random() != nullptr)
+                {
+                    T survival = std::min(strength, T(0.95));
+                    if (ray.get_random()->next() >= survival)
+                    {
+                        break;
+                    }
+                    throughput = throughput / survival;
+                }
+
+                ray = std::move(scattered_ray);
+                if (!scene->intersects_ray(ray, intersection, requirements))
+                {
+                    result += throughput * background(x, y, ray.get_line());
+                    break;
                 }
             }
 
-            if (!scattered && !local)
+            return clamp_visible(result);
+        }
+    }
+
+    // An alternative to sample_scene() that follows the path of the ray in a
+    // loop (so the stack does not grow with the depth), ending it after
+    // options.max_depth surfaces, or earlier with russian roulette (when the
+    // ray has a random number source).  Colors are clamped only at the end
+    // of the path, rather than at every surface.
+    template <typename T, typename color_type = rgbcolor<T>>
+    color_type trace_path(
+        T x, T y,
+        const ray_parameters<T,color_type>& ray,
+        const shape_ptr<T, color_type>& scene,
+        const texture_ptr<T, color_type>& scene_texture,
+        const intersection_requirements& requirements,
+        const lighting_function<T, color_type>& brightness,
+        const background_function<T, color_type>& background,
+        const render_options& options)
+    {
+        intersection_info<T,color_type> intersection;
+        if (scene->intersects_ray(ray, intersection, requirements))
+        {
+            return impl::follow_path(x, y, ray, intersection, scene, scene_texture, requirements, brightness, background, options);
+        }
+        return background(x, y, ray.get_line());
+    }
+
+    namespace impl
+    {
+        template <typename T, typename color_type>
+        void scale_differentials(ray_parameters<T, color_type>& ray, T factor)
+        {
+            if (ray.have_differentials() && (factor != 1))
             {
-                // A potential point to hit a debugger.  Could mean total internal reflection, border case, etc. that will be fixed by supersampling.
+                ray_differentials<T> d = ray.get_differentials();
+                d.scale(factor);
+                ray.set_differentials(d);
+            }
+        }
+
+        struct render_tile
+        {
+            size_t x_begin;
+            size_t y_begin;
+            size_t x_end;
+            size_t y_end;
+
+            size_t pixels() const { return (x_end - x_begin) * (y_end - y_begin); }
+        };
+
+        inline std::vector<render_tile> split_into_tiles(size_t width, size_t height, size_t tile_size)
+        {
+            tile_size = std::max<size_t>(tile_size, 1);
 
-                // std::cout << "scattered nothing, refracted nothing, local texture has no value." << std::endl;
+            std::vector<render_tile> tiles;
+            for (size_t y = 0; y < height; y += tile_size)
+            {
+                for (size_t x = 0; x < width; x += tile_size)
+                {
+                    tiles.push_back({ x, y, std::min(x + tile_size, width), std::min(y + tile_size, height) });
+                }
             }
+            return tiles;
+        }
+
+        // Mix a render seed and pixel location into a seed for that pixel's
+        // random numbers (the splitmix64 finalizer).
+        inline uint32_t pixel_seed(uint32_t seed, size_t x, size_t y)
+        {
+            uint64_t z = (uint64_t(seed) << 32) ^ (uint64_t(y) * 0x9E3779B97F4A7C15ULL) ^ uint64_t(x);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return uint32_t((z ^ (z >> 31)) >> 16);
+        }
 
-            return clamp_visible(light * local_color + scattered_color);
+        template <typename color_type>
+        void report_tile(const render_options& options, size_t x, size_t y, const raster_view<const color_type>& pixels)
+        {
+            if constexpr (std::is_same<color_type, rgbcolor<double>>::value)
+            {
+                options.tile_finished(x, y, pixels);
+            }
+            else
+            {
+                raster<rgbcolor<double>> converted(pixels.get_width(), pixels.get_height());
+                converted.fill([&](size_t px, size_t py)
+                    {
+                        const color_type& c = pixels(px, py);
+                        return rgbcolor<double>(c.r(), c.g(), c.b());
+                    });
+                options.tile_finished(x, y, converted.view());
+            }
         }
-        else
+
+        template <typename color_type>
+        double brightness(const color_type& c)
         {
-            return background(x, y, ray.get_line());
+            return 0.2126 * c.r() + 0.7152 * c.g() + 0.0722 * c.b();
         }
+
+        // The samples of one pixel: their sum, and the running mean and
+        // variance of their brightness (Welford's method).
+        template <typename color_type>
+        struct pixel_statistics
+        {
+            color_type sum = colors<color_type>::black;
+            size_t count = 0;
+            double mean = 0;
+            double m2 = 0;
+
+            void add(const color_type& c)
+            {
+                sum += c;
+                ++count;
+                double b = brightness(c);
+                double delta = b - mean;
+                mean += delta / count;
+                m2 += delta * (b - mean);
+            }
+
+            double variance_of_mean() const
+            {
+                return (count > 1) ? m2 / ((count - 1) * count) : std::numeric_limits<double>::max();
+            }
+
+            // Relative to the brightness plus a little, so that black pixels
+            // can converge.
+            double relative_error() const
+            {
+                return std::sqrt(variance_of_mean()) / (std::abs(mean) + 0.01);
+            }
+        };
+
+        // Reports progress (in 0.1% steps) as pixels are completed.  Only
+        // used from the thread that called render().
+        template <typename T>
+        class progress_reporter
+        {
+        public:
+            progress_reporter(const progress_function<T>& fn, uint64_t total_pixels)
+                : m_progress(fn)
+                , m_total_pixels(std::max<uint64_t>(total_pixels, 1))
+            {
+            }
+
+            void report(uint64_t completed_pixels)
+            {
+                uint64_t current_percentage_x10 = 1000 * completed_pixels / m_total_pixels;
+                if (current_percentage_x10 != m_last_percentage_x10 && m_progress)
+                {
+                    m_progress(current_percentage_x10 / 10.0);
+                }
+                m_last_percentage_x10 = current_percentage_x10;
+            }
+        private:
+            const progress_function<T>& m_progress;
+            uint64_t m_total_pixels;
+            uint64_t m_last_percentage_x10 = uint64_t(-1);
+        };
     }
 
     // This will change a whole bunch as we progress, but there is way too much
     // duplicated code in the samples that are being written.
+    //
+    // The image is rendered in tiles, optionally on several threads.  Each
+    // pixel reseeds a private copy of the sampler and the random numbers used
+    // by scattering materials from options.seed, so the resulting image is
+    // identical no matter how many threads are used or in which order the
+    // tiles are completed.
     template <typename T, typename color_type = rgbcolor<T>>
     raster<color_type> render(
         camera_ptr<T, color_type> camera,
@@ -167,7 +511,8 @@ namespace amethyst
         background_function<T, color_type> background = nullptr,
         size_t samples_per_pixel = 1,
         sample_generator_2d_ptr<T> sampler = std::make_shared<regular_sample_2d<T>>(),
-        progress_function<T> progress = nullptr
+        progress_function<T> progress = nullptr,
+        const render_options& options = render_options()
     )
     {
         // If no background function was give, apply a gradient.
@@ -180,12 +525,291 @@ namespace amethyst
             };
         }
 
-        auto color = [&](T x, T y)
+        raster<color_type> result;
+        if (options.keep_image)
+        {
+            result = raster<color_type>(width, height);
+        }
+        if (options.variance_output)
         {
-            ray_parameters<T,color_type> r = camera->get_ray(x, y);
-            return sample_scene(x, y, r, scene, scene_texture, requirements, brightness, background);
+            *options.variance_output = raster<double>(width, height);
+        }
+        if (options.samples_output)
+        {
+            *options.samples_output = raster<size_t>(width, height);
+        }
+
+        const bool adaptive = options.adaptive_threshold > 0;
+        const size_t first_samples = adaptive ? std::max<size_t>(options.adaptive_min_samples, 2) : samples_per_pixel;
+        const size_t max_samples = options.adaptive_max_samples ? options.adaptive_max_samples : 8 * samples_per_pixel;
+
+        // The packets only find the closest hit, so anything needing more than
+        // that is traced one ray at a time.
+        const bool use_packets = options.ray_packets && !requirements.needs_all_hits() && !requirements.needs_containers();
+
+        // Each sample covers a part of its pixel, so textures are filtered
+        // over less of it.
+        const T differential_scale = 1 / std::sqrt(T(std::max<size_t>(samples_per_pixel, 1)));
+
+        const bool iterative = options.integrator == integrator_type::iterative;
+        auto integrate = [&](T a, T b, const ray_parameters<T, color_type>& r)
+        {
+            return iterative ?
+                trace_path(a, b, r, scene, scene_texture, requirements, brightness, background, options) :
+                sample_scene(a, b, r, scene, scene_texture, requirements, brightness, background);
+        };
+        auto integrate_hit = [&](T a, T b, const ray_parameters<T, color_type>& r, const intersection_info<T, color_type>& intersection)
+        {
+            return iterative ?
+                impl::follow_path(a, b, r, intersection, scene, scene_texture, requirements, brightness, background, options) :
+                shade_intersection(a, b, r, intersection, scene, scene_texture, requirements, brightness, background);
+        };
+
+        auto render_one_tile = [&](const impl::render_tile& tile)
+        {
+            // Samplers carry state, so each tile gets a private copy (with its
+            // own random generator) of the one that was passed in.
+            std::unique_ptr<sample_generator_2d<T>> tile_sampler = sampler->clone_new();
+            tile_sampler->set_rand_gen(sampler->get_rand_gen());
+
+            // The pixels of each row are handled in groups.  The camera rays
+            // for the whole group are traced as packets, then each pixel is
+            // shaded in turn with its own random numbers (so the scattering is
+            // the same as when tracing one ray at a time).
+            const size_t group_size = use_packets ? ray_packet<T, color_type>::width : 1;
+            std::vector<default_random<T>> group_random(group_size, default_random<T>(0));
+            std::vector<size_t> group_samples(group_size);
+            // Reused for every pixel, so the loops below allocate nothing once
+            // the first group has been done.
+            std::vector<coord2<T>> samples;
+            std::vector<coord2<T>> positions;
+            std::vector<ray_parameters<T, color_type>> rays;
+            std::vector<const shape<T, color_type>*> hits;
+            ray_packet<T, color_type> packet;
+
+            const size_t tile_width = tile.x_end - tile.x_begin;
+            std::vector<impl::pixel_statistics<color_type>> statistics(tile.pixels());
+
+            for (size_t y = tile.y_begin; y < tile.y_end; ++y)
+            {
+                for (size_t group_x = tile.x_begin; group_x < tile.x_end; group_x += group_size)
+                {
+                    const size_t group_end = std::min(group_x + group_size, tile.x_end);
+
+                    positions.clear();
+                    rays.clear();
+                    for (size_t x = group_x; x < group_end; ++x)
+                    {
+                        uint32_t seed = impl::pixel_seed(options.seed, x, y);
+                        tile_sampler->set_seed(seed);
+                        group_random[x - group_x].set_seed(~seed);
+
+                        tile_sampler->get_samples(first_samples, samples);
+                        group_samples[x - group_x] = samples.size();
+                        for (const auto& sample : samples)
+                        {
+                            T a = x + sample.x();
+                            T b = y + sample.y();
+
+                            positions.emplace_back(a, b);
+                            rays.push_back(camera->get_ray(a, b));
+                            rays.back().set_random(&group_random[x - group_x]);
+                            impl::scale_differentials(rays.back(), differential_scale);
+                        }
+                    }
+
+                    if (use_packets)
+                    {
+                        hits.assign(rays.size(), nullptr);
+                        for (size_t first = 0; first < rays.size(); first += packet.width)
+                        {
+                            packet.clear();
+                            for (size_t i = first; i < std::min(first + packet.width, rays.size()); ++i)
+                            {
+                                packet.add(rays[i].get_line(), rays[i].get_time());
+                            }
+                            scene->intersect_packet(packet);
+                            std::copy(packet.hit, packet.hit + packet.size(), hits.begin() + first);
+                        }
+                    }
+
+                    auto shade = [&](size_t ray_index)
+                    {
+                        T a = positions[ray_index].x();
+                        T b = positions[ray_index].y();
+                        const ray_parameters<T, color_type>& r = rays[ray_index];
+
+                        if (!use_packets)
+                        {
+                            return integrate(a, b, r);
+                        }
+
+                        // Only the shape that was hit needs the full
+                        // intersection (normal, uv, etc).
+                        intersection_info<T, color_type> intersection;
+                        if (hits[ray_index] == nullptr)
+                        {
+                            return background(a, b, r.get_line());
+                        }
+                        else if (hits[ray_index]->intersects_ray(r, intersection, requirements))
+                        {
+                            return integrate_hit(a, b, r, intersection);
+                        }
+                        return integrate(a, b, r);
+                    };
+
+                    size_t ray_index = 0;
+                    for (size_t x = group_x; x < group_end; ++x)
+                    {
+                        impl::pixel_statistics<color_type>& pixel = statistics[(y - tile.y_begin) * tile_width + (x - tile.x_begin)];
+                        for (size_t i = 0; i < group_samples[x - group_x]; ++i, ++ray_index)
+                        {
+                            pixel.add(shade(ray_index));
+                        }
+                    }
+                }
+            }
+
+            if (adaptive)
+            {
+                // Later rounds reseed every pixel differently, and shift its
+                // samples by a random offset (wrapping around the pixel), so
+                // each batch of samples is independent of the ones before it,
+                // even from a sampler that always gives the same positions
+                // (such as regular_sample_2d).  The shift keeps any
+                // stratification the sampler has.
+                size_t used = 0;
+                for (const auto& pixel : statistics)
+                {
+                    used += pixel.count;
+                }
+                const size_t budget = samples_per_pixel * tile.pixels();
+                std::vector<std::pair<double, size_t>> noisy;
+                default_random<T> pixel_random(0);
+
+                for (uint32_t round = 1; used < budget; ++round)
+                {
+                    noisy.clear();
+                    for (size_t i = 0; i < statistics.size(); ++i)
+                    {
+                        double error = statistics[i].relative_error();
+                        if (error > options.adaptive_threshold && statistics[i].count < max_samples)
+                        {
+                            noisy.emplace_back(error, i);
+                        }
+                    }
+                    if (noisy.empty())
+                    {
+                        break;
+                    }
+                    std::sort(noisy.begin(), noisy.end(), [](const auto& a, const auto& b)
+                        {
+                            return (a.first > b.first) || ((a.first == b.first) && (a.second < b.second));
+                        });
+
+                    for (const auto& n : noisy)
+                    {
+                        if (used >= budget)
+                        {
+                            break;
+                        }
+                        size_t x = tile.x_begin + n.second % tile_width;
+                        size_t y = tile.y_begin + n.second / tile_width;
+                        uint32_t seed = impl::pixel_seed(options.seed + round * 0x9E3779B9u, x, y);
+                        tile_sampler->set_seed(seed);
+                        pixel_random.set_seed(~seed);
+
+                        tile_sampler->get_samples(first_samples, samples);
+                        const T shift_x = pixel_random.next();
+                        const T shift_y = pixel_random.next();
+                        for (const auto& sample : samples)
+                        {
+                            const T sx = sample.x() + shift_x;
+                            const T sy = sample.y() + shift_y;
+                            T a = x + (sx - std::floor(sx));
+                            T b = y + (sy - std::floor(sy));
+                            ray_parameters<T, color_type> r = camera->get_ray(a, b);
+                            r.set_random(&pixel_random);
+                            impl::scale_differentials(r, differential_scale);
+                            statistics[n.second].add(integrate(a, b, r));
+                        }
+                        used += samples.size();
+                    }
+                }
+            }
+
+            raster<color_type> tile_pixels;
+            raster_view<color_type> output;
+            if (options.keep_image)
+            {
+                output = result.view(tile.x_begin, tile.y_begin, tile.x_end - 1, tile.y_end - 1);
+            }
+            else
+            {
+                tile_pixels = raster<color_type>(tile_width, tile.y_end - tile.y_begin);
+                output = tile_pixels.view();
+            }
+
+            for (size_t y = tile.y_begin; y < tile.y_end; ++y)
+            {
+                for (size_t x = tile.x_begin; x < tile.x_end; ++x)
+                {
+                    const impl::pixel_statistics<color_type>& pixel = statistics[(y - tile.y_begin) * tile_width + (x - tile.x_begin)];
+                    output(x - tile.x_begin, y - tile.y_begin) = pixel.sum / T(pixel.count);
+                    if (options.variance_output)
+                    {
+                        (*options.variance_output)(x, y) = pixel.variance_of_mean();
+                    }
+                    if (options.samples_output)
+                    {
+                        (*options.samples_output)(x, y) = pixel.count;
+                    }
+                }
+            }
+
+            if (options.tile_finished)
+            {
+                impl::report_tile(options, tile.x_begin, tile.y_begin, raster_view<const color_type>(output));
+            }
         };
 
-        return render<T, color_type>(width, height, color, samples_per_pixel, sampler, progress);
+        std::vector<impl::render_tile> tiles = impl::split_into_tiles(width, height, options.tile_size);
+        impl::progress_reporter<T> reporter(progress, uint64_t(width) * height);
+
+        size_t thread_count = options.threads ? options.threads : thread_pool::default_thread_count();
+        if (thread_count <= 1 || tiles.size() <= 1)
+        {
+            uint64_t completed = 0;
+            for (const auto& tile : tiles)
+            {
+                reporter.report(completed);
+                render_one_tile(tile);
+                completed += tile.pixels();
+            }
+            reporter.report(completed);
+            return result;
+        }
+
+        // Workers only bump a counter once per tile; the calling thread polls
+        // it and is the only one to ever call the progress function.
+        std::atomic<uint64_t> completed(0);
+        thread_pool pool(std::min(thread_count, tiles.size()));
+        for (const auto& tile : tiles)
+        {
+            pool.submit([&, tile]()
+            {
+                render_one_tile(tile);
+                completed.fetch_add(tile.pixels(), std::memory_order_relaxed);
+            });
+        }
+
+        reporter.report(0);
+        while (!pool.wait_for(std::chrono::milliseconds(50)))
+        {
+            reporter.report(completed.load(std::memory_order_relaxed));
+        }
+        reporter.report(completed.load(std::memory_order_relaxed));
+
+        return result;
     }
-}
\ No newline at end of file
+}
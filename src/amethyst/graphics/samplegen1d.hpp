@@ -55,9 +55,10 @@ namespace amethyst
         {
         }
         virtual ~random_sample_1d() = default;
-        std::vector<T> get_samples(size_t num_samples) override;
+        using parent::get_samples;
+        void get_samples(size_t num_samples, std::vector<T>& samples) override;
         void get_samples(size_t num_samples, typename parent::sample_output_fn pf) override;
-        std::unique_ptr<random_sample_1d<T>> clone_new() const override
+        std::unique_ptr<sample_generator_1d<T>> clone_new() const override
         {
             return std::make_unique<random_sample_1d<T>>(*this);
         }
@@ -74,9 +75,10 @@ namespace amethyst
         {
         }
         virtual ~regular_sample_1d() = default;
-        std::vector<T> get_samples(size_t num_samples) override;
+        using parent::get_samples;
+        void get_samples(size_t num_samples, std::vector<T>& samples) override;
         void get_samples(size_t num_samples, typename parent::sample_output_fn pf) override;
-        std::unique_ptr<regular_sample_1d<T>> clone_new() const override
+        std::unique_ptr<sample_generator_1d<T>> clone_new() const override
         {
             return std::make_unique<regular_sample_1d<T>>(*this);
         }
@@ -93,7 +95,8 @@ namespace amethyst
         {
         }
         virtual ~jitter_sample_1d() = default;
-        std::vector<T> get_samples(size_t num_samples) override;
+        using parent::get_samples;
+        void get_samples(size_t num_samples, std::vector<T>& samples) override;
         void get_samples(size_t num_samples, typename parent::sample_output_fn pf) override;
         std::unique_ptr<sample_generator_1d<T>> clone_new() const override
         {
@@ -115,7 +118,8 @@ namespace amethyst
         {
         }
         virtual ~poisson_sample_1d() = default;
-        std::vector<T> get_samples(size_t num_samples) override;
+        using parent::get_samples;
+        void get_samples(size_t num_samples, std::vector<T>& samples) override;
         void get_samples(size_t num_samples, typename parent::sample_output_fn pf) override;
         std::unique_ptr<sample_generator_1d<T>> clone_new() const override
         {
@@ -126,16 +130,13 @@ namespace amethyst
     };
 
     template <class T>
-    std::vector<T> random_sample_1d<T>::get_samples(size_t num_samples)
+    void random_sample_1d<T>::get_samples(size_t num_samples, std::vector<T>& samples)
     {
-        std::vector<T> v;
-        int i;
-
-        for (i = 0; i < num_samples; ++i)
+        samples.clear();
+        for (size_t i = 0; i < num_samples; ++i)
         {
-            v.push_back(sample_generator_1d<T>::next_rand());
+            samples.push_back(sample_generator_1d<T>::next_rand());
         }
-        return v;
     }
 
     template <class T>
@@ -149,15 +150,14 @@ namespace amethyst
     }
 
     template <class T>
-    std::vector<T> regular_sample_1d<T>::get_samples(size_t num_samples)
+    void regular_sample_1d<T>::get_samples(size_t num_samples, std::vector<T>& samples)
     {
         const T scalar = NEAR_ONE / T(num_samples + 1);
-        std::vector<T> v;
-        for (int x = 1; x <= num_samples; ++x)
+        samples.clear();
+        for (size_t x = 1; x <= num_samples; ++x)
         {
-            v.push_back(x * scalar);
+            samples.push_back(x * scalar);
         }
-        return v;
     }
 
     template <class T>
@@ -171,15 +171,13 @@ namespace amethyst
     }
 
     template <class T>
-    std::vector<T> jitter_sample_1d<T>::get_samples(size_t num_samples)
+    void jitter_sample_1d<T>::get_samples(size_t num_samples, std::vector<T>& samples)
     {
-        int x;
-        std::vector<T> v;
-        for (x = 0; x < num_samples; ++x)
+        samples.clear();
+        for (size_t x = 0; x < num_samples; ++x)
         {
-            v.push_back((x + sample_generator_1d<T>::next_rand()) / T(num_samples));
+            samples.push_back((x + sample_generator_1d<T>::next_rand()) / T(num_samples));
         }
-        return v;
     }
 
     template <class T>
@@ -193,11 +191,11 @@ namespace amethyst
     }
 
     template <class T>
-    std::vector<T> poisson_sample_1d<T>::get_samples(size_t num_samples)
+    void poisson_sample_1d<T>::get_samples(size_t num_samples, std::vector<T>& samples)
     {
-        std::vector<T> samples(num_samples);
-        int samples_gathered = 0;
-        int current_sample;
+        samples.resize(num_samples);
+        size_t samples_gathered = 0;
+        size_t current_sample;
         T next_point;
 
         while (samples_gathered < num_samples)
@@ -215,13 +213,13 @@ namespace amethyst
                 ++samples_gathered;
             }
         }
-        return samples;
     }
 
     template <class T>
     void poisson_sample_1d<T>::get_samples(size_t num_samples, typename sample_generator_1d<T>::sample_output_fn pf)
     {
-        std::vector<T> v = get_samples(num_samples);
+        std::vector<T> v;
+        get_samples(num_samples, v);
         for (T t : v)
         {
             pf(t);
@@ -21,9 +21,17 @@
    16May2004 Changed the names from 3d to 2d.  Added a clone function.
    Added nrooks and multi-jitter sample generators.
    06Apr2018 Refactored a bit, made more C++11-ish.
+   17Oct2026 Added the sobol, halton and blue noise sample generators.
  */
 
 #include "samplegen_base.hpp"
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 
 namespace amethyst
 {
@@ -56,16 +64,14 @@ namespace amethyst
         random_sample_2d(const typename parent::random_type& r = default_random<T>()) : parent(r) {}
         virtual ~random_sample_2d() = default;
 
-        std::vector<coord2<T>> get_samples(size_t num_samples) override
+        using parent::get_samples;
+        void get_samples(size_t num_samples, std::vector<coord2<T>>& samples) override
         {
-            std::vector<coord2<T>> v;
-            v.reserve(num_samples);
-
+            samples.clear();
             for (size_t i = 0; i < num_samples; ++i)
             {
-                v.emplace_back(sample_generator_2d<T>::next_rand());
+                samples.emplace_back(sample_generator_2d<T>::next_rand());
             }
-            return v;
         }
 
         void get_samples(size_t num_samples, typename parent::sample_output_fn pf) override
@@ -95,24 +101,21 @@ namespace amethyst
         virtual ~regular_sample_2d() = default;
 
         using parent::get_samples;
-        std::vector<coord2<T>> get_samples(size_t num_samples) override
+        void get_samples(size_t num_samples, std::vector<coord2<T>>& samples) override
         {
             size_t sample_height = size_t(sqrt(num_samples));
             size_t sample_width = num_samples / sample_height;
             T scalarY = NEAR_ONE / T(sample_height + 1);
             T scalarX = NEAR_ONE / T(sample_width + 1);
 
-            std::vector<coord2<T>> v;
-            v.reserve(num_samples);
-
+            samples.clear();
             for (size_t y = 1; y <= sample_height; ++y)
             {
                 for (size_t x = 1; x <= sample_width; ++x)
                 {
-                    v.emplace_back(coord2<T>(x * scalarX, y * scalarY));
+                    samples.emplace_back(coord2<T>(x * scalarX, y * scalarY));
                 }
             }
-            return v;
         }
 
         std::unique_ptr<sample_generator_2d<T>> clone_new() const override
@@ -145,9 +148,9 @@ namespace amethyst
         virtual ~nrooks_sample_2d() = default;
 
         using parent::get_samples;
-        std::vector<coord2<T>> get_samples(size_t num_samples) override
+        void get_samples(size_t num_samples, std::vector<coord2<T>>& vec) override
         {
-            std::vector<coord2<T>> vec(num_samples);
+            vec.resize(num_samples);
             for (size_t i = 0; i < num_samples; ++i)
             {
                 coord2<T> p = sample_generator_2d<T>::next_rand();
@@ -165,7 +168,6 @@ namespace amethyst
                     vec[i].swap_x(vec[target]);
                 }
             }
-            return vec;
         }
 
         std::unique_ptr<sample_generator_2d<T>> clone_new() const override
@@ -187,26 +189,24 @@ namespace amethyst
         virtual ~jitter_sample_2d() = default;
 
         using parent::get_samples;
-        std::vector<coord2<T>> get_samples(size_t num_samples) override
+        void get_samples(size_t num_samples, std::vector<coord2<T>>& samples) override
         {
             // This arrangement tends to favor width over height.  As most images are
             // wider than they are tall, this is not a bad thing.  If an even square
             // is used, they will be equal.
             size_t sample_height = size_t(sqrt(T(num_samples)));
             size_t sample_width = num_samples / sample_height;
-            std::vector<coord2<T>> v;
-            v.reserve(num_samples);
 
+            samples.clear();
             for (size_t y = 0; y < sample_height; ++y)
             {
                 for (size_t x = 0; x < sample_width; ++x)
                 {
                     coord2<T> p = sample_generator_2d<T>::next_rand();
-                    v.emplace_back(coord2<T>((x + p.x()) / T(sample_width),
+                    samples.emplace_back(coord2<T>((x + p.x()) / T(sample_width),
                         (y + p.y()) / T(sample_height)));
                 }
             }
-            return v;
         }
 
         std::unique_ptr<sample_generator_2d<T>> clone_new() const override
@@ -228,7 +228,7 @@ namespace amethyst
         virtual ~multi_jitter_sample_2d() = default;
 
         using parent::get_samples;
-        std::vector<coord2<T>> get_samples(size_t num_samples) override
+        void get_samples(size_t num_samples, std::vector<coord2<T>>& vec) override
         {
             size_t sqrt_samples = size_t(sqrt(num_samples));
             size_t adjusted_samples = sqrt_samples * sqrt_samples;
@@ -239,7 +239,7 @@ namespace amethyst
                 num_samples = (sqrt_samples * sqrt_samples);
             }
 
-            std::vector<coord2<T>> vec(num_samples);
+            vec.resize(num_samples);
 
             T subcell_width = T(1.0) / T(num_samples);
 
@@ -276,7 +276,6 @@ namespace amethyst
                     vec[current * sqrt_samples + x].swap_x(vec[target_y * sqrt_samples + x]);
                 }
             }
-            return vec;
         }
 
         std::unique_ptr<sample_generator_2d<T>> clone_new() const override
@@ -299,9 +298,9 @@ namespace amethyst
         virtual ~poisson_sample_2d() = default;
 
         using parent::get_samples;
-        std::vector<coord2<T>> get_samples(size_t num_samples) override
+        void get_samples(size_t num_samples, std::vector<coord2<T>>& samples) override
         {
-            std::vector<coord2<T>> samples(num_samples);
+            samples.resize(num_samples);
             size_t samples_gathered = 0;
             size_t current_sample;
             size_t bad_attempts = 0;
@@ -338,7 +337,6 @@ namespace amethyst
                     }
                 }
             }
-            return samples;
         }
 
         std::unique_ptr<sample_generator_2d<T>> clone_new() const override
@@ -348,4 +346,297 @@ namespace amethyst
     private:
         T distance_between_samples;
     };
+
+    namespace impl
+    {
+        inline uint32_t reverse_bits(uint32_t x)
+        {
+            x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+            x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+            x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+            x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+            return (x >> 16) | (x << 16);
+        }
+
+        // Owen (nested uniform) scrambling of a 32 bit fraction.  Each bit is
+        // flipped based on a hash of the bits above it, using the hash of
+        // Laine and Karras on the reversed bits.
+        inline uint32_t owen_scramble(uint32_t x, uint32_t seed)
+        {
+            x = reverse_bits(x);
+            x += seed;
+            x ^= x * 0x6c50b47cu;
+            x ^= x * 0xb82f1e52u;
+            x ^= x * 0xc7afe638u;
+            x ^= x * 0x8d22f6e6u;
+            return reverse_bits(x);
+        }
+
+        // The first two dimensions of the Sobol sequence, as 32 bit
+        // fractions.  The first is the van der Corput sequence; the second
+        // uses the primitive polynomial x + 1.
+        inline uint32_t sobol_first(uint32_t index)
+        {
+            return reverse_bits(index);
+        }
+
+        inline uint32_t sobol_second(uint32_t index)
+        {
+            uint32_t result = 0;
+            for (uint32_t v = 1u << 31; index != 0; index >>= 1, v ^= v >> 1)
+            {
+                if (index & 1)
+                {
+                    result ^= v;
+                }
+            }
+            return result;
+        }
+
+        template <typename T>
+        T radical_inverse(uint32_t base, uint32_t index)
+        {
+            const T inverse_base = T(1) / T(base);
+            T factor = inverse_base;
+            T result = 0;
+            for (; index != 0; index /= base, factor *= inverse_base)
+            {
+                result += T(index % base) * factor;
+            }
+            return result;
+        }
+
+        // Keep a sample in [0,1), as rounding can push it up to 1.
+        template <typename T>
+        T below_one(T x)
+        {
+            return std::min(x, std::nextafter(T(1), T(0)));
+        }
+
+        template <typename T>
+        T fraction_to_unit(uint32_t x)
+        {
+            return below_one(T(std::ldexp(double(x), -32)));
+        }
+
+        // A Cranley-Patterson rotation: a toroidal shift of the unit interval.
+        template <typename T>
+        T rotate_unit(T x, T offset)
+        {
+            x += offset;
+            return below_one(x >= 1 ? x - 1 : x);
+        }
+    }
+
+    /*
+       The 2d Sobol sequence.  Any power of two samples are stratified in
+       every set of 2^m equal boxes that cover the square (4x4, 16x1, 1x16 for
+       16 samples, etc).  When scrambled, each call uses a new Owen scrambling
+       (from the random generator), which keeps the stratification while
+       making the sets of different pixels independent.
+     */
+    template <class T>
+    class sobol_sample_2d : public sample_generator_2d<T>
+    {
+    public:
+        using parent = sample_generator_2d<T>;
+
+        sobol_sample_2d(const typename parent::random_type& r = default_random<T>(), bool scramble = true)
+            : parent(r)
+            , scrambled(scramble)
+        {
+        }
+        virtual ~sobol_sample_2d() = default;
+
+        using parent::get_samples;
+        void get_samples(size_t num_samples, std::vector<coord2<T>>& samples) override
+        {
+            uint32_t seed_x = 0;
+            uint32_t seed_y = 0;
+            if (scrambled)
+            {
+                seed_x = parent::next_int_rand();
+                seed_y = parent::next_int_rand();
+            }
+
+            samples.clear();
+            for (uint32_t i = 0; i < num_samples; ++i)
+            {
+                uint32_t x = impl::sobol_first(i);
+                uint32_t y = impl::sobol_second(i);
+                if (scrambled)
+                {
+                    x = impl::owen_scramble(x, seed_x);
+                    y = impl::owen_scramble(y, seed_y);
+                }
+                samples.emplace_back(impl::fraction_to_unit<T>(x), impl::fraction_to_unit<T>(y));
+            }
+        }
+
+        std::unique_ptr<sample_generator_2d<T>> clone_new() const override
+        {
+            return std::make_unique<sobol_sample_2d<T>>(*this);
+        }
+    private:
+        bool scrambled;
+    };
+
+    /*
+       The 2d Halton sequence (radical inverses in bases 2 and 3).  When
+       scrambled, each call rotates the whole set by a random toroidal offset
+       (Cranley-Patterson rotation).
+     */
+    template <class T>
+    class halton_sample_2d : public sample_generator_2d<T>
+    {
+    public:
+        using parent = sample_generator_2d<T>;
+
+        halton_sample_2d(const typename parent::random_type& r = default_random<T>(), bool scramble = true)
+            : parent(r)
+            , scrambled(scramble)
+        {
+        }
+        virtual ~halton_sample_2d() = default;
+
+        using parent::get_samples;
+        void get_samples(size_t num_samples, std::vector<coord2<T>>& samples) override
+        {
+            coord2<T> offset(0, 0);
+            if (scrambled)
+            {
+                offset = parent::next_rand();
+            }
+
+            samples.clear();
+            for (uint32_t i = 0; i < num_samples; ++i)
+            {
+                samples.emplace_back(
+                    impl::rotate_unit(impl::radical_inverse<T>(2, i), offset.x()),
+                    impl::rotate_unit(impl::radical_inverse<T>(3, i), offset.y()));
+            }
+        }
+
+        std::unique_ptr<sample_generator_2d<T>> clone_new() const override
+        {
+            return std::make_unique<halton_sample_2d<T>>(*this);
+        }
+    private:
+        bool scrambled;
+    };
+
+    /*
+       Blue noise samples from a precomputed tile.  The tile is built once
+       (with Mitchell's best candidate algorithm on the torus), and is shared
+       by all clones.  Every prefix of the tile is evenly spread, so any count
+       can be taken from the front of it.  Each call rotates the samples by a
+       random toroidal offset, which keeps the spacing.
+
+       This gives samples much like the poisson_sample_2d class, without the
+       cost of the rejection sampling for every pixel.
+     */
+    template <class T>
+    class blue_noise_sample_2d : public sample_generator_2d<T>
+    {
+    public:
+        using parent = sample_generator_2d<T>;
+
+        static constexpr size_t default_tile_size = 256;
+
+        blue_noise_sample_2d(const typename parent::random_type& r = default_random<T>(), size_t tile_size = default_tile_size)
+            : parent(r)
+            , tile(shared_tile(std::max<size_t>(tile_size, 1)))
+        {
+        }
+        virtual ~blue_noise_sample_2d() = default;
+
+        using parent::get_samples;
+        void get_samples(size_t num_samples, std::vector<coord2<T>>& samples) override
+        {
+            samples.clear();
+            coord2<T> offset;
+            for (size_t i = 0; i < num_samples; ++i)
+            {
+                // Every pass over the tile gets a new rotation.
+                if (i % tile->size() == 0)
+                {
+                    offset = parent::next_rand();
+                }
+                const coord2<T>& p = (*tile)[i % tile->size()];
+                samples.emplace_back(impl::rotate_unit(p.x(), offset.x()), impl::rotate_unit(p.y(), offset.y()));
+            }
+        }
+
+        const std::vector<coord2<T>>& get_tile() const { return *tile; }
+
+        std::unique_ptr<sample_generator_2d<T>> clone_new() const override
+        {
+            return std::make_unique<blue_noise_sample_2d<T>>(*this);
+        }
+    private:
+        // The tile of each size is built once, and shared by every generator.
+        static std::shared_ptr<const std::vector<coord2<T>>> shared_tile(size_t tile_size);
+        static std::shared_ptr<const std::vector<coord2<T>>> make_tile(size_t tile_size);
+
+        std::shared_ptr<const std::vector<coord2<T>>> tile;
+    };
+
+    template <class T>
+    std::shared_ptr<const std::vector<coord2<T>>> blue_noise_sample_2d<T>::shared_tile(size_t tile_size)
+    {
+        static std::mutex lock;
+        static std::map<size_t, std::shared_ptr<const std::vector<coord2<T>>>> tiles;
+
+        std::lock_guard<std::mutex> guard(lock);
+        auto& tile = tiles[tile_size];
+        if (!tile)
+        {
+            tile = make_tile(tile_size);
+        }
+        return tile;
+    }
+
+    template <class T>
+    std::shared_ptr<const std::vector<coord2<T>>> blue_noise_sample_2d<T>::make_tile(size_t tile_size)
+    {
+        // The distance (squared) on the unit torus, so the tile has no edges.
+        auto toroidal_distance = [](const coord2<T>& a, const coord2<T>& b)
+        {
+            T dx = std::abs(a.x() - b.x());
+            T dy = std::abs(a.y() - b.y());
+            dx = std::min(dx, 1 - dx);
+            dy = std::min(dy, 1 - dy);
+            return dx * dx + dy * dy;
+        };
+
+        // A fixed seed, so every tile of a given size is the same.
+        default_random<T> rnd(1);
+        auto points = std::make_shared<std::vector<coord2<T>>>();
+        points->reserve(tile_size);
+        points->emplace_back(rnd.next(), rnd.next());
+
+        // Each new point is the best (farthest from all others) of a number
+        // of candidates that grows with the number of points.
+        while (points->size() < tile_size)
+        {
+            coord2<T> best;
+            T best_distance = -1;
+            for (size_t candidate = 0; candidate <= points->size(); ++candidate)
+            {
+                coord2<T> c(rnd.next(), rnd.next());
+                T closest = std::numeric_limits<T>::max();
+                for (const auto& p : *points)
+                {
+                    closest = std::min(closest, toroidal_distance(c, p));
+                }
+                if (closest > best_distance)
+                {
+                    best_distance = closest;
+                    best = c;
+                }
+            }
+            points->push_back(best);
+        }
+        return points;
+    }
 }
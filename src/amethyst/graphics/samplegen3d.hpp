@@ -4,6 +4,19 @@
 
 namespace amethyst
 {
+    // A uniformly distributed point inside the unit sphere (rejection sampled).
+    template <typename T>
+    coord3<T> random_in_unit_sphere(random<T>& r)
+    {
+        coord3<T> result;
+        do
+        {
+            result.set(2 * r.next() - 1, 2 * r.next() - 1, 2 * r.next() - 1);
+        }
+        while (squared_length(result) >= 1);
+        return result;
+    }
+
     template <typename T>
     class sample_generator_3d : public sample_generator_base<T, 3>
     {
@@ -24,15 +37,14 @@ namespace amethyst
         using parent::parent;
         virtual ~random_sample_3d() = default;
 
-        std::vector<typename parent::sample_type> get_samples(size_t num_samples) override
+        using parent::get_samples;
+        void get_samples(size_t num_samples, std::vector<typename parent::sample_type>& samples) override
         {
-            std::vector<typename parent::sample_type> result;
-            result.reserve(num_samples);
+            samples.clear();
             for(; num_samples > 0; --num_samples)
             {
-                result.emplace_back(parent::next_rand());
+                samples.emplace_back(parent::next_rand());
             }
-            return result;
         }
 
         void get_samples(size_t num_samples, typename parent::sample_output_fn pf) override
@@ -69,15 +81,14 @@ namespace amethyst
             return result;
         }
 
-        std::vector<sample_type> get_samples(size_t num_samples) override
+        using parent::get_samples;
+        void get_samples(size_t num_samples, std::vector<sample_type>& samples) override
         {
-            std::vector<sample_type> result;
-            result.reserve(num_samples);
+            samples.clear();
             for (; num_samples > 0; --num_samples)
             {
-                result.emplace_back(next_sample());
+                samples.emplace_back(next_sample());
             }
-            return result;
         }
 
         void get_samples(size_t num_samples, typename parent::sample_output_fn pf) override
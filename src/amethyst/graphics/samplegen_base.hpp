@@ -3,6 +3,7 @@
 #include "math/coord2.hpp"
 #include "math/coord3.hpp"
 #include <algorithm>
+#include <functional>
 #include <vector>
 #include <memory>
 
@@ -45,10 +46,22 @@ namespace amethyst
         sample_generator_base(const sample_generator_base&) = default;
         virtual ~sample_generator_base() = default;
 
-        virtual std::vector<sample_type> get_samples(size_t num_samples) = 0;
+        // Replace the contents of samples with num_samples new samples (some
+        // generators round the count up).  The storage of samples is reused,
+        // so a buffer kept between calls is only allocated once.
+        virtual void get_samples(size_t num_samples, std::vector<sample_type>& samples) = 0;
+
+        std::vector<sample_type> get_samples(size_t num_samples)
+        {
+            std::vector<sample_type> v;
+            get_samples(num_samples, v);
+            return v;
+        }
+
         virtual void get_samples(size_t num_samples, sample_output_fn pf)
         {
-            std::vector<sample_type> v = get_samples(num_samples);
+            std::vector<sample_type> v;
+            get_samples(num_samples, v);
             for (const auto& s : v)
             {
                 pf(s);
@@ -57,6 +70,7 @@ namespace amethyst
 
         const random_type& get_rand_gen() const { return *rand_gen; }
         void set_rand_gen(const random_type& r) { rand_gen = r.clone_new(); }
+        void set_seed(uint32_t seed) { rand_gen->set_seed(seed); }
 
         T next_fp_rand() { return rand_gen->next(); }
         uint32_t next_int_rand() { return rand_gen->next_int(); };
@@ -0,0 +1,180 @@
+#include "scanline_writer.hpp"
+#include "png_stream.hpp"
+#include "general/string_format.hpp"
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+
+namespace amethyst
+{
+    namespace
+    {
+        bool put(std::streambuf& output, const void* data, size_t length)
+        {
+            return output.sputn(static_cast<const char*>(data), std::streamsize(length)) == std::streamsize(length);
+        }
+
+        class ppm_encoder : public row_encoder
+        {
+        public:
+            explicit ppm_encoder(std::streambuf& output) : m_output(output) { }
+
+            bool begin(size_t width, size_t height) override
+            {
+                m_width = width;
+                std::string header = string_format("P6 %1 %2 255\n", int(width), int(height));
+                return put(m_output, header.data(), header.size());
+            }
+            bool write_row(const rgbcolor<uint8_t>* pixels) override
+            {
+                return put(m_output, pixels, m_width * sizeof(*pixels));
+            }
+            bool end() override
+            {
+                return m_output.pubsync() == 0;
+            }
+
+        private:
+            std::streambuf& m_output;
+            size_t m_width = 0;
+        };
+
+        class tga_encoder : public row_encoder
+        {
+        public:
+            explicit tga_encoder(std::streambuf& output) : m_output(output) { }
+
+            bool begin(size_t width, size_t height) override
+            {
+                if ((width > 0xffff) || (height > 0xffff))
+                {
+                    return false;
+                }
+                // Uncompressed RGB, with the origin at the top left (as in
+                // tga_io).
+                const uint8_t header[18] = {
+                    0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                    uint8_t(width & 0xff), uint8_t(width >> 8),
+                    uint8_t(height & 0xff), uint8_t(height >> 8),
+                    24, 32
+                };
+                m_row.resize(width * 3);
+                return put(m_output, header, sizeof(header));
+            }
+            bool write_row(const rgbcolor<uint8_t>* pixels) override
+            {
+                for (size_t x = 0; x < m_row.size() / 3; ++x)
+                {
+                    m_row[3 * x + 0] = pixels[x].b();
+                    m_row[3 * x + 1] = pixels[x].g();
+                    m_row[3 * x + 2] = pixels[x].r();
+                }
+                return put(m_output, m_row.data(), m_row.size());
+            }
+            bool end() override
+            {
+                return m_output.pubsync() == 0;
+            }
+
+        private:
+            std::streambuf& m_output;
+            std::vector<uint8_t> m_row;
+        };
+
+        class png_encoder : public row_encoder
+        {
+        public:
+            explicit png_encoder(std::streambuf& output) : m_png(output, 8) { }
+
+            bool begin(size_t width, size_t height) override
+            {
+                return m_png.begin(width, height);
+            }
+            bool write_row(const rgbcolor<uint8_t>* pixels) override
+            {
+                return m_png.write_row(reinterpret_cast<const uint8_t*>(pixels));
+            }
+            bool end() override
+            {
+                return m_png.end();
+            }
+
+        private:
+            png_stream m_png;
+        };
+
+        // An encoder that writes to a file it owns.
+        class file_encoder : public row_encoder
+        {
+        public:
+            explicit file_encoder(const std::string& filename)
+            {
+                std::string::size_type dot = filename.rfind('.');
+                std::string extension = (dot == std::string::npos) ? std::string() : filename.substr(dot + 1);
+                for (char& c : extension)
+                {
+                    c = char(std::tolower(static_cast<unsigned char>(c)));
+                }
+
+                if (extension == "ppm")
+                {
+                    m_encoder = make_ppm_encoder(m_file);
+                }
+                else if (extension == "tga")
+                {
+                    m_encoder = make_tga_encoder(m_file);
+                }
+                else if (extension == "png")
+                {
+                    m_encoder = make_png_encoder(m_file);
+                }
+                else
+                {
+                    throw std::runtime_error("Unknown image format: " + filename);
+                }
+
+                if (!m_file.open(filename.c_str(), std::ios_base::out | std::ios_base::binary))
+                {
+                    throw std::runtime_error("Unable to create " + filename);
+                }
+            }
+
+            bool begin(size_t width, size_t height) override
+            {
+                return m_encoder->begin(width, height);
+            }
+            bool write_row(const rgbcolor<uint8_t>* pixels) override
+            {
+                return m_encoder->write_row(pixels);
+            }
+            bool end() override
+            {
+                return m_encoder->end() && m_file.close();
+            }
+
+        private:
+            std::filebuf m_file;
+            std::unique_ptr<row_encoder> m_encoder;
+        };
+    }
+
+    std::unique_ptr<row_encoder> make_ppm_encoder(std::streambuf& output)
+    {
+        return std::make_unique<ppm_encoder>(output);
+    }
+
+    std::unique_ptr<row_encoder> make_tga_encoder(std::streambuf& output)
+    {
+        return std::make_unique<tga_encoder>(output);
+    }
+
+    std::unique_ptr<row_encoder> make_png_encoder(std::streambuf& output)
+    {
+        return std::make_unique<png_encoder>(output);
+    }
+
+    std::unique_ptr<row_encoder> make_file_encoder(const std::string& filename)
+    {
+        return std::make_unique<file_encoder>(filename);
+    }
+}
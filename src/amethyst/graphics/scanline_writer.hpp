@@ -0,0 +1,270 @@
+#pragma once
+
+/*
+   scanline_writer.hpp -- Writing PPM, TGA and PNG files a few rows (or
+   tiles) at a time, as they are rendered, without holding the whole image.
+ */
+
+#include "graphics/image_converter.hpp"
+#include "graphics/raster.hpp"
+#include "graphics/raster_view.hpp"
+#include "graphics/rgbcolor.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace amethyst
+{
+    /**
+     * Encodes 8 bit rows, top to bottom, into one image format.
+     */
+    class row_encoder
+    {
+    public:
+        virtual ~row_encoder() = default;
+
+        virtual bool begin(size_t width, size_t height) = 0;
+        virtual bool write_row(const rgbcolor<uint8_t>* pixels) = 0;
+        virtual bool end() = 0;
+    };
+
+    std::unique_ptr<row_encoder> make_ppm_encoder(std::streambuf& output);
+    std::unique_ptr<row_encoder> make_tga_encoder(std::streambuf& output);
+    // The image data is compressed as it is written (see deflate_stream).
+    std::unique_ptr<row_encoder> make_png_encoder(std::streambuf& output);
+
+    // An encoder for a new file, with the format chosen by the extension
+    // (ppm, tga or png).
+    // @throws std::runtime_error if the format is unknown or the file cannot
+    // be created.
+    std::unique_ptr<row_encoder> make_file_encoder(const std::string& filename);
+
+    /**
+     *
+     * Writes an image as its pixels become available, so that a large frame
+     * never has to be held (or converted to 8 bits) all at once.
+     *
+     * Pixels can be given as whole rows in order (write_rows), or as tiles in
+     * any order (write_tile), which may come from several threads.  Each row
+     * is converted to 8 bits as soon as it arrives, and is written as soon as
+     * it and every row above it are complete, so only the rows that are
+     * waiting for other tiles are held.  Every pixel must be written exactly
+     * once.  Rows are encoded by one thread at a time, outside of the lock,
+     * so the other threads can keep adding tiles while a row is compressed.
+     *
+     * @author Kevin Harris <kpharris@users.sourceforge.net>
+     * @version $Revision: 1.0 $
+     *
+     */
+    template <class ColorType>
+    class scanline_writer
+    {
+    public:
+        scanline_writer(std::unique_ptr<row_encoder> encoder, size_t width, size_t height);
+        // @throws std::runtime_error if the file cannot be created.
+        scanline_writer(const std::string& filename, size_t width, size_t height)
+            : scanline_writer(make_file_encoder(filename), width, height)
+        {
+        }
+
+        scanline_writer(const scanline_writer&) = delete;
+        scanline_writer& operator=(const scanline_writer&) = delete;
+
+        // Encode the pixels with a gamma curve (like image_io::output with a
+        // gamma).  Must be set before any pixels are written.
+        void set_gamma(const gamma_curve& curve)
+        {
+            m_gamma = gamma_lut<uint8_t>::shared(curve);
+        }
+
+        // The next rows of the image, which must be the full width.
+        bool write_rows(const raster_view<const ColorType>& rows);
+        bool write_rows(const raster<ColorType>& rows)
+        {
+            return write_rows(rows.view());
+        }
+
+        // A tile with its top left corner at (x, y).
+        bool write_tile(size_t x, size_t y, const raster_view<const ColorType>& tile);
+
+        // Finish the file.  Fails if any pixels are missing, or if anything
+        // could not be written.
+        bool finish();
+
+        size_t get_width() const { return m_width; }
+        size_t get_height() const { return m_height; }
+        size_t rows_written() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_rows_written;
+        }
+
+    private:
+        struct pending_row
+        {
+            std::vector<rgbcolor<uint8_t>> pixels;
+            size_t filled = 0;
+        };
+
+        void convert(const ColorType* source, size_t count, rgbcolor<uint8_t>* dest) const;
+        // Called with the lock held, which is released while encoding.
+        void write_ready_rows(std::unique_lock<std::mutex>& lock);
+
+        std::unique_ptr<row_encoder> m_encoder;
+        std::shared_ptr<const gamma_lut<uint8_t>> m_gamma;
+        size_t m_width;
+        size_t m_height;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_done_writing;
+        std::map<size_t, pending_row> m_pending;
+        // The next row to be taken for encoding, and the rows encoded so far.
+        size_t m_next_row = 0;
+        size_t m_rows_written = 0;
+        bool m_writing = false;
+        size_t m_next_strip = 0;
+        bool m_good;
+        bool m_finished = false;
+    };
+
+    template <class ColorType>
+    scanline_writer<ColorType>::scanline_writer(std::unique_ptr<row_encoder> encoder, size_t width, size_t height)
+        : m_encoder(std::move(encoder))
+        , m_width(width)
+        , m_height(height)
+    {
+        m_good = m_encoder->begin(width, height);
+    }
+
+    template <class ColorType>
+    void scanline_writer<ColorType>::convert(const ColorType* source, size_t count, rgbcolor<uint8_t>* dest) const
+    {
+        if (m_gamma)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                dest[i] = (*m_gamma)(source[i]);
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                dest[i] = convert_color<uint8_t>(source[i]);
+            }
+        }
+    }
+
+    template <class ColorType>
+    bool scanline_writer<ColorType>::write_rows(const raster_view<const ColorType>& rows)
+    {
+        if (rows.get_width() != m_width)
+        {
+            return false;
+        }
+        size_t y;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            y = m_next_strip;
+            m_next_strip += rows.get_height();
+        }
+        return write_tile(0, y, rows);
+    }
+
+    template <class ColorType>
+    bool scanline_writer<ColorType>::write_tile(size_t x, size_t y, const raster_view<const ColorType>& tile)
+    {
+        if ((x + tile.get_width() > m_width) || (y + tile.get_height() > m_height))
+        {
+            return false;
+        }
+
+        // Converted before taking the lock, so tiles from several threads
+        // are converted at the same time.
+        std::vector<rgbcolor<uint8_t>> converted(tile.get_numpixels());
+        for (size_t row = 0; row < tile.get_height(); ++row)
+        {
+            convert(tile.row(row), tile.get_width(), converted.data() + row * tile.get_width());
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_finished || (y < m_next_row))
+        {
+            return false;
+        }
+        for (size_t row = 0; row < tile.get_height(); ++row)
+        {
+            pending_row& pending = m_pending[y + row];
+            if (pending.pixels.empty())
+            {
+                pending.pixels.resize(m_width);
+            }
+            std::copy_n(converted.data() + row * tile.get_width(), tile.get_width(), pending.pixels.data() + x);
+            pending.filled += tile.get_width();
+        }
+        write_ready_rows(lock);
+        return m_good;
+    }
+
+    template <class ColorType>
+    void scanline_writer<ColorType>::write_ready_rows(std::unique_lock<std::mutex>& lock)
+    {
+        // The thread already encoding picks up these rows when it is done
+        // with its own, which keeps the rows in order.
+        if (m_writing)
+        {
+            return;
+        }
+        m_writing = true;
+
+        std::vector<std::vector<rgbcolor<uint8_t>>> ready;
+        while (true)
+        {
+            for (auto row = m_pending.begin(); row != m_pending.end() && row->first == m_next_row && row->second.filled >= m_width; )
+            {
+                ready.push_back(std::move(row->second.pixels));
+                row = m_pending.erase(row);
+                ++m_next_row;
+            }
+            if (ready.empty())
+            {
+                break;
+            }
+
+            lock.unlock();
+            bool good = true;
+            for (const auto& pixels : ready)
+            {
+                good = m_encoder->write_row(pixels.data()) && good;
+            }
+            lock.lock();
+
+            m_good = good && m_good;
+            m_rows_written += ready.size();
+            ready.clear();
+        }
+
+        m_writing = false;
+        m_done_writing.notify_all();
+    }
+
+    template <class ColorType>
+    bool scanline_writer<ColorType>::finish()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done_writing.wait(lock, [this] { return !m_writing; });
+        if (!m_finished)
+        {
+            m_finished = true;
+            m_good = m_good && (m_rows_written == m_height) && m_encoder->end();
+            m_pending.clear();
+        }
+        return m_good;
+    }
+}
@@ -7,6 +7,165 @@
 
 namespace amethyst
 {
+    namespace impl
+    {
+        // Fold the hit for one member of a container (found in temp_intersection)
+        // into the hit information for the container as a whole.
+        template <typename T, typename color_type>
+        void merge_intersection(const shape<T, color_type>* container,
+            intersection_info<T, color_type>& temp_intersection,
+            intersection_info<T, color_type>& intersection,
+            bool& intersects_something,
+            const intersection_requirements& requirements)
+        {
+            if (intersects_something && requirements.needs_containers())
+            {
+                temp_intersection.append_container(container);
+            }
+
+            if (!requirements.needs_all_hits())
+            {
+                // This is the easy case, because the entire hit information is
+                // replaced if the hit is closer than the current (if any).
+                if (!intersects_something ||
+                    (temp_intersection.get_first_distance() < intersection.get_first_distance()))
+                {
+                    intersection = temp_intersection;
+                }
+            } // !all hits
+            else
+            {
+                // This is the harder case, or at least messier case, because some of
+                // the information will need to be preserved (I've chosen the shape,
+                // the distance), for later comparison.
+
+                // Append the complete intersection information, for later retrieval.
+                intersection.append_intersection(temp_intersection);
+                if (!intersects_something)
+                {
+                    // Copy some of the values (distance, shape) to the main intersection container.
+                    if (temp_intersection.have_shape())
+                    {
+                        intersection.set_shape(temp_intersection.get_shape());
+                    }
+                    if (temp_intersection.have_distance())
+                    {
+                        intersection.set_first_distance(temp_intersection.get_first_distance());
+                    }
+                } // !intersects something
+                else // Do a comparison before assigning.
+                {
+                    if ((temp_intersection.have_distance() && intersection.have_distance()) &&
+                        (temp_intersection.get_first_distance() < intersection.get_first_distance()))
+                    {
+                        intersection.set_first_distance(temp_intersection.get_first_distance());
+                        // Copy some of the values (distance, shape, line) to the main intersection container.
+                        if (temp_intersection.have_shape())
+                        {
+                            intersection.set_shape(temp_intersection.get_shape());
+                        }
+                    } // this hit is closer than any preexisting hits.
+                } // prior hits
+            } // all hits required
+
+            intersects_something = true;
+        }
+
+        // The closest hit path for containers: find the closest shape using
+        // closest_hit() (distances only), then do the full intersection (via
+        // intersect(shape)) on that one shape.  Returns false if this can't
+        // give the answer (the requirements want more than the closest hit, or
+        // the full test of the shape disagrees with its quick test), in which
+        // case the container needs to do a complete search.
+        template <typename T, typename color_type, typename intersect_function>
+        bool intersect_closest(const shape<T, color_type>& container,
+            const unit_line3<T>& line, T time,
+            const intersection_requirements& requirements,
+            bool& intersects_something,
+            intersect_function intersect)
+        {
+            if (requirements.needs_all_hits() || requirements.needs_containers())
+            {
+                return false;
+            }
+
+            hit_record<T, color_type> closest;
+            if (!container.closest_hit(line, time, closest))
+            {
+                intersects_something = false;
+                return true;
+            }
+            intersects_something = intersect(*closest.obj);
+            return intersects_something;
+        }
+
+        template <typename shape_list>
+        bool combined_bounds(const shape_list& shapes, bounding_box<typename shape_list::value_type::element_type::base_type>& box)
+        {
+            bounding_box<typename shape_list::value_type::element_type::base_type> result;
+            for (const auto& obj : shapes)
+            {
+                decltype(result) obj_box;
+                if (!obj->get_bounds(obj_box))
+                {
+                    return false;
+                }
+                result.add(obj_box);
+            }
+            box = result;
+            return true;
+        }
+
+        template <typename shape_list>
+        intersection_capabilities combined_intersection_capabilities(const shape_list& shapes)
+        {
+            intersection_capabilities caps = intersection_capabilities::ALL;
+
+            // Checkme! Are any of these capabilities disjoint (like the ones in the object capabilities)?
+            for (const auto& obj : shapes)
+            {
+                caps &= obj->get_intersection_capabilities();
+            }
+            return caps;
+        }
+
+        template <typename shape_list>
+        object_capabilities combined_object_capabilities(const shape_list& shapes)
+        {
+            object_capabilities caps = object_capabilities::ALL;
+            caps &= ~object_capabilities::MOVABLE;
+            caps &= ~object_capabilities::SIMPLE;
+            caps |= object_capabilities::CONTAINER;
+            caps &= ~object_capabilities::IMPLICIT;
+
+            for (const auto& obj : shapes)
+            {
+                object_capabilities obj_caps = obj->get_object_capabilities();
+
+                if (!!(obj_caps & object_capabilities::NOT_FINITE))
+                {
+                    caps &= ~object_capabilities::BOUNDABLE;
+                }
+                if (!!(obj_caps & object_capabilities::BOUNDABLE))
+                {
+                    caps &= ~object_capabilities::NOT_FINITE;
+                }
+                if (!!(obj_caps & object_capabilities::MOVABLE))
+                {
+                    caps |= object_capabilities::MOVABLE;
+                }
+                if (!(obj_caps & object_capabilities::POLYGONIZATION))
+                {
+                    caps &= ~object_capabilities::POLYGONIZATION;
+                }
+                if (!!(obj_caps & object_capabilities::IMPLICIT))
+                {
+                    caps |= object_capabilities::IMPLICIT;
+                }
+            }
+            return caps;
+        }
+    }
 
     /**
      *
@@ -67,20 +226,36 @@ namespace amethyst
          */
         bool quick_intersection(const unit_line3<T>& line, T time, T& distance) const override;
 
+        /** Records the contained shape (not the aggregate) that was hit. */
+        bool closest_hit(const unit_line3<T>& line, T time, hit_record<T, color_type>& hit) const override
+        {
+            bool changed = false;
+            for (const auto& obj : m_shape_list)
+            {
+                changed = obj->closest_hit(line, time, hit) || changed;
+            }
+            return changed;
+        }
+
+        /** Records the contained shape (not the aggregate) hit in each lane. */
+        void intersect_packet(ray_packet<T, color_type>& packet) const override
+        {
+            for (const auto& obj : m_shape_list)
+            {
+                obj->intersect_packet(packet);
+            }
+        }
+
+        /** The bounds of all contained shapes (false if any are unbounded). */
+        bool get_bounds(bounding_box<T>& box) const override;
+
         std::string internal_members(const std::string& indentation, bool prefix_with_classname = false) const override;
 
         std::string name() const override { return "aggregate"; }
 
         intersection_capabilities get_intersection_capabilities() const override
         {
-            intersection_capabilities caps = intersection_capabilities::ALL;
-
-            // Checkme! Are any of these capabilities disjoint (like the ones in the object capabilities)?
-            for (const auto& obj : m_shape_list)
-            {
-                caps &= obj->get_intersection_capabilities();
-            }
-            return caps;
+            return impl::combined_intersection_capabilities(m_shape_list);
         }
         object_capabilities get_object_capabilities() const override;
 
@@ -171,74 +346,20 @@ namespace amethyst
         // Clear it out...
         intersection = intersection_info<T,color_type>();
 
+        if (impl::intersect_closest(*this, line, T(0), requirements, intersects_something,
+                [&](const shape<T, color_type>& obj) { return obj.intersects_line(line, intersection, requirements); }))
+        {
+            return intersects_something;
+        }
+
         for(const auto& obj : m_shape_list)
         {
             intersection_info<T,color_type> temp_intersection;
             if (obj->intersects_line(line, temp_intersection, requirements))
             {
-
-                if (intersects_something && requirements.needs_containers())
-                {
-                    temp_intersection.append_container(this);
-                }
-
-                if (!requirements.needs_all_hits())
-                {
-                    // This is the easy case, because the entire hit information is
-                    // replaced if the hit is closer than the current (if any).
-                    if (!intersects_something)
-                    {
-                        intersects_something = true;
-                        intersection = temp_intersection;
-                    }
-                    else
-                    {
-                        if (temp_intersection.get_first_distance() < intersection.get_first_distance())
-                        {
-                            intersection = temp_intersection;
-                        }
-                        else
-                        {
-                            // The existing hit is closer...
-                        }
-                    }
-                } // !all hits
-                else
-                {
-                    // This is the harder case, or at least messier case, because some of
-                    // the information will need to be preserved (I've chosen the shape,
-                    // the distance), for later comparison.
-
-                    // Append the complete intersection information, for later retrieval.
-                    intersection.append_intersection(temp_intersection);
-                    if (!intersects_something)
-                    {
-                        // Copy some of the values (distance, shape) to the main intersection container.
-                        if (temp_intersection.have_shape())
-                        {
-                            intersection.set_shape(temp_intersection.get_shape());
-                        }
-                        if (temp_intersection.have_distance())
-                        {
-                            intersection.set_first_distance(temp_intersection.get_first_distance());
-                        }
-                    } // !intersects something
-                    else // Do a comparison before assigning.
-                    {
-                        if ((temp_intersection.have_distance() && intersection.have_distance()) &&
-                            (temp_intersection.get_first_distance() < intersection.get_first_distance()))
-                        {
-                            intersection.set_first_distance(temp_intersection.get_first_distance());
-                            // Copy some of the values (distance, shape, line) to the main intersection container.
-                            if (temp_intersection.have_shape())
-                            {
-                                intersection.set_shape(temp_intersection.get_shape());
-                            }
-                        } // this hit is closer than any preexisting hits.
-                    } // prior hits
-                } // all hits required
-            } // if the shape intersects the line.
-        } // for each shape.
+                impl::merge_intersection(this, temp_intersection, intersection, intersects_something, requirements);
+            }
+        }
 
         return intersects_something;
     }
@@ -254,78 +375,29 @@ namespace amethyst
         // Clear it out...
         intersection = intersection_info<T,color_type>();
 
+        if (impl::intersect_closest(*this, ray.get_line(), ray.get_time(), requirements, intersects_something,
+                [&](const shape<T, color_type>& obj) { return obj.intersects_ray(ray, intersection, requirements); }))
+        {
+            return intersects_something;
+        }
+
         for (const auto& obj : m_shape_list)
         {
             intersection_info<T,color_type> temp_intersection;
             if (obj->intersects_ray(ray, temp_intersection, requirements))
             {
-
-                if (intersects_something && requirements.needs_containers())
-                {
-                    temp_intersection.append_container(this);
-                }
-
-                if (!requirements.needs_all_hits())
-                {
-                    // This is the easy case, because the entire hit information is
-                    // replaced if the hit is closer than the current (if any).
-                    if (!intersects_something)
-                    {
-                        intersects_something = true;
-                        intersection = temp_intersection;
-                    }
-                    else
-                    {
-                        if (temp_intersection.get_first_distance() < intersection.get_first_distance())
-                        {
-                            intersection = temp_intersection;
-                        }
-                        else
-                        {
-                            // The existing hit is closer...
-                        }
-                    }
-                } // !all hits
-                else
-                {
-                    // This is the harder case, or at least messier case, because some of
-                    // the information will need to be preserved (I've chosen the shape,
-                    // the distance), for later comparison.
-
-                    // Append the complete intersection information, for later retrieval.
-                    intersection.append_intersection(temp_intersection);
-                    if (!intersects_something)
-                    {
-                        // Copy some of the values (distance, shape) to the main intersection container.
-                        if (temp_intersection.have_shape())
-                        {
-                            intersection.set_shape(temp_intersection.get_shape());
-                        }
-                        if (temp_intersection.have_distance())
-                        {
-                            intersection.set_first_distance(temp_intersection.get_first_distance());
-                        }
-                    } // !intersects something
-                    else // Do a comparison before assigning.
-                    {
-                        if ((temp_intersection.have_distance() && intersection.have_distance()) &&
-                            (temp_intersection.get_first_distance() < intersection.get_first_distance()))
-                        {
-                            intersection.set_first_distance(temp_intersection.get_first_distance());
-                            // Copy some of the values (distance, shape, line) to the main intersection container.
-                            if (temp_intersection.have_shape())
-                            {
-                                intersection.set_shape(temp_intersection.get_shape());
-                            }
-                        } // this hit is closer than any preexisting hits.
-                    } // prior hits
-                } // all hits required
-            } // if the shape intersects the line.
-        } // for each shape.
+                impl::merge_intersection(this, temp_intersection, intersection, intersects_something, requirements);
+            }
+        }
 
         return intersects_something;
     }
 
+    template <typename T, typename color_type>
+    bool aggregate<T,color_type>::get_bounds(bounding_box<T>& box) const
+    {
+        return impl::combined_bounds(m_shape_list, box);
+    }
 
     template <typename T, typename color_type>
     std::string aggregate<T,color_type>::internal_members(const std::string& indentation, bool prefix_with_classname) const
@@ -354,37 +426,6 @@ namespace amethyst
     template <typename T, typename color_type>
     object_capabilities aggregate<T,color_type>::get_object_capabilities() const
     {
-        object_capabilities caps = object_capabilities::ALL;
-        caps &= ~object_capabilities::MOVABLE;
-        caps &= ~object_capabilities::SIMPLE;
-        caps |= object_capabilities::CONTAINER;
-        caps &= ~object_capabilities::IMPLICIT;
-
-        for (const auto& obj : m_shape_list)
-        {
-            object_capabilities obj_caps = obj->get_object_capabilities();
-
-            if (!!(obj_caps & object_capabilities::NOT_FINITE))
-            {
-                caps &= ~object_capabilities::BOUNDABLE;
-            }
-            if (!!(obj_caps & object_capabilities::BOUNDABLE))
-            {
-                caps &= ~object_capabilities::NOT_FINITE;
-            }
-            if (!!(obj_caps & object_capabilities::MOVABLE))
-            {
-                caps |= object_capabilities::MOVABLE;
-            }
-            if (!(obj_caps & object_capabilities::POLYGONIZATION))
-            {
-                caps &= ~object_capabilities::POLYGONIZATION;
-            }
-            if (!!(obj_caps & object_capabilities::IMPLICIT))
-            {
-                caps |= object_capabilities::IMPLICIT;
-            }
-        }
-        return caps;
+        return impl::combined_object_capabilities(m_shape_list);
     }
 }
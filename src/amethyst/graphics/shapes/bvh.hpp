@@ -0,0 +1,712 @@
+#pragma once
+
+#include "amethyst/graphics/shapes/aggregate.hpp"
+#include "amethyst/graphics/shapes/sphere.hpp"
+#include "amethyst/math/bounding_box.hpp"
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <vector>
+
+namespace amethyst
+{
+
+    /**
+     *
+     * A bounding volume hierarchy.  This holds the same kind of collection
+     * as an aggregate, but sorts the shapes into a tree of boxes so that a
+     * line only needs to be tested against the shapes whose boxes it passes
+     * through.
+     *
+     * The tree is built once (using a binned surface area heuristic) and is
+     * stored as a flat array of nodes in depth-first order.  Shapes that
+     * cannot report their bounds (planes, etc) are kept aside and tested
+     * against every line.
+     *
+     * @author Kevin Harris <kpharris@users.sourceforge.net>
+     * @version $Revision: 1.0 $
+     *
+     */
+    template <typename T, typename color_type>
+    class bvh : public shape<T, color_type>
+    {
+    public:
+        using parent = shape<T, color_type>;
+        using shape_type = shape_ptr<T, color_type>;
+        using shape_list = std::vector<shape_type>;
+
+        explicit bvh(const aggregate<T, color_type>& shapes, size_t max_leaf_size = 4);
+        explicit bvh(shape_list shapes, size_t max_leaf_size = 4);
+        virtual ~bvh() = default;
+        bvh(const bvh& old) = default;
+        bvh& operator=(const bvh& old) = default;
+
+        /** Returns if the given point is inside the shape. */
+        bool inside(const point3<T>& p) const override;
+
+        /** Returns if the given sphere intersects the shape. */
+        bool intersects(const sphere<T,color_type>& s) const override;
+
+        /** Returns if the given plane intersects the shape. */
+        bool intersects(const plane<T,color_type>& p) const override;
+
+        /** Returns if the given line intersects the shape. */
+        using parent::intersects_line;
+
+        bool intersects_line(const unit_line3<T>& line,
+            intersection_info<T,color_type>& intersection,
+            const intersection_requirements& requirements = intersection_requirements()) const override;
+
+        bool intersects_ray(const ray_parameters<T,color_type>& ray,
+            intersection_info<T,color_type>& intersection,
+            const intersection_requirements& requirements = intersection_requirements()) const override;
+
+        /**
+         * A quick intersection test.  This will calculate nothing but the
+         * distance. This is most useful for shadow tests, and other tests where no
+         * textures will be applied.
+         */
+        bool quick_intersection(const unit_line3<T>& line, T time, T& distance) const override;
+
+        /** Records the contained shape (not the bvh) that was hit. */
+        bool closest_hit(const unit_line3<T>& line, T time, hit_record<T, color_type>& hit) const override;
+
+        /**
+         * Walks the tree once for the whole packet, visiting the nodes that
+         * any of the lanes enter.  Records the contained shape hit in each
+         * lane.
+         */
+        void intersect_packet(ray_packet<T, color_type>& packet) const override;
+
+        /** The bounds of all contained shapes (false if any are unbounded). */
+        bool get_bounds(bounding_box<T>& box) const override;
+
+        std::string internal_members(const std::string& indentation, bool prefix_with_classname = false) const override;
+
+        std::string name() const override { return "bvh"; }
+
+        intersection_capabilities get_intersection_capabilities() const override;
+        object_capabilities get_object_capabilities() const override;
+
+        // The total number of shapes (bounded and unbounded).
+        size_t size() const { return m_bounded.size() + m_unbounded.size(); }
+        size_t node_count() const { return m_nodes.size(); }
+
+    private:
+        struct node
+        {
+            bounding_box<T> box;
+            // Leaves: the index of the first shape in m_bounded.
+            // Interior nodes: the index of the second child (the first child
+            // immediately follows its parent).
+            uint32_t offset;
+            // The number of shapes in a leaf, 0 for an interior node.
+            uint16_t count;
+            // The axis an interior node was split on.
+            uint8_t axis;
+        };
+
+        struct build_entry
+        {
+            bounding_box<T> box;
+            point3<T> centroid;
+            shape_type obj;
+        };
+
+        // Deeper than this and the build falls back to median splits, so the
+        // traversal stack below can never overflow.
+        static constexpr size_t max_sah_depth = 64;
+        static constexpr size_t max_depth = 128;
+        static constexpr size_t bin_count = 12;
+
+        void build(shape_list shapes);
+        void build_node(std::vector<build_entry>& entries, size_t begin, size_t end, size_t depth);
+        size_t find_split(std::vector<build_entry>& entries, size_t begin, size_t end,
+            const bounding_box<T>& centroid_box, unsigned axis, const bounding_box<T>& node_box) const;
+
+        // Calls visitor(shape) for every bounded shape in a leaf whose box the
+        // line enters before 'limit'.  The visitor returns the (possibly
+        // reduced) limit for the rest of the traversal.
+        template <typename visitor_type>
+        void traverse(const unit_line3<T>& line, T limit, visitor_type visitor) const;
+
+        template <typename intersect_function>
+        bool find_intersection(const unit_line3<T>& line, T time,
+            intersection_info<T,color_type>& intersection,
+            const intersection_requirements& requirements,
+            intersect_function intersect) const;
+
+        size_t m_max_leaf_size;
+        // The bounded shapes, in the order the leaves refer to them.
+        shape_list m_bounded;
+        shape_list m_unbounded;
+        std::vector<node> m_nodes;
+    };
+
+    template <typename T, typename color_type>
+    bvh<T, color_type>::bvh(const aggregate<T, color_type>& shapes, size_t max_leaf_size)
+        : m_max_leaf_size(std::max<size_t>(1, std::min<size_t>(max_leaf_size, std::numeric_limits<uint16_t>::max())))
+    {
+        shape_list all;
+        all.reserve(shapes.size());
+        for (size_t i = 0; i < shapes.size(); ++i)
+        {
+            all.push_back(shapes[i]);
+        }
+        build(std::move(all));
+    }
+
+    template <typename T, typename color_type>
+    bvh<T, color_type>::bvh(shape_list shapes, size_t max_leaf_size)
+        : m_max_leaf_size(std::max<size_t>(1, std::min<size_t>(max_leaf_size, std::numeric_limits<uint16_t>::max())))
+    {
+        build(std::move(shapes));
+    }
+
+    template <typename T, typename color_type>
+    void bvh<T, color_type>::build(shape_list shapes)
+    {
+        std::vector<build_entry> entries;
+        entries.reserve(shapes.size());
+
+        for (auto& obj : shapes)
+        {
+            bounding_box<T> box;
+            if (obj->get_bounds(box) && !box.empty())
+            {
+                entries.push_back({ box, box.center(), std::move(obj) });
+            }
+            else
+            {
+                m_unbounded.push_back(std::move(obj));
+            }
+        }
+
+        if (!entries.empty())
+        {
+            m_nodes.reserve(2 * entries.size());
+            m_bounded.reserve(entries.size());
+            build_node(entries, 0, entries.size(), 0);
+        }
+    }
+
+    template <typename T, typename color_type>
+    void bvh<T, color_type>::build_node(std::vector<build_entry>& entries, size_t begin, size_t end, size_t depth)
+    {
+        bounding_box<T> node_box;
+        bounding_box<T> centroid_box;
+        for (size_t i = begin; i < end; ++i)
+        {
+            node_box.add(entries[i].box);
+            centroid_box.add(entries[i].centroid);
+        }
+
+        size_t node_index = m_nodes.size();
+        m_nodes.push_back({ node_box, 0, 0, 0 });
+
+        size_t count = end - begin;
+        unsigned axis = centroid_box.longest_axis();
+        size_t middle = begin;
+
+        if (count > m_max_leaf_size)
+        {
+            if (depth < max_sah_depth && centroid_box.extent()[axis] > 0)
+            {
+                middle = find_split(entries, begin, end, centroid_box, axis, node_box);
+            }
+            else if (count > std::numeric_limits<uint16_t>::max() || depth < max_depth)
+            {
+                // Everything is piled up in one spot, or the tree is getting
+                // too deep.  Just cut the list in half.
+                middle = begin + count / 2;
+                std::nth_element(entries.begin() + begin, entries.begin() + middle, entries.begin() + end,
+                    [axis](const build_entry& a, const build_entry& b) { return a.centroid[axis] < b.centroid[axis]; });
+            }
+        }
+
+        if (middle == begin || middle == end)
+        {
+            m_nodes[node_index].offset = uint32_t(m_bounded.size());
+            m_nodes[node_index].count = uint16_t(count);
+            for (size_t i = begin; i < end; ++i)
+            {
+                m_bounded.push_back(std::move(entries[i].obj));
+            }
+            return;
+        }
+
+        m_nodes[node_index].axis = uint8_t(axis);
+        build_node(entries, begin, middle, depth + 1);
+        m_nodes[node_index].offset = uint32_t(m_nodes.size());
+        build_node(entries, middle, end, depth + 1);
+    }
+
+    // Returns the index to split the entries at (or 'begin' if they should
+    // stay together in a leaf), partitioning them around that index.
+    template <typename T, typename color_type>
+    size_t bvh<T, color_type>::find_split(std::vector<build_entry>& entries, size_t begin, size_t end,
+        const bounding_box<T>& centroid_box, unsigned axis, const bounding_box<T>& node_box) const
+    {
+        struct bin
+        {
+            bounding_box<T> box;
+            size_t count = 0;
+        };
+        std::array<bin, bin_count> bins;
+
+        T axis_min = centroid_box.minimum()[axis];
+        T scale = T(bin_count) / centroid_box.extent()[axis];
+        auto bin_for = [&](const build_entry& e)
+        {
+            size_t b = size_t((e.centroid[axis] - axis_min) * scale);
+            return std::min(b, bin_count - 1);
+        };
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            bin& b = bins[bin_for(entries[i])];
+            b.box.add(entries[i].box);
+            ++b.count;
+        }
+
+        // Sweep from the right to get the area and count of everything after
+        // each split plane, then from the left to evaluate the costs.
+        std::array<T, bin_count> right_area;
+        std::array<size_t, bin_count> right_count;
+        bounding_box<T> accumulated;
+        size_t accumulated_count = 0;
+        for (size_t i = bin_count - 1; i > 0; --i)
+        {
+            accumulated.add(bins[i].box);
+            accumulated_count += bins[i].count;
+            right_area[i] = accumulated.surface_area();
+            right_count[i] = accumulated_count;
+        }
+
+        // Costs are relative to intersecting a single shape, with traversing a
+        // node assumed to cost about the same.
+        T best_cost = std::numeric_limits<T>::max();
+        size_t best_split = 0;
+        accumulated = bounding_box<T>();
+        accumulated_count = 0;
+        for (size_t i = 1; i < bin_count; ++i)
+        {
+            accumulated.add(bins[i - 1].box);
+            accumulated_count += bins[i - 1].count;
+            if (accumulated_count == 0 || right_count[i] == 0)
+            {
+                continue;
+            }
+            T cost = accumulated.surface_area() * accumulated_count + right_area[i] * right_count[i];
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best_split = i;
+            }
+        }
+
+        size_t count = end - begin;
+        T node_area = node_box.surface_area();
+        T leaf_cost = T(count);
+        T split_cost = 1 + (node_area > 0 ? best_cost / node_area : T(count));
+
+        if (best_split == 0 || (split_cost >= leaf_cost && count <= std::numeric_limits<uint16_t>::max()))
+        {
+            return begin;
+        }
+
+        auto middle = std::partition(entries.begin() + begin, entries.begin() + end,
+            [&](const build_entry& e) { return bin_for(e) < best_split; });
+        return size_t(middle - entries.begin());
+    }
+
+    template <typename T, typename color_type>
+    template <typename visitor_type>
+    void bvh<T, color_type>::traverse(const unit_line3<T>& line, T limit, visitor_type visitor) const
+    {
+        if (m_nodes.empty())
+        {
+            return;
+        }
+
+        const box_line_tester<T> tester(line);
+        const T line_begin = line.limits().begin();
+        const T line_end = line.limits().end();
+
+        std::array<uint32_t, max_depth + 2> stack;
+        size_t top = 0;
+        stack[top++] = 0;
+
+        while (top > 0)
+        {
+            uint32_t index = stack[--top];
+            const node& n = m_nodes[index];
+
+            T t_near;
+            T t_far;
+            if (!tester.intersects(n.box, line_begin, std::min(limit, line_end), t_near, t_far))
+            {
+                continue;
+            }
+
+            if (n.count > 0)
+            {
+                for (uint32_t i = n.offset; i < n.offset + n.count; ++i)
+                {
+                    limit = visitor(*m_bounded[i], limit);
+                }
+            }
+            else
+            {
+                // Visit the child on the near side of the split first (by
+                // pushing it last), so hits found there can cull the other.
+                if (line.direction()[n.axis] < 0)
+                {
+                    stack[top++] = index + 1;
+                    stack[top++] = n.offset;
+                }
+                else
+                {
+                    stack[top++] = n.offset;
+                    stack[top++] = index + 1;
+                }
+            }
+        }
+    }
+
+    template <typename T, typename color_type>
+    template <typename intersect_function>
+    bool bvh<T, color_type>::find_intersection(const unit_line3<T>& line, T time,
+        intersection_info<T,color_type>& intersection,
+        const intersection_requirements& requirements,
+        intersect_function intersect) const
+    {
+        bool intersects_something = false;
+        bool all_hits = requirements.needs_all_hits();
+
+        // Clear it out...
+        intersection = intersection_info<T,color_type>();
+
+        if (impl::intersect_closest(*this, line, time, requirements, intersects_something,
+                [&](const shape<T, color_type>& obj) { return intersect(obj, intersection); }))
+        {
+            return intersects_something;
+        }
+
+        auto visit = [&](const shape<T, color_type>& obj, T limit)
+        {
+            intersection_info<T,color_type> temp_intersection;
+            if (intersect(obj, temp_intersection))
+            {
+                impl::merge_intersection<T, color_type>(this, temp_intersection, intersection, intersects_something, requirements);
+                if (!all_hits)
+                {
+                    return std::min(limit, intersection.get_first_distance());
+                }
+            }
+            return limit;
+        };
+
+        T limit = line.limits().end();
+        for (const auto& obj : m_unbounded)
+        {
+            limit = visit(*obj, limit);
+        }
+        traverse(line, limit, visit);
+
+        return intersects_something;
+    }
+
+    template <typename T, typename color_type>
+    bool bvh<T, color_type>::intersects_line(const unit_line3<T>& line,
+        intersection_info<T,color_type>& intersection,
+        const intersection_requirements& requirements) const
+    {
+        return find_intersection(line, T(0), intersection, requirements,
+            [&](const shape<T, color_type>& obj, intersection_info<T,color_type>& temp)
+            {
+                return obj.intersects_line(line, temp, requirements);
+            });
+    }
+
+    template <typename T, typename color_type>
+    bool bvh<T, color_type>::intersects_ray(const ray_parameters<T,color_type>& ray,
+        intersection_info<T,color_type>& intersection,
+        const intersection_requirements& requirements) const
+    {
+        return find_intersection(ray.get_line(), ray.get_time(), intersection, requirements,
+            [&](const shape<T, color_type>& obj, intersection_info<T,color_type>& temp)
+            {
+                return obj.intersects_ray(ray, temp, requirements);
+            });
+    }
+
+    template <typename T, typename color_type>
+    bool bvh<T, color_type>::quick_intersection(const unit_line3<T>& line, T time, T& distance) const
+    {
+        bool hit_something = false;
+        T closest = line.limits().end();
+
+        auto visit = [&](const shape<T, color_type>& obj, T limit)
+        {
+            T dist;
+            if (obj.quick_intersection(line, time, dist) && dist < limit)
+            {
+                hit_something = true;
+                closest = dist;
+                return dist;
+            }
+            return limit;
+        };
+
+        for (const auto& obj : m_unbounded)
+        {
+            closest = visit(*obj, closest);
+        }
+        traverse(line, closest, visit);
+
+        if (hit_something)
+        {
+            distance = closest;
+        }
+        return hit_something;
+    }
+
+    template <typename T, typename color_type>
+    bool bvh<T, color_type>::closest_hit(const unit_line3<T>& line, T time, hit_record<T, color_type>& hit) const
+    {
+        bool changed = false;
+
+        auto visit = [&](const shape<T, color_type>& obj, T limit)
+        {
+            changed = obj.closest_hit(line, time, hit) || changed;
+            return std::min(limit, hit.distance);
+        };
+
+        T limit = std::min(line.limits().end(), hit.distance);
+        for (const auto& obj : m_unbounded)
+        {
+            limit = visit(*obj, limit);
+        }
+        traverse(line, limit, visit);
+
+        return changed;
+    }
+
+    template <typename T, typename color_type>
+    void bvh<T, color_type>::intersect_packet(ray_packet<T, color_type>& packet) const
+    {
+        for (const auto& obj : m_unbounded)
+        {
+            obj->intersect_packet(packet);
+        }
+        if (m_nodes.empty())
+        {
+            return;
+        }
+
+        // The children are ordered by the first lane; the packets are
+        // expected to be coherent.
+        const T first_direction[3] = { packet.direction_x[0], packet.direction_y[0], packet.direction_z[0] };
+
+        std::array<uint32_t, max_depth + 2> stack;
+        size_t top = 0;
+        stack[top++] = 0;
+
+        while (top > 0)
+        {
+            uint32_t index = stack[--top];
+            const node& n = m_nodes[index];
+
+            if (!packet.intersects(n.box))
+            {
+                continue;
+            }
+
+            if (n.count > 0)
+            {
+                for (uint32_t i = n.offset; i < n.offset + n.count; ++i)
+                {
+                    m_bounded[i]->intersect_packet(packet);
+                }
+            }
+            else if (first_direction[n.axis] < 0)
+            {
+                stack[top++] = index + 1;
+                stack[top++] = n.offset;
+            }
+            else
+            {
+                stack[top++] = n.offset;
+                stack[top++] = index + 1;
+            }
+        }
+    }
+
+    template <typename T, typename color_type>
+    bool bvh<T, color_type>::inside(const point3<T>& p) const
+    {
+        for (const auto& s : m_unbounded)
+        {
+            if (s->inside(p))
+            {
+                return true;
+            }
+        }
+
+        std::vector<uint32_t> stack;
+        if (!m_nodes.empty())
+        {
+            stack.push_back(0);
+        }
+        while (!stack.empty())
+        {
+            uint32_t index = stack.back();
+            stack.pop_back();
+            const node& n = m_nodes[index];
+            if (!n.box.inside(p))
+            {
+                continue;
+            }
+            if (n.count > 0)
+            {
+                for (uint32_t i = n.offset; i < n.offset + n.count; ++i)
+                {
+                    if (m_bounded[i]->inside(p))
+                    {
+                        return true;
+                    }
+                }
+            }
+            else
+            {
+                stack.push_back(index + 1);
+                stack.push_back(n.offset);
+            }
+        }
+        return false;
+    }
+
+    template <typename T, typename color_type>
+    bool bvh<T, color_type>::intersects(const sphere<T,color_type>& s) const
+    {
+        for (const auto& p : m_unbounded)
+        {
+            if (p->intersects(s))
+            {
+                return true;
+            }
+        }
+
+        bounding_box<T> sphere_box;
+        s.get_bounds(sphere_box);
+
+        std::vector<uint32_t> stack;
+        if (!m_nodes.empty())
+        {
+            stack.push_back(0);
+        }
+        while (!stack.empty())
+        {
+            uint32_t index = stack.back();
+            stack.pop_back();
+            const node& n = m_nodes[index];
+            if (!n.box.overlaps(sphere_box))
+            {
+                continue;
+            }
+            if (n.count > 0)
+            {
+                for (uint32_t i = n.offset; i < n.offset + n.count; ++i)
+                {
+                    if (m_bounded[i]->intersects(s))
+                    {
+                        return true;
+                    }
+                }
+            }
+            else
+            {
+                stack.push_back(index + 1);
+                stack.push_back(n.offset);
+            }
+        }
+        return false;
+    }
+
+    template <typename T, typename color_type>
+    bool bvh<T, color_type>::intersects(const plane<T,color_type>& p) const
+    {
+        for (const auto& s : m_unbounded)
+        {
+            if (s->intersects(p))
+            {
+                return true;
+            }
+        }
+        for (const auto& s : m_bounded)
+        {
+            if (s->intersects(p))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename T, typename color_type>
+    bool bvh<T, color_type>::get_bounds(bounding_box<T>& box) const
+    {
+        if (!m_unbounded.empty())
+        {
+            return false;
+        }
+        box = m_nodes.empty() ? bounding_box<T>() : m_nodes.front().box;
+        return true;
+    }
+
+    template <typename T, typename color_type>
+    intersection_capabilities bvh<T, color_type>::get_intersection_capabilities() const
+    {
+        return impl::combined_intersection_capabilities(m_bounded) &
+            impl::combined_intersection_capabilities(m_unbounded);
+    }
+
+    template <typename T, typename color_type>
+    object_capabilities bvh<T, color_type>::get_object_capabilities() const
+    {
+        shape_list all = m_bounded;
+        all.insert(all.end(), m_unbounded.begin(), m_unbounded.end());
+        return impl::combined_object_capabilities(all);
+    }
+
+    template <typename T, typename color_type>
+    std::string bvh<T, color_type>::internal_members(const std::string& indentation, bool prefix_with_classname) const
+    {
+        std::string retval;
+        std::string internal_tagging = indentation;
+
+        if (prefix_with_classname)
+        {
+            internal_tagging += bvh<T, color_type>::name() + "::";
+        }
+
+        retval += indentation + string_format("intersection_capabilities=%1\n", to_string(get_intersection_capabilities()));
+        retval += indentation + string_format("object_capabilities=%1\n", to_string(get_object_capabilities()));
+        retval += internal_tagging + string_format("nodes=%1\n", m_nodes.size());
+        retval += internal_tagging + string_format("unbounded=%1\n", m_unbounded.size());
+
+        std::string level_indent = "  ";
+
+        for (const auto& s : m_unbounded)
+        {
+            retval += s->to_string(indentation, level_indent) + "\n";
+        }
+        for (const auto& s : m_bounded)
+        {
+            retval += s->to_string(indentation, level_indent) + "\n";
+        }
+
+        return retval;
+    }
+}
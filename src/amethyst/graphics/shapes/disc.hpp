@@ -59,6 +59,15 @@ namespace amethyst
         bool quick_intersection(const unit_line3<T>& line,
             T time, T& distance) const override;
 
+        // No packet kernel yet; test each lane on its own (rather than as the
+        // plane would).
+        void intersect_packet(ray_packet<T, color_type>& packet) const override
+        {
+            shape<T, color_type>::intersect_packet(packet);
+        }
+
+        bool get_bounds(bounding_box<T>& box) const override;
+
         std::string internal_members(const std::string& indentation, bool prefix_with_classname = false) const override;
 
         std::string name() const override { return "disc"; }
@@ -71,6 +80,20 @@ namespace amethyst
         T m_radius_squared = T(1);
     };
 
+    template <typename T, typename color_type>
+    bool disc<T,color_type>::get_bounds(bounding_box<T>& box) const
+    {
+        // The disc extends radius*sin(angle between the normal and the axis)
+        // along each axis.
+        const vector3<T>& n = plane<T,color_type>::get_normal();
+        vector3<T> r(m_radius * std::sqrt(std::max(T(0), 1 - n.x() * n.x())),
+            m_radius * std::sqrt(std::max(T(0), 1 - n.y() * n.y())),
+            m_radius * std::sqrt(std::max(T(0), 1 - n.z() * n.z())));
+        const point3<T>& center = plane<T,color_type>::get_origin();
+        box = bounding_box<T>(center - r, center + r);
+        return true;
+    }
+
     template <typename T, typename color_type>
     bool disc<T,color_type>::inside(const point3<T>& point) const
     {
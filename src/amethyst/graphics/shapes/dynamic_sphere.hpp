@@ -4,7 +4,9 @@
 #include "amethyst/graphics/shapes/plane.hpp"
 #include "amethyst/graphics/interpolated_value.hpp"
 #include "amethyst/general/defines.hpp"
+#include <algorithm>
 #include <memory>
+#include <vector>
 #include "amethyst/general/string_format.hpp"
 
 namespace amethyst
@@ -89,6 +91,15 @@ namespace amethyst
             intersection_info<T,color_type>& intersection,
             const intersection_requirements& requirements = intersection_requirements()) const override;
 
+        /**
+         * The bounds over the whole span of the center and radius
+         * interpolation points.
+         */
+        bool get_bounds(bounding_box<T>& box) const override;
+
+        /** The bounds of the sphere for every time in the given range. */
+        bool get_motion_bounds(const interval<T>& time_range, bounding_box<T>& box) const override;
+
         std::string internal_members(const std::string& indentation, bool prefix_with_classname = false) const override;
 
         std::string name() const override { return "dynamic_sphere"; }
@@ -99,6 +110,9 @@ namespace amethyst
     private:
         coord2<T> get_uv(const point3<T>& location, T time) const;
 
+        // The number of evenly spaced times sampled when bounding a time range.
+        static constexpr unsigned bounds_samples = 32;
+
         using center_type = interpolation_point<T, coord3<T>>;
         using radius_type = interpolation_point<T, T>;
 
@@ -242,6 +256,74 @@ namespace amethyst
         return false;
     }
 
+    template <typename T, typename color_type>
+    bool dynamic_sphere<T,color_type>::get_bounds(bounding_box<T>& box) const
+    {
+        T first = T(0);
+        T last = T(0);
+        bool have_range = false;
+        for (const auto& p : center->get_interpolation_points())
+        {
+            first = have_range ? std::min(first, p.parameter) : p.parameter;
+            last = have_range ? std::max(last, p.parameter) : p.parameter;
+            have_range = true;
+        }
+        for (const auto& p : radius->get_interpolation_points())
+        {
+            first = have_range ? std::min(first, p.parameter) : p.parameter;
+            last = have_range ? std::max(last, p.parameter) : p.parameter;
+            have_range = true;
+        }
+        return get_motion_bounds(interval<T>(first, last), box);
+    }
+
+    template <typename T, typename color_type>
+    bool dynamic_sphere<T,color_type>::get_motion_bounds(const interval<T>& time_range, bounding_box<T>& box) const
+    {
+        // The interpolation is not guaranteed to be monotonic between points,
+        // so the range is sampled at the interpolation points that fall inside
+        // it, and at evenly spaced times.  The result is padded by the largest
+        // movement seen between two neighbouring samples to cover overshoot.
+        std::vector<T> times;
+        times.reserve(bounds_samples + 1);
+        for (unsigned i = 0; i <= bounds_samples; ++i)
+        {
+            times.push_back(time_range.begin() + (time_range.end() - time_range.begin()) * T(i) / T(bounds_samples));
+        }
+        for (const auto& p : center->get_interpolation_points())
+        {
+            if (time_range.inside(p.parameter))
+            {
+                times.push_back(p.parameter);
+            }
+        }
+        for (const auto& p : radius->get_interpolation_points())
+        {
+            if (time_range.inside(p.parameter))
+            {
+                times.push_back(p.parameter);
+            }
+        }
+        std::sort(times.begin(), times.end());
+
+        bounding_box<T> result;
+        T padding = T(0);
+        point3<T> previous_center = get_center(times.front());
+        T previous_radius = std::abs(get_radius(times.front()));
+        for (T time : times)
+        {
+            point3<T> c = get_center(time);
+            T r = std::abs(get_radius(time));
+            result.add(bounding_box<T>(c - vector3<T>(r, r, r), c + vector3<T>(r, r, r)));
+
+            padding = std::max(padding, length(c - previous_center) + std::abs(r - previous_radius));
+            previous_center = c;
+            previous_radius = r;
+        }
+        box = result.expand(padding + AMETHYST_EPSILON);
+        return true;
+    }
+
     template <typename T, typename color_type>
     std::string dynamic_sphere<T,color_type>::internal_members(const std::string& indentation, bool prefix_with_classname) const
     {
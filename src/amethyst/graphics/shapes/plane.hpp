@@ -55,6 +55,21 @@ namespace amethyst
         virtual bool quick_intersection(const unit_line3<T>& line,
                                         T time, T& distance) const;
 
+        void intersect_packet(ray_packet<T, color_type>& packet) const override
+        {
+            intersect_packet_where(packet, [](T u, T v) { return true; });
+        }
+
+        // An infinite plane has no bounds.
+        bool get_bounds(bounding_box<T>& box) const override { return false; }
+
+        bool get_uv_derivatives(const point3<T>& location, vector3<T>& dp_du, vector3<T>& dp_dv) const override
+        {
+            dp_du = u_vector;
+            dp_dv = v_vector;
+            return true;
+        }
+
         virtual std::string internal_members(const std::string& indentation, bool prefix_with_classname = false) const;
 
         virtual std::string name() const {
@@ -72,6 +87,13 @@ namespace amethyst
         virtual intersection_capabilities get_intersection_capabilities() const;
         virtual object_capabilities get_object_capabilities() const;
 
+    protected:
+        // The packet version of quick_intersection(), which only records a
+        // hit in lanes where accept(u, v) is true for the point hit.  This
+        // is the kernel for the planar shapes (triangles, rectangles).
+        template <typename uv_test>
+        void intersect_packet_where(ray_packet<T, color_type>& packet, uv_test accept) const;
+
     private:
         void setup_non_zero_indices();
 
@@ -287,6 +309,42 @@ namespace amethyst
         }
     }
 
+    template <typename T, typename color_type>
+    template <typename uv_test>
+    void plane<T,color_type>::intersect_packet_where(ray_packet<T, color_type>& packet, uv_test accept) const
+    {
+        // These follow quick_intersection() and
+        // extract_uv_for_point_nonchecked() operation for operation, so a lane
+        // gets exactly the distance (and uv) that a single line would.
+        const T u_scalar = u_vector[non_zero_v_index] / u_vector[non_zero_u_index];
+        const T v_denominator = (v_vector[non_zero_v_index] - v_vector[non_zero_u_index] * u_scalar);
+        const T u_denominator = u_vector[non_zero_u_index];
+        const T v_along_u = v_vector[non_zero_u_index];
+
+        for (size_t lane = 0; lane < ray_packet<T, color_type>::width; ++lane)
+        {
+            const T ctheta = (packet.direction_x[lane] * normal.x()) + (packet.direction_y[lane] * normal.y()) + (packet.direction_z[lane] * normal.z());
+            const T to_plane_x = defining_point.x() - packet.origin_x[lane];
+            const T to_plane_y = defining_point.y() - packet.origin_y[lane];
+            const T to_plane_z = defining_point.z() - packet.origin_z[lane];
+            // Negating both sides (as quick_intersection does for ctheta <= 0)
+            // gives the same value, so that case isn't needed here.
+            const T t = ((to_plane_x * normal.x()) + (to_plane_y * normal.y()) + (to_plane_z * normal.z())) / ctheta;
+
+            const T diff[3] = {
+                (t * packet.direction_x[lane] + packet.origin_x[lane]) - defining_point.x(),
+                (t * packet.direction_y[lane] + packet.origin_y[lane]) - defining_point.y(),
+                (t * packet.direction_z[lane] + packet.origin_z[lane]) - defining_point.z()
+            };
+            const T v = (diff[non_zero_v_index] - diff[non_zero_u_index] * u_scalar) / v_denominator;
+            const T u = (diff[non_zero_u_index] - v * v_along_u) / u_denominator;
+
+            const bool closer = (packet.begin[lane] < t) && (t < packet.limit[lane]) && accept(u, v);
+            packet.limit[lane] = closer ? t : packet.limit[lane];
+            packet.hit[lane] = closer ? this : packet.hit[lane];
+        }
+    }
+
     template <typename T, typename color_type>
     inline bool plane<T,color_type>::extract_uv_for_point(const point3<T>& point,
                                                coord2<T>& uv) const
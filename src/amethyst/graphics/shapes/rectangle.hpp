@@ -1,5 +1,5 @@
 #pragma once
-#include "amethyst/graphics/plane.hpp"
+#include "amethyst/graphics/shapes/plane.hpp"
 
 namespace amethyst
 {
@@ -18,17 +18,19 @@ namespace amethyst
     public:
         rectangle() = default;
 
-        rectangle(const point3<T>& point = point3<T>(0, 0, 0),
-            const vector3<T>& u = vector3<T>(1, 0, 0),
-            const vector3<T>& v = vector3<T>(0, 1, 0))
-            : plane(point, u, v)
+        // A rectangle with one corner at point, and edges along u and v.
+        rectangle(const point3<T>& point,
+            const vector3<T>& u,
+            const vector3<T>& v)
+            : plane<T,color_type>(point, crossprod(u, v), u, v)
         {
         }
 
-        rectangle(const point3<T>& corner1 = point3<T>(0, 0, 0),
-            const point3<T>& corner2 = point3<T>(1, 0, 0),
-            const point3<T>& corner3 = point3<T>(0, 1, 0))
-            : plane(corner1, corner2, corner3)
+        // A rectangle with one corner at corner1, and edges to corner2 and corner3.
+        rectangle(const point3<T>& corner1,
+            const point3<T>& corner2,
+            const point3<T>& corner3)
+            : plane<T,color_type>(corner1, corner2, corner3)
         {
         }
 
@@ -45,16 +47,32 @@ namespace amethyst
 
         bool quick_intersection(const unit_line3<T>& line, T time, T& distance) const override;
 
+        void intersect_packet(ray_packet<T, color_type>& packet) const override
+        {
+            plane<T, color_type>::intersect_packet_where(packet, [](T u, T v) { return (u > 0) && (v > 0) && (u < 1) && (v < 1); });
+        }
+
+        bool get_bounds(bounding_box<T>& box) const override
+        {
+            const point3<T>& origin = plane<T,color_type>::get_origin();
+            const vector3<T>& u = plane<T,color_type>::get_u_vector();
+            const vector3<T>& v = plane<T,color_type>::get_v_vector();
+            box = bounding_box<T>(origin, origin + u + v);
+            box.add(origin + u);
+            box.add(origin + v);
+            return true;
+        }
+
         std::string internal_members(const std::string& indentation, bool prefix_with_classname = false) const override;
 
         std::string name() const override { return "rectangle"; }
 
         intersection_capabilities get_intersection_capabilities() const override;
-        object_capabilities get_object capabilities() const override;
+        object_capabilities get_object_capabilities() const override;
     };
 
     template <typename T, typename color_type>
-    bool rectangle<T>::inside(const point3<T>& point) const
+    bool rectangle<T,color_type>::inside(const point3<T>& point) const
     {
         coord2<T> uv;
         if (plane<T,color_type>::extract_uv_for_point(point, uv))
@@ -70,7 +88,7 @@ namespace amethyst
     }
 
     template <typename T, typename color_type>
-    bool rectangle<T>::intersects(const sphere<T,color_type>& s) const
+    bool rectangle<T,color_type>::intersects(const sphere<T,color_type>& s) const
     {
         if (plane<T,color_type>::intersects(s))
         {
@@ -92,7 +110,7 @@ namespace amethyst
     }
 
     template <typename T, typename color_type>
-    bool rectangle<T>::intersects(const plane<T,color_type>& p) const
+    bool rectangle<T,color_type>::intersects(const plane<T,color_type>& p) const
     {
         // This should be replaced with a much faster method.
         //  One potential method would be to project onto the plane to calculate
@@ -120,7 +138,7 @@ namespace amethyst
     }
 
     template <typename T, typename color_type>
-    bool rectangle<T>::intersects_line(const unit_line3<T>& line,
+    bool rectangle<T,color_type>::intersects_line(const unit_line3<T>& line,
                                        intersection_info<T,color_type>& intersection,
                                        const intersection_requirements& requirements) const
     {
@@ -152,14 +170,34 @@ namespace amethyst
     }
 
     template <typename T, typename color_type>
-    std::string rectangle<T>::internal_members(const std::string& indentation, bool prefix_with_classname) const
+    bool rectangle<T,color_type>::quick_intersection(const unit_line3<T>& line, T time, T& distance) const
+    {
+        T t;
+        if (plane<T,color_type>::quick_intersection(line, time, t))
+        {
+            coord2<T> uv;
+            plane<T,color_type>::extract_uv_for_point_nonchecked(line.point_at(t), uv);
+            if ((uv.x() > 0) &&
+                (uv.y() > 0) &&
+                (uv.x() < 1) &&
+                (uv.y() < 1))
+            {
+                distance = t;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename T, typename color_type>
+    std::string rectangle<T,color_type>::internal_members(const std::string& indentation, bool prefix_with_classname) const
     {
-        std::string retval = = plane<T,color_type>::internal_members(indentation, prefix_with_classname);
+        std::string retval = plane<T,color_type>::internal_members(indentation, prefix_with_classname);
         std::string internal_tagging = indentation;
 
         if (prefix_with_classname)
         {
-            internal_tagging += rectangle<T>::name() + "::";
+            internal_tagging += rectangle<T,color_type>::name() + "::";
         }
 
         // No local members.
@@ -168,7 +206,7 @@ namespace amethyst
     }
 
     template <typename T, typename color_type>
-    intersection_capabilities rectangle<T>::get_intersection_capabilities() const
+    intersection_capabilities rectangle<T,color_type>::get_intersection_capabilities() const
     {
         intersection_capabilities caps = plane<T,color_type>::get_intersection_capabilities();
 
@@ -176,7 +214,7 @@ namespace amethyst
     }
 
     template <typename T, typename color_type>
-    object_capabilities rectangle<T>::get_object_capabilities() const
+    object_capabilities rectangle<T,color_type>::get_object_capabilities() const
     {
         object_capabilities caps = plane<T,color_type>::get_object_capabilities();
 
@@ -4,10 +4,13 @@
 #include "amethyst/math/point3.hpp"
 #include "amethyst/math/line3.hpp"
 #include "amethyst/math/unit_line3.hpp"
+#include "amethyst/math/bounding_box.hpp"
 #include "amethyst/graphics/intersection_info.hpp"
 #include "amethyst/graphics/capabilities.hpp"
 #include "amethyst/graphics/requirements.hpp"
 #include "amethyst/graphics/ray_parameters.hpp"
+#include "amethyst/graphics/ray_packet.hpp"
+#include "amethyst/graphics/hit_record.hpp"
 #include "amethyst/general/string_dumpable.hpp"
 #include "amethyst/graphics/texture/texture.hpp"
 
@@ -80,6 +83,55 @@ namespace amethyst
          */
         virtual bool quick_intersection(const unit_line3<T>& line, T time, T& distance) const = 0;
 
+        /**
+         * Record this shape in hit if it is hit closer than the current
+         * closest.  Returns true if the record was changed.  Containers
+         * override this to record the contained shape that was hit, so the
+         * full intersection can be done on that shape alone.
+         */
+        virtual bool closest_hit(const unit_line3<T>& line, T time, hit_record<T, color_type>& hit) const
+        {
+            T distance;
+            return quick_intersection(line, time, distance) && hit.record(distance, this);
+        }
+
+        /**
+         * Intersect every lane of a packet, recording this shape in the lanes
+         * where it is closer than any hit found so far.  The default calls
+         * quick_intersection() once per lane; simple shapes override it with
+         * a kernel that handles all of the lanes together.
+         */
+        virtual void intersect_packet(ray_packet<T, color_type>& packet) const;
+
+        /**
+         * Get an axis-aligned box containing the entire shape.  Returns false
+         * if the shape is unbounded (or does not know its bounds), in which
+         * case the box is left untouched.
+         */
+        virtual bool get_bounds(bounding_box<T>& box) const
+        {
+            return false;
+        }
+
+        /**
+         * Get an axis-aligned box containing the shape at every time in the
+         * given range.  Shapes which do not move use their static bounds.
+         */
+        virtual bool get_motion_bounds(const interval<T>& time_range, bounding_box<T>& box) const
+        {
+            return get_bounds(box);
+        }
+
+        /**
+         * How the surface moves with its u-v coordinates at the given point on
+         * it, which (with ray differentials) tells how much of a texture a
+         * pixel covers.  Returns false if the shape does not know.
+         */
+        virtual bool get_uv_derivatives(const point3<T>& location, vector3<T>& dp_du, vector3<T>& dp_dv) const
+        {
+            return false;
+        }
+
         virtual std::string name() const
         {
             return "shape";
@@ -122,6 +174,19 @@ namespace amethyst
     }
 
 
+    template <typename T, typename color_type>
+    void shape<T, color_type>::intersect_packet(ray_packet<T, color_type>& packet) const
+    {
+        for (size_t lane = 0; lane < packet.size(); ++lane)
+        {
+            T distance;
+            if (quick_intersection(packet.get_line(lane), packet.time[lane], distance))
+            {
+                packet.record_hit(lane, distance, this);
+            }
+        }
+    }
+
     template <typename T, typename color_type>
     bool shape<T, color_type>::intersects_ray(const ray_parameters<T,color_type>& ray,
         intersection_info<T,color_type>& intersection,
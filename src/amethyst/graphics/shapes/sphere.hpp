@@ -90,6 +90,18 @@ namespace amethyst
 
         bool quick_intersection(const unit_line3<T>& line, T time, T& distance) const override;
 
+        /** The same test as quick_intersection(), for all lanes at once. */
+        void intersect_packet(ray_packet<T, color_type>& packet) const override;
+
+        bool get_bounds(bounding_box<T>& box) const override
+        {
+            vector3<T> r(m_radius, m_radius, m_radius);
+            box = bounding_box<T>(m_center - r, m_center + r);
+            return true;
+        }
+
+        bool get_uv_derivatives(const point3<T>& location, vector3<T>& dp_du, vector3<T>& dp_dv) const override;
+
         std::string internal_members(const std::string& indentation, bool prefix_with_classname = false) const override;
 
         std::string name() const override { return "sphere"; }
@@ -177,6 +189,38 @@ namespace amethyst
         return quick_sphere_intersection_test(m_center, m_radius, m_radius_squared, line, distance);
     }
 
+    template <typename T, typename color_type>
+    void sphere<T,color_type>::intersect_packet(ray_packet<T, color_type>& packet) const
+    {
+        // This follows quick_sphere_intersection_test() operation for
+        // operation, so a lane gets exactly the distance a single line would.
+        for (size_t lane = 0; lane < ray_packet<T, color_type>::width; ++lane)
+        {
+            const T ocx = packet.origin_x[lane] - m_center.x();
+            const T ocy = packet.origin_y[lane] - m_center.y();
+            const T ocz = packet.origin_z[lane] - m_center.z();
+            const T dx = packet.direction_x[lane];
+            const T dy = packet.direction_y[lane];
+            const T dz = packet.direction_z[lane];
+
+            const T A = (dx * dx) + (dy * dy) + (dz * dz);
+            const T B = 2 * ((dx * ocx) + (dy * ocy) + (dz * ocz));
+            const T C = ((ocx * ocx) + (ocy * ocy) + (ocz * ocz)) - m_radius_squared;
+            const T discriminant = B * B - 4 * A * C;
+            const T sqrtd = sqrt(discriminant < 0 ? T(0) : discriminant);
+
+            // The near side is used unless it is before the start of the
+            // line.  A near side past the limit means the far side is too.
+            const T t1 = (-B - sqrtd) / (2 * A);
+            const T t2 = (-B + sqrtd) / (2 * A);
+            const T t = (packet.begin[lane] < t1) ? t1 : t2;
+
+            const bool closer = !(discriminant < 0) && (packet.begin[lane] < t) && (t < packet.limit[lane]);
+            packet.limit[lane] = closer ? t : packet.limit[lane];
+            packet.hit[lane] = closer ? this : packet.hit[lane];
+        }
+    }
+
     template <typename T, typename color_type>
     std::string sphere<T,color_type>::internal_members(const std::string& indentation, bool prefix_with_classname) const
     {
@@ -241,4 +285,23 @@ namespace amethyst
 
         return { u, v };
     }
-}
\ No newline at end of file
+
+    template <typename T, typename color_type>
+    bool sphere<T,color_type>::get_uv_derivatives(const point3<T>& location, vector3<T>& dp_du, vector3<T>& dp_dv) const
+    {
+        // Differentiating the point at (theta, phi) as get_uv() finds them,
+        // where u = (pi - phi) / 2pi and v = 1 - theta / pi.
+        vector3<T> point_vector = (location - m_center) / m_radius;
+        const T sin_theta = sqrt(point_vector.x() * point_vector.x() + point_vector.z() * point_vector.z());
+        if (sin_theta < AMETHYST_EPSILON)
+        {
+            // The poles, where u is undefined.
+            return false;
+        }
+
+        const T cos_theta = point_vector.y();
+        dp_du = T(2 * M_PI) * m_radius * vector3<T>(point_vector.z(), 0, -point_vector.x());
+        dp_dv = T(-M_PI) * m_radius * vector3<T>(cos_theta * point_vector.x() / sin_theta, -sin_theta, cos_theta * point_vector.z() / sin_theta);
+        return true;
+    }
+}
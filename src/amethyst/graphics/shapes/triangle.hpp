@@ -35,6 +35,19 @@ namespace amethyst
             const intersection_requirements& requirements) const override;
         bool quick_intersection(const unit_line3<T>& line, T time, T& distance) const override;
 
+        void intersect_packet(ray_packet<T, color_type>& packet) const override
+        {
+            plane<T, color_type>::intersect_packet_where(packet, [](T u, T v) { return (u > 0 && v > 0) && (u + v < 1); });
+        }
+
+        bool get_bounds(bounding_box<T>& box) const override
+        {
+            const point3<T>& origin = plane<T, color_type>::get_origin();
+            box = bounding_box<T>(origin, origin + plane<T, color_type>::get_u_vector());
+            box.add(origin + plane<T, color_type>::get_v_vector());
+            return true;
+        }
+
         std::string internal_members(const std::string& indentation, bool prefix_with_classname = false) const override;
         std::string name() const override { return "triangle"; }
 
@@ -5,6 +5,7 @@
 
 #include "stb_image_helper.hpp"
 #include <memory>
+#include <stdexcept>
 
 namespace amethyst
 {
@@ -12,6 +13,10 @@ namespace amethyst
     {
         int width, height, bytes_per_pixel;
         std::shared_ptr<unsigned char> data(stbi_load(filename.c_str(), &width, &height, &bytes_per_pixel, STBI_rgb), stbi_image_free);
+        if (!data)
+        {
+            throw std::runtime_error("Unable to load image " + filename + ": " + stbi_failure_reason());
+        }
         rgbcolor<uint8_t>* reinterpreted = reinterpret_cast<rgbcolor<uint8_t>*>(data.get());
         raster<rgbcolor<uint8_t>> result(width, height);
         for (size_t j = 0; j < size_t(height); ++j)
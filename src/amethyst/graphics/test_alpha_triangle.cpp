@@ -0,0 +1,109 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "graphics/alpha_triangle_2d.hpp"
+#include "general/random.hpp"
+
+using namespace amethyst;
+
+namespace
+{
+    bool same_color(const rgbcolor<double>& a, const rgbcolor<double>& b)
+    {
+        return (a.r() == b.r()) && (a.g() == b.g()) && (a.b() == b.b());
+    }
+
+    // Triangles that are partly off the image, and some thin enough to be
+    // drawn with x and y swapped.
+    std::vector<alpha_triangle_2d<double>> random_triangles(size_t count, size_t width, size_t height)
+    {
+        default_random<double> rnd(11);
+        std::vector<alpha_triangle_2d<double>> triangles(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (alpha_vertex_2d<double>* v : { &triangles[i].v1, &triangles[i].v2, &triangles[i].v3 })
+            {
+                v->xy.set((rnd.next() - 0.25) * width, (rnd.next() - 0.25) * height);
+                v->rgb.set(rnd.next(), rnd.next(), rnd.next());
+                v->a = rnd.next() / 2;
+            }
+            if (i % 4 == 0)
+            {
+                triangles[i].v2.xy.set(triangles[i].v2.xy.x(), triangles[i].v1.xy.y() + 0.5);
+            }
+        }
+        return triangles;
+    }
+}
+
+AUTO_UNIT_TEST(triangle_region_holds_drawn_pixels)
+{
+    const size_t width = 37;
+    const size_t height = 23;
+    for (const alpha_triangle_2d<double>& t : random_triangles(200, width, height))
+    {
+        image<double> img(width, height);
+        img.fill([](size_t, size_t) { return rgbcolor<double>(-1, -1, -1); });
+        dda_rasterize_triangle(img, t);
+
+        const pixel_region region = triangle_region(t, width, height);
+        for (size_t y = 0; y < height; ++y)
+        {
+            for (size_t x = 0; x < width; ++x)
+            {
+                const bool inside = (x >= region.x_begin) && (x < region.x_end) && (y >= region.y_begin) && (y < region.y_end);
+                TEST_BOOLEAN(inside || same_color(img(x, y), rgbcolor<double>(-1, -1, -1)));
+            }
+        }
+    }
+}
+
+AUTO_UNIT_TEST(clipped_triangles_match_unclipped)
+{
+    const size_t width = 41;
+    const size_t height = 29;
+    const std::vector<alpha_triangle_2d<double>> triangles = random_triangles(60, width, height);
+
+    image<double> full(width, height);
+    full.fill([](size_t, size_t) { return rgbcolor<double>(0, 0, 0); });
+    for (const alpha_triangle_2d<double>& t : triangles)
+    {
+        dda_rasterize_triangle(full, t);
+    }
+
+    const pixel_region clip{ 7, 5, 30, 19 };
+    image<double> clipped(width, height);
+    clipped.fill([](size_t, size_t) { return rgbcolor<double>(-1, -1, -1); });
+    for (size_t y = clip.y_begin; y < clip.y_end; ++y)
+    {
+        for (size_t x = clip.x_begin; x < clip.x_end; ++x)
+        {
+            clipped(x, y).set(0, 0, 0);
+        }
+    }
+    for (const alpha_triangle_2d<double>& t : triangles)
+    {
+        dda_rasterize_triangle(clipped, t, clip);
+    }
+
+    for (size_t y = 0; y < height; ++y)
+    {
+        for (size_t x = 0; x < width; ++x)
+        {
+            const bool inside = (x >= clip.x_begin) && (x < clip.x_end) && (y >= clip.y_begin) && (y < clip.y_end);
+            TEST_BOOLEAN(same_color(clipped(x, y), inside ? full(x, y) : rgbcolor<double>(-1, -1, -1)));
+        }
+    }
+}
+
+AUTO_UNIT_TEST(region_merge_and_intersect)
+{
+    const pixel_region a{ 0, 0, 10, 10 };
+    const pixel_region b{ 5, 8, 20, 12 };
+    const pixel_region m = merge_regions(a, b);
+    TEST_COMPARE_EQUAL(m.x_begin, 0u);
+    TEST_COMPARE_EQUAL(m.y_end, 12u);
+    TEST_COMPARE_EQUAL(m.pixels(), 240u);
+    TEST_COMPARE_EQUAL(intersect_regions(a, b).pixels(), 10u);
+    TEST_BOOLEAN(intersect_regions(a, pixel_region{ 10, 0, 12, 5 }).empty());
+    TEST_COMPARE_EQUAL(merge_regions(pixel_region(), b).pixels(), b.pixels());
+}
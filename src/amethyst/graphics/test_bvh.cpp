@@ -0,0 +1,212 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "graphics/shapes/bvh.hpp"
+#include "graphics/shapes/sphere.hpp"
+#include "graphics/shapes/triangle.hpp"
+#include "graphics/shapes/plane.hpp"
+#include "graphics/shapes/disc.hpp"
+#include "general/random.hpp"
+
+using namespace amethyst;
+
+namespace
+{
+    using point = point3<double>;
+    using vec = vector3<double>;
+    using info = intersection_info<double, vec>;
+    using shape_type = shape_ptr<double, vec>;
+
+    aggregate<double, vec> make_scene(size_t count, bool include_plane)
+    {
+        default_random<double> rnd(42);
+        auto coord = [&](double range) { return (rnd.next() * 2 - 1) * range; };
+
+        aggregate<double, vec> scene;
+        for (size_t i = 0; i < count; ++i)
+        {
+            point p(coord(10), coord(10), coord(10));
+            switch (i % 3)
+            {
+            case 0:
+                scene.add(std::make_shared<sphere<double, vec>>(p, 0.1 + rnd.next()));
+                break;
+            case 1:
+                scene.add(std::make_shared<triangle<double, vec>>(p, p + vec(coord(1), coord(1), coord(1)), p + vec(coord(1), coord(1), coord(1))));
+                break;
+            default:
+                scene.add(std::make_shared<disc<double, vec>>(p, 0.5, unit(vec(coord(1), coord(1), 1))));
+                break;
+            }
+        }
+        if (include_plane)
+        {
+            scene.add(std::make_shared<plane<double, vec>>(point(0, -9, 0), vec(0, 1, 0)));
+        }
+        return scene;
+    }
+
+    std::vector<unit_line3<double>> make_lines(size_t count)
+    {
+        default_random<double> rnd(7);
+        auto coord = [&](double range) { return (rnd.next() * 2 - 1) * range; };
+
+        std::vector<unit_line3<double>> lines;
+        for (size_t i = 0; i < count; ++i)
+        {
+            point origin(coord(15), coord(15), coord(15));
+            point target(coord(5), coord(5), coord(5));
+            lines.emplace_back(origin, target - origin, interval<double>(AMETHYST_EPSILON, std::numeric_limits<double>::max()));
+        }
+        return lines;
+    }
+}
+
+AUTO_UNIT_TEST(bvh_construction)
+{
+    auto scene = make_scene(300, true);
+    bvh<double, vec> tree(scene);
+    TEST_COMPARE_EQUAL(tree.size(), scene.size());
+    TEST_BOOLEAN(tree.node_count() > 1);
+
+    bounding_box<double> box;
+    TEST_BOOLEAN(!tree.get_bounds(box));
+
+    bvh<double, vec> bounded(make_scene(30, false));
+    TEST_BOOLEAN(bounded.get_bounds(box));
+    TEST_BOOLEAN(!box.empty());
+
+    bvh<double, vec> empty_tree(aggregate<double, vec>{});
+    unit_line3<double> line(point(0, 0, 0), vec(1, 0, 0));
+    info i;
+    TEST_BOOLEAN(!empty_tree.intersects_line(line, i));
+}
+
+AUTO_UNIT_TEST(bvh_matches_aggregate)
+{
+    auto scene = make_scene(600, true);
+    bvh<double, vec> tree(scene, 2);
+
+    intersection_requirements requirements;
+    requirements.force_first_only(true);
+    requirements.force_normal(true);
+
+    size_t hits = 0;
+    size_t mismatches = 0;
+    for (const auto& line : make_lines(2000))
+    {
+        info expected;
+        info actual;
+        bool expected_hit = scene.intersects_line(line, expected, requirements);
+        bool actual_hit = tree.intersects_line(line, actual, requirements);
+        if (expected_hit != actual_hit)
+        {
+            ++mismatches;
+            continue;
+        }
+        if (expected_hit)
+        {
+            ++hits;
+            if (expected.get_shape() != actual.get_shape() ||
+                expected.get_first_distance() != actual.get_first_distance())
+            {
+                ++mismatches;
+            }
+        }
+
+        double expected_distance = 0;
+        double actual_distance = 0;
+        bool expected_quick = scene.quick_intersection(line, 0, expected_distance);
+        bool actual_quick = tree.quick_intersection(line, 0, actual_distance);
+        if (expected_quick != actual_quick || expected_distance != actual_distance)
+        {
+            ++mismatches;
+        }
+    }
+    TEST_BOOLEAN(hits > 100);
+    TEST_COMPARE_EQUAL(mismatches, size_t(0));
+}
+
+AUTO_UNIT_TEST(bvh_inside_and_sphere)
+{
+    aggregate<double, vec> scene;
+    scene.add(std::make_shared<sphere<double, vec>>(point(0, 0, 0), 1));
+    scene.add(std::make_shared<sphere<double, vec>>(point(5, 0, 0), 1));
+    scene.add(std::make_shared<sphere<double, vec>>(point(0, 5, 0), 1));
+    bvh<double, vec> tree(scene, 1);
+
+    TEST_BOOLEAN(tree.inside(point(5, 0.5, 0)));
+    TEST_BOOLEAN(!tree.inside(point(2.5, 2.5, 0)));
+    TEST_BOOLEAN(tree.intersects(sphere<double, vec>(point(0, 3.5, 0), 1)));
+    TEST_BOOLEAN(!tree.intersects(sphere<double, vec>(point(3, 3, 0), 0.5)));
+}
+
+AUTO_UNIT_TEST(closest_hit_matches_full_search)
+{
+    auto scene = make_scene(300, true);
+    bvh<double, vec> tree(scene, 2);
+
+    intersection_requirements closest;
+    closest.force_normal(true);
+    // Containers are only recorded by the full search.
+    intersection_requirements full = closest;
+    full.force_containers(true);
+
+    size_t hits = 0;
+    size_t mismatches = 0;
+    for (const auto& line : make_lines(1000))
+    {
+        for (const shape<double, vec>* s : { static_cast<const shape<double, vec>*>(&scene), static_cast<const shape<double, vec>*>(&tree) })
+        {
+            info expected;
+            info actual;
+            bool expected_hit = s->intersects_line(line, expected, full);
+            bool actual_hit = s->intersects_line(line, actual, closest);
+            hit_record<double, vec> record;
+            bool recorded = s->closest_hit(line, 0, record);
+            if (expected_hit != actual_hit || expected_hit != recorded)
+            {
+                ++mismatches;
+                continue;
+            }
+            if (expected_hit)
+            {
+                ++hits;
+                if (expected.get_shape() != actual.get_shape() ||
+                    expected.get_first_distance() != actual.get_first_distance() ||
+                    record.obj != actual.get_shape() ||
+                    length(expected.get_normal() - actual.get_normal()) != 0)
+                {
+                    ++mismatches;
+                }
+                // Nothing beyond the closest hit is collected without the requirement.
+                if (actual.have_containers() || actual.have_multiple_intersections())
+                {
+                    ++mismatches;
+                }
+            }
+        }
+    }
+    TEST_BOOLEAN(hits > 100);
+    TEST_COMPARE_EQUAL(mismatches, size_t(0));
+}
+
+AUTO_UNIT_TEST(intersection_info_extras_copy)
+{
+    sphere<double, vec> s(point(0, 0, 0), 1);
+    info original;
+    TEST_BOOLEAN(!original.have_containers());
+    TEST_BOOLEAN(!original.have_multiple_intersections());
+    original.append_container(&s);
+
+    info copy = original;
+    copy.append_container(&s);
+    TEST_COMPARE_EQUAL(original.get_containers().size(), size_t(1));
+    TEST_COMPARE_EQUAL(copy.get_containers().size(), size_t(2));
+
+    info moved = std::move(copy);
+    TEST_COMPARE_EQUAL(moved.get_containers().size(), size_t(2));
+    TEST_BOOLEAN(!moved.have_multiple_intersections());
+
+    original = info();
+    TEST_BOOLEAN(!original.have_containers());
+}
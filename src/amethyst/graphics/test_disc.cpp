@@ -1,6 +1,7 @@
 #define auto_unit_test_main main
 #include "test_framework/unit_test_auto.hpp"
 #include "graphics/shapes/disc.hpp"
+#include "graphics/shapes/rectangle.hpp"
 #include <cmath>
 #include <iostream>
 
@@ -113,3 +114,34 @@ AUTO_UNIT_TEST(test_ray_disc)
 }
 
 
+
+
+AUTO_UNIT_TEST(test_planar_bounds)
+{
+    amethyst::bounding_box<base_type> b;
+
+    // An infinite plane has no bounds, and leaves the box untouched.
+    TEST_BOOLEAN(!plane(point3(0, 0, 0), vec3(0, 0, 1)).get_bounds(b));
+    TEST_BOOLEAN(b.empty());
+
+    // A disc facing along z is flat in z.
+    TEST_BOOLEAN(disc(point3(1, 2, 3), 2, vec3(0, 0, 1)).get_bounds(b));
+    TEST_XYZ_CLOSE(b.minimum(), -1, 0, 3);
+    TEST_XYZ_CLOSE(b.maximum(), 3, 4, 3);
+
+    amethyst::rectangle<base_type,vec3> r(point3(0, 0, 0), vec3(2, 0, 0), vec3(0, 0, 3));
+    TEST_BOOLEAN(r.get_bounds(b));
+    TEST_XYZ_CLOSE(b.minimum(), 0, 0, 0);
+    TEST_XYZ_CLOSE(b.maximum(), 2, 0, 3);
+}
+
+AUTO_UNIT_TEST(test_rectangle_intersection)
+{
+    amethyst::rectangle<base_type,vec3> r(point3(0, 0, 0), vec3(2, 0, 0), vec3(0, 2, 0));
+    double distance;
+    TEST_BOOLEAN(r.quick_intersection(amethyst::unit_line3<base_type>(point3(1, 1, 5), vec3(0, 0, -1)), 0, distance));
+    TEST_CLOSE(distance, 5);
+    TEST_BOOLEAN(!r.quick_intersection(amethyst::unit_line3<base_type>(point3(3, 1, 5), vec3(0, 0, -1)), 0, distance));
+    TEST_BOOLEAN(r.inside(point3(1, 1, 0)));
+    TEST_BOOLEAN(!r.inside(point3(-1, 1, 0)));
+}
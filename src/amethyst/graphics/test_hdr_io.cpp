@@ -0,0 +1,154 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "graphics/half.hpp"
+#include "graphics/exr_io.hpp"
+#include "graphics/image_loader.hpp"
+#include "graphics/png_io.hpp"
+#include "graphics/stb_image.h"
+#include "general/random.hpp"
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <sstream>
+
+using namespace amethyst;
+
+AUTO_UNIT_TEST(half_conversion)
+{
+    // Every half survives a round trip through float, and the midpoint
+    // between neighbouring halves rounds to the even one.
+    size_t mismatches = 0;
+    for (uint32_t h = 0; h < 0x10000; ++h)
+    {
+        float f = half_to_float(uint16_t(h));
+        if (std::isnan(f))
+        {
+            mismatches += !std::isnan(half_to_float(float_to_half(f)));
+            continue;
+        }
+        mismatches += (float_to_half(f) != h);
+
+        if ((h & 0x7fff) < 0x7bff)
+        {
+            float next = half_to_float(uint16_t(h + 1));
+            float midpoint = f + (next - f) / 2;
+            uint16_t expected = (h & 1) ? uint16_t(h + 1) : uint16_t(h);
+            mismatches += (float_to_half(midpoint) != expected);
+            mismatches += (float_to_half(std::nextafter(midpoint, next)) != h + 1);
+            mismatches += (float_to_half(std::nextafter(midpoint, f)) != h);
+        }
+    }
+    TEST_COMPARE_EQUAL(mismatches, size_t(0));
+
+    TEST_COMPARE_EQUAL(float_to_half(1.0f), 0x3c00);
+    TEST_COMPARE_EQUAL(float_to_half(-2.0f), 0xc000);
+    TEST_COMPARE_EQUAL(float_to_half(65504.0f), 0x7bff);
+    TEST_COMPARE_EQUAL(float_to_half(65520.0f), 0x7c00);
+    TEST_COMPARE_EQUAL(float_to_half(1e-8f), 0);
+    TEST_COMPARE_EQUAL(float_to_half(std::numeric_limits<float>::infinity()), 0x7c00);
+    TEST_BOOLEAN(std::isnan(half_to_float(float_to_half(std::numeric_limits<float>::quiet_NaN()))));
+
+    float values[11] = { 0.1f, 1, 2, 3, 4, 5, 6, 7, 8, 9, 1e5f };
+    uint16_t halves[11];
+    float_to_half(values, halves, 11);
+    float back[11];
+    half_to_float(halves, back, 11);
+    for (size_t i = 0; i < 10; ++i)
+    {
+        TEST_COMPARE_EQUAL(halves[i], float_to_half(values[i]));
+        TEST_COMPARE_EQUAL(back[i], half_to_float(halves[i]));
+    }
+    TEST_BOOLEAN(std::isinf(back[10]));
+}
+
+AUTO_UNIT_TEST(exr_round_trip)
+{
+    image<double> img(19, 7);
+    default_random<double> random(1);
+    img.fill([&](size_t x, size_t y) { return rgbcolor<double>(random.next() * 100, x * 1e-3, -double(y)); });
+
+    std::stringbuf file;
+    exr_io<double> exr;
+    TEST_BOOLEAN(exr.output(file, img));
+    // A header, the offset table, and 8 + 6 bytes per pixel per line.
+    TEST_BOOLEAN(file.str().size() < 400 + 7 * (8 + 8 + 19 * 6));
+
+    std::istringstream input(file.str());
+    image<double> loaded = exr.input(input);
+    TEST_COMPARE_EQUAL(loaded.get_width(), size_t(19));
+    TEST_COMPARE_EQUAL(loaded.get_height(), size_t(7));
+    double worst = 0;
+    for (size_t y = 0; y < img.get_height(); ++y)
+    {
+        for (size_t x = 0; x < img.get_width(); ++x)
+        {
+            for (unsigned c = 0; c < 3; ++c)
+            {
+                double expected = half_to_float(float_to_half(float(img(x, y)[c])));
+                worst = std::max(worst, std::abs(loaded(x, y)[c] - expected));
+            }
+        }
+    }
+    TEST_COMPARE_EQUAL(worst, 0.0);
+
+    // Through the loader, by extension.
+    const std::string filename = "test_hdr_io.exr";
+    TEST_BOOLEAN(save_image(filename, img));
+    image<double> from_file = loadImageD(filename);
+    TEST_CLOSE(from_file(3, 2).r(), loaded(3, 2).r());
+    std::remove(filename.c_str());
+
+    std::istringstream not_exr("P6 1 1 255\n...");
+    TEST_EXCEPTION_THROW_SPECIFIC(exr.input(not_exr), std::runtime_error);
+    std::string compressed = file.str();
+    compressed[compressed.find("compression") + 2 * sizeof("compression") + 4] = 3;
+    std::istringstream unsupported(compressed);
+    TEST_EXCEPTION_THROW_SPECIFIC(exr.input(unsupported), std::runtime_error);
+
+    // Sizes that do not fit in the file are refused before anything is
+    // allocated for them.
+    std::string huge_window = file.str();
+    const size_t window = huge_window.find("dataWindow") + sizeof("dataWindow") + sizeof("box2i") + 4;
+    const char window_max[] = { '\xff', '\xff', '\xff', '\x3f', '\xff', '\xff', '\xff', '\x3f' };
+    huge_window.replace(window + 8, sizeof(window_max), window_max, sizeof(window_max));
+    std::istringstream too_large(huge_window);
+    TEST_EXCEPTION_THROW_SPECIFIC(exr.input(too_large), std::runtime_error);
+    std::string huge_attribute = file.str();
+    const size_t attribute_size = huge_attribute.find("compression") + 2 * sizeof("compression");
+    huge_attribute.replace(attribute_size, 4, "\xff\xff\xff\x7f", 4);
+    std::istringstream too_long(huge_attribute);
+    TEST_EXCEPTION_THROW_SPECIFIC(exr.input(too_long), std::runtime_error);
+    std::istringstream truncated(file.str().substr(0, file.str().size() - 10));
+    TEST_EXCEPTION_THROW_SPECIFIC(exr.input(truncated), std::runtime_error);
+}
+
+AUTO_UNIT_TEST(png16_output)
+{
+    image<double> img(33, 9);
+    img.fill([](size_t x, size_t y) { return rgbcolor<double>(x / 32.0, y / 8.0, (x * y) / 256.0); });
+
+    std::stringbuf file;
+    TEST_BOOLEAN(png_io<double>(16).output(file, img));
+    const std::string data = file.str();
+
+    int w = 0, h = 0, channels = 0;
+    const stbi_uc* bytes = reinterpret_cast<const stbi_uc*>(data.data());
+    TEST_BOOLEAN(stbi_is_16_bit_from_memory(bytes, int(data.size())));
+    stbi_us* decoded = stbi_load_16_from_memory(bytes, int(data.size()), &w, &h, &channels, 3);
+    TEST_BOOLEAN(decoded != nullptr);
+    if (decoded)
+    {
+        size_t mismatches = 0;
+        for (size_t y = 0; y < img.get_height(); ++y)
+        {
+            for (size_t x = 0; x < img.get_width(); ++x)
+            {
+                rgbcolor<uint16_t> expected = convert_color<uint16_t>(img(x, y));
+                const stbi_us* p = decoded + 3 * (y * w + x);
+                mismatches += (p[0] != expected.r()) + (p[1] != expected.g()) + (p[2] != expected.b());
+            }
+        }
+        TEST_COMPARE_EQUAL(mismatches, size_t(0));
+        stbi_image_free(decoded);
+    }
+}
@@ -0,0 +1,160 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "graphics/image_converter.hpp"
+#include "general/random.hpp"
+#include <cmath>
+#include <limits>
+
+using namespace amethyst;
+
+namespace
+{
+    // Inputs spread over many orders of magnitude, as dark values are where
+    // the curves are steepest.
+    std::vector<double> test_inputs(size_t count)
+    {
+        default_random<double> random(5);
+        std::vector<double> inputs;
+        for (size_t i = 0; i < count; ++i)
+        {
+            inputs.push_back(std::pow(random.next(), 1 + 7 * random.next()) * (i % 8 == 0 ? 5 : 1));
+        }
+        return inputs;
+    }
+
+    template <class U>
+    size_t lut_mismatches(const gamma_curve& curve)
+    {
+        const double max_value = std::numeric_limits<U>::max();
+        auto reference = [&](double x) { return size_t(std::min(curve.encode(x), 1.0) * max_value); };
+        const gamma_lut<U> lut(curve);
+        size_t mismatches = 0;
+
+        for (double x : test_inputs(100000))
+        {
+            mismatches += (lut(x) != reference(x));
+        }
+
+        // Each side of every step of the output.
+        for (size_t code = 1; code <= max_value; ++code)
+        {
+            double x = curve.decode(code / max_value);
+            for (int i = 0; i < 4; ++i)
+            {
+                x = std::nextafter(x, 0.0);
+            }
+            for (int i = 0; i < 8; ++i, x = std::nextafter(x, 2.0))
+            {
+                mismatches += (lut(x) != reference(x));
+            }
+        }
+        return mismatches;
+    }
+
+    template <class T>
+    double encode_relative_error(const gamma_curve& curve)
+    {
+        std::vector<double> inputs = test_inputs(100000);
+        std::vector<T> values(inputs.begin(), inputs.end());
+        gamma_encode(values.data(), values.size(), curve);
+
+        double worst = 0;
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            const double x = T(inputs[i]);
+            if (x >= std::numeric_limits<T>::min())
+            {
+                const double expected = curve.encode(x);
+                worst = std::max(worst, std::abs(values[i] - expected) / expected);
+            }
+        }
+        return worst;
+    }
+}
+
+AUTO_UNIT_TEST(gamma_lut_matches_reference)
+{
+    for (const gamma_curve& curve : { gamma_curve::power(2.2), gamma_curve::power(1.8), gamma_curve::srgb_curve() })
+    {
+        TEST_COMPARE_EQUAL(lut_mismatches<uint8_t>(curve), size_t(0));
+        TEST_COMPARE_EQUAL(lut_mismatches<uint16_t>(curve), size_t(0));
+    }
+
+    const gamma_lut<uint8_t> lut(gamma_curve::power(2.2));
+    TEST_COMPARE_EQUAL(lut(0.0), 0);
+    TEST_COMPARE_EQUAL(lut(-0.5), 0);
+    TEST_COMPARE_EQUAL(lut(std::numeric_limits<double>::quiet_NaN()), 0);
+    TEST_COMPARE_EQUAL(lut(1.0), 255);
+    TEST_COMPARE_EQUAL(lut(7.0), 255);
+}
+
+AUTO_UNIT_TEST(gamma_encode_precision)
+{
+    for (const gamma_curve& curve : { gamma_curve::power(2.2), gamma_curve::power(1.8), gamma_curve::srgb_curve() })
+    {
+        TEST_BOOLEAN(encode_relative_error<double>(curve) < 2e-8);
+        TEST_BOOLEAN(encode_relative_error<float>(curve) < 5e-6);
+    }
+
+    float edges[] = { -1.0f, 0.0f, 1e-40f, std::numeric_limits<float>::quiet_NaN(), 1.0f, 3.0f };
+    gamma_encode(edges, 6, gamma_curve::power(2.0));
+    TEST_COMPARE_EQUAL(edges[0], 0.0f);
+    TEST_COMPARE_EQUAL(edges[1], 0.0f);
+    TEST_COMPARE_EQUAL(edges[2], 0.0f);
+    TEST_COMPARE_EQUAL(edges[3], 0.0f);
+    TEST_CLOSE(edges[4], 1.0f);
+    TEST_CLOSE(edges[5], std::sqrt(3.0f));
+}
+
+AUTO_UNIT_TEST(convert_image_matches_gamma_convert_color)
+{
+    image<double> img(37, 11);
+    default_random<double> random(9);
+    for (size_t y = 0; y < img.get_height(); ++y)
+    {
+        for (size_t x = 0; x < img.get_width(); ++x)
+        {
+            img(x, y) = rgbcolor<double>(random.next(), random.next() * 1e-3, 1.5 * random.next());
+        }
+    }
+
+    image<uint8_t> bytes = convert_image<uint8_t>(img, 2.2);
+    image<double> doubles = convert_image<double>(img, 2.2);
+    size_t mismatches = 0;
+    double worst = 0;
+    for (size_t y = 0; y < img.get_height(); ++y)
+    {
+        for (size_t x = 0; x < img.get_width(); ++x)
+        {
+            rgbcolor<uint8_t> expected = gamma_convert_color<uint8_t>(img(x, y), 2.2);
+            mismatches += (bytes(x, y).r() != expected.r()) + (bytes(x, y).g() != expected.g()) + (bytes(x, y).b() != expected.b());
+
+            rgbcolor<double> exact = gamma_convert_color<double>(img(x, y), 2.2);
+            worst = std::max(worst, std::abs(doubles(x, y).r() - exact.r()));
+            worst = std::max(worst, std::abs(doubles(x, y).g() - exact.g()));
+            worst = std::max(worst, std::abs(doubles(x, y).b() - exact.b()));
+        }
+    }
+    TEST_COMPARE_EQUAL(mismatches, size_t(0));
+    TEST_BOOLEAN(worst < 1e-7);
+}
+
+AUTO_UNIT_TEST(convert_image_gamma_from_bytes)
+{
+    image<uint8_t> img(3, 1);
+    img(0, 0) = rgbcolor<uint8_t>(10, 64, 128);
+    img(1, 0) = rgbcolor<uint8_t>(0, 1, 255);
+    img(2, 0) = rgbcolor<uint8_t>(200, 254, 33);
+
+    image<uint8_t> bytes = convert_image<uint8_t>(img, 2.2);
+    size_t mismatches = 0;
+    for (size_t x = 0; x < img.get_width(); ++x)
+    {
+        rgbcolor<uint8_t> expected = gamma_convert_color<uint8_t>(img(x, 0), 2.2);
+        mismatches += (bytes(x, 0).r() != expected.r()) + (bytes(x, 0).g() != expected.g()) + (bytes(x, 0).b() != expected.b());
+    }
+    TEST_COMPARE_EQUAL(mismatches, size_t(0));
+    TEST_COMPARE_EQUAL(bytes(0, 0).r(), 58);
+    TEST_COMPARE_EQUAL(bytes(0, 0).g(), 136);
+    TEST_COMPARE_EQUAL(bytes(0, 0).b(), 186);
+}
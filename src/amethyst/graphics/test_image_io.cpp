@@ -0,0 +1,93 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "graphics/ppm_io.hpp"
+#include "graphics/tga_io.hpp"
+#include <sstream>
+
+using namespace amethyst;
+
+namespace
+{
+    image<uint8_t> test_image()
+    {
+        image<uint8_t> img(7, 5);
+        // The first pixel looks like whitespace and a comment.
+        img.fill([](size_t x, size_t y) { return rgbcolor<uint8_t>(uint8_t(10 + 40 * x), uint8_t(32 + 7 * y), uint8_t('#' + x * y)); });
+        return img;
+    }
+
+    bool same(const image<uint8_t>& a, const image<uint8_t>& b)
+    {
+        if ((a.get_width() != b.get_width()) || (a.get_height() != b.get_height()))
+        {
+            return false;
+        }
+        for (size_t y = 0; y < a.get_height(); ++y)
+        {
+            for (size_t x = 0; x < a.get_width(); ++x)
+            {
+                if ((a(x, y).r() != b(x, y).r()) || (a(x, y).g() != b(x, y).g()) || (a(x, y).b() != b(x, y).b()))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+AUTO_UNIT_TEST(ppm_read_matches_written)
+{
+    const image<uint8_t> img = test_image();
+    ppm_io<uint8_t> ppm;
+
+    std::stringstream binary;
+    ppm.output(binary, img);
+    TEST_BOOLEAN(same(ppm.input(binary), img));
+
+    std::stringstream text("P3\n# a comment\n2 1\n255\n1 2 3  250 251 252\n");
+    image<uint8_t> from_text = ppm.input(text);
+    TEST_COMPARE_EQUAL(from_text.get_width(), size_t(2));
+    TEST_COMPARE_EQUAL(int(from_text(1, 0).g()), 251);
+
+    std::stringstream wide(std::string("P6 1 1 65535\n", 13) + std::string("\xff\xff\x80\x00\x00\x00", 6));
+    image<double> from_wide = ppm_io<double>().input(wide);
+    TEST_CLOSE(from_wide(0, 0).r(), 1.0);
+    TEST_CLOSE(from_wide(0, 0).g(), 0x8000 / 65535.0);
+
+    // Doubles read the same values as convert_color gives.
+    std::stringstream again;
+    ppm.output(again, img);
+    image<double> doubles = ppm_io<double>().input(again);
+    TEST_CLOSE(doubles(3, 2).r(), convert_color<double>(img(3, 2)).r());
+
+    std::stringstream truncated("P6 4 4 255\nabc");
+    TEST_EXCEPTION_THROW_SPECIFIC(ppm.input(truncated), std::runtime_error);
+    std::stringstream unknown("P7 4 4 255\n");
+    TEST_EXCEPTION_THROW_SPECIFIC(ppm.input(unknown), std::runtime_error);
+}
+
+AUTO_UNIT_TEST(tga_read_matches_written)
+{
+    const image<uint8_t> img = test_image();
+    tga_io<uint8_t> tga;
+
+    std::stringstream top_down;
+    tga.output(top_down, img);
+    TEST_BOOLEAN(same(tga.input(top_down), img));
+
+    // The same image stored bottom up.
+    std::string data = top_down.str();
+    std::string bottom_up = data.substr(0, 18);
+    bottom_up[17] = 0;
+    const size_t row_bytes = img.get_width() * 3;
+    for (size_t y = img.get_height(); y > 0; --y)
+    {
+        bottom_up += data.substr(18 + (y - 1) * row_bytes, row_bytes);
+    }
+    std::stringstream flipped(bottom_up);
+    TEST_BOOLEAN(same(tga.input(flipped), img));
+
+    std::stringstream truncated(data.substr(0, data.size() - 1));
+    TEST_BOOLEAN(tga.input(truncated).empty());
+}
@@ -0,0 +1,148 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "graphics/image_metrics.hpp"
+#include "general/random.hpp"
+#include <cmath>
+
+using namespace amethyst;
+
+namespace
+{
+    template <typename T>
+    void fill(image<T>& img, const rgbcolor<T>& c)
+    {
+        for (size_t y = 0; y < img.get_height(); ++y)
+        {
+            for (size_t x = 0; x < img.get_width(); ++x)
+            {
+                img(x, y) = c;
+            }
+        }
+    }
+
+    image<double> random_image(size_t width, size_t height, unsigned seed)
+    {
+        default_random<double> rnd(seed);
+        image<double> img(width, height);
+        for (size_t y = 0; y < height; ++y)
+        {
+            for (size_t x = 0; x < width; ++x)
+            {
+                img(x, y).set(rnd.next(), rnd.next(), rnd.next());
+            }
+        }
+        return img;
+    }
+
+    // The metric added up one channel at a time.
+    long double naive_difference(const image<double>& a, const image<double>& b, image_metric metric)
+    {
+        long double sum = 0;
+        for (size_t y = 0; y < a.get_height(); ++y)
+        {
+            for (size_t x = 0; x < a.get_width(); ++x)
+            {
+                for (unsigned c = 0; c < 3; ++c)
+                {
+                    long double d = (long double)a(x, y)[c] - (long double)b(x, y)[c];
+                    sum += (metric == image_metric::l1) ? std::fabs(d) : d * d;
+                }
+            }
+        }
+        return sum;
+    }
+}
+
+AUTO_UNIT_TEST(image_difference_known_values)
+{
+    image<double> a(5, 3);
+    image<double> b(5, 3);
+    fill(a, rgbcolor<double>(0.5, 0.5, 0.5));
+    fill(b, rgbcolor<double>(0.5, 0.5, 0.5));
+    b(2, 1) = rgbcolor<double>(0.75, 0.25, 1.0);
+
+    TEST_CLOSE(image_difference(a, b, image_metric::l1), 1.0);
+    TEST_CLOSE(image_difference(a, b, image_metric::l2), 0.375);
+    TEST_CLOSE(mean_image_difference(a, b, image_metric::l1), 1.0 / 45);
+    TEST_CLOSE(mean_image_difference(a, b, image_metric::l2), std::sqrt(0.375 / 45));
+}
+
+AUTO_UNIT_TEST(image_difference_matches_naive_sum)
+{
+    // Widths on either side of the block and lane sizes.
+    for (size_t width : { 1u, 7u, 255u, 300u, 513u })
+    {
+        image<double> a = random_image(width, 9, 1);
+        image<double> b = random_image(width, 9, 2);
+        for (image_metric metric : { image_metric::l1, image_metric::l2 })
+        {
+            double expected = double(naive_difference(a, b, metric));
+            TEST_BOOLEAN(std::fabs(image_difference(a, b, metric) - expected) <= 1e-12 * expected);
+        }
+    }
+}
+
+AUTO_UNIT_TEST(image_difference_of_views)
+{
+    image<double> a = random_image(40, 30, 3);
+    image<double> b = random_image(40, 30, 4);
+
+    // The difference of a view is the same as the difference of a copy of it.
+    image<double> a_part(11, 6);
+    image<double> b_part(11, 6);
+    for (size_t y = 0; y < 6; ++y)
+    {
+        for (size_t x = 0; x < 11; ++x)
+        {
+            a_part(x, y) = a(x + 5, y + 20);
+            b_part(x, y) = b(x + 5, y + 20);
+        }
+    }
+    for (image_metric metric : { image_metric::l1, image_metric::l2, image_metric::perceptual })
+    {
+        TEST_CLOSE(image_difference(a.view(5, 20, 15, 25), b.view(5, 20, 15, 25), metric),
+                   image_difference(a_part, b_part, metric));
+    }
+}
+
+AUTO_UNIT_TEST(image_difference_of_bytes)
+{
+    image<uint8_t> a(20, 2);
+    image<uint8_t> b(20, 2);
+    fill(a, rgbcolor<uint8_t>(10, 200, 0));
+    fill(b, rgbcolor<uint8_t>(250, 0, 0));
+    TEST_CLOSE(image_difference(a, b, image_metric::l1), 40.0 * 440);
+    TEST_CLOSE(image_difference(a, b, image_metric::l2), 40.0 * (240 * 240 + 200 * 200));
+
+    image<uint8_t> d = difference_image(a, b);
+    TEST_COMPARE_EQUAL(int(d(3, 1).r()), 240);
+    TEST_COMPARE_EQUAL(int(d(3, 1).g()), 200);
+    TEST_COMPARE_EQUAL(int(d(3, 1).b()), 0);
+}
+
+AUTO_UNIT_TEST(perceptual_difference_properties)
+{
+    image<double> a = random_image(33, 17, 5);
+    image<double> b = random_image(33, 17, 6);
+    TEST_CLOSE(image_difference(a, a, image_metric::perceptual), 0.0);
+    TEST_CLOSE(image_difference(a, b, image_metric::perceptual), image_difference(b, a, image_metric::perceptual));
+    TEST_BOOLEAN(image_difference(a, b, image_metric::perceptual) > 0);
+
+    // Green is weighted more than blue.
+    image<double> black(1, 1);
+    image<double> green(1, 1);
+    image<double> blue(1, 1);
+    fill(black, rgbcolor<double>(0, 0, 0));
+    fill(green, rgbcolor<double>(0, 0.5, 0));
+    fill(blue, rgbcolor<double>(0, 0, 0.5));
+    TEST_BOOLEAN(image_difference(black, green, image_metric::perceptual) >
+                 image_difference(black, blue, image_metric::perceptual));
+}
+
+AUTO_UNIT_TEST(image_difference_size_mismatch)
+{
+    image<double> a(4, 4);
+    image<double> b(4, 5);
+    TEST_EXCEPTION_THROW_SPECIFIC(image_difference(a, b, image_metric::l1), size_mismatch);
+    TEST_EXCEPTION_THROW_SPECIFIC(difference_image(a, b), size_mismatch);
+}
@@ -0,0 +1,65 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "graphics/image_scale.hpp"
+
+using namespace amethyst;
+
+namespace
+{
+    // Each pixel holds its own position.
+    image<double> position_image(size_t width, size_t height)
+    {
+        image<double> img(width, height);
+        img.fill([](size_t x, size_t y) { return rgbcolor<double>(double(x), double(y), 1); });
+        return img;
+    }
+}
+
+AUTO_UNIT_TEST(scale_image_same_size)
+{
+    const image<double> img = position_image(5, 3);
+    const image<double> copy = scale_image(img, 5, 3);
+    for (size_t y = 0; y < 3; ++y)
+    {
+        for (size_t x = 0; x < 5; ++x)
+        {
+            TEST_CLOSE(copy(x, y).r(), double(x));
+            TEST_CLOSE(copy(x, y).g(), double(y));
+        }
+    }
+}
+
+AUTO_UNIT_TEST(scale_image_averages_blocks)
+{
+    // With as many samples as the reduction, each pixel is the average of
+    // its own block of source pixels (and no others).
+    const image<double> img = position_image(12, 8);
+    const image<double> reduced = scale_image(img, 3, 2, 4);
+    for (size_t y = 0; y < 2; ++y)
+    {
+        for (size_t x = 0; x < 3; ++x)
+        {
+            TEST_CLOSE(reduced(x, y).r(), 4 * x + 1.5);
+            TEST_CLOSE(reduced(x, y).g(), 4 * y + 1.5);
+        }
+    }
+
+    // One sample takes the source pixel at the center of the block.
+    const image<double> nearest = scale_image(img, 3, 2);
+    TEST_CLOSE(nearest(0, 0).r(), 2.0);
+    TEST_CLOSE(nearest(0, 0).g(), 2.0);
+    TEST_CLOSE(nearest(2, 1).r(), 10.0);
+    TEST_CLOSE(nearest(2, 1).g(), 6.0);
+}
+
+AUTO_UNIT_TEST(scale_image_enlarges)
+{
+    const image<double> img = position_image(2, 2);
+    const image<double> larger = scale_image(img, 4, 4, 2);
+    TEST_CLOSE(larger(0, 0).r(), 0.0);
+    TEST_CLOSE(larger(0, 0).g(), 0.0);
+    TEST_CLOSE(larger(1, 2).r(), 0.0);
+    TEST_CLOSE(larger(1, 2).g(), 1.0);
+    TEST_CLOSE(larger(3, 3).r(), 1.0);
+    TEST_CLOSE(larger(3, 3).g(), 1.0);
+}
@@ -0,0 +1,120 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "graphics/mapped_raster.hpp"
+#include "graphics/ppm_io.hpp"
+#include "graphics/rgbcolor.hpp"
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace amethyst;
+
+AUTO_UNIT_TEST(raster_view_shares_pixels)
+{
+    raster<int> r(6, 4);
+    r.fill([](size_t x, size_t y) { return int(10 * y + x); });
+
+    raster_view<int> v = r.view(1, 1, 4, 2);
+    TEST_COMPARE_EQUAL(v.get_width(), size_t(4));
+    TEST_COMPARE_EQUAL(v.get_height(), size_t(2));
+    TEST_COMPARE_EQUAL(v.get_stride(), size_t(6));
+    TEST_BOOLEAN(!v.contiguous());
+    TEST_COMPARE_EQUAL(v(0, 0), 11);
+    TEST_COMPARE_EQUAL(v(3, 1), 24);
+
+    // Writes go to the raster, and views of views stay in it.
+    v(2, 1) = -1;
+    TEST_COMPARE_EQUAL(r(3, 2), -1);
+    raster_view<int> inner = v.sub_view(1, 0, 2, 1);
+    TEST_BOOLEAN(&inner(0, 0) == &r(2, 1));
+    inner.fill(7);
+    TEST_COMPARE_EQUAL(r(2, 2), 7);
+    TEST_COMPARE_EQUAL(r(4, 2), 24);
+
+    raster<int> copied = inner.copy();
+    TEST_COMPARE_EQUAL(copied.get_width(), size_t(2));
+    TEST_COMPARE_EQUAL(copied(1, 1), 7);
+
+    const raster<int>& const_r = r;
+    raster_view<const int> read_only = const_r.view();
+    raster_view<const int> converted = v;
+    TEST_COMPARE_EQUAL(read_only(5, 3), 35);
+    TEST_COMPARE_EQUAL(converted(0, 0), 11);
+
+    TEST_EXCEPTION_THROW_SPECIFIC(v(4, 0), out_of_range);
+    TEST_EXCEPTION_THROW_SPECIFIC(r.view(0, 0, 6, 1), out_of_range);
+    TEST_EXCEPTION_THROW_SPECIFIC(v.sub_view(2, 0, 1, 1), out_of_range);
+}
+
+AUTO_UNIT_TEST(mapped_raster_round_trip)
+{
+    const std::string filename = "test_mapped_raster.bin";
+    {
+        raster<rgbcolor<float>> r = create_mapped_raster<rgbcolor<float>>(filename, 5, 3);
+        r.fill([](size_t x, size_t y) { return rgbcolor<float>(float(x), float(y), 0.5f); });
+    }
+
+    {
+        // Changes to a read-only mapping stay private.
+        raster<rgbcolor<float>> r = open_mapped_raster<rgbcolor<float>>(filename);
+        TEST_COMPARE_EQUAL(r.get_width(), size_t(5));
+        TEST_COMPARE_EQUAL(r.get_height(), size_t(3));
+        TEST_CLOSE(r(4, 2).r(), 4.0f);
+        TEST_CLOSE(r(4, 2).g(), 2.0f);
+        r(4, 2) = rgbcolor<float>(9, 9, 9);
+
+        // Copies own their pixels.
+        raster<rgbcolor<float>> copy = r;
+        copy(0, 0) = rgbcolor<float>(-1, -1, -1);
+        TEST_CLOSE(r(0, 0).r(), 0.0f);
+    }
+    {
+        raster<rgbcolor<float>> r = open_mapped_raster<rgbcolor<float>>(filename, map_mode::read_write);
+        TEST_CLOSE(r(4, 2).r(), 4.0f);
+        r(1, 1) = rgbcolor<float>(3, 3, 3);
+
+        // Resizing leaves the file.
+        r.resize(2, 2);
+        r(1, 1) = rgbcolor<float>(8, 8, 8);
+    }
+    {
+        raster<rgbcolor<float>> r = open_mapped_raster<rgbcolor<float>>(filename);
+        TEST_CLOSE(r(1, 1).r(), 3.0f);
+    }
+
+    TEST_EXCEPTION_THROW_SPECIFIC(open_mapped_raster<rgbcolor<double>>(filename), std::runtime_error);
+    TEST_EXCEPTION_THROW_SPECIFIC(open_mapped_raster<float>("test_mapped_raster_missing.bin"), std::runtime_error);
+
+    // A size whose byte count wraps around to one that fits the file, and
+    // pixels starting past the end of the file.
+    create_mapped_raster<float>(filename, 4, 4);
+    {
+        std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+        const uint64_t huge_size[] = { uint64_t(1) << 32, uint64_t(1) << 32 };
+        file.seekp(offsetof(mapped_raster_header, width));
+        file.write(reinterpret_cast<const char*>(huge_size), sizeof(huge_size));
+    }
+    TEST_EXCEPTION_THROW_SPECIFIC(open_mapped_raster<float>(filename), std::runtime_error);
+    {
+        std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+        const uint64_t past_end[] = { 1, 1, sizeof(float), uint64_t(1) << 40 };
+        file.seekp(offsetof(mapped_raster_header, width));
+        file.write(reinterpret_cast<const char*>(past_end), sizeof(past_end));
+    }
+    TEST_EXCEPTION_THROW_SPECIFIC(open_mapped_raster<float>(filename), std::runtime_error);
+    std::remove(filename.c_str());
+}
+
+AUTO_UNIT_TEST(write_view_without_copy)
+{
+    raster<rgbcolor<double>> r(8, 8);
+    r.fill([](size_t x, size_t y) { return rgbcolor<double>(x / 8.0, y / 8.0, 0); });
+
+    std::stringbuf from_view;
+    std::stringbuf from_copy;
+    ppm_io<double> ppm;
+    TEST_BOOLEAN(ppm.output(from_view, r.view(2, 3, 5, 6)));
+    TEST_BOOLEAN(ppm.output(from_copy, r.sub_raster(2, 3, 5, 6)));
+    TEST_BOOLEAN(from_view.str() == from_copy.str());
+}
@@ -0,0 +1,123 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "graphics/mipmap.hpp"
+#include "graphics/image.hpp"
+#include "graphics/texture/image_texture.hpp"
+
+using namespace amethyst;
+
+namespace
+{
+    template <typename T>
+    bool same_color(const rgbcolor<T>& a, const rgbcolor<T>& b)
+    {
+        return (a.r() == b.r()) && (a.g() == b.g()) && (a.b() == b.b());
+    }
+
+    image<double> checkerboard(size_t width, size_t height)
+    {
+        image<double> img(width, height);
+        img.fill([](size_t x, size_t y) { return rgbcolor<double>(((x + y) % 2 == 0) ? 1 : 0); });
+        return img;
+    }
+}
+
+AUTO_UNIT_TEST(mipmap_levels)
+{
+    image<double> img(10, 6);
+    img.fill([](size_t x, size_t y) { return rgbcolor<double>(x, y, x * y); });
+    mipmap<rgbcolor<double>> pyramid(img);
+
+    // 10x6, 5x3, 3x2, 2x1, 1x1
+    TEST_COMPARE_EQUAL(pyramid.levels(), size_t(5));
+    TEST_COMPARE_EQUAL(pyramid.get_width(2), size_t(3));
+    TEST_COMPARE_EQUAL(pyramid.get_height(2), size_t(2));
+    TEST_COMPARE_EQUAL(pyramid.get_width(4), size_t(1));
+    TEST_COMPARE_EQUAL(pyramid.get_height(4), size_t(1));
+
+    // The tiled first level holds the image as it was.
+    bool same = true;
+    for (size_t y = 0; y < 6; ++y)
+    {
+        for (size_t x = 0; x < 10; ++x)
+        {
+            same = same && same_color(pyramid.texel(0, x, y), img(x, y));
+        }
+    }
+    TEST_BOOLEAN(same);
+    // 16x8 texels, in 4x4 tiles.
+    TEST_COMPARE_EQUAL(pyramid.memory_used() > 16 * 8 * sizeof(rgbcolor<double>), true);
+
+    // Box filtered.
+    TEST_CLOSE(pyramid.texel(1, 2, 1).r(), 4.5);
+    TEST_CLOSE(pyramid.texel(1, 2, 1).g(), 2.5);
+    TEST_CLOSE(pyramid.texel(1, 2, 1).b(), (4 * 2 + 5 * 2 + 4 * 3 + 5 * 3) / 4.0);
+}
+
+AUTO_UNIT_TEST(mipmap_filters)
+{
+    for (mipmap_filter filter : { mipmap_filter::box, mipmap_filter::kaiser })
+    {
+        // A checkerboard of single texels averages to grey in one step.
+        mipmap<rgbcolor<double>> pyramid(checkerboard(16, 16), mipmap_wrap::repeat, filter);
+        TEST_CLOSE(pyramid.texel(1, 3, 5).r(), 0.5);
+        TEST_CLOSE(pyramid.texel(4, 0, 0).g(), 0.5);
+
+        // Constant colors stay constant (the weights add to one), including
+        // in bytes.
+        image<uint8_t> grey(13, 7);
+        grey.fill(rgbcolor<uint8_t>(100, 150, 200));
+        mipmap<rgbcolor<uint8_t>> bytes(grey, mipmap_wrap::clamp, filter);
+        TEST_BOOLEAN(same_color(bytes.texel(2, 1, 1), rgbcolor<uint8_t>(100, 150, 200)));
+        TEST_BOOLEAN(same_color(bytes.trilinear(0.3, 0.6, 0.2), rgbcolor<uint8_t>(100, 150, 200)));
+    }
+}
+
+AUTO_UNIT_TEST(mipmap_lookups)
+{
+    image<double> img(4, 2);
+    img.fill([](size_t x, size_t y) { return rgbcolor<double>(x, y, 0); });
+    mipmap<rgbcolor<double>> clamped(img);
+    mipmap<rgbcolor<double>> repeated(img, mipmap_wrap::repeat);
+
+    // Texel centers give the texels, and between them is interpolated.
+    TEST_CLOSE(clamped.bilinear(0, 0.375, 0.25).r(), 1.0);
+    TEST_CLOSE(clamped.bilinear(0, 0.5, 0.5).r(), 1.5);
+    TEST_CLOSE(clamped.bilinear(0, 0.5, 0.5).g(), 0.5);
+    TEST_CLOSE(clamped.nearest(0.99, 0.99).r(), 3.0);
+
+    // At the edge, clamping repeats the last texel; repeating blends in the
+    // first.
+    TEST_CLOSE(clamped.bilinear(0, 1.0, 0.25).r(), 3.0);
+    TEST_CLOSE(repeated.bilinear(0, 1.0, 0.25).r(), 1.5);
+    TEST_CLOSE(repeated.bilinear(0, 2.0, 0.25).r(), 1.5);
+    TEST_CLOSE(repeated.nearest(-0.01, 0.25).r(), 3.0);
+
+    // No footprint is the first level, and a footprint as large as the image
+    // is the average of it.
+    TEST_CLOSE(clamped.trilinear(0.375, 0.25, 0.0).r(), 1.0);
+    TEST_CLOSE(clamped.trilinear(0.375, 0.25, 10.0).r(), 1.5);
+    TEST_CLOSE(clamped.trilinear(0.375, 0.25, 10.0).g(), 0.5);
+    // Half way (in log2) between the first two levels.
+    double between = clamped.trilinear(0.375, 0.25, std::sqrt(2.0) / 4).r();
+    TEST_CLOSE(between, (clamped.bilinear(0, 0.375, 0.25).r() + clamped.bilinear(1, 0.375, 0.25).r()) / 2);
+}
+
+AUTO_UNIT_TEST(image_texture_filtering)
+{
+    image_texture<double, rgbcolor<double>> tex(checkerboard(64, 64), image_mapping_type::repeated);
+    const vector3<double> normal(0, 0, 1);
+
+    // Sampled at a point, the checks are there; over a footprint of many
+    // texels they are averaged away.
+    const coord2<double> uv(0.5 / 64, 1 - 0.5 / 64);
+    TEST_CLOSE(tex.get_color_at_location(uv, normal).r(), 1.0);
+    TEST_CLOSE(tex.get_filtered_color_at_location(uv, normal, 0.25).r(), 0.5);
+
+    rgbcolor<double> color;
+    TEST_BOOLEAN(tex.get_filtered_color(point3<double>(), coord2<double>(3.2, -1.7), normal, 1.0, color));
+    TEST_CLOSE(color.r(), 0.5);
+
+    image_texture<double, rgbcolor<double>> once(checkerboard(64, 64), image_mapping_type::once);
+    TEST_CLOSE(once.get_filtered_color_at_location(coord2<double>(1.5, 0.5), normal, 0.25).r(), 0.0);
+}
@@ -0,0 +1,78 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "graphics/noise.hpp"
+#include <cmath>
+
+using namespace amethyst;
+
+namespace
+{
+    // The noise as a sum over the corners of the cell, as it is defined.
+    template <typename T>
+    T corner_sum(const noise<T>& n, const coord3<T>& point)
+    {
+        int floor_x = int(std::floor(point.x()));
+        int floor_y = int(std::floor(point.y()));
+        int floor_z = int(std::floor(point.z()));
+        T val = 0;
+        for (int i = floor_x; i <= floor_x + 1; ++i)
+        {
+            for (int j = floor_y; j <= floor_y + 1; ++j)
+            {
+                for (int k = floor_z; k <= floor_z + 1; ++k)
+                {
+                    val += n.omega_knot(i, j, k, point.x() - i, point.y() - j, point.z() - k);
+                }
+            }
+        }
+        return val;
+    }
+
+    template <typename T>
+    std::vector<coord3<T>> spread_points(size_t count)
+    {
+        default_random<T> rnd(7);
+        std::vector<coord3<T>> points(count);
+        for (auto& p : points)
+        {
+            p.set(40 * rnd.next() - 20, 40 * rnd.next() - 20, 40 * rnd.next() - 20);
+        }
+        return points;
+    }
+}
+
+AUTO_UNIT_TEST(noise_matches_corner_sum)
+{
+    // 256 uses the masked tables, 100 the modulo.
+    for (size_t size : { 256u, 100u })
+    {
+        noise<double> n(std::make_shared<default_random<double>>(3), size);
+        for (const coord3<double>& p : spread_points<double>(500))
+        {
+            TEST_CLOSE(n.value(p), corner_sum(n, p));
+        }
+    }
+}
+
+AUTO_UNIT_TEST(noise_is_zero_on_the_lattice)
+{
+    noise<double> n;
+    TEST_COMPARE_EQUAL(n.value(coord3<double>(0, 0, 0)), 0.0);
+    TEST_COMPARE_EQUAL(n.value(coord3<double>(-3, 5, 17)), 0.0);
+}
+
+AUTO_UNIT_TEST(batched_noise_matches_single_points)
+{
+    noise<float> n(std::make_shared<default_random<float>>(5));
+    // Not a multiple of the block size.
+    std::vector<coord3<float>> points = spread_points<float>(75);
+    std::vector<float> values(points.size());
+    std::vector<float> turbulences(points.size());
+    n.values(points.data(), values.data(), points.size());
+    n.turbulences(points.data(), turbulences.data(), points.size(), 5, 2);
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        TEST_CLOSE(values[i], n.value(points[i]));
+        TEST_CLOSE(turbulences[i], n.turbulence(points[i], 5, 2));
+    }
+}
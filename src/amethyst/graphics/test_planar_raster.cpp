@@ -0,0 +1,63 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "graphics/planar_raster.hpp"
+#include "graphics/image.hpp"
+#include <cstdint>
+
+using namespace amethyst;
+
+AUTO_UNIT_TEST(planar_rows_are_aligned_and_padded)
+{
+    planar_image<float> planes(21, 5);
+    TEST_COMPARE_EQUAL(planes.get_stride(), size_t(32));
+    for (size_t c = 0; c < 3; ++c)
+    {
+        for (size_t y = 0; y < planes.get_height(); ++y)
+        {
+            TEST_COMPARE_EQUAL(reinterpret_cast<uintptr_t>(planes.row(c, y)) % planes.alignment, uintptr_t(0));
+        }
+    }
+
+    planar_raster<uint8_t, 1> bytes(65, 2);
+    TEST_COMPARE_EQUAL(bytes.get_stride(), size_t(128));
+    TEST_COMPARE_EQUAL(bytes.row(0, 1)[127], 0);
+
+    planar_image<double> empty(0, 4);
+    TEST_BOOLEAN(empty.empty());
+}
+
+AUTO_UNIT_TEST(planar_round_trip)
+{
+    image<double> img(13, 7);
+    img.fill([](size_t x, size_t y) { return rgbcolor<double>(x, y, x * y + 0.5); });
+
+    planar_image<double> planes = to_planar(img);
+    TEST_CLOSE(planes(0, 12, 6), 12.0);
+    TEST_CLOSE(planes(1, 12, 6), 6.0);
+    TEST_CLOSE(planes(2, 12, 6), 72.5);
+    TEST_CLOSE(planes.row(2, 3)[4], 12.5);
+    // Padding is left alone.
+    TEST_CLOSE(planes.row(0, 2)[13], 0.0);
+
+    raster_view<double> green = planes.channel(1);
+    TEST_COMPARE_EQUAL(green.get_stride(), planes.get_stride());
+    green(3, 3) = -1;
+    TEST_CLOSE(planes(1, 3, 3), -1.0);
+
+    image<double> back = to_interleaved(planes);
+    TEST_CLOSE(back(3, 3).g(), -1.0);
+    TEST_CLOSE(back(5, 4).b(), img(5, 4).b());
+
+    // Copies own their planes.
+    planar_image<double> copy = planes;
+    copy(0, 0, 0) = 99;
+    TEST_CLOSE(planes(0, 0, 0), 0.0);
+
+    planar_image<double> cropped = to_planar(img.view(2, 1, 4, 3));
+    TEST_COMPARE_EQUAL(cropped.get_width(), size_t(3));
+    TEST_CLOSE(cropped(2, 2, 2), 12.5);
+
+    TEST_EXCEPTION_THROW_SPECIFIC(planes(3, 0, 0), out_of_range);
+    TEST_EXCEPTION_THROW_SPECIFIC(planes(0, 13, 0), out_of_range);
+    TEST_EXCEPTION_THROW_SPECIFIC(planes.channel(3), out_of_range);
+}
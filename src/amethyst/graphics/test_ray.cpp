@@ -2,6 +2,10 @@
 #include "test_framework/unit_test_auto.hpp"
 #include "graphics/ray_parameters.hpp"
 #include "graphics/iors.hpp"
+#include "graphics/pinhole_camera.hpp"
+#include "graphics/rgbcolor.hpp"
+#include "graphics/shapes/plane.hpp"
+#include "graphics/shapes/sphere.hpp"
 
 using namespace amethyst;
 
@@ -10,6 +14,39 @@ namespace
 	using point = point3<double>;
 	using vec = vector3<double>;
 	using info = intersection_info<double, vec>;
+	using info_type = intersection_info<double, rgbcolor<double>>;
+	using color = rgbcolor<double>;
+	using ray = ray_parameters<double, color>;
+
+	bool vectors_close(const vec& a, const vec& b, double tolerance)
+	{
+		return length(a - b) <= tolerance * std::max(1.0, length(b));
+	}
+
+	// A ray from origin along direction, with its direction changing by
+	// spread per pixel across, and nothing down.
+	ray make_spreading_ray(const point& origin, const vec& direction, double spread)
+	{
+		unit_line3<double> line(origin, direction);
+		ray r(line);
+		ray_differentials<double> d;
+		d.origin_dx = vec(0, 0, 0);
+		d.origin_dy = vec(0, 0, 0);
+		d.direction_dx = vec(spread, 0, 0);
+		d.direction_dy = vec(0, 0, 0);
+		r.set_differentials(d);
+		return r;
+	}
+
+	info_type hit(const shape<double, color>& s, const ray& r)
+	{
+		intersection_requirements requirements;
+		requirements.force_normal(true);
+		requirements.force_uv(true);
+		info_type result;
+		s.intersects_ray(r, result, requirements);
+		return result;
+	}
 }
 
 AUTO_UNIT_TEST(test_critical_angle)
@@ -81,3 +118,100 @@ AUTO_UNIT_TEST(test_refraction)
 
 	// FIXME!
 }
+
+AUTO_UNIT_TEST(test_camera_differentials)
+{
+	pinhole_camera<double, color> camera(point(1, 2, 10), vec(0.1, 0, -1), vec(0, 1, 0), 1.5, 1, 1, 150, 100);
+
+	// The differentials match the change to the next pixel (to first order).
+	ray r = camera.get_ray(40.0, 30.0);
+	TEST_BOOLEAN(r.have_differentials());
+	const ray_differentials<double>& d = r.get_differentials();
+	TEST_BOOLEAN(vectors_close(d.origin_dx, vec(0, 0, 0), 1e-12));
+	vec across = camera.get_ray(40.001, 30.0).get_line().direction() - r.get_line().direction();
+	vec down = camera.get_ray(40.0, 30.001).get_line().direction() - r.get_line().direction();
+	TEST_BOOLEAN(vectors_close(d.direction_dx * 0.001, across, 1e-4));
+	TEST_BOOLEAN(vectors_close(d.direction_dy * 0.001, down, 1e-4));
+	// A unit direction only changes across itself.
+	TEST_CLOSE(dotprod(d.direction_dx, r.get_line().direction()), 0.0);
+
+	ray s = camera.get_ray(coord2<double>(0.25, 0.5));
+	vec step = camera.get_ray(coord2<double>(0.25 + 0.001 / 150, 0.5)).get_line().direction() - s.get_line().direction();
+	TEST_BOOLEAN(vectors_close(s.get_differentials().direction_dx * 0.001, step, 1e-4));
+}
+
+AUTO_UNIT_TEST(test_differentials_at_surfaces)
+{
+	// Straight down from a height of 2, the footprint is 2 * spread across; at
+	// 60 degrees from the normal, it is stretched by 1 / cos = 2 along the
+	// plane.
+	plane<double, color> floor(point(0, 0, 0), vec(0, 0, 1), vec(1, 0, 0), vec(0, 1, 0));
+	ray down = make_spreading_ray(point(0, 0, 2), vec(0, 0, -1), 0.01);
+	info_type straight = hit(floor, down);
+	ray_differentials<double> at_floor = transfer_differentials(down.get_differentials(), vec(0, 0, -1), straight.get_first_distance(), straight.get_normal());
+	TEST_BOOLEAN(vectors_close(at_floor.origin_dx, vec(0.02, 0, 0), 1e-9));
+
+	vec slanted(std::sin(M_PI / 3), 0, -std::cos(M_PI / 3));
+	ray oblique(make_spreading_ray(point(0, 0, 1), slanted, 0));
+	ray_differentials<double> spread;
+	spread.origin_dx = vec(0, 0, 0);
+	spread.origin_dy = vec(0, 0, 0);
+	spread.direction_dx = 0.01 * vec(std::cos(M_PI / 3), 0, std::sin(M_PI / 3));
+	spread.direction_dy = vec(0, 0, 0);
+	oblique.set_differentials(spread);
+	info_type angled = hit(floor, oblique);
+	at_floor = transfer_differentials(spread, slanted, angled.get_first_distance(), angled.get_normal());
+	TEST_CLOSE(at_floor.origin_dx.z(), 0.0);
+	TEST_CLOSE(length(at_floor.origin_dx), 2 * 0.01 * angled.get_first_distance());
+
+	// A flat mirror: the reflection spreads as if it had carried on through
+	// the mirror.
+	ray reflected;
+	TEST_BOOLEAN(down.perfect_reflection(straight, reflected));
+	TEST_BOOLEAN(reflected.have_differentials());
+	TEST_BOOLEAN(vectors_close(reflected.get_differentials().origin_dx, vec(0.02, 0, 0), 1e-9));
+	TEST_BOOLEAN(vectors_close(reflected.get_differentials().direction_dx, vec(0.01, 0, 0), 1e-9));
+
+	// Into glass straight on, the spread is divided by the IOR.
+	ray refracted;
+	TEST_BOOLEAN(down.perfect_refraction(straight, 1.5, refracted));
+	TEST_BOOLEAN(vectors_close(refracted.get_differentials().direction_dx, vec(0.01 / 1.5, 0, 0), 1e-9));
+	TEST_BOOLEAN(vectors_close(refracted.get_differentials().origin_dx, vec(0.02, 0, 0), 1e-9));
+
+	// Rays without differentials make none.
+	unit_line3<double> line(point(0, 0, 2), vec(0, 0, -1));
+	ray plain(line);
+	TEST_BOOLEAN(plain.perfect_reflection(straight, reflected));
+	TEST_BOOLEAN(!reflected.have_differentials());
+}
+
+AUTO_UNIT_TEST(test_uv_footprint)
+{
+	// u is 2 units long on the plane, v is 4.
+	plane<double, color> floor(point(0, 0, 0), vec(0, 0, 1), vec(2, 0, 0), vec(0, 4, 0));
+	ray down = make_spreading_ray(point(1, 1, 2), vec(0, 0, -1), 0.01);
+	double width = 0;
+	TEST_BOOLEAN(down.get_uv_footprint(hit(floor, down), width));
+	TEST_CLOSE(width, 0.02 / 2);
+
+	// On a sphere's equator, u goes around 2 pi r.
+	sphere<double, color> ball(point(0, 0, 0), 3);
+	ray toward = make_spreading_ray(point(0, 0, 10), vec(0, 0, -1), 0.01);
+	toward.set_differentials([]()
+		{
+			ray_differentials<double> d;
+			d.origin_dx = vec(0, 0, 0);
+			d.origin_dy = vec(0, 0.05, 0);
+			d.direction_dx = vec(0.01, 0, 0);
+			d.direction_dy = vec(0, 0, 0);
+			return d;
+		}());
+	TEST_BOOLEAN(toward.get_uv_footprint(hit(ball, toward), width));
+	// Across: 0.07 around the equator.  Down: 0.05 of the pi r from pole to
+	// pole, which is larger.
+	TEST_CLOSE(width, std::max(0.07 / (2 * M_PI * 3), 0.05 / (M_PI * 3)));
+
+	ray plain = toward;
+	plain.clear_differentials();
+	TEST_BOOLEAN(!plain.get_uv_footprint(hit(ball, toward), width));
+}
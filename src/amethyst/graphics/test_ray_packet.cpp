@@ -0,0 +1,203 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "graphics/ray_packet.hpp"
+#include "graphics/shapes/bvh.hpp"
+#include "graphics/shapes/sphere.hpp"
+#include "graphics/shapes/triangle.hpp"
+#include "graphics/shapes/rectangle.hpp"
+#include "graphics/shapes/plane.hpp"
+#include "graphics/shapes/disc.hpp"
+#include "general/random.hpp"
+
+using namespace amethyst;
+
+namespace
+{
+    using point = point3<double>;
+    using vec = vector3<double>;
+    using info = intersection_info<double, vec>;
+    using packet_type = ray_packet<double, vec>;
+
+    aggregate<double, vec> make_scene(size_t count)
+    {
+        default_random<double> rnd(42);
+        auto coord = [&](double range) { return (rnd.next() * 2 - 1) * range; };
+
+        aggregate<double, vec> scene;
+        for (size_t i = 0; i < count; ++i)
+        {
+            point p(coord(10), coord(10), coord(10));
+            switch (i % 4)
+            {
+            case 0:
+                scene.add(std::make_shared<sphere<double, vec>>(p, 0.1 + rnd.next()));
+                break;
+            case 1:
+                scene.add(std::make_shared<triangle<double, vec>>(p, p + vec(coord(1), coord(1), coord(1)), p + vec(coord(1), coord(1), coord(1))));
+                break;
+            case 2:
+                scene.add(std::make_shared<rectangle<double, vec>>(p, vec(coord(1), coord(1), coord(1)), vec(coord(1), coord(1), coord(1))));
+                break;
+            default:
+                scene.add(std::make_shared<disc<double, vec>>(p, 0.5, unit(vec(coord(1), coord(1), 1))));
+                break;
+            }
+        }
+        scene.add(std::make_shared<plane<double, vec>>(point(0, -9, 0), vec(0, 1, 0)));
+        return scene;
+    }
+
+    // Lines from a few origins (like a camera), spread over the scene.
+    std::vector<unit_line3<double>> make_lines(size_t count)
+    {
+        default_random<double> rnd(7);
+        auto coord = [&](double range) { return (rnd.next() * 2 - 1) * range; };
+
+        std::vector<unit_line3<double>> lines;
+        for (size_t i = 0; i < count; ++i)
+        {
+            point origin((i / 64) % 2 ? 15 : -15, 1, 2);
+            point target(coord(8), coord(8), coord(8));
+            lines.emplace_back(origin, target - origin, interval<double>(AMETHYST_EPSILON, std::numeric_limits<double>::max()));
+        }
+        return lines;
+    }
+
+    // Compare every lane of the packets against tracing the lines one at a time.
+    size_t count_mismatches(const shape<double, vec>& scene, const std::vector<unit_line3<double>>& lines, size_t& hits)
+    {
+        size_t mismatches = 0;
+        packet_type packet;
+        for (size_t first = 0; first < lines.size(); first += packet_type::width)
+        {
+            packet.clear();
+            for (size_t i = first; i < std::min(first + packet_type::width, lines.size()); ++i)
+            {
+                packet.add(lines[i]);
+            }
+            scene.intersect_packet(packet);
+
+            for (size_t lane = 0; lane < packet.size(); ++lane)
+            {
+                info scalar;
+                intersection_requirements requirements;
+                bool scalar_hit = scene.intersects_line(lines[first + lane], scalar, requirements);
+                if (scalar_hit != (packet.hit[lane] != nullptr))
+                {
+                    ++mismatches;
+                }
+                else if (scalar_hit)
+                {
+                    ++hits;
+                    if ((scalar.get_shape() != packet.hit[lane]) ||
+                        (scalar.get_first_distance() != packet.limit[lane]))
+                    {
+                        ++mismatches;
+                    }
+                }
+            }
+        }
+        return mismatches;
+    }
+}
+
+AUTO_UNIT_TEST(packet_filling)
+{
+    packet_type packet;
+    TEST_BOOLEAN(packet.empty());
+
+    unit_line3<double> line(point(0, 0, 0), vec(1, 0, 0), interval<double>(1, 5));
+    TEST_COMPARE_EQUAL(packet.add(line, 0.5), size_t(0));
+    TEST_COMPARE_EQUAL(packet.size(), size_t(1));
+    TEST_CLOSE(packet.direction_x[0], 1);
+    TEST_CLOSE(packet.begin[0], 1);
+    TEST_CLOSE(packet.limit[0], 5);
+    TEST_CLOSE(packet.time[0], 0.5);
+
+    // Hits outside the range, or further than the closest, are ignored.
+    sphere<double, vec> s(point(0, 0, 0), 1);
+    packet.record_hit(0, 0.5, &s);
+    TEST_BOOLEAN(packet.hit[0] == nullptr);
+    packet.record_hit(0, 3, &s);
+    TEST_BOOLEAN(packet.hit[0] == &s);
+    packet.record_hit(0, 4, nullptr);
+    TEST_BOOLEAN(packet.hit[0] == &s);
+    TEST_CLOSE(packet.limit[0], 3);
+
+    // Unused lanes never hit anything.
+    packet.record_hit(1, 1, &s);
+    TEST_BOOLEAN(packet.hit[1] == nullptr);
+}
+
+AUTO_UNIT_TEST(packet_box)
+{
+    packet_type packet;
+    const interval<double> forward(0, std::numeric_limits<double>::max());
+    unit_line3<double> toward(point(-5, 0, 0), vec(1, 0, 0), forward);
+    unit_line3<double> away(point(-5, 0, 0), vec(-1, 0, 0), forward);
+    packet.add(toward);
+    packet.add(away);
+
+    bool enters[packet_type::width];
+    TEST_BOOLEAN(packet.intersects(bounding_box<double>(point(-1, -1, -1), point(1, 1, 1)), enters));
+    TEST_BOOLEAN(enters[0]);
+    TEST_BOOLEAN(!enters[1]);
+    for (size_t lane = 2; lane < packet_type::width; ++lane)
+    {
+        TEST_BOOLEAN(!enters[lane]);
+    }
+    TEST_BOOLEAN(!packet.intersects(bounding_box<double>(point(-1, 2, -1), point(1, 3, 1)), enters));
+}
+
+AUTO_UNIT_TEST(packet_box_on_slab_plane)
+{
+    // Axis aligned lines starting on the planes of the box, where the slab
+    // distances for the other axes are 0 * infinity.
+    const bounding_box<double> box(point(-1, -1, -1), point(1, 1, 1));
+    const interval<double> forward(0, std::numeric_limits<double>::max());
+    const unit_line3<double> lines[] = {
+        unit_line3<double>(point(-1, 0, -5), vec(0, 0, 1), forward),
+        unit_line3<double>(point(1, 0, -5), vec(0, 0, 1), forward),
+        unit_line3<double>(point(0, -1, 5), vec(0, 0, -1), forward),
+        unit_line3<double>(point(-1, 1, -5), vec(0, 0, 1), forward),
+        unit_line3<double>(point(-5, 1, 0), vec(1, 0, 0), forward),
+        unit_line3<double>(point(0, 5, 1), vec(0, -1, 0), forward),
+        unit_line3<double>(point(2, 0, -5), vec(0, 0, 1), forward),
+    };
+
+    packet_type packet;
+    for (const auto& line : lines)
+    {
+        packet.add(line);
+    }
+    bool enters[packet_type::width];
+    packet.intersects(box, enters);
+    for (size_t lane = 0; lane < packet.size(); ++lane)
+    {
+        double t_near;
+        double t_far;
+        const bool single = box_line_tester<double>(lines[lane]).intersects(box, forward.begin(), forward.end(), t_near, t_far);
+        TEST_COMPARE_EQUAL(enters[lane], single);
+    }
+    // The lines on the planes graze the box; the last misses it.
+    TEST_BOOLEAN(enters[0]);
+    TEST_BOOLEAN(enters[1]);
+    TEST_BOOLEAN(enters[2]);
+    TEST_BOOLEAN(!enters[6]);
+}
+
+AUTO_UNIT_TEST(packet_matches_single_lines)
+{
+    aggregate<double, vec> scene = make_scene(200);
+    std::vector<unit_line3<double>> lines = make_lines(1000);
+
+    size_t hits = 0;
+    TEST_COMPARE_EQUAL(count_mismatches(scene, lines, hits), size_t(0));
+    // Make sure the test is meaningful.
+    TEST_BOOLEAN(hits > 100);
+
+    bvh<double, vec> tree(scene);
+    size_t tree_hits = 0;
+    TEST_COMPARE_EQUAL(count_mismatches(tree, lines, tree_hits), size_t(0));
+    TEST_COMPARE_EQUAL(tree_hits, hits);
+}
@@ -0,0 +1,418 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "graphics/renderer.hpp"
+#include "graphics/progressive_renderer.hpp"
+#include "graphics/pinhole_camera.hpp"
+#include "graphics/shapes/aggregate.hpp"
+#include "graphics/shapes/plane.hpp"
+#include "graphics/shapes/sphere.hpp"
+#include "graphics/shapes/triangle.hpp"
+#include "graphics/texture/lambertian.hpp"
+#include "graphics/texture/metal.hpp"
+#include "graphics/texture/dielectric.hpp"
+#include "graphics/texture/image_texture.hpp"
+#include <cmath>
+#include <fstream>
+#include <mutex>
+
+using namespace amethyst;
+
+namespace
+{
+    using point = point3<double>;
+    using vec = vector3<double>;
+    using color = rgbcolor<double>;
+    using image_type = raster<color>;
+
+    const size_t width = 37;
+    const size_t height = 23;
+
+    shape_ptr<double, color> make_scene()
+    {
+        auto scene = std::make_shared<aggregate<double, color>>();
+        scene->add(std::make_shared<sphere<double, color>>(point(0, 0, -1), 0.5, std::make_shared<lambertian<double, color>>(color{ 0.1, 0.2, 0.5 })));
+        scene->add(std::make_shared<sphere<double, color>>(point(0, -100.5, -1), 100, std::make_shared<lambertian<double, color>>(color{ 0.8, 0.8, 0.0 })));
+        scene->add(std::make_shared<sphere<double, color>>(point(1, 0, -1), 0.5, std::make_shared<metal<double, color>>(color{ 0.8, 0.6, 0.2 }, 0.3)));
+        scene->add(std::make_shared<sphere<double, color>>(point(-1, 0, -1), 0.5, std::make_shared<dielectric<double, color>>(1.5)));
+        scene->add(std::make_shared<triangle<double, color>>(point(-2, -0.5, -2), point(2, -0.5, -2), point(0, 1.5, -2.5)));
+        return scene;
+    }
+
+    camera_ptr<double, color> make_camera()
+    {
+        return std::make_shared<pinhole_camera<double, color>>(
+            point(0, 0, 1), vec(0, 0, -1), vec(0, 1, 0), 3.2, 2.0, 1.0, width, height);
+    }
+
+    intersection_requirements make_requirements()
+    {
+        intersection_requirements requirements;
+        requirements.force_first_only(true);
+        requirements.force_normal(true);
+        requirements.force_uv(true);
+        return requirements;
+    }
+
+    image_type render_scene(const render_options& options, size_t samples_per_pixel = 4)
+    {
+        auto camera = make_camera();
+        intersection_requirements requirements = make_requirements();
+
+        return render<double, color>(
+            camera, make_scene(), std::make_shared<lambertian<double, color>>(color{ 0.5, 0.5, 0.5 }),
+            width, height, requirements,
+            [](const point&, const vec&) { return color{ 0, 0, 0 }; },
+            nullptr, samples_per_pixel, std::make_shared<jitter_sample_2d<double>>(), nullptr, options);
+    }
+
+    double average(const image_type& image)
+    {
+        double total = 0;
+        for (size_t y = 0; y < image.get_height(); ++y)
+        {
+            for (size_t x = 0; x < image.get_width(); ++x)
+            {
+                total += image(x, y).r() + image(x, y).g() + image(x, y).b();
+            }
+        }
+        return total / (3 * image.get_width() * image.get_height());
+    }
+
+    template <typename U>
+    std::vector<U> values(const raster<U>& r)
+    {
+        std::vector<U> result;
+        for (size_t y = 0; y < r.get_height(); ++y)
+        {
+            for (size_t x = 0; x < r.get_width(); ++x)
+            {
+                result.push_back(r(x, y));
+            }
+        }
+        return result;
+    }
+
+    bool identical(const image_type& a, const image_type& b)
+    {
+        for (size_t y = 0; y < a.get_height(); ++y)
+        {
+            for (size_t x = 0; x < a.get_width(); ++x)
+            {
+                const color& ca = a(x, y);
+                const color& cb = b(x, y);
+                if (ca.r() != cb.r() || ca.g() != cb.g() || ca.b() != cb.b())
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+AUTO_UNIT_TEST(render_threads_match_serial)
+{
+    render_options serial;
+    serial.seed = 1234;
+    image_type reference = render_scene(serial);
+
+    render_options threaded = serial;
+    threaded.threads = 4;
+    threaded.tile_size = 5;
+    TEST_BOOLEAN(identical(reference, render_scene(threaded)));
+
+    threaded.threads = 3;
+    threaded.tile_size = 64;
+    TEST_BOOLEAN(identical(reference, render_scene(threaded)));
+}
+
+AUTO_UNIT_TEST(render_packets_match_single_rays)
+{
+    render_options single;
+    single.seed = 99;
+    single.ray_packets = false;
+
+    render_options packets = single;
+    packets.ray_packets = true;
+    TEST_BOOLEAN(identical(render_scene(single), render_scene(packets)));
+
+    packets.threads = 3;
+    packets.tile_size = 7;
+    TEST_BOOLEAN(identical(render_scene(single), render_scene(packets)));
+}
+
+AUTO_UNIT_TEST(render_iterative_integrator)
+{
+    render_options recursive;
+    recursive.seed = 5;
+    render_options iterative = recursive;
+    iterative.integrator = integrator_type::iterative;
+
+    image_type reference = render_scene(recursive);
+    image_type image = render_scene(iterative);
+
+    // Repeatable, and independent of threads and packets.
+    TEST_BOOLEAN(identical(image, render_scene(iterative)));
+    render_options threaded = iterative;
+    threaded.threads = 3;
+    threaded.tile_size = 6;
+    threaded.ray_packets = false;
+    TEST_BOOLEAN(identical(image, render_scene(threaded)));
+
+    // The same scene, so the same overall brightness (the paths are random,
+    // so the pixels themselves differ).
+    TEST_BOOLEAN(std::abs(average(image) - average(reference)) < 0.02);
+
+    // With only one surface allowed, nothing is scattered, and the scene
+    // has no light of its own, so every hit is black and only the sky (seen
+    // directly) has any color.
+    iterative.max_depth = 1;
+    image_type direct = render_scene(iterative);
+    size_t black = 0;
+    for (size_t y = 0; y < height; ++y)
+    {
+        for (size_t x = 0; x < width; ++x)
+        {
+            const color& c = direct(x, y);
+            black += (c.r() + c.g() + c.b() == 0) ? 1 : 0;
+        }
+    }
+    TEST_BOOLEAN(black > width * height / 4);
+    TEST_BOOLEAN(black < width * height);
+    TEST_BOOLEAN(average(direct) < average(image));
+}
+
+AUTO_UNIT_TEST(render_adaptive_sampling)
+{
+    raster<double> variance;
+    raster<size_t> counts;
+
+    // Without adaptive sampling, every pixel gets the same count.
+    render_options fixed;
+    fixed.seed = 3;
+    fixed.samples_output = &counts;
+    render_scene(fixed, 9);
+    TEST_COMPARE_EQUAL(counts.get_width(), width);
+    std::vector<size_t> fixed_counts = values(counts);
+    TEST_COMPARE_EQUAL(*std::min_element(fixed_counts.begin(), fixed_counts.end()), size_t(9));
+    TEST_COMPARE_EQUAL(*std::max_element(fixed_counts.begin(), fixed_counts.end()), size_t(9));
+
+    render_options adaptive = fixed;
+    adaptive.tile_size = 8;
+    adaptive.adaptive_threshold = 0.02;
+    adaptive.adaptive_min_samples = 4;
+    adaptive.variance_output = &variance;
+    image_type image = render_scene(adaptive, 16);
+
+    // The flat pixels stop early, and the budget goes to the noisy ones.
+    std::vector<size_t> adaptive_counts = values(counts);
+    size_t total = 0;
+    for (size_t c : adaptive_counts)
+    {
+        total += c;
+    }
+    const size_t tiles = ((width + 7) / 8) * ((height + 7) / 8);
+    TEST_COMPARE_EQUAL(*std::min_element(adaptive_counts.begin(), adaptive_counts.end()), size_t(4));
+    TEST_BOOLEAN(*std::max_element(adaptive_counts.begin(), adaptive_counts.end()) > 16);
+    TEST_BOOLEAN(*std::max_element(adaptive_counts.begin(), adaptive_counts.end()) <= 128);
+    TEST_BOOLEAN(total <= 16 * width * height + 4 * tiles);
+    TEST_COMPARE_EQUAL(variance.get_height(), height);
+    std::vector<double> variances = values(variance);
+    TEST_BOOLEAN(*std::min_element(variances.begin(), variances.end()) >= 0);
+
+    // Still the same for any number of threads.
+    raster<size_t> threaded_counts;
+    render_options threaded = adaptive;
+    threaded.threads = 3;
+    threaded.variance_output = nullptr;
+    threaded.samples_output = &threaded_counts;
+    TEST_BOOLEAN(identical(image, render_scene(threaded, 16)));
+    TEST_BOOLEAN(values(threaded_counts) == adaptive_counts);
+
+    // And it converges to the same image.
+    fixed.samples_output = nullptr;
+    TEST_BOOLEAN(std::abs(average(image) - average(render_scene(fixed, 16))) < 0.02);
+}
+
+AUTO_UNIT_TEST(render_adaptive_regular_sampler)
+{
+    // Nothing to hit, and a background that is white over the left 40% of
+    // every pixel.  The regular 2x2 samples all land at 1/3 and 2/3 of the
+    // way across, which gives half coverage however often they are taken.
+    // The later rounds have to move them to find the real coverage.
+    auto background = [](double a, double, const unit_line3<double>&)
+    {
+        return (a - std::floor(a) < 0.4) ? color{ 1, 1, 1 } : color{ 0, 0, 0 };
+    };
+    render_options options;
+    options.seed = 11;
+    options.adaptive_threshold = 0.01;
+    options.adaptive_min_samples = 4;
+    image_type image = render<double, color>(
+        make_camera(), std::make_shared<aggregate<double, color>>(), std::make_shared<lambertian<double, color>>(color{ 0.5, 0.5, 0.5 }),
+        4, 2, make_requirements(), [](const point&, const vec&) { return color{ 0, 0, 0 }; },
+        background, 256, std::make_shared<regular_sample_2d<double>>(), nullptr, options);
+
+    // Each pixel is still noisy, but not all of them together.
+    TEST_BOOLEAN(std::abs(average(image) - 0.4) < 0.03);
+}
+
+AUTO_UNIT_TEST(render_progressive_resumes)
+{
+    const std::string checkpoint = "test_renderer_checkpoint.bin";
+    std::remove(checkpoint.c_str());
+
+    auto scene = make_scene();
+    auto scene_texture = std::make_shared<lambertian<double, color>>(color{ 0.5, 0.5, 0.5 });
+    auto sampler = std::make_shared<jitter_sample_2d<double>>();
+    lighting_function<double, color> light = [](const point&, const vec&) { return color{ 0, 0, 0 }; };
+    render_options options;
+    options.seed = 21;
+
+    // The first pass is the same as a plain render.
+    std::vector<size_t> frames;
+    image_type first_frame;
+    image_type straight = render_progressive<double, color>(
+        make_camera(), scene, scene_texture, width, height, make_requirements(), light, nullptr,
+        4, 3, sampler,
+        [&](const image_type& frame, size_t passes)
+        {
+            frames.push_back(passes);
+            if (passes == 1)
+            {
+                first_frame = frame;
+            }
+        },
+        std::string(), options);
+    TEST_COMPARE_EQUAL(frames.size(), size_t(3));
+    TEST_COMPARE_EQUAL(frames.back(), size_t(3));
+    TEST_BOOLEAN(identical(first_frame, render_scene(options)));
+
+    // Stop after one pass (as if killed), then resume to three.
+    render_progressive<double, color>(
+        make_camera(), scene, scene_texture, width, height, make_requirements(), light, nullptr,
+        4, 1, sampler, nullptr, checkpoint, options);
+    accumulation_buffer<color> saved;
+    TEST_BOOLEAN(saved.load(checkpoint));
+    TEST_COMPARE_EQUAL(saved.passes(), size_t(1));
+    TEST_COMPARE_EQUAL(saved.samples(), uint64_t(4));
+    TEST_COMPARE_EQUAL(saved.get_seed(), uint32_t(21));
+
+    frames.clear();
+    image_type resumed = render_progressive<double, color>(
+        make_camera(), scene, scene_texture, width, height, make_requirements(), light, nullptr,
+        4, 3, sampler, [&](const image_type&, size_t passes) { frames.push_back(passes); }, checkpoint, options);
+    TEST_COMPARE_EQUAL(frames.size(), size_t(2));
+    TEST_BOOLEAN(identical(straight, resumed));
+
+    // A checkpoint for a different image is refused.
+    TEST_EXCEPTION_THROW_SPECIFIC(
+        (render_progressive<double, color>(
+            make_camera(), scene, scene_texture, width + 1, height, make_requirements(), light, nullptr,
+            4, 3, sampler, nullptr, checkpoint, options)),
+        std::runtime_error);
+
+    // A header whose size does not match the pixels in the file is refused
+    // (before the buffer is allocated).
+    {
+        std::fstream file(checkpoint, std::ios::binary | std::ios::in | std::ios::out);
+        const uint64_t huge_size[] = { uint64_t(1) << 40, uint64_t(1) << 40 };
+        file.seekp(8);
+        file.write(reinterpret_cast<const char*>(huge_size), sizeof(huge_size));
+    }
+    TEST_EXCEPTION_THROW_SPECIFIC(saved.load(checkpoint), std::runtime_error);
+    {
+        std::fstream file(checkpoint, std::ios::binary | std::ios::in | std::ios::out);
+        const uint64_t wrong_size[] = { width, height + 1 };
+        file.seekp(8);
+        file.write(reinterpret_cast<const char*>(wrong_size), sizeof(wrong_size));
+    }
+    TEST_EXCEPTION_THROW_SPECIFIC(saved.load(checkpoint), std::runtime_error);
+
+    std::remove(checkpoint.c_str());
+    TEST_BOOLEAN(!saved.load(checkpoint));
+}
+
+AUTO_UNIT_TEST(render_seed_changes_output)
+{
+    render_options first;
+    first.seed = 1;
+    render_options second;
+    second.seed = 2;
+    TEST_BOOLEAN(identical(render_scene(first), render_scene(first)));
+    TEST_BOOLEAN(!identical(render_scene(first), render_scene(second)));
+}
+
+AUTO_UNIT_TEST(render_tiles_without_keeping_image)
+{
+    render_options options;
+    options.threads = 2;
+    options.tile_size = 8;
+    const image_type expected = render_scene(options);
+
+    std::mutex mutex;
+    image_type assembled(width, height);
+    size_t pixels = 0;
+    options.keep_image = false;
+    options.tile_finished = [&](size_t x, size_t y, const raster_view<const color>& tile)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t ty = 0; ty < tile.get_height(); ++ty)
+        {
+            std::copy_n(tile.row(ty), tile.get_width(), &assembled(x, y + ty));
+        }
+        pixels += tile.get_numpixels();
+    };
+    image_type result = render_scene(options);
+    TEST_BOOLEAN(result.empty());
+    TEST_COMPARE_EQUAL(pixels, width * height);
+    TEST_BOOLEAN(identical(assembled, expected));
+}
+
+AUTO_UNIT_TEST(render_filters_distant_textures)
+{
+    // A wall of single texel checks, repeated so often that each pixel
+    // covers dozens of them.  Point sampled, every pixel would be black or
+    // white; filtered over the camera rays' footprints, they are all grey.
+    image_type checks(8, 8);
+    checks.fill([](size_t x, size_t y) { return color(((x + y) % 2 == 0) ? 1 : 0); });
+    auto texture = std::make_shared<image_texture<double, color>>(checks, image_mapping_type::repeated);
+    auto wall = std::make_shared<plane<double, color>>(point(0, 0, -10), vec(0, 0, 1), vec(0.0213, 0, 0), vec(0, 0.0197, 0));
+
+    render_options options;
+    image_type image = render<double, color>(
+        make_camera(), wall, texture, width, height, make_requirements(),
+        [](const point&, const vec&) { return color{ 1, 1, 1 }; },
+        nullptr, 1, std::make_shared<regular_sample_2d<double>>(), nullptr, options);
+
+    double worst = 0;
+    for (color c : values(image))
+    {
+        worst = std::max(worst, std::abs(c.r() - 0.5));
+    }
+    TEST_BOOLEAN(worst < 0.01);
+}
+
+AUTO_UNIT_TEST(render_progress_reaches_completion)
+{
+    auto camera = std::make_shared<pinhole_camera<double, color>>(
+        point(0, 0, 1), vec(0, 0, -1), vec(0, 1, 0), 3.2, 2.0, 1.0, width, height);
+    intersection_requirements requirements;
+    requirements.force_normal(true);
+
+    render_options options;
+    options.threads = 2;
+    options.tile_size = 4;
+
+    double last = -1;
+    bool increasing = true;
+    render<double, color>(
+        camera, make_scene(), std::make_shared<lambertian<double, color>>(color{ 0.5, 0.5, 0.5 }),
+        width, height, requirements,
+        [](const point&, const vec&) { return color{ 1, 1, 1 }; },
+        nullptr, 1, std::make_shared<regular_sample_2d<double>>(),
+        [&](double percentage) { increasing = increasing && percentage > last; last = percentage; },
+        options);
+    TEST_BOOLEAN(increasing);
+    TEST_CLOSE(last, 100.0);
+}
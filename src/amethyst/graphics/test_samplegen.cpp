@@ -0,0 +1,227 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "graphics/samplegen1d.hpp"
+#include "graphics/samplegen2d.hpp"
+#include "graphics/samplegen3d.hpp"
+#include <cmath>
+#include <cstring>
+
+using namespace amethyst;
+
+namespace
+{
+    // The buffer form of get_samples gives the same samples as the returning
+    // form, and reuses the buffer's storage.
+    template <typename generator_type>
+    size_t check_buffer_samples(generator_type& generator, size_t count)
+    {
+        size_t failures = 0;
+
+        generator.set_seed(11);
+        auto expected = generator.get_samples(count);
+
+        using sample_type = typename generator_type::sample_type;
+        std::vector<sample_type> samples;
+        generator.set_seed(11);
+        generator.get_samples(count, samples);
+        if (samples.size() != expected.size() || samples.size() < count)
+        {
+            ++failures;
+        }
+        for (size_t i = 0; i < std::min(samples.size(), expected.size()); ++i)
+        {
+            if (std::memcmp(&samples[i], &expected[i], sizeof(sample_type)) != 0)
+            {
+                ++failures;
+            }
+        }
+
+        const sample_type* storage = samples.data();
+        generator.get_samples(count, samples);
+        generator.get_samples(count / 2, samples);
+        if (samples.data() != storage || samples.size() < count / 2)
+        {
+            ++failures;
+        }
+        return failures;
+    }
+}
+
+AUTO_UNIT_TEST(sample_buffers_1d)
+{
+    random_sample_1d<double> random_gen;
+    regular_sample_1d<double> regular_gen;
+    jitter_sample_1d<double> jitter_gen;
+    poisson_sample_1d<double> poisson_gen(default_random<double>(), 0.01);
+
+    TEST_COMPARE_EQUAL(check_buffer_samples(regular_gen, 16), size_t(0));
+    TEST_COMPARE_EQUAL(check_buffer_samples(jitter_gen, 16), size_t(0));
+    TEST_COMPARE_EQUAL(check_buffer_samples(poisson_gen, 16), size_t(0));
+
+    std::vector<double> samples;
+    random_gen.get_samples(9, samples);
+    TEST_COMPARE_EQUAL(samples.size(), size_t(9));
+}
+
+AUTO_UNIT_TEST(sample_buffers_2d)
+{
+    random_sample_2d<double> random_gen;
+    regular_sample_2d<double> regular_gen;
+    nrooks_sample_2d<double> nrooks_gen;
+    jitter_sample_2d<double> jitter_gen;
+    multi_jitter_sample_2d<double> multi_jitter_gen;
+    poisson_sample_2d<double> poisson_gen(default_random<double>(), 0.05);
+    sobol_sample_2d<double> sobol_gen;
+    halton_sample_2d<double> halton_gen;
+    blue_noise_sample_2d<double> blue_noise_gen(default_random<double>(), 64);
+
+    TEST_COMPARE_EQUAL(check_buffer_samples(random_gen, 16), size_t(0));
+    TEST_COMPARE_EQUAL(check_buffer_samples(regular_gen, 16), size_t(0));
+    TEST_COMPARE_EQUAL(check_buffer_samples(nrooks_gen, 16), size_t(0));
+    TEST_COMPARE_EQUAL(check_buffer_samples(jitter_gen, 16), size_t(0));
+    TEST_COMPARE_EQUAL(check_buffer_samples(multi_jitter_gen, 16), size_t(0));
+    TEST_COMPARE_EQUAL(check_buffer_samples(poisson_gen, 16), size_t(0));
+    TEST_COMPARE_EQUAL(check_buffer_samples(sobol_gen, 16), size_t(0));
+    TEST_COMPARE_EQUAL(check_buffer_samples(halton_gen, 16), size_t(0));
+    TEST_COMPARE_EQUAL(check_buffer_samples(blue_noise_gen, 100), size_t(0));
+
+    // Counts that are not perfect squares are rounded up.
+    std::vector<coord2<double>> samples;
+    multi_jitter_gen.get_samples(10, samples);
+    TEST_COMPARE_EQUAL(samples.size(), size_t(16));
+}
+
+AUTO_UNIT_TEST(sample_buffers_3d)
+{
+    random_sample_3d<double> random_gen;
+    sphere_sample_3d<double> sphere_gen;
+
+    TEST_COMPARE_EQUAL(check_buffer_samples(random_gen, 16), size_t(0));
+    TEST_COMPARE_EQUAL(check_buffer_samples(sphere_gen, 16), size_t(0));
+
+    std::vector<coord3<double>> samples;
+    sphere_gen.get_samples(100, samples);
+    size_t outside = 0;
+    for (const auto& s : samples)
+    {
+        outside += (squared_length(s) >= 1) ? 1 : 0;
+    }
+    TEST_COMPARE_EQUAL(outside, size_t(0));
+}
+
+namespace
+{
+    // The number of cells (of a grid of columns x rows) that do not have
+    // exactly one sample.
+    size_t badly_stratified(const std::vector<coord2<double>>& samples, size_t columns, size_t rows)
+    {
+        std::vector<size_t> counts(columns * rows, 0);
+        for (const auto& s : samples)
+        {
+            ++counts[size_t(s.y() * rows) * columns + size_t(s.x() * columns)];
+        }
+        return size_t(std::count_if(counts.begin(), counts.end(), [](size_t c) { return c != 1; }));
+    }
+
+    // The RMS error of estimating the area of the quarter disc with many
+    // sets of samples.
+    double quarter_disc_error(sample_generator_2d<double>& generator, size_t count)
+    {
+        const size_t trials = 400;
+        std::vector<coord2<double>> samples;
+        double total = 0;
+        for (size_t trial = 0; trial < trials; ++trial)
+        {
+            generator.get_samples(count, samples);
+            size_t inside = 0;
+            for (const auto& s : samples)
+            {
+                inside += (s.x() * s.x() + s.y() * s.y() < 1) ? 1 : 0;
+            }
+            double error = double(inside) / samples.size() - M_PI / 4;
+            total += error * error;
+        }
+        return std::sqrt(total / trials);
+    }
+}
+
+AUTO_UNIT_TEST(low_discrepancy_sequences)
+{
+    sobol_sample_2d<double> sobol_gen(default_random<double>(), false);
+    std::vector<coord2<double>> samples = sobol_gen.get_samples(4);
+    TEST_CLOSE(samples[1].x(), 0.5);
+    TEST_CLOSE(samples[1].y(), 0.5);
+    TEST_CLOSE(samples[2].x(), 0.25);
+    TEST_CLOSE(samples[2].y(), 0.75);
+    TEST_CLOSE(samples[3].x(), 0.75);
+    TEST_CLOSE(samples[3].y(), 0.25);
+
+    halton_sample_2d<double> halton_gen(default_random<double>(), false);
+    samples = halton_gen.get_samples(4);
+    TEST_CLOSE(samples[1].x(), 0.5);
+    TEST_CLOSE(samples[1].y(), 1.0 / 3);
+    TEST_CLOSE(samples[2].x(), 0.25);
+    TEST_CLOSE(samples[2].y(), 2.0 / 3);
+    TEST_CLOSE(samples[3].x(), 0.75);
+    TEST_CLOSE(samples[3].y(), 1.0 / 9);
+
+    // Owen scrambling keeps the stratification of the sequence, and gives a
+    // different set every time.
+    sobol_sample_2d<double> scrambled;
+    std::vector<coord2<double>> first = scrambled.get_samples(16);
+    samples = scrambled.get_samples(16);
+    TEST_BOOLEAN(std::memcmp(first.data(), samples.data(), sizeof(coord2<double>) * 16) != 0);
+    for (const auto& set : { first, samples })
+    {
+        TEST_COMPARE_EQUAL(badly_stratified(set, 4, 4), size_t(0));
+        TEST_COMPARE_EQUAL(badly_stratified(set, 16, 1), size_t(0));
+        TEST_COMPARE_EQUAL(badly_stratified(set, 1, 16), size_t(0));
+        TEST_COMPARE_EQUAL(badly_stratified(set, 8, 2), size_t(0));
+    }
+}
+
+AUTO_UNIT_TEST(blue_noise_tile)
+{
+    blue_noise_sample_2d<double> blue_noise_gen(default_random<double>(), 64);
+    TEST_COMPARE_EQUAL(blue_noise_gen.get_tile().size(), size_t(64));
+
+    // The tile is only built once, and is shared by clones and by other
+    // generators of the same size.
+    auto clone = blue_noise_gen.clone_new();
+    TEST_BOOLEAN(&static_cast<blue_noise_sample_2d<double>&>(*clone).get_tile() == &blue_noise_gen.get_tile());
+    blue_noise_sample_2d<double> other(default_random<double>(5), 64);
+    TEST_BOOLEAN(&other.get_tile() == &blue_noise_gen.get_tile());
+    blue_noise_sample_2d<double> larger(default_random<double>(), 65);
+    TEST_COMPARE_EQUAL(larger.get_tile().size(), size_t(65));
+
+    // Rotation keeps the (toroidal) spacing of the tile: 16 random points are
+    // usually within 0.05 of each other, while these are well spread out.
+    std::vector<coord2<double>> samples = blue_noise_gen.get_samples(16);
+    double closest = 1;
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        for (size_t j = 0; j < i; ++j)
+        {
+            double dx = std::abs(samples[i].x() - samples[j].x());
+            double dy = std::abs(samples[i].y() - samples[j].y());
+            dx = std::min(dx, 1 - dx);
+            dy = std::min(dy, 1 - dy);
+            closest = std::min(closest, std::sqrt(dx * dx + dy * dy));
+        }
+    }
+    TEST_BOOLEAN(closest > 0.12);
+}
+
+AUTO_UNIT_TEST(low_discrepancy_error)
+{
+    random_sample_2d<double> random_gen;
+    sobol_sample_2d<double> sobol_gen;
+    halton_sample_2d<double> halton_gen;
+    blue_noise_sample_2d<double> blue_noise_gen;
+
+    // With 64 samples, random sampling has about twice the error.
+    const double random_error = quarter_disc_error(random_gen, 64);
+    TEST_BOOLEAN(quarter_disc_error(sobol_gen, 64) < 0.6 * random_error);
+    TEST_BOOLEAN(quarter_disc_error(halton_gen, 64) < 0.6 * random_error);
+    TEST_BOOLEAN(quarter_disc_error(blue_noise_gen, 64) < 0.6 * random_error);
+}
@@ -0,0 +1,196 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "graphics/scanline_writer.hpp"
+#include "graphics/ppm_io.hpp"
+#include "graphics/tga_io.hpp"
+#include "graphics/stb_image.h"
+#include "general/deflate_stream.hpp"
+#include "general/random.hpp"
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+
+using namespace amethyst;
+
+namespace
+{
+    // Smooth gradients with some noise, so rows compress to various degrees.
+    image<double> test_image(size_t width, size_t height)
+    {
+        image<double> img(width, height);
+        default_random<double> random(3);
+        img.fill([&](size_t x, size_t y)
+            {
+                return rgbcolor<double>(x / double(width), y / double(height), (x / 16 + y / 16) % 2 ? random.next() : 0.5);
+            });
+        return img;
+    }
+
+    // Write the image in tiles, in reverse order.
+    template <class ColorType>
+    bool write_tiles_backwards(scanline_writer<ColorType>& writer, const raster<ColorType>& img, size_t tile_size)
+    {
+        bool ok = true;
+        for (size_t y = (img.get_height() - 1) / tile_size * tile_size + tile_size; y > 0; y -= tile_size)
+        {
+            for (size_t x = (img.get_width() - 1) / tile_size * tile_size + tile_size; x > 0; x -= tile_size)
+            {
+                size_t x1 = x - tile_size;
+                size_t y1 = y - tile_size;
+                size_t x2 = std::min(x, img.get_width()) - 1;
+                size_t y2 = std::min(y, img.get_height()) - 1;
+                ok = writer.write_tile(x1, y1, img.view(x1, y1, x2, y2)) && ok;
+            }
+        }
+        return ok;
+    }
+}
+
+AUTO_UNIT_TEST(stream_matches_whole_image_writers)
+{
+    const image<double> img = test_image(45, 31);
+
+    std::stringbuf whole_ppm;
+    ppm_io<double>().output(whole_ppm, img);
+    std::stringbuf rows_ppm;
+    scanline_writer<rgbcolor<double>> ppm_writer(make_ppm_encoder(rows_ppm), 45, 31);
+    TEST_BOOLEAN(ppm_writer.write_rows(img.view(0, 0, 44, 9)));
+    TEST_BOOLEAN(ppm_writer.write_rows(img.view(0, 10, 44, 30)));
+    TEST_BOOLEAN(ppm_writer.finish());
+    TEST_BOOLEAN(rows_ppm.str() == whole_ppm.str());
+
+    std::stringbuf whole_tga;
+    tga_io<double>().output(whole_tga, img);
+    std::stringbuf tiles_tga;
+    scanline_writer<rgbcolor<double>> tga_writer(make_tga_encoder(tiles_tga), 45, 31);
+    TEST_BOOLEAN(write_tiles_backwards(tga_writer, img, 8));
+    TEST_COMPARE_EQUAL(tga_writer.rows_written(), size_t(31));
+    TEST_BOOLEAN(tga_writer.finish());
+    TEST_BOOLEAN(tiles_tga.str() == whole_tga.str());
+}
+
+AUTO_UNIT_TEST(stream_png_decodes)
+{
+    const size_t width = 300;
+    const size_t height = 200;
+    const image<double> img = test_image(width, height);
+    const image<uint8_t> bytes = convert_image<uint8_t>(img, 2.2);
+
+    std::stringbuf png;
+    scanline_writer<rgbcolor<double>> writer(make_png_encoder(png), width, height);
+    writer.set_gamma(gamma_curve::power(2.2));
+    TEST_BOOLEAN(write_tiles_backwards(writer, img, 16));
+    TEST_BOOLEAN(writer.finish());
+
+    const std::string data = png.str();
+    TEST_BOOLEAN(data.size() < width * height * 3);
+
+    int w = 0, h = 0, channels = 0;
+    unsigned char* decoded = stbi_load_from_memory(reinterpret_cast<const unsigned char*>(data.data()), int(data.size()), &w, &h, &channels, 3);
+    TEST_BOOLEAN(decoded != nullptr);
+    if (decoded)
+    {
+        TEST_COMPARE_EQUAL(w, int(width));
+        TEST_COMPARE_EQUAL(h, int(height));
+        TEST_BOOLEAN(std::equal(decoded, decoded + width * height * 3, bytes.reinterpret<const unsigned char*>()));
+        stbi_image_free(decoded);
+    }
+}
+
+AUTO_UNIT_TEST(stream_png_from_threads)
+{
+    const size_t width = 160;
+    const size_t height = 120;
+    const size_t tile_size = 8;
+    const image<double> img = test_image(width, height);
+
+    std::stringbuf whole_png;
+    scanline_writer<rgbcolor<double>> whole_writer(make_png_encoder(whole_png), width, height);
+    TEST_BOOLEAN(whole_writer.write_rows(img));
+    TEST_BOOLEAN(whole_writer.finish());
+
+    // Each thread takes every fourth row of tiles, so rows finish in a
+    // different order each time, while others are being encoded.
+    std::stringbuf tiles_png;
+    scanline_writer<rgbcolor<double>> writer(make_png_encoder(tiles_png), width, height);
+    const size_t thread_count = 4;
+    bool ok[thread_count];
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < thread_count; ++t)
+    {
+        threads.emplace_back([&, t]()
+            {
+                ok[t] = true;
+                for (size_t y = t * tile_size; y < height; y += thread_count * tile_size)
+                {
+                    for (size_t x = 0; x < width; x += tile_size)
+                    {
+                        ok[t] = writer.write_tile(x, y, img.view(x, y, x + tile_size - 1, y + tile_size - 1)) && ok[t];
+                    }
+                }
+            });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    for (size_t t = 0; t < thread_count; ++t)
+    {
+        TEST_BOOLEAN(ok[t]);
+    }
+    TEST_BOOLEAN(writer.finish());
+    TEST_COMPARE_EQUAL(writer.rows_written(), height);
+    TEST_BOOLEAN(tiles_png.str() == whole_png.str());
+}
+
+AUTO_UNIT_TEST(deflate_round_trip)
+{
+    // Long runs, repeats further back than the window, and noise.
+    std::string input;
+    default_random<double> random(7);
+    for (size_t i = 0; i < 200000; ++i)
+    {
+        input.push_back((i / 1000) % 3 == 0 ? char(random.next() * 256) : char('a' + (i % 26)));
+    }
+
+    std::string compressed;
+    deflate_stream deflate([&](const uint8_t* data, size_t length) { compressed.append(reinterpret_cast<const char*>(data), length); });
+    for (size_t i = 0; i < input.size(); i += 777)
+    {
+        deflate.write(input.data() + i, std::min<size_t>(777, input.size() - i));
+    }
+    deflate.finish();
+    TEST_BOOLEAN(compressed.size() < input.size() / 2);
+
+    int length = 0;
+    char* output = stbi_zlib_decode_malloc(compressed.data(), int(compressed.size()), &length);
+    TEST_BOOLEAN(output != nullptr);
+    if (output)
+    {
+        TEST_BOOLEAN(std::string(output, length) == input);
+        free(output);
+    }
+
+    std::string empty;
+    deflate_stream nothing([&](const uint8_t* data, size_t length) { empty.append(reinterpret_cast<const char*>(data), length); });
+    nothing.finish();
+    output = stbi_zlib_decode_malloc(empty.data(), int(empty.size()), &length);
+    TEST_BOOLEAN(output != nullptr);
+    TEST_COMPARE_EQUAL(length, 0);
+    free(output);
+}
+
+AUTO_UNIT_TEST(stream_rejects_bad_tiles)
+{
+    const image<double> img = test_image(10, 10);
+    std::stringbuf out;
+    scanline_writer<rgbcolor<double>> writer(make_ppm_encoder(out), 10, 10);
+    TEST_BOOLEAN(!writer.write_tile(5, 0, img.view()));
+    TEST_BOOLEAN(writer.write_tile(0, 0, img.view(0, 0, 9, 4)));
+    TEST_BOOLEAN(!writer.write_tile(0, 2, img.view(0, 0, 9, 0)));
+    TEST_BOOLEAN(!writer.write_rows(img.view(0, 0, 4, 4)));
+    // Half of the image is missing.
+    TEST_BOOLEAN(!writer.finish());
+
+    TEST_EXCEPTION_THROW_SPECIFIC(scanline_writer<rgbcolor<double>>("test_scanline_writer.xyz", 4, 4), std::runtime_error);
+}
@@ -1,6 +1,7 @@
 #define auto_unit_test_main main
 #include "test_framework/unit_test_auto.hpp"
 #include "graphics/shapes/sphere.hpp"
+#include "graphics/shapes/dynamic_sphere.hpp"
 
 using namespace amethyst;
 
@@ -43,5 +44,56 @@ AUTO_UNIT_TEST(sphere_intersection)
     TEST_BOOLEAN(s1.intersects_line(l2, i2, r));
     TEST_XYZ_CLOSE(i2.get_first_point(), 1.00001, 0, 0);
 
+    // Lists that were not asked for are empty.
+    TEST_BOOLEAN(!i2.have_containers());
+    TEST_BOOLEAN(i2.get_containers().empty());
+    TEST_BOOLEAN(i2.get_all_intersections().empty());
+
     // LOTS MORE IS NEEDED
-}
\ No newline at end of file
+}
+
+AUTO_UNIT_TEST(sphere_bounds)
+{
+    sphere<double,vec> s({ 1,2,3 }, 2);
+    bounding_box<double> b;
+    TEST_BOOLEAN(s.get_bounds(b));
+    TEST_XYZ_CLOSE(b.minimum(), -1, 0, 1);
+    TEST_XYZ_CLOSE(b.maximum(), 3, 4, 5);
+
+    // A static shape has the same bounds over any time range.
+    bounding_box<double> b2;
+    TEST_BOOLEAN(s.get_motion_bounds(interval<double>(0, 10), b2));
+    TEST_XYZ_CLOSE(b2.minimum(), -1, 0, 1);
+    TEST_XYZ_CLOSE(b2.maximum(), 3, 4, 5);
+}
+
+AUTO_UNIT_TEST(dynamic_sphere_bounds)
+{
+    // Moves from x=0 to x=10 over time [0,1], growing from radius 1 to 2.
+    dynamic_sphere<double,vec> s(point(0, 0, 0), 0, point(10, 0, 0), 1, 1, 0, 2, 1);
+
+    bounding_box<double> all;
+    TEST_BOOLEAN(s.get_bounds(all));
+    bounding_box<double> start;
+    TEST_BOOLEAN(s.get_motion_bounds(interval<double>(0, 0.1), start));
+
+    // Every sampled position must be inside the bounds of a range containing it.
+    for (int i = 0; i <= 100; ++i)
+    {
+        double time = i / 100.0;
+        point c = s.get_center(time);
+        double r = s.get_radius(time);
+        TEST_BOOLEAN(all.inside(c + vec(r, 0, 0)));
+        TEST_BOOLEAN(all.inside(c - vec(r, 0, 0)));
+        TEST_BOOLEAN(all.inside(c + vec(0, r, r)));
+        if (time <= 0.1)
+        {
+            TEST_BOOLEAN(start.inside(c + vec(r, 0, 0)));
+            TEST_BOOLEAN(start.inside(c - vec(r, 0, 0)));
+        }
+    }
+
+    // A short range is much tighter than the whole motion.
+    TEST_BOOLEAN(start.extent().x() < all.extent().x() / 2);
+    TEST_BOOLEAN(start.maximum().x() < 5);
+}
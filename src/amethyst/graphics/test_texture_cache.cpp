@@ -0,0 +1,141 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "graphics/texture_cache.hpp"
+#include "graphics/image_loader.hpp"
+#include "graphics/texture/image_texture.hpp"
+#include <cstdio>
+#include <stdexcept>
+
+using namespace amethyst;
+
+namespace
+{
+    // Writes a small test image, removing it again when done.
+    struct temporary_image
+    {
+        temporary_image(const std::string& name, size_t width, size_t height, uint8_t value)
+            : filename(name)
+        {
+            image<uint8_t> img(width, height);
+            img.fill(rgbcolor<uint8_t>(value, uint8_t(value / 2), 7));
+            save_image(filename, img);
+        }
+        ~temporary_image()
+        {
+            std::remove(filename.c_str());
+        }
+        std::string filename;
+    };
+}
+
+AUTO_UNIT_TEST(texture_cache_shares_images)
+{
+    temporary_image file("test_texture_cache_a.ppm", 8, 4, 200);
+    texture_cache cache;
+
+    auto first = cache.get<rgbcolor<double>>(file.filename);
+    auto second = cache.get<rgbcolor<double>>(file.filename);
+    TEST_BOOLEAN(first == second);
+    TEST_COMPARE_EQUAL(first->get_width(), size_t(8));
+    TEST_CLOSE((*first)(3, 2).r(), 200 / 255.0);
+    TEST_COMPARE_EQUAL(cache.misses(), size_t(1));
+    TEST_COMPARE_EQUAL(cache.hits(), size_t(1));
+    TEST_COMPARE_EQUAL(cache.memory_used(), 8 * 4 * sizeof(rgbcolor<double>));
+
+    // Another color type is another entry.
+    auto bytes = cache.get<rgbcolor<uint8_t>>(file.filename);
+    TEST_COMPARE_EQUAL((*bytes)(0, 0).g(), 100);
+    TEST_COMPARE_EQUAL(cache.size(), size_t(2));
+
+    // Textures made from the same file share the decoded image.
+    texture_cache::shared().clear();
+    image_texture<double, rgbcolor<double>> t1(file.filename);
+    image_texture<double, rgbcolor<double>> t2(file.filename);
+    TEST_COMPARE_EQUAL(texture_cache::shared().misses(), size_t(1));
+    texture_cache::shared().clear();
+}
+
+AUTO_UNIT_TEST(texture_cache_evicts_least_recently_used)
+{
+    temporary_image a("test_texture_cache_a.ppm", 16, 16, 10);
+    temporary_image b("test_texture_cache_b.ppm", 16, 16, 20);
+    temporary_image c("test_texture_cache_c.ppm", 16, 16, 30);
+    const size_t image_bytes = 16 * 16 * sizeof(rgbcolor<float>);
+    texture_cache cache(2 * image_bytes);
+
+    auto held = cache.get<rgbcolor<float>>(a.filename);
+    cache.get<rgbcolor<float>>(b.filename);
+    cache.get<rgbcolor<float>>(a.filename);
+    cache.get<rgbcolor<float>>(c.filename);
+    // b was the least recently used.
+    TEST_COMPARE_EQUAL(cache.size(), size_t(2));
+    TEST_COMPARE_EQUAL(cache.memory_used(), 2 * image_bytes);
+    TEST_BOOLEAN(cache.get<rgbcolor<float>>(a.filename) == held);
+    TEST_COMPARE_EQUAL(cache.misses(), size_t(3));
+    cache.get<rgbcolor<float>>(b.filename);
+    TEST_COMPARE_EQUAL(cache.misses(), size_t(4));
+
+    // Evicted images stay alive while in use.
+    cache.set_budget(0);
+    TEST_COMPARE_EQUAL(cache.size(), size_t(0));
+    TEST_COMPARE_EQUAL(cache.memory_used(), size_t(0));
+    TEST_CLOSE((*held)(1, 1).r(), 10 / 255.0f);
+}
+
+AUTO_UNIT_TEST(texture_cache_parallel_loads)
+{
+    std::vector<std::unique_ptr<temporary_image>> files;
+    std::vector<std::string> names;
+    for (int i = 0; i < 6; ++i)
+    {
+        files.push_back(std::make_unique<temporary_image>(string_format("test_texture_cache_%1.ppm", i), 32, 8, uint8_t(i * 40)));
+        names.push_back(files.back()->filename);
+        names.push_back(files.back()->filename);
+    }
+
+    texture_cache cache;
+    thread_pool pool(4);
+    auto images = cache.get_all<rgbcolor<uint8_t>>(names, pool);
+    TEST_COMPARE_EQUAL(images.size(), names.size());
+    TEST_COMPARE_EQUAL(cache.misses(), size_t(6));
+    TEST_COMPARE_EQUAL(cache.hits(), size_t(6));
+    for (size_t i = 0; i < images.size(); i += 2)
+    {
+        TEST_BOOLEAN(images[i] == images[i + 1]);
+        TEST_COMPARE_EQUAL((*images[i])(31, 7).r(), uint8_t(i / 2 * 40));
+    }
+
+    // Failures are reported, and not cached.
+    names.push_back("test_texture_cache_missing.ppm");
+    TEST_EXCEPTION_THROW_SPECIFIC(cache.get_all<rgbcolor<uint8_t>>(names, pool), std::runtime_error);
+    TEST_COMPARE_EQUAL(cache.size(), size_t(6));
+    TEST_EXCEPTION_THROW_SPECIFIC(cache.get<rgbcolor<uint8_t>>("test_texture_cache_missing.ppm"), std::runtime_error);
+}
+
+AUTO_UNIT_TEST(texture_cache_preloads_mipmaps)
+{
+    temporary_image a("test_texture_cache_a.ppm", 8, 8, 60);
+    temporary_image b("test_texture_cache_b.ppm", 4, 4, 90);
+    const std::vector<std::string> names = { a.filename, b.filename, a.filename };
+
+    texture_cache::shared().clear();
+    const size_t misses = texture_cache::shared().misses();
+    thread_pool pool(2);
+    auto mipmaps = texture_cache::shared().get_all_mipmaps<rgbcolor<double>>(names, pool, mipmap_wrap::repeat);
+    TEST_COMPARE_EQUAL(mipmaps.size(), size_t(3));
+    TEST_BOOLEAN(mipmaps[0] == mipmaps[2]);
+    TEST_COMPARE_EQUAL(mipmaps[1]->get_width(), size_t(4));
+    TEST_COMPARE_EQUAL(texture_cache::shared().misses() - misses, size_t(2));
+
+    // Textures with the same wrapping use the preloaded mipmaps.
+    image_texture<double, rgbcolor<double>> repeated(a.filename, image_mapping_type::repeated);
+    image_texture<double, rgbcolor<double>> other(b.filename, image_mapping_type::repeated);
+    TEST_COMPARE_EQUAL(texture_cache::shared().misses() - misses, size_t(2));
+    TEST_CLOSE(repeated.get_color_at_location(coord2<double>(0.5, 0.5), vector3<double>(0, 0, 1)).r(), 60 / 255.0);
+    texture_cache::shared().clear();
+
+    // A texture from an image already in memory.
+    auto img = std::make_shared<const raster<rgbcolor<double>>>(4, 2);
+    image_texture<double, rgbcolor<double>> from_image(img);
+    TEST_BOOLEAN(from_image.internal_members("").find("image=[4,2]") != std::string::npos);
+}
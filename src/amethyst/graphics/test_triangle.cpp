@@ -5,6 +5,7 @@
 
 #include "amethyst/graphics/alpha_triangle_2d.hpp"
 #include "amethyst/graphics/image.hpp"
+#include "amethyst/graphics/shapes/triangle.hpp"
 #include "amethyst/graphics/tga_io.hpp"
 
 template <class T>
@@ -311,3 +312,14 @@ AUTO_UNIT_TEST(test_opaque2)
     }
 }
 
+AUTO_UNIT_TEST(test_triangle_bounds)
+{
+    typedef amethyst::vector3<double> vec3;
+    typedef amethyst::point3<double> point3;
+
+    amethyst::bounding_box<double> b;
+    amethyst::triangle<double,vec3> t(point3(0, 0, 0), point3(1, -1, 0), point3(0, 2, 5));
+    TEST_BOOLEAN(t.get_bounds(b));
+    TEST_XYZ_CLOSE(b.minimum(), 0, -1, 0);
+    TEST_XYZ_CLOSE(b.maximum(), 1, 2, 5);
+}
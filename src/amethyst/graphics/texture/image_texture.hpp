@@ -2,6 +2,8 @@
 
 #include "surface_texture.hpp"
 #include "graphics/image_loader.hpp"
+#include "graphics/mipmap.hpp"
+#include "graphics/texture_cache.hpp"
 #include "math/interval.hpp"
 #include "math/vector2.hpp"
 
@@ -13,35 +15,52 @@ namespace amethyst
         repeated
     };
 
+    /**
+     *
+     * A texture from an image, mapped once over the u-v square or repeated.
+     * Lookups are filtered from a mipmap of the image: bilinear at a point,
+     * or trilinear over a footprint (see get_filtered_color).
+     *
+     * @author Kevin Harris <kpharris@users.sourceforge.net>
+     * @version $Revision: 1.1 $
+     *
+     */
     template <typename T, typename color_type>
     class image_texture : public surface_texture<T, color_type>
     {
     public:
         using image_type = raster<color_type>;
+        using mipmap_type = mipmap<color_type>;
 
         image_texture(const std::string& filename, image_mapping_type type = image_mapping_type::once)
             : m_type(type)
         {
             load_image(filename);
-            m_scale.set(T(m_image->get_width()), T(m_image->get_height()));
         }
-        image_texture(std::shared_ptr<image_type> img, image_mapping_type type = image_mapping_type::once)
-            : m_image(img)
-            , m_scale(m_image->get_width(), m_image->get_height())
+        image_texture(std::shared_ptr<const mipmap_type> pyramid, image_mapping_type type = image_mapping_type::once)
+            : m_type(type)
+        {
+            set_mipmap(std::move(pyramid));
+        }
+        image_texture(std::shared_ptr<const image_type> img, image_mapping_type type = image_mapping_type::once)
+            : image_texture(*img, type)
         {
         }
-        image_texture(image_type img, image_mapping_type type = image_mapping_type::once)
-            : image_texture(std::make_shared<image_type>(std::move(img)), type)
+        image_texture(const image_type& img, image_mapping_type type = image_mapping_type::once)
+            : m_type(type)
         {
+            set_mipmap(std::make_shared<const mipmap_type>(img, wrap()));
         }
         image_texture(const image_texture&) = default;
         ~image_texture() = default;
 
+        // Shares the image's mipmap with every other texture using the file
+        // (see texture_cache).  To load many textures in parallel, pass their
+        // names to texture_cache::shared().get_all_mipmaps() first, with the
+        // wrapping the textures will use (repeat for repeated mapping).
         void load_image(const std::string& filename)
         {
-            m_image = std::make_shared<image_type>(convert_image<typename color_type::number_type>(load_image_with_stb(filename)));
-            // auto loader = getImageLoader<T, color_type>(filename);
-            // m_image = std::make_shared<image_type>(loader->input(filename));
+            set_mipmap(texture_cache::shared().get_mipmap<color_type>(filename, wrap()));
         }
 
         std::string name() const override
@@ -50,6 +69,11 @@ namespace amethyst
         }
 
         color_type get_color_at_location(const coord2<T>& coord, const vector3<T>& normal) const override
+        {
+            return get_filtered_color_at_location(coord, normal, T(0));
+        }
+
+        color_type get_filtered_color_at_location(const coord2<T>& coord, const vector3<T>& normal, T width) const override
         {
             if (m_type == image_mapping_type::once)
             {
@@ -59,29 +83,8 @@ namespace amethyst
                 }
             }
 
-            coord2<T> clipped{ fmod(coord.x(), T(1.0)), fmod(coord.y(), T(1)) };
-
-            if (clipped.x() < 0)
-            {
-                clipped[0] += T(1);
-            }
-            if (clipped.y() < 0)
-            {
-                clipped[0] += T(1);
-            }
-
-            // Now clipped is in [0,1]^2
-
-            coord2<T> wh{ T(m_image->get_width()), T(m_image->get_height()) };
-
-            auto scaled = clipped * wh;
-
-            // FIXME! Interpolate and make this less ugly.
-            auto pix = (*m_image)(
-                size_t(scaled.x()),
-                size_t((m_image->get_height() - 1) - scaled.y())
-                );
-            return pix;
+            // v goes up the image, where the mipmap's goes down.
+            return m_mipmap->trilinear(coord.x(), 1 - coord.y(), width);
         }
 
         std::string internal_members(const std::string& indentation, bool prefix_with_classname = false) const override
@@ -94,7 +97,7 @@ namespace amethyst
                 internal_tagging += image_texture::name() + "::";
             }
 
-            retval += internal_tagging + string_format("image=[%1,%2]\n", m_image->get_width(), m_image->get_height());
+            retval += internal_tagging + string_format("image=[%1,%2]\n", m_mipmap->get_width(), m_mipmap->get_height());
             retval += internal_tagging + "type=" + ((m_type == image_mapping_type::once) ? "once" : "repeated");
             retval += internal_tagging + string_format("scale=%1\n", inspect(m_scale));
 
@@ -102,8 +105,19 @@ namespace amethyst
         }
 
     private:
-        std::shared_ptr<image_type> m_image;
+        mipmap_wrap wrap() const
+        {
+            return (m_type == image_mapping_type::repeated) ? mipmap_wrap::repeat : mipmap_wrap::clamp;
+        }
+
+        void set_mipmap(std::shared_ptr<const mipmap_type> pyramid)
+        {
+            m_mipmap = std::move(pyramid);
+            m_scale.set(T(m_mipmap->get_width()), T(m_mipmap->get_height()));
+        }
+
+        std::shared_ptr<const mipmap_type> m_mipmap;
         image_mapping_type m_type;
         vector2<T> m_scale;
     };
-}
\ No newline at end of file
+}
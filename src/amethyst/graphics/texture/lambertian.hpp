@@ -1,6 +1,7 @@
 #pragma once
 
 #include "amethyst/graphics/texture/texture.hpp"
+#include "amethyst/graphics/samplegen3d.hpp"
 
 namespace amethyst
 {
@@ -24,8 +25,10 @@ namespace amethyst
             {
                 const auto& p = intersection.get_first_point();
                 const auto& n = intersection.get_normal();
-                auto target = p + n + vector3<T>(m_sampler.next_sample());
+                auto target = p + n + vector3<T>(next_offset(ray));
                 reflected.set_line({ p, target - p, reflected.get_line().limits() });
+                // Scattered in a random direction, so its footprint is unknown.
+                reflected.clear_differentials();
                 attenuation = m_albedo;
                 return true;
             }
@@ -56,5 +59,14 @@ namespace amethyst
     private:
         color_type m_albedo;
         mutable sphere_sample_3d<T> m_sampler;
+
+        coord3<T> next_offset(const ray_parameters<T, color_type>& ray) const
+        {
+            if (random<T>* r = ray.get_random())
+            {
+                return random_in_unit_sphere(*r);
+            }
+            return m_sampler.next_sample();
+        }
     };
 }
\ No newline at end of file
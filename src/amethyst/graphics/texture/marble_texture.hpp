@@ -2,6 +2,7 @@
 #include "amethyst/graphics/noise.hpp"
 #include "amethyst/graphics/texture/solid_texture.hpp"
 #include "amethyst/graphics/interpolated_value.hpp"
+#include <algorithm>
 #include <memory>
 
 
@@ -28,6 +29,10 @@ namespace amethyst
 
         color_type get_color_at_point(const point3<T>& location, const vector3<T>& normal) const override;
 
+        // The colors at count points, with the noise for all of them
+        // evaluated together.
+        void get_colors_at_points(const point3<T>* locations, color_type* colors, size_t count) const;
+
         std::string internal_members(const std::string& indentation, bool prefix_with_classname = false) const override;
         std::string name() const override { return "marble_texture"; }
     private:
@@ -111,4 +116,27 @@ namespace amethyst
         }
         return color_type(0);
     }
+
+    template <typename T, typename color_type>
+    void marble_texture<T, color_type>::get_colors_at_points(const point3<T>* locations, color_type* colors, size_t count) const
+    {
+        const size_t batch_size = 64;
+        coord3<T> scaled[batch_size];
+        T turb[batch_size];
+        for (size_t first = 0; first < count; first += batch_size)
+        {
+            const size_t n = std::min(batch_size, count - first);
+            for (size_t i = 0; i < n; ++i)
+            {
+                const point3<T>& location = locations[first + i];
+                scaled[i].set(location.x() * m_freq, location.y() * m_freq, location.z() * m_freq);
+            }
+            m_noise.turbulences(scaled, turb, n, m_octaves);
+            for (size_t i = 0; i < n; ++i)
+            {
+                T noisy_value = (sin(scaled[i].x() + m_scale * turb[i]) + T(1)) / T(2);
+                colors[first + i] = m_colors ? m_colors->interpolate(noisy_value) : color_type(0);
+            }
+        }
+    }
 }
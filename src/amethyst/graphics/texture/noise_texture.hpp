@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include "amethyst/graphics/noise.hpp"
 #include "amethyst/graphics/texture/solid_texture.hpp"
@@ -27,7 +28,11 @@ namespace amethyst
 
         virtual ~noise_texture() = default;
 
-        color_type get_color_at_point(const point3<T>& location) const override;
+        color_type get_color_at_point(const point3<T>& location, const vector3<T>& normal) const override;
+
+        // The colors at count points, with the noise for all of them
+        // evaluated together.
+        void get_colors_at_points(const point3<T>* locations, color_type* colors, size_t count) const;
 
         virtual std::string internal_members(const std::string& indentation, bool prefix_with_classname = false) const override;
         virtual std::string name() const override { return "noise_texture"; }
@@ -40,7 +45,7 @@ namespace amethyst
     template <typename T, typename color_type>
     noise_texture<T, color_type>::noise_texture(T scale, const std::shared_ptr<random<T>>& rnd)
         : noise_texture(
-            create_interpolation<T, color_type>(color_type(0.8, 0.0, 0.0), color_type(0.0, 0.0, 0.8)),
+            create_interpolation<T, color_type>(interpolation_point<T, color_type>(0, color_type(0.8, 0.0, 0.0)), interpolation_point<T, color_type>(1, color_type(0.0, 0.0, 0.8))),
             scale, rnd
         )
     {
@@ -48,7 +53,7 @@ namespace amethyst
 
     template <typename T, typename color_type>
     noise_texture<T, color_type>::noise_texture(const color_type& c0, const color_type& c1, T scale, const std::shared_ptr<random<T>>& rnd)
-        : noise_texture(create_interpolation<T, color_type>(c0, c1), scale, rnd)
+        : noise_texture(create_interpolation<T, color_type>(interpolation_point<T, color_type>(0, c0), interpolation_point<T, color_type>(1, c1)), scale, rnd)
     {
     }
 
@@ -87,7 +92,7 @@ namespace amethyst
     }
 
     template <typename T, typename color_type>
-    color_type noise_texture<T, color_type>::get_color_at_point(const point3<T>& location) const
+    color_type noise_texture<T, color_type>::get_color_at_point(const point3<T>& location, const vector3<T>& normal) const
     {
         coord3<T> v(location.x() * m_scale, location.y() * m_scale, location.z() * m_scale);
         T noisy_value = (m_noise.value(v) + T(1)) / T(2);
@@ -98,4 +103,27 @@ namespace amethyst
         }
         return color_type(0);
     }
+
+    template <typename T, typename color_type>
+    void noise_texture<T, color_type>::get_colors_at_points(const point3<T>* locations, color_type* colors, size_t count) const
+    {
+        const size_t batch_size = 64;
+        coord3<T> scaled[batch_size];
+        T values[batch_size];
+        for (size_t first = 0; first < count; first += batch_size)
+        {
+            const size_t n = std::min(batch_size, count - first);
+            for (size_t i = 0; i < n; ++i)
+            {
+                const point3<T>& location = locations[first + i];
+                scaled[i].set(location.x() * m_scale, location.y() * m_scale, location.z() * m_scale);
+            }
+            m_noise.values(scaled, values, n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                T noisy_value = (values[i] + T(1)) / T(2);
+                colors[first + i] = m_colors ? m_colors->interpolate(noisy_value) : color_type(0);
+            }
+        }
+    }
 }
@@ -27,8 +27,19 @@ namespace amethyst
             return true;
         }
 
+        bool get_filtered_color(const point3<T>& location, const coord2<T>& coord, const vector3<T>& normal, T width, color_type& color) const override
+        {
+            color = get_filtered_color_at_location(coord, normal, width);
+            return true;
+        }
+
         virtual color_type get_color_at_location(const coord2<T>& location, const vector3<T>& normal) const = 0;
 
+        virtual color_type get_filtered_color_at_location(const coord2<T>& location, const vector3<T>& normal, T width) const
+        {
+            return get_color_at_location(location, normal);
+        }
+
 
         std::string name() const override
         {
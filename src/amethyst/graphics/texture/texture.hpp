@@ -30,6 +30,14 @@ namespace amethyst
             return false;
         }
 
+        // The color averaged over a footprint about width across (in u-v
+        // coordinates), for textures that can filter.  Others give the color
+        // at the point.
+        virtual bool get_filtered_color(const point3<T>& location, const coord2<T>& coord, const vector3<T>& normal, T width, color_type& color) const
+        {
+            return get_color(location, coord, normal, color);
+        }
+
         color_type get_color(const point3<T>& location, const coord2<T>& coord, const vector3<T>& normal) const
         {
             color_type result;
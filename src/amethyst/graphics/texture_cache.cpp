@@ -0,0 +1,141 @@
+#include "texture_cache.hpp"
+
+namespace amethyst
+{
+    texture_cache::texture_cache(size_t budget_bytes)
+        : m_budget(budget_bytes)
+    {
+    }
+
+    texture_cache& texture_cache::shared()
+    {
+        static texture_cache cache;
+        return cache;
+    }
+
+    std::shared_ptr<const void> texture_cache::find_or_load(const std::string& filename, std::type_index type, unsigned variant,
+                                                            const std::function<loaded_image()>& load)
+    {
+        const key_type key(filename, type, variant);
+        std::promise<std::shared_ptr<const void>> promise;
+        entry_list::iterator position;
+        {
+            std::unique_lock<std::mutex> guard(m_lock);
+            auto found = m_index.find(key);
+            if (found != m_index.end())
+            {
+                ++m_hits;
+                m_entries.splice(m_entries.begin(), m_entries, found->second);
+                auto image = found->second->image;
+                guard.unlock();
+                // Waits if another thread is still loading it.
+                return image.get();
+            }
+
+            ++m_misses;
+            m_entries.push_front(entry{ key, promise.get_future().share() });
+            position = m_entries.begin();
+            m_index.emplace(key, position);
+        }
+
+        // Loaded without the lock, so other images can be found or loaded
+        // meanwhile.
+        loaded_image loaded;
+        try
+        {
+            loaded = load();
+        }
+        catch (...)
+        {
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                m_index.erase(key);
+                m_entries.erase(position);
+            }
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+
+        promise.set_value(loaded.image);
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            position->bytes = loaded.bytes;
+            position->loaded = true;
+            m_used += loaded.bytes;
+            evict();
+        }
+        return loaded.image;
+    }
+
+    // Drop the least recently used images until the rest fit the budget.
+    // Images still loading are left alone.  m_lock must be held.
+    void texture_cache::evict()
+    {
+        auto position = m_entries.end();
+        while ((m_used > m_budget) && (position != m_entries.begin()))
+        {
+            --position;
+            if (position->loaded)
+            {
+                m_used -= position->bytes;
+                m_index.erase(position->key);
+                position = m_entries.erase(position);
+            }
+        }
+    }
+
+    void texture_cache::set_budget(size_t budget_bytes)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_budget = budget_bytes;
+        evict();
+    }
+
+    size_t texture_cache::budget() const
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_budget;
+    }
+
+    size_t texture_cache::memory_used() const
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_used;
+    }
+
+    size_t texture_cache::size() const
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_entries.size();
+    }
+
+    size_t texture_cache::hits() const
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_hits;
+    }
+
+    size_t texture_cache::misses() const
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_misses;
+    }
+
+    void texture_cache::clear()
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        for (auto position = m_entries.begin(); position != m_entries.end();)
+        {
+            if (position->loaded)
+            {
+                m_used -= position->bytes;
+                m_index.erase(position->key);
+                position = m_entries.erase(position);
+            }
+            else
+            {
+                ++position;
+            }
+        }
+    }
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+/*
+   texture_cache.hpp -- A process-wide cache of decoded texture images, so
+   a file used by many textures is only decoded (and held) once.
+ */
+
+#include "graphics/image_converter.hpp"
+#include "graphics/mipmap.hpp"
+#include "graphics/raster.hpp"
+#include "graphics/stb_image_helper.hpp"
+#include "general/thread_pool.hpp"
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <typeindex>
+#include <vector>
+
+namespace amethyst
+{
+    /**
+     *
+     * Decoded images (and mipmaps made from them), keyed by filename and
+     * color type.  Every caller asking
+     * for the same image gets the same (immutable) raster; if it is still
+     * being loaded by another thread, they wait for that load rather than
+     * starting another.
+     *
+     * Images past the memory budget are dropped, least recently used first.
+     * This only drops the cache's reference: textures using an image keep it
+     * alive, and the next request for it loads it again.
+     *
+     * A failed load throws (to every caller waiting for it) and is not
+     * cached.
+     *
+     * @author Kevin Harris <kpharris@users.sourceforge.net>
+     * @version $Revision: 1.0 $
+     *
+     */
+    class texture_cache
+    {
+    public:
+        static const size_t default_budget = size_t(512) << 20;
+
+        explicit texture_cache(size_t budget_bytes = default_budget);
+
+        texture_cache(const texture_cache&) = delete;
+        texture_cache& operator=(const texture_cache&) = delete;
+
+        // The cache used by image_texture.
+        static texture_cache& shared();
+
+        template <typename ColorType>
+        std::shared_ptr<const raster<ColorType>> get(const std::string& filename)
+        {
+            auto image = find_or_load(filename, typeid(ColorType), 0, [&filename]()
+                {
+                    auto loaded = std::make_shared<const raster<ColorType>>(
+                        convert_image<typename ColorType::number_type>(load_image_with_stb(filename)));
+                    return loaded_image{ loaded, loaded->get_width() * loaded->get_height() * sizeof(ColorType) };
+                });
+            return std::static_pointer_cast<const raster<ColorType>>(image);
+        }
+
+        // The mipmap of an image.  This does not keep the image itself in the
+        // cache (the mipmap's first level is a copy of it).
+        template <typename ColorType>
+        std::shared_ptr<const mipmap<ColorType>> get_mipmap(const std::string& filename,
+                                                            mipmap_wrap wrap = mipmap_wrap::clamp,
+                                                            mipmap_filter filter = mipmap_filter::box)
+        {
+            const unsigned variant = 1 + unsigned(wrap) * 2 + unsigned(filter);
+            auto pyramid = find_or_load(filename, typeid(mipmap<ColorType>), variant, [&filename, wrap, filter]()
+                {
+                    raster<ColorType> image = convert_image<typename ColorType::number_type>(load_image_with_stb(filename));
+                    auto loaded = std::make_shared<const mipmap<ColorType>>(image, wrap, filter);
+                    return loaded_image{ loaded, loaded->memory_used() };
+                });
+            return std::static_pointer_cast<const mipmap<ColorType>>(pyramid);
+        }
+
+        // Load many images at once, one task each on the pool, returning them
+        // in the order given.  Duplicate names are only loaded once.
+        // @throws the first load failure, once every load has finished.
+        template <typename ColorType>
+        std::vector<std::shared_ptr<const raster<ColorType>>> get_all(const std::vector<std::string>& filenames, thread_pool& pool)
+        {
+            std::vector<std::shared_ptr<const raster<ColorType>>> result(filenames.size());
+            for (size_t i = 0; i < filenames.size(); ++i)
+            {
+                pool.submit([this, &filenames, &result, i]() { result[i] = get<ColorType>(filenames[i]); });
+            }
+            pool.wait();
+            return result;
+        }
+
+        // Load the mipmaps of many images at once, as get_all does for the
+        // images.  These are what image_textures with the same wrapping use.
+        // @throws the first load failure, once every load has finished.
+        template <typename ColorType>
+        std::vector<std::shared_ptr<const mipmap<ColorType>>> get_all_mipmaps(const std::vector<std::string>& filenames, thread_pool& pool,
+                                                                             mipmap_wrap wrap = mipmap_wrap::clamp,
+                                                                             mipmap_filter filter = mipmap_filter::box)
+        {
+            std::vector<std::shared_ptr<const mipmap<ColorType>>> result(filenames.size());
+            for (size_t i = 0; i < filenames.size(); ++i)
+            {
+                pool.submit([this, &filenames, &result, i, wrap, filter]() { result[i] = get_mipmap<ColorType>(filenames[i], wrap, filter); });
+            }
+            pool.wait();
+            return result;
+        }
+
+        void set_budget(size_t budget_bytes);
+        size_t budget() const;
+
+        // The bytes held by (fully loaded) cached images.
+        size_t memory_used() const;
+        // The number of images cached or being loaded.
+        size_t size() const;
+
+        size_t hits() const;
+        size_t misses() const;
+
+        void clear();
+
+    private:
+        struct loaded_image
+        {
+            std::shared_ptr<const void> image;
+            size_t bytes;
+        };
+        // The filename, what was made from it, and how (for mipmaps).
+        using key_type = std::tuple<std::string, std::type_index, unsigned>;
+
+        struct entry
+        {
+            key_type key;
+            std::shared_future<std::shared_ptr<const void>> image;
+            size_t bytes = 0;
+            bool loaded = false;
+        };
+        using entry_list = std::list<entry>;
+
+        std::shared_ptr<const void> find_or_load(const std::string& filename, std::type_index type, unsigned variant,
+                                                 const std::function<loaded_image()>& load);
+        void evict();
+
+        mutable std::mutex m_lock;
+        // Most recently used first.
+        entry_list m_entries;
+        std::map<key_type, entry_list::iterator> m_index;
+        size_t m_budget;
+        size_t m_used = 0;
+        size_t m_hits = 0;
+        size_t m_misses = 0;
+    };
+}
@@ -127,31 +127,25 @@ namespace amethyst
     template <typename T, typename ColorType>
     raster<ColorType> tga_io<T, ColorType>::input(std::istream& i) const
     {
-        byte version;
-        byte b1, b2;
-        byte r, g, b;
-        int width, height;
+        std::vector<uint8_t> header;
+        if (!this->input_bytes(i, header, 18))
+        {
+            std::cout << "Truncated header" << std::endl;
+            return {};
+        }
 
-        i.ignore(2);
-        i.get((char&)version);
+        byte version = header[2];
         if (version != 2)
         {
             std::cout << "Incorrect version (" << int(version) << ")" << std::endl;
             return {};
         }
-        else
-        {
-            std::cout << "Version is " << (int)version << std::endl;
-        }
-        i.ignore(9);
-
-        i.get((char&)b1).get((char&)b2);
-        width = word(b1) + (word(b2) << 8);
 
-        i.get((char&)b1).get((char&)b2);
-        height = word(b1) + (word(b2) << 8);
+        int width = word(header[12]) + (word(header[13]) << 8);
+        int height = word(header[14]) + (word(header[15]) << 8);
 
-        i.get((char&)b1).get((char&)b2);
+        byte b1 = header[16];
+        byte b2 = header[17];
         if ((b1 != 24) || ((b2 != 32) && (b2 != 0)))
         {
             std::cout << "Invalid constants..." << std::endl;
@@ -163,24 +157,36 @@ namespace amethyst
             flip_y = true;
         }
 
+        // Skip the image identifier, if there is one.
+        i.ignore(header[0]);
+
         raster<ColorType> dest { size_t(width), size_t(height) };
+        ColorType* data = dest.template reinterpret<ColorType*>();
+        const auto& byte_values = this->byte_values();
 
+        // Whole rows are read at once, then decoded from b,g,r order.
+        std::vector<uint8_t> row;
         for (int y = 0; y < height; ++y)
         {
-            for (int x = 0; x < width; ++x)
+            if (!this->input_bytes(i, row, size_t(width) * 3))
             {
-                i.get((char&)b).get((char&)g).get((char&)r);
+                std::cout << "Truncated image data" << std::endl;
+                return {};
+            }
 
-                int y_pos = y;
-                if (flip_y)
-                {
-                    y_pos = (height - 1) - y;
-                }
+            int y_pos = y;
+            if (flip_y)
+            {
+                y_pos = (height - 1) - y;
+            }
 
-                dest(x, y_pos) = convert_color<T>(rgbcolor<uint8_t>(r, g, b));
+            ColorType* line = data + size_t(y_pos) * width;
+            const uint8_t* bytes = row.data();
+            for (int x = 0; x < width; ++x, bytes += 3)
+            {
+                line[x] = ColorType(byte_values[bytes[2]], byte_values[bytes[1]], byte_values[bytes[0]]);
             }
         }
-        std::cout << "Loaded image of size " << width << "x" << height << std::endl;
 
         return dest;
     }
@@ -0,0 +1,150 @@
+// Compares an image against a reference, for checking renderings for
+// regressions.  Prints the mean absolute difference, the RMS error and PSNR,
+// and the perceptual RMS difference (see image_metrics.hpp), all for
+// channels in 0..1.
+//
+// Usage: image_compare <reference> <image> [--metric l1|l2|perceptual]
+//                      [--threshold x] [--diff file] [--diff-gain g]
+//
+// With a threshold, exits with 1 if the chosen metric (mean absolute
+// difference for l1, RMS for the others) is over it.  Usage and load errors
+// exit with 2.  --diff writes the absolute difference of each channel,
+// multiplied by the gain (default 1).
+
+#include "graphics/image_loader.hpp"
+#include "graphics/image_metrics.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace amethyst;
+
+namespace
+{
+    int usage(const char* program)
+    {
+        std::cerr << "Usage: " << program << " <reference> <image> [--metric l1|l2|perceptual]"
+                  << " [--threshold x] [--diff file] [--diff-gain g]" << std::endl;
+        return 2;
+    }
+
+    // Some of the loaders report errors and return an empty image instead of
+    // throwing, which would otherwise compare as equal to anything empty.
+    image<double> load(const std::string& filename)
+    {
+        image<double> img = getImageLoader<double>(filename)->input(filename);
+        if ((img.get_width() == 0) || (img.get_height() == 0))
+        {
+            throw std::runtime_error("Unable to load an image from " + filename);
+        }
+        return img;
+    }
+}
+
+int main(int argc, const char** argv)
+{
+    std::string names[2];
+    size_t name_count = 0;
+    image_metric metric = image_metric::l2;
+    double threshold = -1;
+    std::string diff_filename;
+    double diff_gain = 1;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--metric" && has_value)
+        {
+            std::string name = argv[++i];
+            if (name == "l1")
+            {
+                metric = image_metric::l1;
+            }
+            else if (name == "l2")
+            {
+                metric = image_metric::l2;
+            }
+            else if (name == "perceptual")
+            {
+                metric = image_metric::perceptual;
+            }
+            else
+            {
+                return usage(argv[0]);
+            }
+        }
+        else if (arg == "--threshold" && has_value)
+        {
+            threshold = std::strtod(argv[++i], nullptr);
+        }
+        else if (arg == "--diff" && has_value)
+        {
+            diff_filename = argv[++i];
+        }
+        else if (arg == "--diff-gain" && has_value)
+        {
+            diff_gain = std::strtod(argv[++i], nullptr);
+        }
+        else if (arg.compare(0, 2, "--") != 0 && name_count < 2)
+        {
+            names[name_count++] = arg;
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+    if (name_count != 2)
+    {
+        return usage(argv[0]);
+    }
+
+    try
+    {
+        image<double> reference = load(names[0]);
+        image<double> img = load(names[1]);
+
+        const double l1 = mean_image_difference(reference, img, image_metric::l1);
+        const double rms = mean_image_difference(reference, img, image_metric::l2);
+        const double perceptual = mean_image_difference(reference, img, image_metric::perceptual);
+        std::cout << "mean absolute difference " << l1 << std::endl;
+        std::cout << "rms error " << rms << ", psnr " << ((rms > 0) ? -20 * std::log10(rms) : INFINITY) << " dB" << std::endl;
+        std::cout << "perceptual rms " << perceptual << std::endl;
+
+        if (!diff_filename.empty())
+        {
+            image<double> diff = difference_image(reference, img);
+            for (size_t y = 0; y < diff.get_height(); ++y)
+            {
+                for (size_t x = 0; x < diff.get_width(); ++x)
+                {
+                    diff(x, y) *= diff_gain;
+                }
+            }
+            if (!save_image(diff_filename, diff))
+            {
+                std::cerr << "Unable to write " << diff_filename << std::endl;
+                return 2;
+            }
+        }
+
+        if (threshold >= 0)
+        {
+            const double value = (metric == image_metric::l1) ? l1 : ((metric == image_metric::l2) ? rms : perceptual);
+            if (value > threshold)
+            {
+                std::cout << "over threshold " << threshold << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,235 @@
+#pragma once
+
+/*
+   bounding_box.hpp -- An axis-aligned box, used for culling and acceleration.
+ */
+
+#include "point3.hpp"
+#include "vector3.hpp"
+#include <algorithm>
+#include <limits>
+#include <ostream>
+
+namespace amethyst
+{
+    //
+    // bounding_box class:
+    // An axis-aligned box described by its minimum and maximum corners.
+    //
+    // A default constructed box is empty (its minimum is greater than its
+    // maximum), so that points and other boxes can be added to it.  A box
+    // containing a single point, or one that is flat on an axis, is not empty.
+    //
+    template <typename T>
+    class bounding_box
+    {
+    public:
+        constexpr bounding_box()
+            : m_minimum(std::numeric_limits<T>::max(), std::numeric_limits<T>::max(), std::numeric_limits<T>::max())
+            , m_maximum(std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest())
+        {
+        }
+        constexpr bounding_box(const point3<T>& p1, const point3<T>& p2)
+            : m_minimum(std::min(p1.x(), p2.x()), std::min(p1.y(), p2.y()), std::min(p1.z(), p2.z()))
+            , m_maximum(std::max(p1.x(), p2.x()), std::max(p1.y(), p2.y()), std::max(p1.z(), p2.z()))
+        {
+        }
+
+        const point3<T>& minimum() const { return m_minimum; }
+        const point3<T>& maximum() const { return m_maximum; }
+
+        bool empty() const
+        {
+            return (m_maximum.x() < m_minimum.x()) || (m_maximum.y() < m_minimum.y()) || (m_maximum.z() < m_minimum.z());
+        }
+
+        // Grow the box to include the point or box.
+        bounding_box& add(const point3<T>& p);
+        bounding_box& add(const bounding_box& b);
+
+        // Grow the box by the given amount in every direction.
+        bounding_box& expand(T amount);
+
+        point3<T> center() const { return m_minimum + (m_maximum - m_minimum) / T(2); }
+        vector3<T> extent() const { return m_maximum - m_minimum; }
+
+        // The index of the longest axis (0=x, 1=y, 2=z).
+        unsigned longest_axis() const;
+
+        // The surface area of the box (0 for an empty box).
+        T surface_area() const;
+
+        bool inside(const point3<T>& p) const;
+        bool overlaps(const bounding_box& b) const;
+
+        // Returns true if the range of the line passes through the box, giving the
+        // range of the line that is inside it.  This is a simple slab test.
+        // Any 3d line type (line3, unit_line3) can be used.
+        template <typename line_type>
+        bool intersects_line(const line_type& line, T& t_near, T& t_far) const;
+
+        // The minimum (0) or maximum (1) corner.
+        const point3<T>& corner(unsigned which) const { return which ? m_maximum : m_minimum; }
+
+    private:
+        point3<T> m_minimum;
+        point3<T> m_maximum;
+    };
+
+    template <typename T>
+    bounding_box<T>& bounding_box<T>::add(const point3<T>& p)
+    {
+        m_minimum.set(std::min(m_minimum.x(), p.x()), std::min(m_minimum.y(), p.y()), std::min(m_minimum.z(), p.z()));
+        m_maximum.set(std::max(m_maximum.x(), p.x()), std::max(m_maximum.y(), p.y()), std::max(m_maximum.z(), p.z()));
+        return *this;
+    }
+
+    template <typename T>
+    bounding_box<T>& bounding_box<T>::add(const bounding_box<T>& b)
+    {
+        if (!b.empty())
+        {
+            add(b.m_minimum);
+            add(b.m_maximum);
+        }
+        return *this;
+    }
+
+    template <typename T>
+    bounding_box<T>& bounding_box<T>::expand(T amount)
+    {
+        if (!empty())
+        {
+            m_minimum -= vector3<T>(amount, amount, amount);
+            m_maximum += vector3<T>(amount, amount, amount);
+        }
+        return *this;
+    }
+
+    template <typename T>
+    unsigned bounding_box<T>::longest_axis() const
+    {
+        vector3<T> e = extent();
+        if (e.x() >= e.y() && e.x() >= e.z())
+        {
+            return 0;
+        }
+        return (e.y() >= e.z()) ? 1 : 2;
+    }
+
+    template <typename T>
+    T bounding_box<T>::surface_area() const
+    {
+        if (empty())
+        {
+            return T(0);
+        }
+        vector3<T> e = extent();
+        return 2 * (e.x() * e.y() + e.y() * e.z() + e.z() * e.x());
+    }
+
+    template <typename T>
+    bool bounding_box<T>::inside(const point3<T>& p) const
+    {
+        return (m_minimum.x() <= p.x()) && (p.x() <= m_maximum.x()) &&
+            (m_minimum.y() <= p.y()) && (p.y() <= m_maximum.y()) &&
+            (m_minimum.z() <= p.z()) && (p.z() <= m_maximum.z());
+    }
+
+    template <typename T>
+    bool bounding_box<T>::overlaps(const bounding_box<T>& b) const
+    {
+        return (m_minimum.x() <= b.m_maximum.x()) && (b.m_minimum.x() <= m_maximum.x()) &&
+            (m_minimum.y() <= b.m_maximum.y()) && (b.m_minimum.y() <= m_maximum.y()) &&
+            (m_minimum.z() <= b.m_maximum.z()) && (b.m_minimum.z() <= m_maximum.z());
+    }
+
+    template <typename T>
+    template <typename line_type>
+    bool bounding_box<T>::intersects_line(const line_type& line, T& t_near, T& t_far) const
+    {
+        t_near = line.limits().begin();
+        t_far = line.limits().end();
+
+        for (unsigned axis = 0; axis < 3; ++axis)
+        {
+            // A zero direction gives infinite values here, which the
+            // comparisons below handle (unless the origin is on a slab edge).
+            T inverse = T(1) / line.direction()[axis];
+            T t0 = (m_minimum[axis] - line.origin()[axis]) * inverse;
+            T t1 = (m_maximum[axis] - line.origin()[axis]) * inverse;
+            if (t1 < t0)
+            {
+                std::swap(t0, t1);
+            }
+            t_near = std::max(t_near, t0);
+            t_far = std::min(t_far, t1);
+            if (t_far < t_near)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //
+    // box_line_tester class:
+    // A slab test for testing one line against many boxes (eg. when walking a
+    // hierarchy).  The reciprocal of the direction and the sign of each axis
+    // are computed once, so each box test is only multiplies and compares,
+    // with no divides or swaps.
+    //
+    // The far distance is scaled up slightly to account for rounding in the
+    // subtractions and multiplies, so a line which grazes the edge of a box
+    // is never missed (see Ize, "Robust BVH Ray Traversal").
+    //
+    template <typename T>
+    class box_line_tester
+    {
+    public:
+        template <typename line_type>
+        explicit box_line_tester(const line_type& line)
+            : m_origin(line.origin())
+            , m_inverse_direction(T(1) / line.direction().x(), T(1) / line.direction().y(), T(1) / line.direction().z())
+            , m_sign{ unsigned(m_inverse_direction.x() < 0), unsigned(m_inverse_direction.y() < 0), unsigned(m_inverse_direction.z() < 0) }
+        {
+        }
+
+        // Returns true if the line hits the box anywhere in [t_min, t_max],
+        // giving the range of the line that is inside it.
+        bool intersects(const bounding_box<T>& box, T t_min, T t_max, T& t_near, T& t_far) const
+        {
+            t_near = t_min;
+            t_far = t_max;
+            for (unsigned axis = 0; axis < 3; ++axis)
+            {
+                T t0 = (box.corner(m_sign[axis])[axis] - m_origin[axis]) * m_inverse_direction[axis];
+                T t1 = (box.corner(1 - m_sign[axis])[axis] - m_origin[axis]) * m_inverse_direction[axis];
+                t1 *= far_scale;
+                // Written so that a NaN (0 * infinity, for an origin on a slab
+                // edge with a zero direction) leaves the range unchanged.
+                t_near = (t0 > t_near) ? t0 : t_near;
+                t_far = (t1 < t_far) ? t1 : t_far;
+            }
+            return t_near <= t_far;
+        }
+
+        // 1 + 2 * gamma(3), where gamma(n) = n * e / (1 - n * e).
+        static constexpr T far_scale = T(1) + T(2) * (T(3) * std::numeric_limits<T>::epsilon() / 2) / (T(1) - T(3) * std::numeric_limits<T>::epsilon() / 2);
+
+    private:
+        point3<T> m_origin;
+        vector3<T> m_inverse_direction;
+        unsigned m_sign[3];
+    };
+
+    template <typename T>
+    std::ostream& operator<<(std::ostream& o, const bounding_box<T>& b)
+    {
+        if (b.empty())
+        {
+            return o << "[empty]";
+        }
+        return o << "[" << b.minimum() << ", " << b.maximum() << "]";
+    }
+}
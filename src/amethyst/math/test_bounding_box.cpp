@@ -0,0 +1,103 @@
+#define auto_unit_test_main main
+#include "test_framework/unit_test_auto.hpp"
+#include "math/bounding_box.hpp"
+#include "math/unit_line3.hpp"
+#include <limits>
+
+namespace
+{
+    using namespace amethyst;
+    using box = bounding_box<double>;
+    using point = point3<double>;
+    using vec = vector3<double>;
+    using line = unit_line3<double>;
+}
+
+AUTO_UNIT_TEST(box_construction)
+{
+    box b1;
+    TEST_BOOLEAN(b1.empty());
+    TEST_CLOSE(b1.surface_area(), 0);
+
+    box b2(point(1, 2, 3), point(-1, -2, -3));
+    TEST_BOOLEAN(!b2.empty());
+    TEST_XYZ_CLOSE(b2.minimum(), -1, -2, -3);
+    TEST_XYZ_CLOSE(b2.maximum(), 1, 2, 3);
+    TEST_XYZ_CLOSE(b2.center(), 0, 0, 0);
+    TEST_COMPARE_EQUAL(b2.longest_axis(), 2u);
+    TEST_CLOSE(b2.surface_area(), 2 * (2 * 4 + 4 * 6 + 6 * 2));
+
+    b1.add(point(0, 0, 0));
+    TEST_BOOLEAN(!b1.empty());
+    TEST_CLOSE(b1.surface_area(), 0);
+    b1.add(box(point(1, 1, 1), point(2, 2, 2)));
+    TEST_XYZ_CLOSE(b1.minimum(), 0, 0, 0);
+    TEST_XYZ_CLOSE(b1.maximum(), 2, 2, 2);
+
+    // Adding an empty box changes nothing.
+    b1.add(box());
+    TEST_XYZ_CLOSE(b1.maximum(), 2, 2, 2);
+
+    TEST_BOOLEAN(b1.inside(point(1, 1, 1)));
+    TEST_BOOLEAN(!b1.inside(point(3, 1, 1)));
+    TEST_BOOLEAN(b1.overlaps(b2));
+    TEST_BOOLEAN(!b1.overlaps(box(point(3, 3, 3), point(4, 4, 4))));
+}
+
+AUTO_UNIT_TEST(box_line_intersection)
+{
+    box b(point(-1, -1, -1), point(1, 1, 1));
+    double t_near;
+    double t_far;
+
+    line l1(point(-5, 0, 0), vec(1, 0, 0));
+    TEST_BOOLEAN(b.intersects_line(l1, t_near, t_far));
+    TEST_CLOSE(t_near, 4);
+    TEST_CLOSE(t_far, 6);
+
+    line l2(point(-5, 2, 0), vec(1, 0, 0));
+    TEST_BOOLEAN(!b.intersects_line(l2, t_near, t_far));
+
+    // The limits of the line are respected.
+    line l3(point(-5, 0, 0), vec(1, 0, 0), interval<double>(0, 3));
+    TEST_BOOLEAN(!b.intersects_line(l3, t_near, t_far));
+
+    box_line_tester<double> tester(l1);
+    TEST_BOOLEAN(tester.intersects(b, 0, 100, t_near, t_far));
+    TEST_CLOSE(t_near, 4);
+    TEST_CLOSE(t_far, 6);
+    TEST_BOOLEAN(!tester.intersects(b, 0, 3, t_near, t_far));
+    TEST_BOOLEAN(!tester.intersects(b, 7, 100, t_near, t_far));
+
+    // Negative directions.
+    line l4(point(3, 3, 3), unit(vec(-1, -1, -1)));
+    box_line_tester<double> diagonal(l4);
+    TEST_BOOLEAN(diagonal.intersects(b, 0, 100, t_near, t_far));
+    TEST_CLOSE(t_near, std::sqrt(12.0));
+    TEST_CLOSE(t_far, std::sqrt(48.0));
+}
+
+AUTO_UNIT_TEST(box_line_edge_cases)
+{
+    box b(point(-1, -1, -1), point(1, 1, 1));
+    double t_near;
+    double t_far;
+
+    // Parallel to a slab, inside and outside it.
+    box_line_tester<double> inside_slab(line(point(-5, 0.5, 0.5), vec(1, 0, 0)));
+    TEST_BOOLEAN(inside_slab.intersects(b, 0, 100, t_near, t_far));
+    box_line_tester<double> outside_slab(line(point(-5, 1.5, 0.5), vec(1, 0, 0)));
+    TEST_BOOLEAN(!outside_slab.intersects(b, 0, 100, t_near, t_far));
+
+    // Starting inside the box.
+    box_line_tester<double> from_inside(line(point(0, 0, 0), vec(0, 0, 1)));
+    TEST_BOOLEAN(from_inside.intersects(b, 0, 100, t_near, t_far));
+    TEST_CLOSE(t_near, 0);
+    TEST_CLOSE(t_far, 1);
+
+    // A flat box (eg. the bounds of an axis-aligned rectangle) is still hit.
+    box flat(point(-1, -1, 0), point(1, 1, 0));
+    box_line_tester<double> down(line(point(0.5, 0.5, 4), vec(0, 0, -1)));
+    TEST_BOOLEAN(down.intersects(flat, 0, 100, t_near, t_far));
+    TEST_CLOSE(t_near, 4);
+}
@@ -0,0 +1,659 @@
+// Times the renderer on the scenes of the rtiow examples:
+//  - In the style of rtiow_04_multiple_spheres (a large ground sphere with
+//    many small spheres and triangles on it), shaded by normal only, so that
+//    nearly all of the time is spent finding the first hit of the camera rays.
+//  - The diffuse, metal and glass spheres of rtiow_07_glass, comparing the
+//    recursive and iterative integrators.
+//  - The error of fixed and adaptive sampling (at the same average number
+//    of samples per pixel) in the glass scene.
+//  - The cost of the 2d sample generators, and their error when estimating
+//    the area of a quarter disc.
+//  - Gamma conversion of a rendered image to 8 and 16 bit, float and double
+//    output, with a pow per channel and with convert_image.
+//  - Loading PPM and TGA images with ppm_io and tga_io, and with stb_image
+//    (the path png_io uses).
+//  - Texture lookups across a plane receding to the horizon: point sampling
+//    the image, and trilinear filtering of box and Kaiser mipmaps, timed and
+//    compared with a supersampled reference.
+//  - Perlin noise and turbulence, per point and in batches, and the marble
+//    and noise textures built on them.
+//  - The l1, l2 and perceptual differences of two images, against the
+//    Kahan sum genetic_triangles used before.
+//  - The number of heap allocations made while rendering a frame, which
+//    should not grow with the number of pixels.
+//
+// Usage: render_benchmark [width height [samples_per_pixel]]
+
+#include "math/unit_line3.hpp"
+#include "graphics/rgbcolor.hpp"
+#include "graphics/renderer.hpp"
+#include "graphics/image_converter.hpp"
+#include "graphics/image_metrics.hpp"
+#include "graphics/mipmap.hpp"
+#include "graphics/ppm_io.hpp"
+#include "graphics/stb_image_helper.hpp"
+#include "graphics/tga_io.hpp"
+#include "graphics/shapes/aggregate.hpp"
+#include "graphics/shapes/bvh.hpp"
+#include "graphics/shapes/sphere.hpp"
+#include "graphics/shapes/triangle.hpp"
+#include "graphics/texture/solid_texture.hpp"
+#include "graphics/texture/marble_texture.hpp"
+#include "graphics/texture/noise_texture.hpp"
+#include "graphics/texture/lambertian.hpp"
+#include "graphics/texture/metal.hpp"
+#include "graphics/texture/dielectric.hpp"
+#include "graphics/pinhole_camera.hpp"
+#include "graphics/samplegen2d.hpp"
+#include "general/random.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+
+using namespace amethyst;
+using Point = point3<double>;
+using Color = rgbcolor<double>;
+using Vec = vector3<double>;
+using Line = unit_line3<double>;
+
+// Every allocation in the program is counted, so a render can be checked for
+// allocations in its per-pixel loops.  All of the forms of new and delete
+// are replaced (including the aligned ones planar_raster uses), and go
+// through counted_allocate and counted_release.
+static std::atomic<size_t> allocation_count(0);
+
+namespace
+{
+    // Every block starts with the pointer malloc returned, just before the
+    // (aligned) pointer handed out, so that any form of delete can free it.
+    void* counted_allocate(size_t size, size_t alignment)
+    {
+        ++allocation_count;
+        alignment = std::max(alignment, alignof(std::max_align_t));
+        if (void* block = std::malloc(size + alignment + sizeof(void*)))
+        {
+            uintptr_t start = reinterpret_cast<uintptr_t>(block) + sizeof(void*);
+            void* p = reinterpret_cast<void*>((start + alignment - 1) & ~uintptr_t(alignment - 1));
+            static_cast<void**>(p)[-1] = block;
+            return p;
+        }
+        throw std::bad_alloc();
+    }
+
+    void counted_release(void* p) noexcept
+    {
+        if (p)
+        {
+            std::free(static_cast<void**>(p)[-1]);
+        }
+    }
+}
+
+void* operator new(size_t size) { return counted_allocate(size, 0); }
+void* operator new[](size_t size) { return counted_allocate(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) { return counted_allocate(size, size_t(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return counted_allocate(size, size_t(alignment)); }
+void operator delete(void* p) noexcept { counted_release(p); }
+void operator delete[](void* p) noexcept { counted_release(p); }
+void operator delete(void* p, size_t) noexcept { counted_release(p); }
+void operator delete[](void* p, size_t) noexcept { counted_release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { counted_release(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { counted_release(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { counted_release(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { counted_release(p); }
+
+namespace
+{
+    class normal_scene_texture : public solid_texture<double, Color>
+    {
+    public:
+        Color get_color_at_point(const Point& location, const Vec& normal) const override
+        {
+            return 0.5 * Color(normal.x() + 1, normal.y() + 1, normal.z() + 1);
+        }
+        std::string internal_members(const std::string& indentation, bool prefix_with_classname) const override
+        {
+            return { };
+        }
+    };
+
+    std::shared_ptr<aggregate<double, Color>> make_scene()
+    {
+        default_random<double> rnd(1);
+        auto scene = std::make_shared<aggregate<double, Color>>();
+        scene->add(std::make_shared<sphere<double, Color>>(Point(0, -1000, 0), 1000));
+        for (int a = -11; a < 11; ++a)
+        {
+            for (int b = -11; b < 11; ++b)
+            {
+                Point center(a + 0.9 * rnd.next(), 0.2, b + 0.9 * rnd.next());
+                if ((a + b) % 4 == 0)
+                {
+                    scene->add(std::make_shared<triangle<double, Color>>(center - Vec(0.2, 0.2, 0), center + Vec(0.2, -0.2, 0), center + Vec(0, 0.2, 0)));
+                }
+                else
+                {
+                    scene->add(std::make_shared<sphere<double, Color>>(center, 0.2));
+                }
+            }
+        }
+        scene->add(std::make_shared<sphere<double, Color>>(Point(0, 1, 0), 1.0));
+        scene->add(std::make_shared<sphere<double, Color>>(Point(-4, 1, 0), 1.0));
+        scene->add(std::make_shared<sphere<double, Color>>(Point(4, 1, 0), 1.0));
+        return scene;
+    }
+
+    std::shared_ptr<aggregate<double, Color>> make_material_scene()
+    {
+        auto scene = std::make_shared<aggregate<double, Color>>();
+        scene->add(std::make_shared<sphere<double, Color>>(Point(0, 0, -1), 0.5, std::make_shared<lambertian<double, Color>>(Color{ 0.1, 0.2, 0.5 })));
+        scene->add(std::make_shared<sphere<double, Color>>(Point(0, -100.5, -1), 100, std::make_shared<lambertian<double, Color>>(Color{ 0.8, 0.8, 0.0 })));
+        scene->add(std::make_shared<sphere<double, Color>>(Point(1, 0, -1), 0.5, std::make_shared<metal<double, Color>>(Color{ 0.8, 0.6, 0.2 }, 0.2)));
+        scene->add(std::make_shared<sphere<double, Color>>(Point(-1, 0, -1), 0.5, std::make_shared<dielectric<double, Color>>(1.5)));
+        return scene;
+    }
+
+    struct timing
+    {
+        double seconds;
+        raster<Color> image;
+    };
+
+    timing time_render(shape_ptr<double, Color> scene, texture_ptr<double, Color> scene_texture, camera_ptr<double, Color> camera,
+        size_t nx, size_t ny, size_t spp, const render_options& options, Color light = Color{ 1, 1, 1 },
+        sample_generator_2d_ptr<double> sampler = std::make_shared<regular_sample_2d<double>>())
+    {
+        intersection_requirements requirements;
+        requirements.force_first_only(true);
+        requirements.force_normal(true);
+        requirements.force_uv(true);
+
+        auto start = std::chrono::steady_clock::now();
+        raster<Color> image = render<double, Color>(
+            camera, scene, scene_texture, nx, ny, requirements,
+            [=](const Point&, const Vec&) { return light; },
+            nullptr, spp, sampler, nullptr, options);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return { elapsed.count(), std::move(image) };
+    }
+
+    double average(const raster<Color>& image)
+    {
+        double total = 0;
+        for (size_t y = 0; y < image.get_height(); ++y)
+        {
+            for (size_t x = 0; x < image.get_width(); ++x)
+            {
+                total += image(x, y).r() + image(x, y).g() + image(x, y).b();
+            }
+        }
+        return total / (3 * image.get_width() * image.get_height());
+    }
+
+    // Returns the seconds per set of samples, and the RMS error of the
+    // estimated quarter disc area.
+    std::pair<double, double> time_sampler(sample_generator_2d<double>& generator, size_t count, size_t sets)
+    {
+        std::vector<coord2<double>> samples;
+        double total_error = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t set = 0; set < sets; ++set)
+        {
+            generator.get_samples(count, samples);
+            size_t inside = 0;
+            for (const auto& s : samples)
+            {
+                inside += (s.x() * s.x() + s.y() * s.y() < 1) ? 1 : 0;
+            }
+            double error = double(inside) / samples.size() - M_PI / 4;
+            total_error += error * error;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return { elapsed.count() / sets, std::sqrt(total_error / sets) };
+    }
+
+    double rms_difference(const raster<Color>& a, const raster<Color>& b)
+    {
+        return mean_image_difference(a, b, image_metric::l2);
+    }
+
+    // The absolute difference as genetic_triangles summed it before
+    // image_difference: one pixel at a time into a Kahan sum, with the sum
+    // kept in memory so the correction is not optimized away.
+    double kahan_difference(const raster<Color>& a, const raster<Color>& b)
+    {
+        double sum = 0;
+        double correction = 0;
+        const Color* pa = a.raw_data();
+        const Color* pb = b.raw_data();
+        for (size_t i = 0; i < a.get_width() * a.get_height(); ++i)
+        {
+            double term = std::fabs(pa[i].r() - pb[i].r()) + std::fabs(pa[i].g() - pb[i].g()) + std::fabs(pa[i].b() - pb[i].b());
+            volatile double next = sum + term;
+            correction += (sum - next) + term;
+            sum = next;
+        }
+        return sum + correction;
+    }
+
+    // Gamma conversion as convert_image did it before gamma_lut and
+    // gamma_encode: a pow per channel.
+    template <typename U, typename T>
+    image<U> convert_each(const image<T>& source, double gamma)
+    {
+        image<U> result(source.get_width(), source.get_height());
+        for (size_t y = 0; y < source.get_height(); ++y)
+        {
+            for (size_t x = 0; x < source.get_width(); ++x)
+            {
+                result(x, y) = gamma_convert_color<U>(source(x, y), gamma);
+            }
+        }
+        return result;
+    }
+
+    // Returns the seconds for the old and the new conversion of the image.
+    template <typename U, typename T>
+    std::pair<double, double> time_gamma(const image<T>& source, size_t repeats)
+    {
+        std::pair<double, double> seconds;
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < repeats; ++i)
+            {
+                image<U> result = (pass == 0) ? convert_each<U>(source, 2.2) : convert_image<U>(source, 2.2);
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            (pass == 0 ? seconds.first : seconds.second) = elapsed.count() / repeats;
+        }
+        return seconds;
+    }
+
+    // Returns the seconds to load the file into an image<double>.
+    double time_load(const std::function<image<double>()>& load, size_t repeats)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < repeats; ++i)
+        {
+            image<double> loaded = load();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / repeats;
+    }
+
+    // Where pixel (x, y) of a width x height view of a textured plane, seen
+    // at a grazing angle, lands in the (repeated) texture, and about how
+    // wide its footprint there is.
+    struct plane_view
+    {
+        size_t width;
+        size_t height;
+
+        coord2<double> uv(double x, double y) const
+        {
+            const double z = 1 / (1 - y / (height + 1));
+            return { 0.5 + (x / width - 0.5) * z / 4, z / 20 };
+        }
+
+        double footprint(double x, double y) const
+        {
+            const double z = 1 / (1 - y / (height + 1));
+            return std::max(z / (4 * width), z * z / (20 * (height + 1)));
+        }
+    };
+
+    // Returns the seconds per lookup, and the RMS difference from the
+    // reference.
+    std::pair<double, double> time_lookups(const plane_view& view, const raster<Color>& reference,
+                                           const std::function<Color(double x, double y)>& lookup)
+    {
+        raster<Color> result(view.width, view.height);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t y = 0; y < view.height; ++y)
+        {
+            for (size_t x = 0; x < view.width; ++x)
+            {
+                result(x, y) = lookup(x + 0.5, y + 0.5);
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return { elapsed.count() / (view.width * view.height), rms_difference(result, reference) };
+    }
+
+    bool identical(const raster<Color>& a, const raster<Color>& b)
+    {
+        for (size_t y = 0; y < a.get_height(); ++y)
+        {
+            for (size_t x = 0; x < a.get_width(); ++x)
+            {
+                if (a(x, y).r() != b(x, y).r() || a(x, y).g() != b(x, y).g() || a(x, y).b() != b(x, y).b())
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, const char** argv)
+{
+    size_t nx = 400;
+    size_t ny = 200;
+    size_t spp = 4;
+    if (argc >= 3)
+    {
+        nx = std::strtoul(argv[1], nullptr, 10);
+        ny = std::strtoul(argv[2], nullptr, 10);
+    }
+    if (argc >= 4)
+    {
+        spp = std::strtoul(argv[3], nullptr, 10);
+    }
+
+    auto camera = std::make_shared<pinhole_camera<double, Color>>(
+        Point(13, 2, 3), Point(0, 0, 0) - Point(13, 2, 3), Vec(0, 1, 0),
+        2 * std::tan(M_PI / 18) * double(nx) / ny, 2 * std::tan(M_PI / 18), 1.0, nx, ny);
+    auto normal_texture = std::make_shared<normal_scene_texture>();
+
+    auto list = make_scene();
+    auto tree = std::make_shared<bvh<double, Color>>(*list);
+    const double rays = double(nx) * ny * spp;
+
+    std::cout << nx << "x" << ny << " at " << spp << " samples per pixel, " << list->size() << " shapes" << std::endl;
+
+    for (bool use_tree : { false, true })
+    {
+        shape_ptr<double, Color> scene = use_tree ? shape_ptr<double, Color>(tree) : shape_ptr<double, Color>(list);
+
+        render_options single;
+        single.ray_packets = false;
+        render_options packets;
+        packets.ray_packets = true;
+
+        timing t_single = time_render(scene, normal_texture, camera, nx, ny, spp, single);
+        timing t_packets = time_render(scene, normal_texture, camera, nx, ny, spp, packets);
+
+        std::cout << (use_tree ? "bvh:       " : "aggregate: ")
+                  << "single rays " << t_single.seconds << "s (" << rays / t_single.seconds / 1e6 << " Mrays/s), "
+                  << "packets " << t_packets.seconds << "s (" << rays / t_packets.seconds / 1e6 << " Mrays/s), "
+                  << "speedup " << t_single.seconds / t_packets.seconds << "x"
+                  << (identical(t_single.image, t_packets.image) ? "" : " [IMAGES DIFFER]")
+                  << std::endl;
+    }
+
+    // The glass scene, lit only by the sky.
+    auto glass_camera = std::make_shared<pinhole_camera<double, Color>>(
+        Point(0, 0, 1), Vec(0, 0, -1), Vec(0, 1, 0), 4 * double(nx) / (2 * ny), 2.0, 1.0, nx, ny);
+    auto glass_scene = make_material_scene();
+    auto glass_texture = std::make_shared<lambertian<double, Color>>(Color{ 0.5, 0.5, 0.5 });
+
+    render_options recursive;
+    render_options iterative;
+    iterative.integrator = integrator_type::iterative;
+
+    timing t_recursive = time_render(glass_scene, glass_texture, glass_camera, nx, ny, spp, recursive, Color{ 0, 0, 0 });
+    timing t_iterative = time_render(glass_scene, glass_texture, glass_camera, nx, ny, spp, iterative, Color{ 0, 0, 0 });
+    std::cout << "glass:     "
+              << "recursive " << t_recursive.seconds << "s (average " << average(t_recursive.image) << "), "
+              << "iterative " << t_iterative.seconds << "s (average " << average(t_iterative.image) << "), "
+              << "speedup " << t_recursive.seconds / t_iterative.seconds << "x"
+              << std::endl;
+
+    {
+        // A quarter of the size, against a reference with many samples.
+        const size_t ax = nx / 4;
+        const size_t ay = ny / 4;
+        auto small_camera = std::make_shared<pinhole_camera<double, Color>>(
+            Point(0, 0, 1), Vec(0, 0, -1), Vec(0, 1, 0), 4 * double(nx) / (2 * ny), 2.0, 1.0, ax, ay);
+        render_options fixed;
+        fixed.threads = 0;
+        timing reference = time_render(glass_scene, glass_texture, small_camera, ax, ay, 1024, fixed, Color{ 0, 0, 0 },
+            std::make_shared<jitter_sample_2d<double>>());
+        fixed.seed = 1;
+        render_options adaptive = fixed;
+        adaptive.adaptive_threshold = 0.02;
+        const size_t budget = 16;
+        auto jitter = std::make_shared<jitter_sample_2d<double>>();
+        timing t_fixed = time_render(glass_scene, glass_texture, small_camera, ax, ay, budget, fixed, Color{ 0, 0, 0 }, jitter);
+        timing t_adaptive = time_render(glass_scene, glass_texture, small_camera, ax, ay, budget, adaptive, Color{ 0, 0, 0 }, jitter);
+        std::cout << "adaptive:  " << ax << "x" << ay << " at " << budget << " samples per pixel, "
+                  << "fixed rms error " << rms_difference(t_fixed.image, reference.image) << " (" << t_fixed.seconds << "s), "
+                  << "adaptive rms error " << rms_difference(t_adaptive.image, reference.image) << " (" << t_adaptive.seconds << "s)"
+                  << std::endl;
+    }
+
+    std::pair<const char*, std::shared_ptr<sample_generator_2d<double>>> samplers[] = {
+        { "random", std::make_shared<random_sample_2d<double>>() },
+        { "jitter", std::make_shared<jitter_sample_2d<double>>() },
+        { "multi_jitter", std::make_shared<multi_jitter_sample_2d<double>>() },
+        { "poisson", std::make_shared<poisson_sample_2d<double>>(default_random<double>(), 0.08) },
+        { "sobol", std::make_shared<sobol_sample_2d<double>>() },
+        { "halton", std::make_shared<halton_sample_2d<double>>() },
+        { "blue_noise", std::make_shared<blue_noise_sample_2d<double>>() },
+    };
+    for (const auto& sampler : samplers)
+    {
+        auto result = time_sampler(*sampler.second, 64, 2000);
+        std::cout << "sampler:   " << sampler.first << " " << result.first * 1e6 << "us per 64 samples, "
+                  << "quarter disc rms error " << result.second << std::endl;
+    }
+
+    image<float> float_image(nx, ny);
+    for (size_t y = 0; y < ny; ++y)
+    {
+        for (size_t x = 0; x < nx; ++x)
+        {
+            const Color& c = t_recursive.image(x, y);
+            float_image(x, y) = rgbcolor<float>(float(c.r()), float(c.g()), float(c.b()));
+        }
+    }
+    std::pair<const char*, std::pair<double, double>> conversions[] = {
+        { "uint8", time_gamma<uint8_t>(t_recursive.image, 10) },
+        { "uint16", time_gamma<uint16_t>(t_recursive.image, 10) },
+        { "float", time_gamma<float>(float_image, 10) },
+        { "double", time_gamma<double>(t_recursive.image, 10) },
+    };
+    for (const auto& conversion : conversions)
+    {
+        std::cout << "gamma:     " << conversion.first << " pow per channel " << conversion.second.first * 1e3 << "ms, "
+                  << "convert_image " << conversion.second.second * 1e3 << "ms, "
+                  << "speedup " << conversion.second.first / conversion.second.second << "x" << std::endl;
+    }
+
+    // A large texture, in both formats that ppm_io, tga_io and stb_image can
+    // all read.
+    {
+        const size_t texture_size = 2048;
+        image<double> texture(texture_size, texture_size);
+        default_random<double> texture_random(11);
+        texture.fill([&](size_t x, size_t y) { return Color(x / double(texture_size), texture_random.next(), y / double(texture_size)); });
+        const double megabytes = texture_size * texture_size * 3 / 1e6;
+
+        std::pair<std::string, std::shared_ptr<image_io<double>>> formats[] = {
+            { "render_benchmark_texture.ppm", std::make_shared<ppm_io<double>>() },
+            { "render_benchmark_texture.tga", std::make_shared<tga_io<double>>() },
+        };
+        for (const auto& format : formats)
+        {
+            format.second->output(format.first, texture);
+            double reader = time_load([&]() { return format.second->input(format.first); }, 3);
+            double stb = time_load([&]() { return convert_image<double>(load_image_with_stb(format.first)); }, 3);
+            std::cout << "load:      " << format.second->default_extension() << " "
+                      << format.second->default_extension() << "_io " << megabytes / reader << "MB/s, "
+                      << "stb_image " << megabytes / stb << "MB/s" << std::endl;
+            std::remove(format.first.c_str());
+        }
+    }
+
+    // Texture lookups over a plane, where most pixels cover many texels.
+    {
+        const size_t texture_size = 2048;
+        image<double> texture(texture_size, texture_size);
+        default_random<double> texture_random(12);
+        texture.fill([&](size_t x, size_t y) { return Color(((x ^ y) & 4) ? 1 : 0, texture_random.next(), ((x + y) % 2) ? 1 : 0); });
+
+        auto start = std::chrono::steady_clock::now();
+        mipmap<Color> box(texture, mipmap_wrap::repeat, mipmap_filter::box);
+        std::chrono::duration<double> box_seconds = std::chrono::steady_clock::now() - start;
+        start = std::chrono::steady_clock::now();
+        mipmap<Color> kaiser(texture, mipmap_wrap::repeat, mipmap_filter::kaiser);
+        std::chrono::duration<double> kaiser_seconds = std::chrono::steady_clock::now() - start;
+
+        const plane_view view{ nx, ny };
+        auto point = [&](double x, double y)
+        {
+            const coord2<double> uv = view.uv(x, y);
+            const double u = uv.x() - std::floor(uv.x());
+            const double v = uv.y() - std::floor(uv.y());
+            return texture(size_t(u * texture_size) % texture_size, size_t(v * texture_size) % texture_size);
+        };
+
+        // Each pixel's average over 16x16 point samples.
+        raster<Color> reference(nx, ny);
+        const size_t grid = 16;
+        for (size_t y = 0; y < ny; ++y)
+        {
+            for (size_t x = 0; x < nx; ++x)
+            {
+                Color sum(0, 0, 0);
+                for (size_t j = 0; j < grid; ++j)
+                {
+                    for (size_t i = 0; i < grid; ++i)
+                    {
+                        sum += point(x + (i + 0.5) / grid, y + (j + 0.5) / grid);
+                    }
+                }
+                reference(x, y) = sum / double(grid * grid);
+            }
+        }
+
+        std::pair<std::string, std::function<Color(double, double)>> lookups[] = {
+            { "point   ", point },
+            { "box     ", [&](double x, double y) { coord2<double> uv = view.uv(x, y); return box.trilinear(uv.x(), uv.y(), view.footprint(x, y)); } },
+            { "kaiser  ", [&](double x, double y) { coord2<double> uv = view.uv(x, y); return kaiser.trilinear(uv.x(), uv.y(), view.footprint(x, y)); } },
+        };
+        std::cout << "mipmap:    " << texture_size << "x" << texture_size << " box " << box_seconds.count() * 1e3 << "ms, "
+                  << "kaiser " << kaiser_seconds.count() * 1e3 << "ms" << std::endl;
+        for (const auto& lookup : lookups)
+        {
+            auto result = time_lookups(view, reference, lookup.second);
+            std::cout << "texture:   " << lookup.first << result.first * 1e9 << "ns per lookup, "
+                      << "rms error " << result.second << std::endl;
+        }
+    }
+
+    // Noise, at points spread over a few lattice cells.
+    {
+        const size_t count = 1 << 16;
+        std::vector<coord3<double>> points(count);
+        default_random<double> point_random(13);
+        for (auto& p : points)
+        {
+            p.set(16 * point_random.next(), 16 * point_random.next(), 16 * point_random.next());
+        }
+        std::vector<double> results(count);
+        noise<double> perlin;
+
+        auto time_points = [&](const std::function<void()>& run)
+        {
+            auto start = std::chrono::steady_clock::now();
+            run();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            return elapsed.count() * 1e9 / count;
+        };
+        double value = time_points([&]() { for (size_t i = 0; i < count; ++i) results[i] = perlin.value(points[i]); });
+        double turbulence = time_points([&]() { for (size_t i = 0; i < count; ++i) results[i] = perlin.turbulence(points[i]); });
+        double batch_value = time_points([&]() { perlin.values(points.data(), results.data(), count); });
+        double batch_turbulence = time_points([&]() { perlin.turbulences(points.data(), results.data(), count); });
+        std::cout << "noise:     value " << value << "ns, turbulence " << turbulence << "ns per point" << std::endl;
+        std::cout << "noise:     batched value " << batch_value << "ns, turbulence " << batch_turbulence << "ns per point" << std::endl;
+
+        marble_texture<double, Color> marble;
+        noise_texture<double, Color> solid_noise;
+        std::vector<Color> colors(count);
+        double marble_ns = time_points([&]() { for (size_t i = 0; i < count; ++i) colors[i] = marble.get_color(Point(points[i].x(), points[i].y(), points[i].z()), coord2<double>(), Vec(0, 0, 1)); });
+        double noise_ns = time_points([&]() { for (size_t i = 0; i < count; ++i) colors[i] = solid_noise.get_color(Point(points[i].x(), points[i].y(), points[i].z()), coord2<double>(), Vec(0, 0, 1)); });
+        std::cout << "textures:  marble " << marble_ns << "ns, noise " << noise_ns << "ns per sample" << std::endl;
+
+        std::vector<Point> locations(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            locations[i] = Point(points[i].x(), points[i].y(), points[i].z());
+        }
+        double batch_marble = time_points([&]() { marble.get_colors_at_points(locations.data(), colors.data(), count); });
+        double batch_noise = time_points([&]() { solid_noise.get_colors_at_points(locations.data(), colors.data(), count); });
+        std::cout << "textures:  batched marble " << batch_marble << "ns, noise " << batch_noise << "ns per sample" << std::endl;
+    }
+
+    // Image differences, between two noisy 1024x1024 images.
+    {
+        const size_t size = 1024;
+        image<double> a(size, size);
+        image<double> b(size, size);
+        default_random<double> pixel_random(17);
+        for (size_t y = 0; y < size; ++y)
+        {
+            for (size_t x = 0; x < size; ++x)
+            {
+                a(x, y).set(pixel_random.next(), pixel_random.next(), pixel_random.next());
+                b(x, y).set(pixel_random.next(), pixel_random.next(), pixel_random.next());
+            }
+        }
+        double result = 0;
+        auto time_pixels = [&](const std::function<double()>& run)
+        {
+            auto start = std::chrono::steady_clock::now();
+            result = run();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            return elapsed.count() * 1e9 / (size * size);
+        };
+        double kahan = time_pixels([&]() { return kahan_difference(a, b); });
+        const double kahan_result = result;
+        double l1 = time_pixels([&]() { return image_difference(a, b, image_metric::l1); });
+        const double l1_result = result;
+        double l2 = time_pixels([&]() { return image_difference(a, b, image_metric::l2); });
+        double perceptual = time_pixels([&]() { return image_difference(a, b, image_metric::perceptual); });
+        std::cout << "metrics:   kahan l1 " << kahan << "ns, l1 " << l1 << "ns, l2 " << l2 << "ns, perceptual "
+                  << perceptual << "ns per pixel, l1 relative difference " << std::fabs(l1_result - kahan_result) / kahan_result
+                  << std::endl;
+    }
+
+    // Allocations for two frame sizes, rendered as a single tile: the
+    // difference is what the extra pixels cost.
+    render_options allocation_options;
+    allocation_options.threads = 1;
+    allocation_options.tile_size = std::max(nx, ny);
+    for (bool use_packets : { false, true })
+    {
+        allocation_options.ray_packets = use_packets;
+        size_t per_frame[2];
+        size_t pixels[2] = { nx * ny / 4, nx * ny };
+        for (size_t i = 0; i < 2; ++i)
+        {
+            size_t width = (i == 0) ? nx / 2 : nx;
+            size_t height = (i == 0) ? ny / 2 : ny;
+            auto frame_camera = std::make_shared<pinhole_camera<double, Color>>(
+                Point(13, 2, 3), Point(0, 0, 0) - Point(13, 2, 3), Vec(0, 1, 0),
+                2 * std::tan(M_PI / 18) * double(nx) / ny, 2 * std::tan(M_PI / 18), 1.0, width, height);
+            size_t before = allocation_count;
+            time_render(tree, normal_texture, frame_camera, width, height, spp, allocation_options);
+            per_frame[i] = allocation_count - before;
+        }
+        std::cout << (use_packets ? "packets:   " : "single:    ")
+                  << "allocations per frame " << per_frame[0] << " (" << pixels[0] << " pixels), "
+                  << per_frame[1] << " (" << pixels[1] << " pixels), "
+                  << "per pixel " << double(per_frame[1] - per_frame[0]) / (pixels[1] - pixels[0])
+                  << std::endl;
+    }
+
+    return 0;
+}
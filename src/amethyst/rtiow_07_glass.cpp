@@ -118,12 +118,15 @@ int main(int argc, const char** argv)
 
     auto sampler = std::make_shared<regular_sample_2d<double>>();
 
+    render_options options;
+    options.threads = 0; // Use every available core.
+
     std::cout << "Scene: " << scene << std::endl;
 
     auto img = render<double, Color>(
         camera, scene, scene_texture, nx, ny,
         requirements, lighting, background_color, spp,
-        sampler, progress
+        sampler, progress, options
         );
 
     save_image("rtiow_07_glass.png", img);